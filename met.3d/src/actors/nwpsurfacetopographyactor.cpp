@@ -169,6 +169,10 @@ void MNWPSurfaceTopographyActor::onBoundingBoxChanged()
         return;
     }
 
+    // Actor variables that restrict their data requests to the bounding box
+    // need to request new data.
+    broadcastPropertyChangedEvent(MPropertyType::BoundingBox, nullptr);
+
     // The bbox position has changed. In the next render cycle, update the
     // render region, download target grid from GPU and update contours.
     updateRenderRegion = true;
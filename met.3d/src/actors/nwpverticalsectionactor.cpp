@@ -615,6 +615,10 @@ void MNWPVerticalSectionActor::onBoundingBoxChanged()
 
     if (suppressActorUpdates()) return;
 
+    // Actor variables that restrict their data requests to the bounding box
+    // need to request new data.
+    broadcastPropertyChangedEvent(MPropertyType::BoundingBox, nullptr);
+
     // Adapt iso pressure lines set to new boundaries.
     generateIsoPressureLines();
     updatePath = true;
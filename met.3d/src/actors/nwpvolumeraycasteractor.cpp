@@ -1089,6 +1089,10 @@ void MNWPVolumeRaycasterActor::onBoundingBoxChanged()
         emitActorChangedSignal();
         return;
     }
+    // Actor variables that restrict their data requests to the bounding box
+    // need to request new data.
+    broadcastPropertyChangedEvent(MPropertyType::BoundingBox, nullptr);
+
     generateVolumeBoxGeometry();
 
     updateNextRenderFrame.set(UpdateShadowImage);
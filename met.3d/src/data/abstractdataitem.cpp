@@ -52,6 +52,8 @@ MMemoryManagementUsingObject::MMemoryManagementUsingObject()
 MAbstractDataItem::MAbstractDataItem()
     : MMemoryManagementUsingObject(),
       memoryManager(nullptr),
+      isReleasedToCache(false),
+      isCompactedForCache(false),
       generatingRequest(""),
       storingObject(nullptr)
 {
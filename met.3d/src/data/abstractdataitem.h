@@ -27,6 +27,7 @@
 #define ABSTRACTDATAITEM_H
 
 // standard library imports
+#include <atomic>
 
 // related third party imports
 #include <QtCore>
@@ -95,10 +96,31 @@ protected:
 
     MMemoryManagementUsingObject* getStoringObject();
 
+    /**
+      Called by the memory manager when the item has been released by all its
+      users and is kept in the cache (@ref compactForCache()), and when it is
+      requested again (@ref restoreFromCache()). Items can override the
+      methods to keep their data in a more compact form while they are not in
+      use; @ref getMemorySize_kb() needs to return the current size. The
+      default implementations do nothing.
+     */
+    virtual void compactForCache() { }
+
+    virtual void restoreFromCache() { }
+
     // If not nullptr, the memory manager that controls this item. May be used
     // by the item to release dependent items.
     MAbstractMemoryManager *memoryManager;
 
+    // Cache state managed by MLRUMemoryManager. compactForCache() and
+    // restoreFromCache() are called without the memory manager's cache
+    // mutex; cacheStateMutex serialises them. isReleasedToCache is changed
+    // with the cache mutex locked, isCompactedForCache with cacheStateMutex
+    // locked.
+    QMutex cacheStateMutex;
+    std::atomic<bool> isReleasedToCache;
+    bool isCompactedForCache;
+
 private:
     // The request that generated this data item.
     MDataRequest generatingRequest;
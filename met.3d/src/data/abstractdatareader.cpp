@@ -28,9 +28,11 @@
 // standard library imports
 
 // related third party imports
+#include <log4cplus/loggingmacros.h>
 
 // local application imports
 #include "gxfw/msystemcontrol.h"
+#include "util/mutil.h"
 
 using namespace std;
 
@@ -134,6 +136,20 @@ void MAbstractDataReader::getAvailableFilesFromFilters(QStringList &availableFil
     // Since dataRoot was used to search the sub-directories, reset dataRoot to
     // the root directory.
     dataRoot.setPath(rootPath);
+
+    // Keep track of the latest modification so that persistently cached
+    // data derived from the files can be invalidated.
+    dataRootLastModified = QDateTime();
+    foreach (QString availableFile, availableFiles)
+    {
+        QDateTime lastModified =
+                QFileInfo(dataRoot, availableFile).lastModified();
+        if (!dataRootLastModified.isValid()
+                || lastModified > dataRootLastModified)
+        {
+            dataRootLastModified = lastModified;
+        }
+    }
 }
 
 
@@ -212,6 +228,20 @@ void MAbstractDataReader::updateFileScanProgressDialog()
 }
 
 
+void MAbstractDataReader::logFileScanErrors(const QStringList& files,
+                                            const QVector<QString>& errors)
+{
+    for (int i = 0; i < files.size(); i++)
+    {
+        if (errors[i].isEmpty()) continue;
+
+        LOG4CPLUS_ERROR(mlog, "ERROR: cannot scan file "
+                        << files[i].toStdString() << " ("
+                        << errors[i].toStdString() << "); skipping file.");
+    }
+}
+
+
 void MAbstractDataReader::deleteFileScanProgressDialog()
 {
     if (fileScanProgressDialogList.last() != nullptr)
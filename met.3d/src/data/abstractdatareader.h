@@ -27,9 +27,12 @@
 #define ABSTRACTDATAREADER_H
 
 // standard library imports
+#include <exception>
+#include <functional>
 
 // related third party imports
 #include <QtCore>
+#include <QtConcurrentRun>
 #include <QProgressDialog>
 
 // local application imports
@@ -91,6 +94,12 @@ public:
      */
     int getEnsembleMemberIDFromFileName(QString fileName);
 
+    /**
+      Returns the latest modification time of the files found by the last
+      call to @ref getAvailableFilesFromFilters().
+     */
+    QDateTime getDataRootLastModified() { return dataRootLastModified; }
+
 protected:
     /**
      Scans the data root directory to determine which data is available. This
@@ -128,9 +137,78 @@ protected:
      */
     void deleteFileScanProgressDialog();
 
+    /**
+      Parallel per-file phase of @ref scanDataRoot(): calls @p scanFile for
+      each of @p files on the global thread pool and returns the results in
+      the order of @p files. Derived classes merge the results serially into
+      their catalogue of available data, hence the catalogue does not depend
+      on the order in which the files have been scanned.
+
+      The calling thread waits for the files in the order of @p files and
+      advances the progress dialog created with @ref
+      initializeFileScanProgressDialog() by one step per file.
+
+      Exceptions thrown by @p scanFile are caught per file; the result of
+      such a file is left default-constructed and the error is logged once
+      all files have been scanned (see @ref logFileScanErrors()).
+
+      @note @p scanFile is called concurrently; it must not modify the
+      reader's catalogue and must only access members that are thread-safe.
+     */
+    template<typename T> QVector<T> scanFilesConcurrently(
+            const QStringList& files,
+            std::function<T(const QString&)> scanFile)
+    {
+        QVector<T> results(files.size());
+        QVector<QString> errors(files.size());
+        T *resultData = results.data();
+        QString *errorData = errors.data();
+
+        QList< QFuture<void> > futures;
+        for (int i = 0; i < files.size(); i++)
+        {
+            futures << QtConcurrent::run([&, i]()
+            {
+                // Exceptions must not escape into the thread pool.
+                try
+                {
+                    resultData[i] = scanFile(files.at(i));
+                }
+                catch (std::exception &e)
+                {
+                    errorData[i] = QString::fromStdString(e.what());
+                }
+                catch (...)
+                {
+                    errorData[i] = "unknown exception";
+                }
+            });
+        }
+
+        // waitForFinished() blocks until the file has been scanned, or scans
+        // it in the calling thread if the pool has not started it yet.
+        for (int i = 0; i < futures.size(); i++)
+        {
+            futures[i].waitForFinished();
+            updateFileScanProgressDialog();
+        }
+
+        logFileScanErrors(files, errors);
+
+        return results;
+    }
+
+    /**
+      Logs the non-empty entries of @p errors, which contains one error
+      message per file in @p files (see @ref scanFilesConcurrently()).
+     */
+    void logFileScanErrors(const QStringList& files,
+                           const QVector<QString>& errors);
+
     QString identifier;
     QDir dataRoot;
     QString dirFileFilters;
+    QDateTime dataRootLastModified;
 
     /** Global NetCDF access mutex, as the NetCDF (C++) library is not
         thread-safe (notes Feb2015). This mutex must be used to protect
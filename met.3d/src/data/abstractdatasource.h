@@ -87,6 +87,15 @@ public:
      */
     virtual const QStringList& requiredKeys() = 0;
 
+    /**
+      Returns a string that identifies the input files of the data produced
+      by this source: data root, file filter and latest file modification
+      time of all data readers upstream in the pipeline. Used to key
+      persistent caches (see @ref MPersistentDataCache). An empty string is
+      returned if the source does not depend on any data files.
+     */
+    virtual QString dataSignature() = 0;
+
 signals:
     /**
      Emitted when a data request issued with @ref requestData() has completed.
@@ -455,7 +455,6 @@ void MClimateForecastReader::scanDataRoot()
     getAvailableFilesFromFilters(availableFiles);
 
     ensembleIDIsSpecifiedInFileName = dirFileFilters.contains("%m");
-    int  ensembleIDFromFile = -1;
 
     QMap<QString, MNcVarDimensionInfo> auxiliaryVarsDimensionsInfo;
 
@@ -472,552 +471,324 @@ void MClimateForecastReader::scanDataRoot()
     // cleared when starting to read a new file.
     QMap<MVerticalLevelType, QMap<QString, bool>> checkedVariables;
 
+    // Files that have not been modified since they have been scanned last
+    // are not opened; their variables are taken from the catalogue cache.
+    // Datasets in the same data root that are configured differently use
+    // different cache files.
+    QString catalogueCachePath = dataRoot.filePath(
+                QString(".met3d_cf_catalogue_%1").arg(
+                    QString(catalogueCacheConfiguration().toHex().left(16))));
+    MNcCatalogueCache catalogueCache;
+    if (QFile::exists(catalogueCachePath))
+    {
+        readCatalogueCache(catalogueCachePath, &catalogueCache);
+    }
+
     // Create and initialise progress bar.
     initializeFileScanProgressDialog(availableFiles.size());
 
-    // For each file, open the file and extract information about the contained
-    // variables and forecast valid times.
-    foreach (QString fileName, availableFiles)
+    // For each file, open the file and extract information about the
+    // contained variables and forecast valid times.
+    QVector<MNcFileScanResult> scanResults =
+            scanFilesConcurrently<MNcFileScanResult>(
+                availableFiles, [this, &catalogueCache](const QString& fileName)
     {
-        updateFileScanProgressDialog();
-        LOG4CPLUS_DEBUG(mlog, "\t** Parsing file "
-                        << fileName.toStdString() << " .." << flush);
-
-        checkedVariables.clear();
+        return scanNetCDFFile(fileName, catalogueCache);
+    });
 
-        // NetCDF library is not thread-safe (at least the regular C/C++
-        // interface is not; hence all NetCDF calls need to be serialized
-        // globally in Met.3D! (notes Feb2015).
-        QMutexLocker ncAccessMutexLocker(&staticNetCDFAccessMutex);
+    deleteFileScanProgressDialog();
 
-        // Open the file.
-        NcFile *ncFile;
-        try
+    // Update the catalogue cache with the files that have been scanned, and
+    // remove entries of files that do not exist anymore. (Entries of files
+    // that exist but do not match the file filter are kept, they may be
+    // used by other datasets in the same data root.)
+    int numCachedFiles = 0;
+    bool catalogueCacheModified = false;
+    for (int i = 0; i < availableFiles.size(); i++)
+    {
+        if (scanResults[i].isFromCache)
         {
-            ncFile = new NcFile(dataRoot.filePath(fileName).toStdString(),
-                                NcFile::read);
+            numCachedFiles++;
         }
-        catch (NcException& e)
+        else if (scanResults[i].isValid)
         {
-            LOG4CPLUS_ERROR(mlog, "ERROR: cannot open the file \""
-                            << fileName.toStdString()
-                            << "\".." << flush);
-            continue;
+            catalogueCache.insert(availableFiles[i], scanResults[i]);
+            catalogueCacheModified = true;
         }
-
-        multimap<string, NcVar> ncVariables = ncFile->getVars();
-
-        if (ensembleIDIsSpecifiedInFileName)
+        else if (catalogueCache.remove(availableFiles[i]) > 0)
         {
-            ensembleIDFromFile = getEnsembleMemberIDFromFileName(fileName);
-
-            if (ensembleIDFromFile == -1)
-            {
-                LOG4CPLUS_ERROR(mlog, "ERROR: ensemble tag found in file filter "
-                                      " but filter did not match file \""
-                                << fileName.toStdString()
-                                << "\" (currently only integer values are allowed"
-                                   " as ensemble member specifiers)." << flush);
-                continue;
-            }
+            catalogueCacheModified = true;
         }
-
-        // Loop over all variables: Obtain available time values for each
-        // variable and insert the fields into "availableDataFields".
-        for (multimap<string, NcVar>::iterator var=ncVariables.begin();
-             var != ncVariables.end(); var++)
+    }
+    foreach (QString fileName, catalogueCache.keys())
+    {
+        if (!QFile::exists(dataRoot.filePath(fileName)))
         {
-            QString varName = QString::fromStdString(var->first);
+            catalogueCache.remove(fileName);
+            catalogueCacheModified = true;
+        }
+    }
 
-            LOG4CPLUS_DEBUG(mlog, "\t**** Checking variable <"
-                            << varName.toStdString() << "> ...");
-            if ( NcCFVar::isCFDataVariable(
-                     ncFile->getVar(varName.toStdString()), NcCFVar::LAT_LON,
-                     treatRotatedGridAsRegularLonLatGrid,
-                     treatProjectedGridAsRegularLonLatGrid) )
-            {
-                // Get the NcVar object belonging to the variable and wrap
-                // it in a NcCFVar object.
-                NcCFVar currCFVar(ncFile->getVar(varName.toStdString()));
-
-                // Read the variable's long_name, standard_name and units
-                // attributes, if present. If they are not present, leave the
-                // corresponding variables empty.
-                string longname = "";
-                string standardname = "";
-                string units = "";
-                try { currCFVar.getAtt("long_name").getValues(longname); }
-                catch (std::exception &NcException) {}
-                try { currCFVar.getAtt("standard_name").getValues(standardname); }
-                catch (std::exception &NcException) {}
-                try { currCFVar.getAtt("units").getValues(units); }
-                catch (std::exception &NcException) {}
+    LOG4CPLUS_DEBUG(mlog, numCachedFiles << " of " << availableFiles.size()
+                    << " files have been read from the catalogue cache.");
 
-                // If no standard name is provided in the file, check if we
-                // can reconstruct the standard name from the
-                // "variableToStandardNameMap" table.
-                if (standardname == "")
-                {
-                    if (variableToStandardNameMap.contains(varName))
-                    {
-                        standardname = variableToStandardNameMap[
-                                varName].toStdString();
-                    }
-                    else
-                    {
-                        LOG4CPLUS_WARN(mlog,
-                                       "\tNOTE: no standard name and no mapping "
-                                       "from variable name to standard name "
-                                       "defined for <"
-                                       << varName.toStdString() << ">.");
-                    }
-                }
+    if (catalogueCacheModified)
+    {
+        writeCatalogueCache(catalogueCachePath, catalogueCache);
+    }
 
-                // Get time values of this variable.
-                QList<QDateTime> currTimeCoordValues;
-                try
-                {
-                    currTimeCoordValues = currCFVar.getTimeValues();
-                }
-                catch (std::exception &NcException)
-                {
-                    LOG4CPLUS_WARN(mlog, "WARNING: unable to identify valid "
-                                         "time values for variable <"
-                                   << varName.toStdString()
-                                   << "> -- skipping variable.");
-                    continue;
-                }
+    // Insert the variables of the files into "availableDataFields", in the
+    // order of the files.
+    for (int i = 0; i < availableFiles.size(); i++)
+    {
+        QString fileName = availableFiles[i];
+        MNcFileScanResult &fileResult = scanResults[i];
+        int ensembleIDFromFile = fileResult.ensembleIDFromFile;
 
-                // Determine init time from the CF variable.
-                QDateTime initTime;
-                try
-                {
-                    initTime = currCFVar.getBaseTime();
-                }
-                catch (std::exception &NcException)
-                {
-                    LOG4CPLUS_WARN(mlog, "WARNING: unable to identify "
-                                         "init/base time for variable <"
-                                   << varName.toStdString()
-                                   << ">  -- skipping variable.");
-                    continue;
-                }
+        checkedVariables.clear();
+
+        if (!fileResult.isValid) continue;
 
-                // Determine the type of the vertical level of the variable.
-                MVerticalLevelType levelType;
-                NcCFVar::NcVariableGridType gridType = currCFVar.getGridType(
-                            auxiliary3DPressureField,
-                            treatRotatedGridAsRegularLonLatGrid,
-                            treatProjectedGridAsRegularLonLatGrid,
-                            disableGridConsistencyCheck);
-
-                LOG4CPLUS_DEBUG(mlog, "\t--detected grid type: "
-                                << NcCFVar::ncVariableGridTypeToString(
-                                    gridType).toStdString()
-                                << (treatRotatedGridAsRegularLonLatGrid ?
-                                        " (with rotated lon/lat)" : "")
-                                << (treatProjectedGridAsRegularLonLatGrid ?
-                                        " (with projected x/y)" : ""));
-
-                int numLevels = -1;
-                switch (gridType)
+        for (int v = 0; v < fileResult.variables.size(); v++)
+        {
+            MNcVariableScanResult &varResult = fileResult.variables[v];
+            QString varName = varResult.variablename;
+            MVerticalLevelType levelType = varResult.levelType;
+
+            // Create a new MVariableInfo struct and store available
+            // variable information in this field.
+            MVariableInfo* vinfo;
+            if (availableDataFields[levelType].contains(varName))
+            {
+                // We need to check a variable for consistency only once per
+                // file since the geographical region parameters are shared
+                // in one file. Thus use the result of a previous check if
+                // present.
+                if (checkedVariables[levelType].contains(varName))
                 {
-                case NcCFVar::LAT_LON:
-                    levelType = SURFACE_2D;
-                    break;
-                case NcCFVar::LAT_LON_P:
-                    levelType = PRESSURE_LEVELS_3D;
-                    if (convertGeometricHeightToPressure_ICAOStandard)
+                    if (!checkedVariables[levelType][varName])
                     {
-                        LOG4CPLUS_WARN(mlog, "WARNING: variable <"
-                                       << varName.toStdString()
-                                       << "> is defined on a grid using vertical"
-                                          " pressure levels, and conversion of"
-                                          " geometric height to pressure"
-                                          " coordinates is enabled -- skipping"
-                                          " variable.");
                         continue;
                     }
-                    numLevels = currCFVar.getVerticalCoordinatePressure()
-                            .getDim(0).getSize();
-                    break;
-                case NcCFVar::LAT_LON_HYBRID:
-                    levelType = HYBRID_SIGMA_PRESSURE_3D;
-                {
-                    NcVar apVar, bVar;
-                    QString psName;
-                    numLevels = currCFVar.getVerticalCoordinateHybridSigmaPressure(
-                                &apVar, &bVar, &psName).getDim(0).getSize();
                 }
-                    break;
-                case NcCFVar::LAT_LON_PVU:
-                    levelType = POTENTIAL_VORTICITY_2D;
-                    numLevels = currCFVar.getVerticalCoordinatePotVort()
-                            .getDim(0).getSize();
-                    break;
-                case NcCFVar::LAT_LON_AUXP3D:
-                    levelType = AUXILIARY_PRESSURE_3D;
-                    break;
-                case NcCFVar::LAT_LON_Z:
-                    numLevels = currCFVar.getVerticalCoordinateGeometricHeight()
-                            .getDim(0).getSize();
-                    if (convertGeometricHeightToPressure_ICAOStandard)
-                    {
-                        levelType = PRESSURE_LEVELS_3D;
-                    }
-                    else if (numLevels != 1)
+                else
+                {
+                    bool consistent = checkSharedVariableDataConsistency(
+                                &sharedVariableInfos[levelType][varName],
+                                &varResult.sharedData,
+                                !ensembleIDIsSpecifiedInFileName);
+                    checkedVariables[levelType][varName] = consistent;
+                    if (!consistent)
                     {
-                        // If only a single vertical level is available, the
-                        // variable is interpreted as a surface field, see
-                        // below.
-                        LOG4CPLUS_WARN(mlog, "WARNING: variable <"
-                                       << varName.toStdString()
-                                       << "> is defined on a grid using vertical"
-                                          " geometric height levels, and"
-                                          " conversion to pressure coordinates is"
-                                          " disabled -- Met.3D can currently only"
-                                          " handle pressure coordinates internally;"
-                                          " skipping variable.");
+                        LOG4CPLUS_ERROR(
+                                    mlog,
+                                    "found different horizontal domain "
+                                    "than previously used for this "
+                                    "variable; skipping grids of variable '"
+                                    + varName.toStdString()
+                                    + "' found in file '"
+                                    + fileName.toStdString() + "'.");
                         continue;
                     }
-                    break;
-                default:
-                    // If neither of the above choices could be matched,
-                    // discard this variable and continue.
-                    LOG4CPLUS_WARN(mlog, "WARNING: variable <"
-                                   << varName.toStdString()
-                                   << "> is defined on a grid that Met.3D "
-                                      "currently does not understand -- skipping "
-                                      "variable.");
-                    continue;
-                    break;
                 }
-
-                // For 3D fields, check the number of available vertical
-                // levels. At least three vertical levels are required
-                // so that vertical interpolation does work - if only
-                // a single level is available, interpret the variable
-                // as a 2D variable.
-                // (check is enabled if numLevels > -1, see above).
-                if (numLevels >= 0)
+                vinfo = availableDataFields[levelType].value(varName);
+                if (ensembleIDIsSpecifiedInFileName)
                 {
-                    int minRequiredVerticalLevels = 3;
-                    if (numLevels == 1)
-                    {
-                        // Single level: Interpret as 2D field.
-                        LOG4CPLUS_WARN(mlog, "NOTE: variable <"
-                                       << varName.toStdString()
-                                       << "> has only a single vertical level;"
-                                          " it will be interpreted as a 2D"
-                                          " 'surface' field.");
-                        levelType = SURFACE_2D;
-                    }
-                    else if (numLevels < minRequiredVerticalLevels)
+                    vinfo->availableMembers.insert(ensembleIDFromFile);
+
+                    foreach (QDateTime validTime, varResult.validTimes) // in UTC!
                     {
-                        LOG4CPLUS_WARN(mlog, "WARNING: variable <"
-                                       << varName.toStdString()
-                                       << "> has only " << numLevels
-                                       << " vertical level(s); at least "
-                                       << minRequiredVerticalLevels
-                                       << " are required for vertical"
-                                          " interpolation to work -- skipping"
-                                          " variable.");
-                        continue;
-                    }
+                        MDatafieldInfo info;
+                        info.filename = fileName;
+                        vinfo->timeMap[varResult.initTime][validTime]
+                                [ensembleIDFromFile] = info;
+                    } // for (valid times)
                 }
+            }
+            else
+            {
+                vinfo = new MVariableInfo;
+                vinfo->longname        = varResult.longname;
+                vinfo->standardname    = varResult.standardname;
+                vinfo->units           = varResult.units;
+                vinfo->variablename    = varName;
 
-                // Create a new MVariableInfo struct and store available
-                // variable information in this field.
-                MVariableInfo* vinfo;
-                if (availableDataFields[levelType].contains(varName))
+                if (levelType == HYBRID_SIGMA_PRESSURE_3D)
                 {
-                    // We need to check a variable for consistency only once per
-                    // file since the geographical region parameters are shared
-                    // in one file. Thus use the result of a previous check if
-                    // present.
-                    if (checkedVariables[levelType].contains(varName))
-                    {
-                        if (!checkedVariables[levelType][varName])
-                        {
-                            continue;
-                        }
-                    }
-                    else
+                    vinfo->surfacePressureName = varResult.surfacePressureName;
+                }
+
+                if (levelType == AUXILIARY_PRESSURE_3D)
+                {
+                    vinfo->auxiliaryPressureName =
+                            varResult.auxiliaryPressureName;
+
+                    // Auxiliary pressure field could be stored in a different
+                    // file, thus it is necessary to perform a check after
+                    // reading all the files whether this variable is
+                    // really an auxiliary pressure variable. (Dimensions
+                    // must match the dimensions of the auxiliary 3D
+                    // pressure field).
+                    if (varResult.auxiliaryPressureVarIsNull)
                     {
-                        bool consistent = checkSharedVariableDataConsistency(
-                                    &sharedVariableInfos[levelType][varName],
-                                    &currCFVar, levelType, false,
-                                    !ensembleIDIsSpecifiedInFileName);
-                        checkedVariables[levelType][varName] = consistent;
-                        if (!consistent)
+                        // Store dimension information (names, sizes) for
+                        // variables detected as auxiliary pressure variable
+                        // but not checked yet since the auxiliary pressure
+                        // field could be stored in a different file. The check
+                        // is performed after all files have been read.
+                        if (!auxiliaryVarsDimensionsInfo.contains(varName))
                         {
-                            LOG4CPLUS_ERROR(
-                                        mlog,
-                                        "found different horizontal domain "
-                                        "than previously used for this "
-                                        "variable; skipping grids of variable '"
-                                        + varName.toStdString()
-                                        + "' found in file '"
-                                        + fileName.toStdString() + "'.");
-                            continue;
+                            MNcVarDimensionInfo varDimensionsInfo =
+                                    auxiliaryVarsDimensionsInfo[varName];
+                            varDimensionsInfo.names
+                                    << varResult.dimensionsInfo.names;
+                            varDimensionsInfo.sizes
+                                    << varResult.dimensionsInfo.sizes;
                         }
                     }
-                    vinfo = availableDataFields[levelType].value(varName);
-                    if (ensembleIDIsSpecifiedInFileName)
-                    {
-                        vinfo->availableMembers.insert(ensembleIDFromFile);
+                }
 
-                        foreach (QDateTime validTime, currTimeCoordValues) // in UTC!
-                        {
-                            MDatafieldInfo info;
-                            info.filename = fileName;
-                            vinfo->timeMap[initTime][validTime][ensembleIDFromFile]
-                                    = info;
-                        } // for (valid times)
-                    }
+
+                if (ensembleIDIsSpecifiedInFileName)
+                {
+                    vinfo->availableMembers.insert(ensembleIDFromFile);
                 }
                 else
                 {
-                    vinfo = new MVariableInfo;
-                    vinfo->longname        = QString::fromStdString(longname);
-                    vinfo->standardname    = QString::fromStdString(standardname);
-                    vinfo->units           = QString::fromStdString(units);
-                    vinfo->variablename    = varName;
-
-                    if (levelType == HYBRID_SIGMA_PRESSURE_3D)
+                    // Check if the variable has an ensemble dimension.
+                    if (varResult.hasEnsembleDimension)
                     {
-                        NcVar vertVar, apVar, bVar;
-                        QString psName;
-                        vertVar = currCFVar.getVerticalCoordinateHybridSigmaPressure(
-                                    &apVar, &bVar, &psName);
-                        vinfo->surfacePressureName = psName;
+                        // If yes, get the available ensemble members.
+                        vinfo->availableMembers =
+                                varResult.sharedData.availableMembers;
                     }
-
-                    if (levelType == AUXILIARY_PRESSURE_3D)
+                    else
                     {
-                        QString pressureName;
-                        int lvlIndex;
-                        NcVar pressureVar =
-                                currCFVar.getVerticalCoordinateAuxiliaryPressure(
-                                    auxiliary3DPressureField, &pressureName,
-                                    &lvlIndex, disableGridConsistencyCheck);
-                        vinfo->auxiliaryPressureName = pressureName;
-
-                        // Auxiliary pressure field could be stored in a different
-                        // file, thus it is necessary to perform a check after
-                        // reading all the files whether this variable is
-                        // really an auxiliary pressure variable. (Dimensions
-                        // must match the dimensions of the auxiliary 3D
-                        // pressure field).
-                        if (pressureVar.isNull())
-                        {
-                            // Store dimension information (names, sizes) for
-                            // variables detected as auxiliary pressure variable
-                            // but not checked yet since the auxiliary pressure
-                            // field could be stored in a different file. The check
-                            // is performed after all files have been read.
-                            if (!auxiliaryVarsDimensionsInfo.contains(varName))
-                            {
-                                MNcVarDimensionInfo varDimensionsInfo =
-                                        auxiliaryVarsDimensionsInfo[varName];
-                                for (int j = 0; j < currCFVar.getDimCount(); j++)
-                                {
-                                    QString dimName = QString::fromStdString(
-                                                currCFVar.getDim(j).getName());
-                                    varDimensionsInfo.names << dimName;
-                                    varDimensionsInfo.sizes
-                                            << int(currCFVar.getDim(j).getSize());
-                                }
-                            }
-                        }
+                        // No ensemble dimension could be found. List the
+                        // available data field as the "0" member.
+                        vinfo->availableMembers.insert(0);
                     }
+                }
 
+                vinfo->horizontalGridType = varResult.horizontalGridType;
 
-                    if (ensembleIDIsSpecifiedInFileName)
+                // Initialise shared data of variable for consistency check.
+                sharedVariableInfos[levelType][varName] = varResult.sharedData;
+
+                if (!disableGridConsistencyCheck)
+                {
+                    QString refVarName = "";
+                    bool check = true;
+                    // Initialise shared lons and lats. This also means it
+                    // is the first variable to be found.
+                    if (sharedLons.isEmpty())
                     {
-                        vinfo->availableMembers.insert(ensembleIDFromFile);
+                        sharedLons =
+                                sharedVariableInfos[levelType][varName]
+                                .lons;
+                        sharedLats =
+                                sharedVariableInfos[levelType][varName]
+                                .lats;
+                        sharedLonLatReferenceVarName = varName;
                     }
                     else
                     {
-                        // Check if the variable has an ensemble dimension.
-                        if (currCFVar.hasEnsembleDimension())
+                        // Only check consistency with level type
+                        // specific values if there exists another
+                        // variable of the same level type.
+                        if (sharedVariableInfos[levelType].values()
+                                .size() > 1)
                         {
-                            // If yes, get the available ensemble members.
-                            vinfo->availableMembers =
-                                    currCFVar.getEnsembleMembers();
+                            // Get the name of the reference variable.
+                            QStringList varNames =
+                                    sharedVariableInfos[levelType].keys();
+                            refVarName = varNames.at(0);
+                            // Don't use the variable itself as reference.
+                            if (refVarName == varName)
+                            {
+                                refVarName = varNames.at(1);
+                            }
+                            check = checkSharedVariableDataConsistency(
+                                        &sharedVariableInfos[levelType]
+                                        [refVarName], &varResult.sharedData,
+                                        false);
                         }
                         else
                         {
-                            // No ensemble dimension could be found. List the
-                            // available data field as the "0" member.
-                            vinfo->availableMembers.insert(0);
+                            check = (sharedLons
+                                     == sharedVariableInfos[levelType]
+                                    [varName].lons)
+                                    && (sharedLats
+                                        == sharedVariableInfos[levelType]
+                                    [varName].lats);
+
+                            if (!check)
+                            {
+                                LOG4CPLUS_ERROR(
+                                            mlog,
+                                            "detected inconsistency in"
+                                            " 'longitudes' or 'latitudes'.");
+                                refVarName = sharedLonLatReferenceVarName;
+                                check = false;
+                            }
                         }
                     }
 
-                    // Check horizontal grid type. Default grid: regular lat-lon.
-                    vinfo->horizontalGridType = MHorizontalGridType::REGULAR_LONLAT_GRID;
-
-                    // Change grid type to ROTATED_REGULAR_LONLAT_GRID or
-                    // PROJECTED_REGULAR_GRID if the data is defined on one
-                    // of these grids.
-                    if (NcCFVar::isDefinedOnRotatedGrid(
-                                ncFile->getVar(varName.toStdString())))
+                    if (!check)
                     {
-                        vinfo->horizontalGridType =
-                                MHorizontalGridType::REGULAR_ROTATED_LONLAT_GRID;
-                    }
-                    if (NcCFVar::isDefinedOnProjectedGrid(
-                                ncFile->getVar(varName.toStdString())))
-                    {
-                        vinfo->horizontalGridType =
-                                MHorizontalGridType::REGULAR_PROJECTED_GRID;
-                    }
-
-                    // Initialise shared data of variable for consistency check.
-                    checkSharedVariableDataConsistency(
-                                &sharedVariableInfos[levelType][varName],
-                                &currCFVar, levelType, true, false);
-
-                    if (!disableGridConsistencyCheck)
-                    {
-                        QString refVarName = "";
-                        bool check = true;
-                        // Initialise shared lons and lats. This also means it
-                        // is the first variable to be found.
-                        if (sharedLons.isEmpty())
-                        {
-                            sharedLons =
-                                    sharedVariableInfos[levelType][varName]
-                                    .lons;
-                            sharedLats =
-                                    sharedVariableInfos[levelType][varName]
-                                    .lats;
-                            sharedLonLatReferenceVarName = varName;
-                        }
-                        else
-                        {
-                            // Only check consistency with level type
-                            // specific values if there exists another
-                            // variable of the same level type.
-                            if (sharedVariableInfos[levelType].values()
-                                    .size() > 1)
-                            {
-                                // Get the name of the reference variable.
-                                QStringList varNames =
-                                        sharedVariableInfos[levelType].keys();
-                                refVarName = varNames.at(0);
-                                // Don't use the variable itself as reference.
-                                if (refVarName == varName)
-                                {
-                                    refVarName = varNames.at(1);
-                                }
-                                check = checkSharedVariableDataConsistency(
-                                            &sharedVariableInfos[levelType]
-                                            [refVarName], &currCFVar,
-                                            levelType, false, false);
-                            }
-                            else
-                            {
-                                check = (sharedLons
-                                         == sharedVariableInfos[levelType]
-                                        [varName].lons)
-                                        && (sharedLats
-                                            == sharedVariableInfos[levelType]
-                                        [varName].lats);
-
-                                if (!check)
-                                {
-                                    LOG4CPLUS_ERROR(
-                                                mlog,
-                                                "detected inconsistency in"
-                                                " 'longitudes' or 'latitudes'.");
-                                    refVarName = sharedLonLatReferenceVarName;
-                                    check = false;
-                                }
-                            }
-                        }
+                        LOG4CPLUS_ERROR(
+                                    mlog,
+                                    "WARNING: "
+                                    "found difference to reference variable"
+                                    " '" + refVarName.toStdString()
+                                    + "'; skipping grids of variable '"
+                                    + varName.toStdString()
+                                    + "' found in file '"
+                                    + fileName.toStdString() + "'."
+                                    + " [Dataset: "
+                                    + getIdentifier().toStdString() + "]");
+                        checkedVariables[levelType][varName] = false;
 
-                        if (!check)
-                        {
-                            LOG4CPLUS_ERROR(
-                                        mlog,
-                                        "WARNING: "
-                                        "found difference to reference variable"
-                                        " '" + refVarName.toStdString()
-                                        + "'; skipping grids of variable '"
-                                        + varName.toStdString()
-                                        + "' found in file '"
-                                        + fileName.toStdString() + "'."
-                                        + " [Dataset: "
-                                        + getIdentifier().toStdString() + "]");
-                            checkedVariables[levelType][varName] = false;
-
-                            delete vinfo;
-                            continue;
-                        }
+                        delete vinfo;
+                        continue;
                     }
-
-                    checkedVariables[levelType][varName] = true;
                 }
 
-                unsigned int ensMem;
-                if (ensembleIDIsSpecifiedInFileName)
-                {
-                    ensMem = ensembleIDFromFile;
-                }
-                else
-                {
-                    // If ensemble members are all stored in one file, use 0 to
-                    // represent them to avoid redundant informations stored.
-                    ensMem = 0;
-                }
+                checkedVariables[levelType][varName] = true;
+            }
 
-                foreach (QDateTime validTime, currTimeCoordValues) // in UTC!
-                {
-                    MDatafieldInfo info;
-                    info.filename = fileName;
-                    vinfo->timeMap[initTime][validTime][ensMem] = info;
-
-//                        cout << "\t"  << filedomain.toStdString()
-//                             << "  "  << varName.toStdString()
-//                             << "  (" << verticalLevelTypeToString(levelType).toStdString()
-//                             << ")  " << initTime.toString(Qt::ISODate).toStdString()
-//                             << "  "  << validTime.toString(Qt::ISODate).toStdString()
-//                             << "  "  << ((vinfo->numEnsembleMembers > 0) ?
-//                                              QString("-- ensemble members: %1")
-//                                              .arg(vinfo->numEnsembleMembers)
-//                                              .toStdString()
-//                                            : "")
-//                             << "\n";
-
-                } // for (valid times)
-
-
-                // Insert the new MVariableInfo struct into the variable name
-                // map..
-                availableDataFields[levelType].insert(
-                            vinfo->variablename, vinfo);
-                // ..and, if a CF standard name is available, into the std
-                // name map.
-                if (standardname != "")
-                    availableDataFieldsByStdName[levelType].insert(
-                                vinfo->standardname, vinfo);
-
-            } // if (is CF variable)
+            unsigned int ensMem;
+            if (ensembleIDIsSpecifiedInFileName)
+            {
+                ensMem = ensembleIDFromFile;
+            }
             else
             {
-                LOG4CPLUS_DEBUG(mlog, "\tvariable <"
-                                << varName.toStdString()
-                                << "> is not a gridded data field that "
-                                   "corresponds to the dataset configuration "
-                                   "-- skipping as gridded data field.");
+                // If ensemble members are all stored in one file, use 0 to
+                // represent them to avoid redundant informations stored.
+                ensMem = 0;
             }
-        } // for (variables)
 
-        delete ncFile;
+            foreach (QDateTime validTime, varResult.validTimes) // in UTC!
+            {
+                MDatafieldInfo info;
+                info.filename = fileName;
+                vinfo->timeMap[varResult.initTime][validTime][ensMem] = info;
+            } // for (valid times)
+
+
+            // Insert the new MVariableInfo struct into the variable name
+            // map..
+            availableDataFields[levelType].insert(
+                        vinfo->variablename, vinfo);
+            // ..and, if a CF standard name is available, into the std
+            // name map.
+            if (varResult.standardname != "")
+                availableDataFieldsByStdName[levelType].insert(
+                            vinfo->standardname, vinfo);
+        } // for (variables)
     } // for (files)
 
-    deleteFileScanProgressDialog();
 
     // Some auxiliary pressure variables might NOT have been checked yet if
     // their dimensions match the dimensions of auxiliary pressure field (i.e.
@@ -1103,12 +874,393 @@ void MClimateForecastReader::scanDataRoot()
 }
 
 
+MNcFileScanResult MClimateForecastReader::scanNetCDFFile(
+        const QString &fileName, const MNcCatalogueCache &catalogueCache)
+{
+    MNcFileScanResult result;
+
+    LOG4CPLUS_DEBUG(mlog, "\t** Parsing file "
+                    << fileName.toStdString() << " .." << flush);
+
+    if (ensembleIDIsSpecifiedInFileName)
+    {
+        result.ensembleIDFromFile = getEnsembleMemberIDFromFileName(fileName);
+
+        if (result.ensembleIDFromFile == -1)
+        {
+            LOG4CPLUS_ERROR(mlog, "ERROR: ensemble tag found in file filter "
+                                  " but filter did not match file \""
+                            << fileName.toStdString()
+                            << "\" (currently only integer values are allowed"
+                               " as ensemble member specifiers)." << flush);
+            return result;
+        }
+    }
+
+    // Use the entry of the catalogue cache if the file has not been modified
+    // since it has been scanned.
+    QFileInfo fileInfo(dataRoot.filePath(fileName));
+    qint64 fileSize = fileInfo.size();
+    qint64 lastModified = fileInfo.lastModified().toMSecsSinceEpoch();
+
+    MNcCatalogueCache::const_iterator cachedResult =
+            catalogueCache.constFind(fileName);
+    if (cachedResult != catalogueCache.constEnd()
+            && cachedResult->fileSize == fileSize
+            && cachedResult->lastModified == lastModified)
+    {
+        int ensembleIDFromFile = result.ensembleIDFromFile;
+        result = cachedResult.value();
+        result.ensembleIDFromFile = ensembleIDFromFile;
+        result.isFromCache = true;
+        return result;
+    }
+
+    result.fileSize = fileSize;
+    result.lastModified = lastModified;
+
+    // NetCDF library is not thread-safe (at least the regular C/C++
+    // interface is not; hence all NetCDF calls need to be serialized
+    // globally in Met.3D! (notes Feb2015).
+    QMutexLocker ncAccessMutexLocker(&staticNetCDFAccessMutex);
+
+    // Open the file.
+    NcFile *ncFile;
+    try
+    {
+        ncFile = new NcFile(dataRoot.filePath(fileName).toStdString(),
+                            NcFile::read);
+    }
+    catch (NcException& e)
+    {
+        LOG4CPLUS_ERROR(mlog, "ERROR: cannot open the file \""
+                        << fileName.toStdString()
+                        << "\".." << flush);
+        return result;
+    }
+
+    multimap<string, NcVar> ncVariables = ncFile->getVars();
+
+    // Loop over all variables: Obtain available time values and the shared
+    // data of each gridded data variable.
+    for (multimap<string, NcVar>::iterator var=ncVariables.begin();
+         var != ncVariables.end(); var++)
+    {
+        QString varName = QString::fromStdString(var->first);
+
+        LOG4CPLUS_DEBUG(mlog, "\t**** Checking variable <"
+                        << varName.toStdString() << "> ...");
+        if ( !NcCFVar::isCFDataVariable(
+                 ncFile->getVar(varName.toStdString()), NcCFVar::LAT_LON,
+                 treatRotatedGridAsRegularLonLatGrid,
+                 treatProjectedGridAsRegularLonLatGrid) )
+        {
+            LOG4CPLUS_DEBUG(mlog, "\tvariable <"
+                            << varName.toStdString()
+                            << "> is not a gridded data field that "
+                               "corresponds to the dataset configuration "
+                               "-- skipping as gridded data field.");
+            continue;
+        }
+
+        try
+        {
+            MNcVariableScanResult varResult;
+            if (scanNetCDFVariable(ncFile, varName, &varResult))
+            {
+                result.variables << varResult;
+            }
+        }
+        catch (std::exception &NcException)
+        {
+            LOG4CPLUS_ERROR(mlog, "ERROR: cannot read variable <"
+                            << varName.toStdString() << "> of file \""
+                            << fileName.toStdString()
+                            << "\" -- skipping variable.");
+        }
+    } // for (variables)
+
+    delete ncFile;
+
+    result.isValid = true;
+    return result;
+}
+
+
+bool MClimateForecastReader::scanNetCDFVariable(
+        NcFile *ncFile, const QString &varName,
+        MNcVariableScanResult *varResult)
+{
+    // Get the NcVar object belonging to the variable and wrap
+    // it in a NcCFVar object.
+    NcCFVar currCFVar(ncFile->getVar(varName.toStdString()));
+
+    // Read the variable's long_name, standard_name and units
+    // attributes, if present. If they are not present, leave the
+    // corresponding variables empty.
+    string longname = "";
+    string standardname = "";
+    string units = "";
+    try { currCFVar.getAtt("long_name").getValues(longname); }
+    catch (std::exception &NcException) {}
+    try { currCFVar.getAtt("standard_name").getValues(standardname); }
+    catch (std::exception &NcException) {}
+    try { currCFVar.getAtt("units").getValues(units); }
+    catch (std::exception &NcException) {}
+
+    // If no standard name is provided in the file, check if we
+    // can reconstruct the standard name from the
+    // "variableToStandardNameMap" table.
+    if (standardname == "")
+    {
+        if (variableToStandardNameMap.contains(varName))
+        {
+            standardname = variableToStandardNameMap.value(
+                    varName).toStdString();
+        }
+        else
+        {
+            LOG4CPLUS_WARN(mlog,
+                           "\tNOTE: no standard name and no mapping "
+                           "from variable name to standard name "
+                           "defined for <"
+                           << varName.toStdString() << ">.");
+        }
+    }
+
+    // Get time values of this variable.
+    QList<QDateTime> currTimeCoordValues;
+    try
+    {
+        currTimeCoordValues = currCFVar.getTimeValues();
+    }
+    catch (std::exception &NcException)
+    {
+        LOG4CPLUS_WARN(mlog, "WARNING: unable to identify valid "
+                             "time values for variable <"
+                       << varName.toStdString()
+                       << "> -- skipping variable.");
+        return false;
+    }
+
+    // Determine init time from the CF variable.
+    QDateTime initTime;
+    try
+    {
+        initTime = currCFVar.getBaseTime();
+    }
+    catch (std::exception &NcException)
+    {
+        LOG4CPLUS_WARN(mlog, "WARNING: unable to identify "
+                             "init/base time for variable <"
+                       << varName.toStdString()
+                       << ">  -- skipping variable.");
+        return false;
+    }
+
+    // Determine the type of the vertical level of the variable.
+    MVerticalLevelType levelType;
+    NcCFVar::NcVariableGridType gridType = currCFVar.getGridType(
+                auxiliary3DPressureField,
+                treatRotatedGridAsRegularLonLatGrid,
+                treatProjectedGridAsRegularLonLatGrid,
+                disableGridConsistencyCheck);
+
+    LOG4CPLUS_DEBUG(mlog, "\t--detected grid type: "
+                    << NcCFVar::ncVariableGridTypeToString(
+                        gridType).toStdString()
+                    << (treatRotatedGridAsRegularLonLatGrid ?
+                            " (with rotated lon/lat)" : "")
+                    << (treatProjectedGridAsRegularLonLatGrid ?
+                            " (with projected x/y)" : ""));
+
+    int numLevels = -1;
+    switch (gridType)
+    {
+    case NcCFVar::LAT_LON:
+        levelType = SURFACE_2D;
+        break;
+    case NcCFVar::LAT_LON_P:
+        levelType = PRESSURE_LEVELS_3D;
+        if (convertGeometricHeightToPressure_ICAOStandard)
+        {
+            LOG4CPLUS_WARN(mlog, "WARNING: variable <"
+                           << varName.toStdString()
+                           << "> is defined on a grid using vertical"
+                              " pressure levels, and conversion of"
+                              " geometric height to pressure"
+                              " coordinates is enabled -- skipping"
+                              " variable.");
+            return false;
+        }
+        numLevels = currCFVar.getVerticalCoordinatePressure()
+                .getDim(0).getSize();
+        break;
+    case NcCFVar::LAT_LON_HYBRID:
+        levelType = HYBRID_SIGMA_PRESSURE_3D;
+    {
+        NcVar apVar, bVar;
+        QString psName;
+        numLevels = currCFVar.getVerticalCoordinateHybridSigmaPressure(
+                    &apVar, &bVar, &psName).getDim(0).getSize();
+    }
+        break;
+    case NcCFVar::LAT_LON_PVU:
+        levelType = POTENTIAL_VORTICITY_2D;
+        numLevels = currCFVar.getVerticalCoordinatePotVort()
+                .getDim(0).getSize();
+        break;
+    case NcCFVar::LAT_LON_AUXP3D:
+        levelType = AUXILIARY_PRESSURE_3D;
+        break;
+    case NcCFVar::LAT_LON_Z:
+        numLevels = currCFVar.getVerticalCoordinateGeometricHeight()
+                .getDim(0).getSize();
+        if (convertGeometricHeightToPressure_ICAOStandard)
+        {
+            levelType = PRESSURE_LEVELS_3D;
+        }
+        else if (numLevels != 1)
+        {
+            // If only a single vertical level is available, the
+            // variable is interpreted as a surface field, see
+            // below.
+            LOG4CPLUS_WARN(mlog, "WARNING: variable <"
+                           << varName.toStdString()
+                           << "> is defined on a grid using vertical"
+                              " geometric height levels, and"
+                              " conversion to pressure coordinates is"
+                              " disabled -- Met.3D can currently only"
+                              " handle pressure coordinates internally;"
+                              " skipping variable.");
+            return false;
+        }
+        break;
+    default:
+        // If neither of the above choices could be matched,
+        // discard this variable and continue.
+        LOG4CPLUS_WARN(mlog, "WARNING: variable <"
+                       << varName.toStdString()
+                       << "> is defined on a grid that Met.3D "
+                          "currently does not understand -- skipping "
+                          "variable.");
+        return false;
+    }
+
+    // For 3D fields, check the number of available vertical
+    // levels. At least three vertical levels are required
+    // so that vertical interpolation does work - if only
+    // a single level is available, interpret the variable
+    // as a 2D variable.
+    // (check is enabled if numLevels > -1, see above).
+    if (numLevels >= 0)
+    {
+        int minRequiredVerticalLevels = 3;
+        if (numLevels == 1)
+        {
+            // Single level: Interpret as 2D field.
+            LOG4CPLUS_WARN(mlog, "NOTE: variable <"
+                           << varName.toStdString()
+                           << "> has only a single vertical level;"
+                              " it will be interpreted as a 2D"
+                              " 'surface' field.");
+            levelType = SURFACE_2D;
+        }
+        else if (numLevels < minRequiredVerticalLevels)
+        {
+            LOG4CPLUS_WARN(mlog, "WARNING: variable <"
+                           << varName.toStdString()
+                           << "> has only " << numLevels
+                           << " vertical level(s); at least "
+                           << minRequiredVerticalLevels
+                           << " are required for vertical"
+                              " interpolation to work -- skipping"
+                              " variable.");
+            return false;
+        }
+    }
+
+    varResult->variablename = varName;
+    varResult->levelType    = levelType;
+    varResult->longname     = QString::fromStdString(longname);
+    varResult->standardname = QString::fromStdString(standardname);
+    varResult->units        = QString::fromStdString(units);
+    varResult->initTime     = initTime;
+    varResult->validTimes   = currTimeCoordValues;
+
+    if (levelType == HYBRID_SIGMA_PRESSURE_3D)
+    {
+        NcVar vertVar, apVar, bVar;
+        QString psName;
+        vertVar = currCFVar.getVerticalCoordinateHybridSigmaPressure(
+                    &apVar, &bVar, &psName);
+        varResult->surfacePressureName = psName;
+    }
+
+    varResult->auxiliaryPressureVarIsNull = false;
+    if (levelType == AUXILIARY_PRESSURE_3D)
+    {
+        QString pressureName;
+        int lvlIndex;
+        NcVar pressureVar =
+                currCFVar.getVerticalCoordinateAuxiliaryPressure(
+                    auxiliary3DPressureField, &pressureName,
+                    &lvlIndex, disableGridConsistencyCheck);
+        varResult->auxiliaryPressureName = pressureName;
+
+        // Auxiliary pressure field could be stored in a different file,
+        // thus store the dimensions of the variable for the check
+        // performed after all files have been scanned.
+        if (pressureVar.isNull())
+        {
+            varResult->auxiliaryPressureVarIsNull = true;
+            for (int j = 0; j < currCFVar.getDimCount(); j++)
+            {
+                QString dimName = QString::fromStdString(
+                            currCFVar.getDim(j).getName());
+                varResult->dimensionsInfo.names << dimName;
+                varResult->dimensionsInfo.sizes
+                        << int(currCFVar.getDim(j).getSize());
+            }
+        }
+    }
+
+    // Check if the variable has an ensemble dimension.
+    varResult->hasEnsembleDimension = currCFVar.hasEnsembleDimension();
+
+    // Check horizontal grid type. Default grid: regular lat-lon.
+    varResult->horizontalGridType = MHorizontalGridType::REGULAR_LONLAT_GRID;
+
+    // Change grid type to ROTATED_REGULAR_LONLAT_GRID or
+    // PROJECTED_REGULAR_GRID if the data is defined on one
+    // of these grids.
+    if (NcCFVar::isDefinedOnRotatedGrid(
+                ncFile->getVar(varName.toStdString())))
+    {
+        varResult->horizontalGridType =
+                MHorizontalGridType::REGULAR_ROTATED_LONLAT_GRID;
+    }
+    if (NcCFVar::isDefinedOnProjectedGrid(
+                ncFile->getVar(varName.toStdString())))
+    {
+        varResult->horizontalGridType =
+                MHorizontalGridType::REGULAR_PROJECTED_GRID;
+    }
+
+    // Shared data of the variable for the consistency checks.
+    readSharedVariableData(&varResult->sharedData, &currCFVar, levelType);
+
+    return true;
+}
+
+
 MStructuredGrid *MClimateForecastReader::readGrid(
         MVerticalLevelType levelType,
         const QString &variableName,
         const QDateTime &initTime,
         const QDateTime &validTime,
-        unsigned int ensembleMember)
+        unsigned int ensembleMember,
+        const MSubDomain &subDomain)
 {
 #ifdef MSTOPWATCH_ENABLED
     MStopwatch stopwatch;
@@ -1467,7 +1619,8 @@ MStructuredGrid *MClimateForecastReader::readGrid(
                 MLonLatAuxiliaryPressureGrid *auxPGrid =
                         dynamic_cast<MLonLatAuxiliaryPressureGrid*>(
                             readGrid(levelType, auxiliary3DPressureField,
-                                     initTime, validTime, ensembleMember));
+                                     initTime, validTime, ensembleMember,
+                                     subDomain));
                 ncAccessMutexLocker.relock();
 
                 shared->reverseLevels = auxPGrid->getReverseLevels();
@@ -1670,36 +1823,50 @@ MStructuredGrid *MClimateForecastReader::readGrid(
     } // initial access
 
 
+    // Determine the part of the grid that covers the requested sub-domain
+    // (the entire grid if no sub-domain has been requested). Only this part
+    // is read from the file (k0/j0/i0 are the indices of the first grid
+    // point in Met.3D index order, nk/nj/ni the number of grid points).
+    MIndex3D firstIndex, numIndices;
+    subDomain.computeIndexRanges(
+                shared->levels.constData(), shared->levels.size(),
+                shared->lats.constData(), shared->lats.size(),
+                shared->lons.constData(), shared->lons.size(),
+                levelType == PRESSURE_LEVELS_3D, &firstIndex, &numIndices);
+    const size_t k0 = firstIndex.k, nk = numIndices.k;
+    const size_t j0 = firstIndex.j, nj = numIndices.j;
+    const size_t i0 = firstIndex.i, ni = numIndices.i;
+
+    // Start indices in the file: latitudes and levels may be stored in
+    // reverse order.
+    const size_t fileLat0 = shared->reverseLatitudes
+            ? shared->lats.size() - j0 - nj : j0;
+    const size_t fileLev0 = shared->reverseLevels
+            ? shared->levels.size() - k0 - nk : k0;
+
     // Return value.
     MStructuredGrid *grid = nullptr;
 
     // Initialize the grid dependent on the vertical level type.
     if (levelType == SURFACE_2D)
     {
-        grid = new MRegularLonLatGrid(shared->lats.size(),
-                                      shared->lons.size());
+        grid = new MRegularLonLatGrid(nj, ni);
     }
 
     else if (levelType == PRESSURE_LEVELS_3D)
     {
-        grid = new MRegularLonLatStructuredPressureGrid(
-                    shared->levels.size(),
-                    shared->lats.size(),
-                    shared->lons.size());
+        grid = new MRegularLonLatStructuredPressureGrid(nk, nj, ni);
     }
 
     else if (levelType == HYBRID_SIGMA_PRESSURE_3D)
     {
         MLonLatHybridSigmaPressureGrid *sigpgrid =
-                new MLonLatHybridSigmaPressureGrid(
-                    shared->levels.size(),
-                    shared->lats.size(),
-                    shared->lons.size());
+                new MLonLatHybridSigmaPressureGrid(nk, nj, ni);
 
         for (unsigned int i = 0; i < sigpgrid->nlevs; i++)
         {
-            sigpgrid->ak_hPa[i] = shared->ak[i];
-            sigpgrid->bk[i] = shared->bk[i];
+            sigpgrid->ak_hPa[i] = shared->ak[k0 + i];
+            sigpgrid->bk[i] = shared->bk[k0 + i];
         }
 
         grid = sigpgrid;
@@ -1707,16 +1874,13 @@ MStructuredGrid *MClimateForecastReader::readGrid(
 
     else if (levelType == POTENTIAL_VORTICITY_2D)
     {
-        grid = new MRegularLonLatGrid(shared->lats.size(),
-                                      shared->lons.size());
+        grid = new MRegularLonLatGrid(nj, ni);
 
     }
 
     else if (levelType == LOG_PRESSURE_LEVELS_3D)
     {
-        grid = new MRegularLonLatLnPGrid(shared->levels.size(),
-                                         shared->lats.size(),
-                                         shared->lons.size());
+        grid = new MRegularLonLatLnPGrid(nk, nj, ni);
 
     }
 
@@ -1724,10 +1888,7 @@ MStructuredGrid *MClimateForecastReader::readGrid(
     {
         MLonLatAuxiliaryPressureGrid *auxGrid =
                 new MLonLatAuxiliaryPressureGrid(
-                    shared->levels.size(),
-                    shared->lats.size(),
-                    shared->lons.size(),
-                    shared->reverseLevels);
+                    nk, nj, ni, shared->reverseLevels);
         // For the pressure field, add itself as pressure field directly since
         // it won't be done otherwise.
         if (variableName == auxiliary3DPressureField)
@@ -1739,14 +1900,16 @@ MStructuredGrid *MClimateForecastReader::readGrid(
 
     // Copy coordinate data.
     for (unsigned int i = 0; i < grid->nlons; i++)
-        grid->lons[i] = shared->lons[i];
+        grid->lons[i] = shared->lons[i0 + i];
 
     for (unsigned int i = 0; i < grid->nlats; i++)
-        grid->lats[i] = shared->lats[i];
+        grid->lats[i] = shared->lats[j0 + i];
 
     if ( !shared->vertVar.isNull() )
         for (unsigned int i = 0; i < grid->nlevs; i++)
-            grid->levels[i] = shared->levels[i];
+            grid->levels[i] = shared->levels[k0 + i];
+
+    grid->setSubDomainIndexOffset(firstIndex);
 
     // Determine the time index of this timestep.
     int timeIndex = shared->timeCoordValues.indexOf(validTime);
@@ -1775,10 +1938,13 @@ MStructuredGrid *MClimateForecastReader::readGrid(
                 // Load from a 4D NetCDF variable (time, vertical, lat, lon).
                 vector<size_t> start(4); start.assign(4,0);
                 start[0] = timeIndex;
+                start[1] = fileLev0;
+                start[2] = fileLat0;
+                start[3] = i0;
                 vector<size_t> count(4); count.assign(4,1);
-                count[1] = shared->levels.size();
-                count[2] = shared->lats.size();
-                count[3] = shared->lons.size();
+                count[1] = nk;
+                count[2] = nj;
+                count[3] = ni;
 
                 if (shared->reverseLatitudes || shared->reverseLevels)
                 {
@@ -1853,11 +2019,14 @@ MStructuredGrid *MClimateForecastReader::readGrid(
                 vector<size_t> start(5); start.assign(5,0);
                 start[0] = timeIndex;
                 start[1] = shared->memberToFileIndexMap.value(ensembleMember);
+                start[2] = fileLev0;
+                start[3] = fileLat0;
+                start[4] = i0;
                 vector<size_t> count(5); count.assign(5,1);
                 count[1] = 1;
-                count[2] = shared->levels.size();
-                count[3] = shared->lats.size();
-                count[4] = shared->lons.size();
+                count[2] = nk;
+                count[3] = nj;
+                count[4] = ni;
 
                 if (shared->reverseLatitudes || shared->reverseLevels)
                 {
@@ -1932,14 +2101,12 @@ MStructuredGrid *MClimateForecastReader::readGrid(
                 // or (time, single level, lat, lon).
                 vector<size_t> start;
                 vector<size_t> count;
-                start.assign({size_t(timeIndex), 0, 0});
-                count.assign({1, size_t(shared->lats.size()),
-                              size_t(shared->lons.size())});
+                start.assign({size_t(timeIndex), fileLat0, i0});
+                count.assign({1, nj, ni});
                 if (shared->cfVar.getDimCount() == 4)
                 {
-                    start.assign({size_t(timeIndex), 0, 0, 0});
-                    count.assign({1, 1, size_t(shared->lats.size()),
-                                  size_t(shared->lons.size())});
+                    start.assign({size_t(timeIndex), 0, fileLat0, i0});
+                    count.assign({1, 1, nj, ni});
                 }
 
                 if (shared->reverseLatitudes)
@@ -1993,16 +2160,14 @@ MStructuredGrid *MClimateForecastReader::readGrid(
                 vector<size_t> count;
                 start.assign({size_t(timeIndex),
                               size_t(shared->memberToFileIndexMap.value(ensembleMember)),
-                              0, 0});
-                count.assign({1, 1, size_t(shared->lats.size()),
-                              size_t(shared->lons.size())});
+                              fileLat0, i0});
+                count.assign({1, 1, nj, ni});
                 if (shared->cfVar.getDimCount() == 5)
                 {
                     start.assign({size_t(timeIndex),
                                   size_t(shared->memberToFileIndexMap.value(ensembleMember)),
-                                  0, 0, 0});
-                    count.assign({1, 1, 1, size_t(shared->lats.size()),
-                                  size_t(shared->lons.size())});
+                                  0, fileLat0, i0});
+                    count.assign({1, 1, 1, nj, ni});
                 }
 
                 if (shared->reverseLatitudes)
@@ -2213,12 +2378,10 @@ bool MClimateForecastReader::parseCfStandardNameFile(const QString &filename)
 }
 
 
-bool MClimateForecastReader::checkSharedVariableDataConsistency(
+void MClimateForecastReader::readSharedVariableData(
         MVariableDataSharedPerFile *shared,
         netCDF::NcCFVar *cfVar,
-        MVerticalLevelType levelType,
-        bool initialiseConsistencyData,
-        bool testEnsembleMemberConsistency)
+        MVerticalLevelType levelType)
 {
     MVariableDataSharedPerFile current;
 
@@ -2246,20 +2409,6 @@ bool MClimateForecastReader::checkSharedVariableDataConsistency(
     try { cfVar->getAtt("add_offset").getValues(&(current.add_offset)); }
     catch (std::exception &NcException) { current.add_offset = 0.; }
 
-    // Have scale and offset been provided? If not, they are not applied.
-    current.scaleAndOffsetProvided =
-            (current.scale_factor != 1.) || (current.add_offset != 0.);
-
-    if (!initialiseConsistencyData
-            && (current.scale_factor != shared->scale_factor)
-            && (current.add_offset != shared->add_offset))
-    {
-        LOG4CPLUS_ERROR(
-                    mlog,
-                    "detected inconsistency in 'scale factor' or 'add offset'.");
-        return false;
-    }
-
     switch (levelType)
     {
     case PRESSURE_LEVELS_3D:
@@ -2304,30 +2453,12 @@ bool MClimateForecastReader::checkSharedVariableDataConsistency(
                     current.ak[i] /= 100.;
                 }
             }
-
-            // QVector operator != compares QVectors componentwise:
-            // https://doc.qt.io/qt-5/qvector.html#operator-not-eq (Qt 5.10)
-            if (!initialiseConsistencyData && (current.ak != shared->ak))
-            {
-                LOG4CPLUS_ERROR(
-                            mlog,
-                            "detected inconsistency in 'ak coefficients'.");
-                return false;
-            }
         }
 
         if ( !bVar.isNull() )
         {
             current.bk.resize(bVar.getDim(0).getSize());
             bVar.getVar(current.bk.data());
-
-            if (!initialiseConsistencyData && (current.bk != shared->bk))
-            {
-                LOG4CPLUS_ERROR(
-                            mlog,
-                            "detected inconsistency in 'bk coefficients'.");
-                return false;
-            }
         }
         break;
     }
@@ -2360,24 +2491,6 @@ bool MClimateForecastReader::checkSharedVariableDataConsistency(
         current.lons.pop_back();
     }
 
-
-    if (!initialiseConsistencyData && (current.lons != shared->lons))
-    {
-        LOG4CPLUS_ERROR(
-                    mlog,
-                    "detected inconsistency in 'longitudes'.");
-        return false;
-    }
-
-    if (!initialiseConsistencyData && (current.lats != shared->lats))
-    {
-        LOG4CPLUS_ERROR(
-                    mlog,
-                    "detected inconsistency in 'latitudes'.");
-        return false;
-    }
-
-
     if ( !current.vertVar.isNull() )
     {
         current.levels.resize(current.vertVar.getDim(0).getSize());
@@ -2416,7 +2529,80 @@ bool MClimateForecastReader::checkSharedVariableDataConsistency(
         }
     }
 
-    if (!initialiseConsistencyData && (current.levels != shared->levels))
+    // Query ensemble dimension.
+    try
+    {
+        current.ensembleVar = cfVar->getEnsembleVar();
+        current.availableMembers = cfVar->getEnsembleMembers(
+                    &(current.memberToFileIndexMap));
+    }
+    catch (std::exception &NcException)
+    {
+    }
+
+    // Only the values are stored; the NetCDF handles are not valid anymore
+    // once the file has been closed.
+    shared->levels = current.levels;
+    shared->lats = current.lats;
+    shared->lons = current.lons;
+    shared->ak = current.ak;
+    shared->bk = current.bk;
+    shared->availableMembers = current.availableMembers;
+    shared->scale_factor = current.scale_factor;
+    shared->add_offset = current.add_offset;
+}
+
+
+bool MClimateForecastReader::checkSharedVariableDataConsistency(
+        MVariableDataSharedPerFile *shared,
+        MVariableDataSharedPerFile *current,
+        bool testEnsembleMemberConsistency)
+{
+    if ((current->scale_factor != shared->scale_factor)
+            && (current->add_offset != shared->add_offset))
+    {
+        LOG4CPLUS_ERROR(
+                    mlog,
+                    "detected inconsistency in 'scale factor' or 'add offset'.");
+        return false;
+    }
+
+    // Hybrid coefficients are only compared if they are provided.
+    // QVector operator != compares QVectors componentwise:
+    // https://doc.qt.io/qt-5/qvector.html#operator-not-eq (Qt 5.10)
+    if (!current->ak.isEmpty() && (current->ak != shared->ak))
+    {
+        LOG4CPLUS_ERROR(
+                    mlog,
+                    "detected inconsistency in 'ak coefficients'.");
+        return false;
+    }
+
+    if (!current->bk.isEmpty() && (current->bk != shared->bk))
+    {
+        LOG4CPLUS_ERROR(
+                    mlog,
+                    "detected inconsistency in 'bk coefficients'.");
+        return false;
+    }
+
+    if (current->lons != shared->lons)
+    {
+        LOG4CPLUS_ERROR(
+                    mlog,
+                    "detected inconsistency in 'longitudes'.");
+        return false;
+    }
+
+    if (current->lats != shared->lats)
+    {
+        LOG4CPLUS_ERROR(
+                    mlog,
+                    "detected inconsistency in 'latitudes'.");
+        return false;
+    }
+
+    if (current->levels != shared->levels)
     {
         LOG4CPLUS_ERROR(
                     mlog,
@@ -2424,45 +2610,237 @@ bool MClimateForecastReader::checkSharedVariableDataConsistency(
         return false;
     }
 
-    // Query ensemble dimension.
-    try
+    if (testEnsembleMemberConsistency
+            && (current->availableMembers != shared->availableMembers))
     {
-        current.ensembleVar = cfVar->getEnsembleVar();
-        current.availableMembers = cfVar->getEnsembleMembers(
-                    &(current.memberToFileIndexMap));
+        LOG4CPLUS_ERROR(
+                    mlog,
+                    "detected inconsistency in 'available ensemble members'.");
+        return false;
     }
-    catch (std::exception &NcException)
+
+    return true;
+}
+
+
+// Layout of the catalogue cache file (QDataStream, Qt 5.0 format): magic,
+// version, configuration fingerprint, table of coordinate arrays, number of
+// files and, per file, name, size, modification time and the variable
+// records, which refer to the coordinate arrays by index.
+const quint32 CF_CATALOGUE_CACHE_MAGIC = 0x4d334343; // "M3CC"
+const qint32  CF_CATALOGUE_CACHE_VERSION = 1;
+
+bool MClimateForecastReader::readCatalogueCache(
+        const QString &path, MNcCatalogueCache *catalogueCache)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0;
+    qint32 version = 0;
+    stream >> magic >> version;
+    if (magic != CF_CATALOGUE_CACHE_MAGIC
+            || version != CF_CATALOGUE_CACHE_VERSION)
+    {
+        LOG4CPLUS_WARN(mlog, "catalogue cache " << path.toStdString()
+                       << " has unknown format or version; scanning all"
+                          " files.");
+        return false;
+    }
+
+    QByteArray configuration;
+    stream >> configuration;
+    if (configuration != catalogueCacheConfiguration())
     {
+        LOG4CPLUS_DEBUG(mlog, "catalogue cache " << path.toStdString()
+                        << " has been created with a different reader"
+                           " configuration; scanning all files.");
+        return false;
     }
 
-    if (testEnsembleMemberConsistency)
+    QVector< QVector<double> > arrays;
+    stream >> arrays;
+
+    quint32 numFiles = 0;
+    stream >> numFiles;
+
+    MNcCatalogueCache cache;
+    for (quint32 f = 0; f < numFiles && stream.status() == QDataStream::Ok;
+         f++)
     {
-        if (!initialiseConsistencyData
-                && (current.availableMembers != shared->availableMembers))
+        QString fileName;
+        MNcFileScanResult fileResult;
+        quint32 numVariables = 0;
+        stream >> fileName >> fileResult.fileSize >> fileResult.lastModified
+               >> numVariables;
+        fileResult.isValid = true;
+
+        for (quint32 v = 0; v < numVariables
+             && stream.status() == QDataStream::Ok; v++)
         {
-            LOG4CPLUS_ERROR(
-                        mlog,
-                        "detected inconsistency in 'available ensemble members'.");
-            return false;
+            MNcVariableScanResult varResult;
+            qint32 levelType = 0;
+            qint32 horizontalGridType = 0;
+
+            stream >> varResult.variablename >> levelType
+                   >> varResult.longname >> varResult.standardname
+                   >> varResult.units >> varResult.surfacePressureName
+                   >> varResult.auxiliaryPressureName
+                   >> varResult.auxiliaryPressureVarIsNull
+                   >> varResult.dimensionsInfo.names
+                   >> varResult.dimensionsInfo.sizes
+                   >> horizontalGridType >> varResult.hasEnsembleDimension
+                   >> varResult.initTime >> varResult.validTimes
+                   >> varResult.sharedData.availableMembers
+                   >> varResult.sharedData.scale_factor
+                   >> varResult.sharedData.add_offset;
+
+            varResult.levelType = MVerticalLevelType(levelType);
+            varResult.horizontalGridType =
+                    MHorizontalGridType(horizontalGridType);
+
+            QVector<double> *sharedArrays[5] = {
+                &varResult.sharedData.levels, &varResult.sharedData.lats,
+                &varResult.sharedData.lons, &varResult.sharedData.ak,
+                &varResult.sharedData.bk };
+            for (int i = 0; i < 5; i++)
+            {
+                qint32 arrayIndex = -1;
+                stream >> arrayIndex;
+                if (arrayIndex < 0 || arrayIndex >= arrays.size())
+                {
+                    stream.setStatus(QDataStream::ReadCorruptData);
+                    break;
+                }
+                *sharedArrays[i] = arrays[arrayIndex]; // implicitly shared
+            }
+
+            fileResult.variables << varResult;
         }
+
+        cache.insert(fileName, fileResult);
     }
 
-    if (initialiseConsistencyData)
+    if (stream.status() != QDataStream::Ok)
     {
-        shared->levels = current.levels;
-        shared->lats = current.lats;
-        shared->lons = current.lons;
-        shared->ak = current.ak;
-        shared->bk = current.bk;
-        shared->availableMembers = current.availableMembers;
-        shared->scale_factor = current.scale_factor;
-        shared->add_offset = current.add_offset;
+        LOG4CPLUS_WARN(mlog, "catalogue cache " << path.toStdString()
+                       << " is invalid; scanning all files.");
+        return false;
     }
 
+    *catalogueCache = cache;
     return true;
 }
 
 
+bool MClimateForecastReader::writeCatalogueCache(
+        const QString &path, const MNcCatalogueCache &catalogueCache)
+{
+    // Coordinate arrays are usually identical for all variables and files
+    // of a dataset; store each distinct array once.
+    QVector< QVector<double> > arrays;
+    QHash<QByteArray, qint32> arrayIndices;
+
+    // The file records are serialised first to collect the arrays.
+    QByteArray records;
+    QDataStream recordStream(&records, QIODevice::WriteOnly);
+    recordStream.setVersion(QDataStream::Qt_5_0);
+
+    recordStream << quint32(catalogueCache.size());
+    for (MNcCatalogueCache::const_iterator it = catalogueCache.constBegin();
+         it != catalogueCache.constEnd(); ++it)
+    {
+        const MNcFileScanResult &fileResult = it.value();
+        recordStream << it.key() << fileResult.fileSize
+                     << fileResult.lastModified
+                     << quint32(fileResult.variables.size());
+
+        foreach (const MNcVariableScanResult &varResult, fileResult.variables)
+        {
+            recordStream << varResult.variablename
+                         << qint32(varResult.levelType)
+                         << varResult.longname << varResult.standardname
+                         << varResult.units << varResult.surfacePressureName
+                         << varResult.auxiliaryPressureName
+                         << varResult.auxiliaryPressureVarIsNull
+                         << varResult.dimensionsInfo.names
+                         << varResult.dimensionsInfo.sizes
+                         << qint32(varResult.horizontalGridType)
+                         << varResult.hasEnsembleDimension
+                         << varResult.initTime << varResult.validTimes
+                         << varResult.sharedData.availableMembers
+                         << varResult.sharedData.scale_factor
+                         << varResult.sharedData.add_offset;
+
+            const QVector<double> *sharedArrays[5] = {
+                &varResult.sharedData.levels, &varResult.sharedData.lats,
+                &varResult.sharedData.lons, &varResult.sharedData.ak,
+                &varResult.sharedData.bk };
+            for (int i = 0; i < 5; i++)
+            {
+                QByteArray key(
+                            reinterpret_cast<const char*>(
+                                sharedArrays[i]->constData()),
+                            sharedArrays[i]->size() * int(sizeof(double)));
+                if (!arrayIndices.contains(key))
+                {
+                    arrayIndices.insert(key, arrays.size());
+                    arrays << *sharedArrays[i];
+                }
+                recordStream << arrayIndices.value(key);
+            }
+        }
+    }
+
+    // Write to a temporary file that replaces the cache on commit(), so that
+    // readers never see a partially written cache.
+    QSaveFile file(path);
+    if (file.open(QIODevice::WriteOnly))
+    {
+        QDataStream stream(&file);
+        stream.setVersion(QDataStream::Qt_5_0);
+        stream << CF_CATALOGUE_CACHE_MAGIC << CF_CATALOGUE_CACHE_VERSION
+               << catalogueCacheConfiguration() << arrays;
+        stream.writeRawData(records.constData(), records.size());
+
+        if (stream.status() == QDataStream::Ok && file.commit())
+        {
+            return true;
+        }
+    }
+
+    LOG4CPLUS_WARN(mlog, "Cannot write catalogue cache "
+                   << path.toStdString() << "; all files will be scanned"
+                      " again on the next start.");
+    return false;
+}
+
+
+QByteArray MClimateForecastReader::catalogueCacheConfiguration()
+{
+    QCryptographicHash sha1(QCryptographicHash::Sha1);
+    sha1.addData(QString("%1/%2/%3/%4/%5\n")
+                 .arg(int(treatRotatedGridAsRegularLonLatGrid))
+                 .arg(int(treatProjectedGridAsRegularLonLatGrid))
+                 .arg(int(convertGeometricHeightToPressure_ICAOStandard))
+                 .arg(int(disableGridConsistencyCheck))
+                 .arg(auxiliary3DPressureField).toUtf8());
+
+    for (QMap<QString, QString>::const_iterator it =
+         variableToStandardNameMap.constBegin();
+         it != variableToStandardNameMap.constEnd(); ++it)
+    {
+        sha1.addData(QString("%1=%2\n").arg(it.key()).arg(it.value())
+                     .toUtf8());
+    }
+
+    return sha1.result();
+}
+
+
 QString MClimateForecastReader::errorMsgDimensionMismatch(
         MVariableDataSharedPerFile *shared, MVerticalLevelType levelType,
         QString expectedDims)
@@ -72,6 +72,55 @@ struct MNcVarDimensionInfo
     QList<int>     sizes;
 };
 
+/**
+  Properties of a gridded data variable in a single file, determined in the
+  parallel phase of @ref MClimateForecastReader::scanDataRoot().
+ */
+struct MNcVariableScanResult
+{
+    MNcVariableScanResult()
+        : levelType(SURFACE_2D),
+          auxiliaryPressureVarIsNull(false),
+          horizontalGridType(MHorizontalGridType::REGULAR_LONLAT_GRID),
+          hasEnsembleDimension(false)
+    { }
+
+    QString variablename;
+    MVerticalLevelType levelType;
+    QString longname, standardname, units;
+    QString surfacePressureName;   // hybrid sigma-pressure variables
+    QString auxiliaryPressureName; // auxiliary pressure variables
+    bool auxiliaryPressureVarIsNull; // pressure variable not in this file
+    MNcVarDimensionInfo dimensionsInfo; // .. hence dimensions are checked
+                                        // after all files have been scanned
+    MHorizontalGridType horizontalGridType;
+    bool hasEnsembleDimension;
+    QDateTime initTime;
+    QList<QDateTime> validTimes;
+
+    // Coordinates etc. for the consistency checks (values only).
+    MVariableDataSharedPerFile sharedData;
+};
+
+struct MNcFileScanResult
+{
+    MNcFileScanResult()
+        : isValid(false), isFromCache(false), ensembleIDFromFile(-1),
+          fileSize(-1), lastModified(-1)
+    { }
+
+    bool isValid;     // false if the file could not be read
+    bool isFromCache; // taken from the catalogue cache, file not opened
+    int ensembleIDFromFile;
+    qint64 fileSize;     // size and modification time (ms since epoch) of
+    qint64 lastModified; // the file at the time it was scanned
+    QVector<MNcVariableScanResult> variables;
+};
+
+// Catalogue cache of a data root: scan results of the files, accessed by
+// file name relative to the data root.
+typedef QHash<QString, MNcFileScanResult> MNcCatalogueCache;
+
 typedef QHash<QString, MVariableDataSharedPerFile> MSharedDataVariableNameMap;
 typedef QHash<MVerticalLevelType, MSharedDataVariableNameMap> MSharedDataLevelTypeMap;
 
@@ -161,13 +210,38 @@ protected:
     QString variableAuxiliaryPressureName(MVerticalLevelType levelType,
                                           const QString&     variableName);
 
+    /**
+      Scans the files in the data root: the variables of the files are read
+      concurrently by @ref scanNetCDFFile() and merged in file order into
+      @ref availableDataFields.
+     */
     void scanDataRoot();
 
+    /**
+      Parallel per-file phase of @ref scanDataRoot(): determines the gridded
+      data variables of the file @p fileName, their times and the data
+      required for the consistency checks. If @p catalogueCache contains an
+      entry for the file that matches its size and modification time, the
+      entry is returned and the file is not opened. Does not modify the
+      catalogue of available data fields.
+     */
+    MNcFileScanResult scanNetCDFFile(const QString& fileName,
+                                     const MNcCatalogueCache& catalogueCache);
+
+    /**
+      Helper for @ref scanNetCDFFile(): reads the properties of the gridded
+      data variable @p varName of @p ncFile into @p varResult. Returns false
+      if the variable cannot be used.
+     */
+    bool scanNetCDFVariable(netCDF::NcFile *ncFile, const QString& varName,
+                            MNcVariableScanResult *varResult);
+
     MStructuredGrid* readGrid(MVerticalLevelType levelType,
                               const QString&     variableName,
                               const QDateTime&   initTime,
                               const QDateTime&   validTime,
-                              unsigned int       ensembleMember);
+                              unsigned int       ensembleMember,
+                              const MSubDomain&  subDomain);
 
     // Dictionaries of available data. Access needs to be protected
     // by the provided read/write lock.
@@ -200,34 +274,60 @@ protected:
     bool parseCfStandardNameFile(const QString& filename);
 
     /**
-      Checks consistency of shared data associated with the NetCDF variable @p
-      cfVar of the vertical level type @p levelType. Shared data includes
-      longitudes, latitudes, levels, etc., that are read only once and re-used
-      for all time steps of a variable. This function ensures that all time
-      steps are defined on, e.g., the same grid.
-
-      If @p initialiseConsistencyData is true @p shared is initialised with the
-      shared data data obtained from @p cfVar. This is the data that subsequent
-      calls to this method will be checked against for consistency.
+      Reads the shared data associated with the NetCDF variable @p cfVar of
+      the vertical level type @p levelType into @p shared. Shared data
+      includes longitudes, latitudes, levels, etc., that are read only once
+      and re-used for all time steps of a variable. Only the values are
+      stored in @p shared, not the NetCDF handles.
+     */
+    void readSharedVariableData(MVariableDataSharedPerFile *shared,
+                                netCDF::NcCFVar *cfVar,
+                                MVerticalLevelType levelType);
 
-      If @p initialiseConsistencyData is false the shared data of @p cfVar are
-      compared to the corresponding data stored in @p shared.
+    /**
+      Checks consistency of the shared data @p current (see @ref
+      readSharedVariableData()) with the reference data @p shared. This
+      ensures that all time steps of a variable are defined on, e.g., the
+      same grid.
 
       Set @p testEnsembleMemberConsistency to true to also test consistency in
       ensemble members (consistency of one variable) and to false to disable
       the ensemble members check (consistency of dataset).
 
-      @return false if @p initialiseConsistencyData is false and the shared
-      data of @p cfVar does not match the corresponding data in @p shared; true
-      otherwise.
+      @return false if the shared data in @p current does not match the
+      corresponding data in @p shared; true otherwise.
      */
     bool checkSharedVariableDataConsistency(
             MVariableDataSharedPerFile *shared,
-            netCDF::NcCFVar *cfVar,
-            MVerticalLevelType levelType,
-            bool initialiseConsistencyData,
+            MVariableDataSharedPerFile *current,
             bool testEnsembleMemberConsistency);
 
+    /**
+      The catalogue cache of a data root stores the results of @ref
+      scanNetCDFFile() so that only new or modified files need to be opened
+      by @ref scanDataRoot(). Coordinate arrays that are shared by several
+      variables and files are stored once.
+
+      The cache is only valid for the reader configuration returned by
+      @ref catalogueCacheConfiguration(). Each configuration has its own
+      cache file in the data root (".met3d_cf_catalogue_<fingerprint>"),
+      so that datasets with different options do not invalidate each
+      other's cache. If the configuration stored in the file differs,
+      @ref readCatalogueCache() returns false and @p catalogueCache is left
+      empty.
+     */
+    bool readCatalogueCache(const QString& path,
+                            MNcCatalogueCache *catalogueCache);
+
+    bool writeCatalogueCache(const QString& path,
+                             const MNcCatalogueCache& catalogueCache);
+
+    /**
+      Fingerprint of the reader parameters and of the variable name to
+      standard name table, which determine the scan results.
+     */
+    QByteArray catalogueCacheConfiguration();
+
     QString errorMsgDimensionMismatch(MVariableDataSharedPerFile *shared,
                                       MVerticalLevelType levelType,
                                       QString expectedDims);
@@ -27,6 +27,7 @@
 #include "gribreader.h"
 
 // standard library imports
+#include <cstring>
 #include <iostream>
 #include <limits>
 
@@ -71,8 +72,8 @@ MGribReader::~MGribReader()
 {
     QMutexLocker openFilesLocker(&openFilesMutex);
 
-    // Close open Grib files & their indices.
-    foreach (MGribFileInfo *finfo, openFiles) fclose(finfo->gribFile);
+    // Unmap and close open Grib files.
+    foreach (MGribFileInfo *finfo, openFiles) delete finfo;
 }
 
 
@@ -339,12 +340,203 @@ void MGribReader::copyLonLatCoordinateDataToGridObject(
 }
 
 
+MStructuredGrid* MGribReader::cropGridToSubDomain(
+        MStructuredGrid *grid, const MSubDomain& subDomain)
+{
+    MIndex3D first, count;
+    subDomain.computeIndexRanges(
+                grid->levels, grid->nlevs, grid->lats, grid->nlats,
+                grid->lons, grid->nlons, grid->leveltype == PRESSURE_LEVELS_3D,
+                &first, &count);
+
+    if (count.k == int(grid->nlevs) && count.j == int(grid->nlats)
+            && count.i == int(grid->nlons))
+    {
+        // The sub-domain covers the entire grid.
+        return grid;
+    }
+
+    MStructuredGrid *subGrid = nullptr;
+
+    if (grid->leveltype == SURFACE_2D)
+    {
+        subGrid = new MRegularLonLatGrid(count.j, count.i);
+    }
+    else if (grid->leveltype == PRESSURE_LEVELS_3D)
+    {
+        subGrid = new MRegularLonLatStructuredPressureGrid(
+                    count.k, count.j, count.i);
+    }
+    else if (grid->leveltype == HYBRID_SIGMA_PRESSURE_3D)
+    {
+        MLonLatHybridSigmaPressureGrid *sigpgrid =
+                static_cast<MLonLatHybridSigmaPressureGrid*>(grid);
+        MLonLatHybridSigmaPressureGrid *sigpSubGrid =
+                new MLonLatHybridSigmaPressureGrid(count.k, count.j, count.i);
+
+        sigpSubGrid->allocateInterfaceCoefficients();
+        for (int k = 0; k <= count.k; k++)
+        {
+            sigpSubGrid->aki_hPa[k] = sigpgrid->aki_hPa[first.k + k];
+            sigpSubGrid->bki[k] = sigpgrid->bki[first.k + k];
+
+            if (k < count.k)
+            {
+                sigpSubGrid->ak_hPa[k] = sigpgrid->ak_hPa[first.k + k];
+                sigpSubGrid->bk[k] = sigpgrid->bk[first.k + k];
+            }
+        }
+
+        subGrid = sigpSubGrid;
+    }
+    else
+    {
+        // Other level types are not read by this reader.
+        return grid;
+    }
+
+    // Copy coordinate data and the data values of the sub-domain.
+    for (uint k = 0; k < subGrid->nlevs; k++)
+    {
+        subGrid->levels[k] = grid->levels[first.k + k];
+    }
+    for (uint j = 0; j < subGrid->nlats; j++)
+    {
+        subGrid->lats[j] = grid->lats[first.j + j];
+    }
+    for (uint i = 0; i < subGrid->nlons; i++)
+    {
+        subGrid->lons[i] = grid->lons[first.i + i];
+    }
+
+    for (uint k = 0; k < subGrid->nlevs; k++)
+        for (uint j = 0; j < subGrid->nlats; j++)
+            for (uint i = 0; i < subGrid->nlons; i++)
+            {
+                subGrid->data[INDEX3zyx_2(k, j, i, subGrid->nlatsnlons,
+                                          subGrid->nlons)] =
+                        grid->data[INDEX3zyx_2(first.k + k, first.j + j,
+                                               first.i + i, grid->nlatsnlons,
+                                               grid->nlons)];
+            }
+
+    // Copy metadata.
+    subGrid->setMetaData(grid->getInitTime(), grid->getValidTime(),
+                         grid->getVariableName(), grid->getEnsembleMember());
+    subGrid->setAvailableMembers(grid->getAvailableMembers());
+    subGrid->setSubDomainIndexOffset(first);
+
+    delete grid;
+    return subGrid;
+}
+
+
+bool MGribReader::decodeGribMessageToLevel(
+        MGribFileInfo *finfo, long offset, MGribVariableInfo *vinfo,
+        bool applyExp, float *levelData, unsigned int nvalues,
+        QVector<double> *valueBuffer)
+{
+    if (offset < 0 || offset + 16 > finfo->mappedSize
+            || strncmp(finfo->mappedData + offset, "GRIB", 4) != 0)
+    {
+        LOG4CPLUS_ERROR(mlog, "Could not read grib message.");
+        return false;
+    }
+
+    // Hand ecCodes a view of the message in the file mapping (no copy). The
+    // message end is determined by ecCodes from the message itself; the
+    // view hence extends to the end of the file (which also covers "large"
+    // GRIB 1 messages whose length is not stored in section 0).
+    grib_handle* gribHandle = grib_handle_new_from_message(
+                0, finfo->mappedData + offset, finfo->mappedSize - offset);
+
+    if (gribHandle == NULL)
+    {
+        LOG4CPLUS_ERROR(mlog, "Could not read grib message.");
+        return false;
+    }
+
+    // Set the missing value number.
+    GRIB_CHECK(grib_set_double(gribHandle, "missingValue",
+                               M_MISSING_VALUE), 0);
+
+    // Get the size of the values array
+    size_t nGribValues = 0;
+    GRIB_CHECK(grib_get_size(gribHandle, "values", &nGribValues), 0);
+    if (nGribValues != nvalues)
+    {
+        LOG4CPLUS_ERROR(mlog, "Number of data values in grib message "
+                        "does not correspond to expected data size. "
+                        "Cannot read data values.");
+        grib_handle_delete(gribHandle);
+        return false;
+    }
+
+    bool shiftLons = vinfo->gridIsCyclicInLongitude
+            && vinfo->longitudinalIndexShiftForCyclicGrid != 0;
+
+#if ECCODES_VERSION >= 23000
+    if (!shiftLons && !applyExp)
+    {
+        // ecCodes >= 2.30 can decode to single precision; no conversion
+        // required, decode directly into the grid.
+        GRIB_CHECK(codes_get_float_array(gribHandle, "values", levelData,
+                                         &nGribValues), 0);
+        grib_handle_delete(gribHandle);
+        return true;
+    }
+#endif
+
+    // Get data.
+    valueBuffer->resize(nGribValues);
+    double *values = valueBuffer->data();
+    GRIB_CHECK(grib_get_double_array(gribHandle, "values", values,
+                                     &nGribValues), 0);
+    grib_handle_delete(gribHandle);
+
+    if (applyExp)
+    {
+        // If surface pressure is specified as lnsp, apply exponential
+        // function to reconstruct surface pressure "sp".
+        for (uint n = 0; n < nGribValues; n++)
+        {
+            values[n] = exp(values[n]);
+        }
+    }
+
+    // Copy double data to MStructuredGrid float array.
+    if (shiftLons)
+    {
+        // Shift in longitude required.
+        const int nlons = vinfo->nlons;
+        const int nlats = nvalues / nlons;
+        for (int j = 0; j < nlats; j++)
+            for (int i = 0; i < nlons; i++)
+            {
+                levelData[INDEX2yx(j, i, nlons)] =
+                        values[INDEX2yx(j, shiftedLonIndex(i, vinfo), nlons)];
+            }
+    }
+    else
+    {
+        // No shift requried, direct copy.
+        for (uint n = 0; n < nGribValues; n++)
+        {
+            levelData[n] = values[n];
+        }
+    }
+
+    return true;
+}
+
+
 MStructuredGrid *MGribReader::readGrid(
         MVerticalLevelType levelType,
         const QString &variableName,
         const QDateTime &initTime,
         const QDateTime &validTime,
-        unsigned int ensembleMember)
+        unsigned int ensembleMember,
+        const MSubDomain &subDomain)
 {
 #ifdef ENABLE_MET3D_STOPWATCH
     MStopwatch stopwatch;
@@ -380,28 +572,33 @@ MStructuredGrid *MGribReader::readGrid(
     }
     else
     {
-        // The file is accessed for the first time -- open.
+        // The file is accessed for the first time -- open and map into
+        // memory. The mapping is private: ecCodes may modify transient
+        // parts of a message handle without affecting the file.
         finfo = new MGribFileInfo();
-        QByteArray ba = filePath.toLocal8Bit();
-        finfo->gribFile = fopen(ba.data(), "r");
+        finfo->gribFile.setFileName(filePath);
+        finfo->mappedSize = finfo->gribFile.size();
+        finfo->mappedData = nullptr;
 
-        if (!finfo->gribFile)
+        if (finfo->gribFile.open(QIODevice::ReadOnly))
         {
-            LOG4CPLUS_ERROR(mlog, "cannot open file "
-                            << filePath.toStdString());
-            throw;
+            finfo->mappedData = reinterpret_cast<const char*>(
+                        finfo->gribFile.map(0, finfo->mappedSize,
+                                            QFileDevice::MapPrivateOption));
+        }
+
+        if (finfo->mappedData == nullptr)
+        {
+            QString msg = QString("cannot open and map GRIB file %1: %2")
+                    .arg(filePath).arg(finfo->gribFile.errorString());
+            LOG4CPLUS_ERROR(mlog, msg.toStdString());
+            delete finfo;
+            throw MBadDataFieldRequest(msg.toStdString(), __FILE__, __LINE__);
         }
 
         openFiles.insert(dinfo.filename, finfo);
     }
 
-    // Shortcut to the file handle.
-    FILE *gribFile = finfo->gribFile;
-
-    // Lock access to "filename" and associated data until the end of this
-    // method.
-    QMutexLocker accessMutexLocker(&(finfo->accessMutex));
-
     openFilesLocker.unlock();
 
 
@@ -418,76 +615,6 @@ MStructuredGrid *MGribReader::readGrid(
         // Store metadata in grid object.
         grid->setMetaData(initTime, validTime, variableName, ensembleMember);
         grid->setAvailableMembers(vinfo->availableMembers_bitfield);
-
-        // Seek current message in file and get grib handle to message.
-        fseek(gribFile, dinfo.offsetForLevel[0], SEEK_SET);
-        int err = 0;
-        grib_handle* gribHandle = grib_handle_new_from_file(0, gribFile, &err);
-        GRIB_CHECK(err, 0);
-
-        if (gribHandle != NULL)
-        {
-            // Read data values into grid object.
-
-            // Set the missing value number.
-            GRIB_CHECK(grib_set_double(gribHandle, "missingValue",
-                                       M_MISSING_VALUE), 0);
-
-            // Get the size of the values array
-            size_t nGribValues = 0;
-            GRIB_CHECK(grib_get_size(gribHandle, "values", &nGribValues), 0);
-            if (nGribValues != grid->nvalues)
-            {
-                LOG4CPLUS_ERROR(mlog, "Number of data values in grib message "
-                                "does not correspond to expected data size. "
-                                "Cannot read data values.");
-            }
-
-            // Get data.
-            double *values = new double[nGribValues];
-            GRIB_CHECK(grib_get_double_array(gribHandle, "values", values,
-                                             &nGribValues), 0);
-
-            if (dinfo.applyExp)
-            {
-                // If surface pressure is specified as lnsp, apply exponential
-                // function to reconstruct surface pressure "sp".
-                for (uint n = 0; n < nGribValues; n++)
-                {
-                    values[n] = exp(values[n]);
-                }
-            }
-
-            // Copy double data to MStructuredGrid float array.
-            if (vinfo->gridIsCyclicInLongitude
-                    && vinfo->longitudinalIndexShiftForCyclicGrid != 0)
-            {
-                // Shift in longitude required.
-                for (uint j = 0; j < grid->nlats; j++)
-                    for (uint i = 0; i < grid->nlons; i++)
-                    {
-                        grid->data[INDEX2yx(j, i, grid->nlons)] =
-                                values[INDEX2yx(j, shiftedLonIndex(i, vinfo),
-                                                grid->nlons)];
-                    }
-            }
-            else
-            {
-                // No shift requried, direct copy.
-                for (uint n = 0; n < nGribValues; n++)
-                {
-                    grid->data[n] = values[n];
-                }
-            }
-
-            delete[] values;
-
-            grib_handle_delete(gribHandle);
-        }
-        else
-        {
-            LOG4CPLUS_ERROR(mlog, "Could not read grib message.");
-        }
     }
 
     else if (levelType == PRESSURE_LEVELS_3D)
@@ -505,73 +632,6 @@ MStructuredGrid *MGribReader::readGrid(
         // Store metadata in grid object.
         grid->setMetaData(initTime, validTime, variableName, ensembleMember);
         grid->setAvailableMembers(vinfo->availableMembers_bitfield);
-
-        // Loop over levels, read each level and store in grid.
-        for (int il = 0; il < vinfo->levels.size(); il++)
-        {
-            long level = vinfo->levels[il];
-
-            // Seek current message in file and get grib handle to message.
-            fseek(gribFile, dinfo.offsetForLevel[level], SEEK_SET);
-            int err = 0;
-            grib_handle* gribHandle = grib_handle_new_from_file(0, gribFile, &err);
-            GRIB_CHECK(err, 0);
-
-            if (gribHandle != NULL)
-            {
-                // Read data values into grid object.
-
-                // Set the missing value number.
-                GRIB_CHECK(grib_set_double(gribHandle, "missingValue",
-                                           M_MISSING_VALUE), 0);
-
-                // Get the size of the values array
-                size_t nGribValues = 0;
-                GRIB_CHECK(grib_get_size(gribHandle, "values", &nGribValues), 0);
-                if (nGribValues != grid->nlatsnlons)
-                {
-                    LOG4CPLUS_ERROR(mlog, "Number of data values in grib message "
-                                    "does not correspond to expected data size. "
-                                    "Cannot read data values.");
-                }
-
-                // Get data.
-                double *values = new double[nGribValues];
-                GRIB_CHECK(grib_get_double_array(gribHandle, "values", values,
-                                                 &nGribValues), 0);
-
-                // Copy double data to MStructuredGrid float array.
-                if (vinfo->gridIsCyclicInLongitude
-                        && vinfo->longitudinalIndexShiftForCyclicGrid != 0)
-                {
-                    // Shift in longitude required.
-                    for (uint j = 0; j < grid->nlats; j++)
-                        for (uint i = 0; i < grid->nlons; i++)
-                        {
-                            grid->data[INDEX3zyx_2(il, j, i,
-                                                   grid->nlatsnlons, grid->nlons)] =
-                                    values[INDEX2yx(j, shiftedLonIndex(i, vinfo),
-                                                    grid->nlons)];
-                        }
-                }
-                else
-                {
-                    // No shift requried, direct copy.
-                    for (uint n = 0; n < nGribValues; n++)
-                    {
-                        grid->data[il*nGribValues + n] = values[n];
-                    }
-                }
-
-                delete[] values;
-
-                grib_handle_delete(gribHandle);
-            }
-            else
-            {
-                LOG4CPLUS_ERROR(mlog, "Could not read grib message.");
-            }
-        }
     }
 
     else if (levelType == HYBRID_SIGMA_PRESSURE_3D)
@@ -610,73 +670,6 @@ MStructuredGrid *MGribReader::readGrid(
         // Store metadata in grid object.
         grid->setMetaData(initTime, validTime, variableName, ensembleMember);
         grid->setAvailableMembers(vinfo->availableMembers_bitfield);
-
-        // Loop over levels, read each level and store in grid.
-        for (int il = 0; il < vinfo->levels.size(); il++)
-        {
-            long level = vinfo->levels[il];
-
-            // Seek current message in file and get grib handle to message.
-            fseek(gribFile, dinfo.offsetForLevel[level], SEEK_SET);
-            int err = 0;
-            grib_handle* gribHandle = grib_handle_new_from_file(0, gribFile, &err);
-            GRIB_CHECK(err, 0);
-
-            if (gribHandle != NULL)
-            {
-                // Read data values into grid object.
-
-                // Set the missing value number.
-                GRIB_CHECK(grib_set_double(gribHandle, "missingValue",
-                                           M_MISSING_VALUE), 0);
-
-                // Get the size of the values array
-                size_t nGribValues = 0;
-                GRIB_CHECK(grib_get_size(gribHandle, "values", &nGribValues), 0);
-                if (nGribValues != grid->nlatsnlons)
-                {
-                    LOG4CPLUS_ERROR(mlog, "Number of data values in grib message "
-                                    "does not correspond to expected data size. "
-                                    "Cannot read data values.");
-                }
-
-                // Get data.
-                double *values = new double[nGribValues];
-                GRIB_CHECK(grib_get_double_array(gribHandle, "values", values,
-                                                 &nGribValues), 0);
-
-                // Copy double data to MStructuredGrid float array.
-                if (vinfo->gridIsCyclicInLongitude
-                        && vinfo->longitudinalIndexShiftForCyclicGrid != 0)
-                {
-                    // Shift in longitude required.
-                    for (uint j = 0; j < grid->nlats; j++)
-                        for (uint i = 0; i < grid->nlons; i++)
-                        {
-                            grid->data[INDEX3zyx_2(il, j, i,
-                                                   grid->nlatsnlons, grid->nlons)] =
-                                    values[INDEX2yx(j, shiftedLonIndex(i, vinfo),
-                                                    grid->nlons)];
-                        }
-                }
-                else
-                {
-                    // No shift requried, direct copy.
-                    for (uint n = 0; n < nGribValues; n++)
-                    {
-                        grid->data[il*nGribValues + n] = values[n];
-                    }
-                }
-
-                delete[] values;
-
-                grib_handle_delete(gribHandle);
-            }
-            else
-            {
-                LOG4CPLUS_ERROR(mlog, "Could not read grib message.");
-            }
-        }
     }
 
     else if (levelType == POTENTIAL_VORTICITY_2D)
@@ -697,6 +690,46 @@ MStructuredGrid *MGribReader::readGrid(
                         "been implemented yet.");
     }
 
+    if (grid != nullptr)
+    {
+        // Byte offsets of the GRIB messages of all levels of the grid.
+        QVector<long> messageOffsets;
+        if (levelType == SURFACE_2D)
+        {
+            messageOffsets << dinfo.offsetForLevel[0];
+        }
+        else
+        {
+            for (int il = 0; il < vinfo->levels.size(); il++)
+            {
+                messageOffsets << dinfo.offsetForLevel[long(vinfo->levels[il])];
+            }
+        }
+
+        // Decode the levels concurrently from the file mapping; each thread
+        // reuses its value buffer for all levels it decodes. The decoded
+        // values are written into the corresponding level of the grid's
+        // data array.
+#pragma omp parallel
+        {
+            QVector<double> valueBuffer;
+
+#pragma omp for schedule(dynamic)
+            for (int il = 0; il < messageOffsets.size(); il++)
+            {
+                decodeGribMessageToLevel(
+                            finfo, messageOffsets[il], vinfo, dinfo.applyExp,
+                            &(grid->data[il * grid->nlatsnlons]),
+                            grid->nlatsnlons, &valueBuffer);
+            }
+        }
+    }
+
+    if (grid != nullptr && subDomain.isValid())
+    {
+        grid = cropGridToSubDomain(grid, subDomain);
+    }
+
 #ifdef ENABLE_MET3D_STOPWATCH
     stopwatch.split();
     LOG4CPLUS_DEBUG(mlog, "single member GRIB data field read in "
@@ -731,746 +764,1110 @@ void MGribReader::scanDataRoot()
     getAvailableFilesFromFilters(availableFiles);
 
     ensembleIDIsSpecifiedInFileName = dirFileFilters.contains("%m");
-    int  ensembleIDFromFile = -1;
-
-    // Create and initialise progress bar.
-    initializeFileScanProgressDialog(availableFiles.size());
 
-    // Scan all grib files contained in the directory.
-    foreach (QString gribFileName, availableFiles)
+    // (Skip index files.)
+    QStringList gribFiles;
+    foreach (QString fileName, availableFiles)
     {
-        updateFileScanProgressDialog();
-        // (Skip index files.)
-        if (gribFileName.endsWith("met3d_grib_index")) continue;
+        if (!fileName.endsWith("met3d_grib_index")) gribFiles << fileName;
+    }
 
-        LOG4CPLUS_DEBUG(mlog, "Scanning file "
-                        << gribFileName.toStdString() << " .." << flush);
+    // Read or create the grib indices of all files concurrently; the
+    // indexed messages are merged into the catalogue of available data
+    // fields afterwards, in the order of the files.
+    initializeFileScanProgressDialog(gribFiles.size());
 
-        // First, read or create the grib index for fast access to messages.
-        // =================================================================
+    QVector<MGribFileScanResult> scanResults =
+            scanFilesConcurrently<MGribFileScanResult>(
+                gribFiles, [this](const QString& gribFileName)
+    {
+        return scanGribFile(gribFileName);
+    });
+
+    deleteFileScanProgressDialog();
 
-        QString filePath = dataRoot.filePath(gribFileName);
-        QString fileIndexPath = QString("%1.met3d_grib_index").arg(filePath);
+#ifdef ENABLE_MET3D_STOPWATCH
+    stopwatch.split();
+    LOG4CPLUS_DEBUG(mlog, gribFiles.size() << " files scanned in "
+                    << stopwatch.getLastSplitTime(MStopwatch::SECONDS)
+                    << " seconds.\n" << flush);
+#endif
 
-        // A) GRIB index file exists. Read from index.
-        // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    // Merge the index records of the files into the catalogue.
+    // ========================================================
 
-        // If the grib index exists, read it. Otherwise, create it and store it.
-        if (QFile::exists(fileIndexPath))
+    // 1. Determine the surface pressure field type from the first sp/lnsp
+    // field in file order, and, if this fails, by searching the grib files
+    // (required for hybrid variables in newly indexed files).
+    bool surfacePressureNamesMissing = false;
+    foreach (const MGribFileScanResult &result, scanResults)
+    {
+        foreach (const MGribMessageIndexInfo &gmiInfo, result.indexRecords)
         {
-            LOG4CPLUS_DEBUG(mlog, "Reading grib index for file "
-                            << gribFileName.toStdString() << " ..");
-
-            // Open index file.
-            QFile indexFile(fileIndexPath);
-            indexFile.open(QIODevice::ReadOnly);
-            QDataStream indexDataStream(&indexFile);
-
-            // Read index file header (only version number "2" supported for
-            // now; this may be changed in the future when the index format
-            // changes).
-            qint32 indexVersion;
-            indexDataStream >> indexVersion;
-            if (indexVersion != 2)
+            if (gmiInfo.levelType == SURFACE_2D)
             {
-                LOG4CPLUS_ERROR(mlog, "ERROR: grib index has version "
-                                << indexVersion << "; this version of Met.3D "
-                                "only supports version 2. Skipping file -- "
-                                "remove the index file if you want the grib "
-                                "file to be considered.");
-                continue;
+                if (gmiInfo.variablename.startsWith("lnsp"))
+                {
+                    setSurfacePressureFieldType("lnsp");
+                }
+                else if (gmiInfo.variablename.startsWith("sp"))
+                {
+                    setSurfacePressureFieldType("sp");
+                }
             }
+        }
+        surfacePressureNamesMissing |= result.indexNeedsUpdate;
+    }
 
-            indexDataStream.setVersion(QDataStream::Qt_4_8);
+    if (surfacePressureNamesMissing)
+    {
+        detectSurfacePressureFieldType(&availableFiles);
 
-            MGribMessageIndexInfo gmiInfo;
-            while ( !indexDataStream.atEnd() )
+        for (int i = 0; i < gribFiles.size(); i++)
+        {
+            MGribFileScanResult &result = scanResults[i];
+            if (!result.indexNeedsUpdate) continue;
+
+            for (int r = 0; r < result.indexRecords.size(); r++)
             {
-                gmiInfo.readFromDataStream(&indexDataStream);
+                MGribMessageIndexInfo &gmiInfo = result.indexRecords[r];
+                if (gmiInfo.levelType == HYBRID_SIGMA_PRESSURE_3D
+                        && gmiInfo.nlons > 0)
+                {
+                    // Variable names are "<shortName> (<dataType>)".
+                    gmiInfo.surfacePressureName =
+                            QString("%1 %2").arg(surfacePressureFieldType)
+                            .arg(gmiInfo.variablename.section(' ', -1));
+                }
+            }
 
-                MVerticalLevelType levelType = gmiInfo.levelType;
+            QString filePath = dataRoot.filePath(gribFiles[i]);
+            writeGribIndex(QString("%1.met3d_grib_index").arg(filePath),
+                           filePath, result.indexRecords);
+        }
+    }
 
-                // Create a new MVariableInfo struct and store available
-                // variable information in this field.
-                MGribVariableInfo* vinfo;
-                if (availableDataFields[levelType].contains(gmiInfo.variablename))
-                {
-                    vinfo = availableDataFields[levelType].value(gmiInfo.variablename);
+    // 2. Register the messages. A variable whose region in a file differs
+    // from the region of the variable in the files merged before is skipped
+    // for this file.
+    for (int i = 0; i < gribFiles.size(); i++)
+    {
+        QSet< QPair<int, QString> > checkedVariables;
+        QSet< QPair<int, QString> > inconsistentVariables;
 
-                    // Domain checks have already been run on index creation;
-                    // skip them here (see below).
-                }
-                else
+        foreach (const MGribMessageIndexInfo &gmiInfo,
+                 scanResults[i].indexRecords)
+        {
+            QPair<int, QString> variableKey(gmiInfo.levelType,
+                                            gmiInfo.variablename);
+
+            if (!checkedVariables.contains(variableKey))
+            {
+                checkedVariables.insert(variableKey);
+
+                if (gmiInfo.nlons > 0 && availableDataFields[
+                        gmiInfo.levelType].contains(gmiInfo.variablename))
                 {
-                    vinfo = new MGribVariableInfo();
-                    vinfo->variablename = gmiInfo.variablename;
-                    vinfo->longname = gmiInfo.longname;
-                    vinfo->standardname = gmiInfo.standardname;
-                    vinfo->units = gmiInfo.units;
-                    vinfo->fcType = gmiInfo.fcType;
-
-                    vinfo->nlons = gmiInfo.nlons;
-                    vinfo->nlats = gmiInfo.nlats;
-                    vinfo->lon0 = gmiInfo.lon0;
-                    vinfo->lat0 = gmiInfo.lat0;
-                    vinfo->lon1 = gmiInfo.lon1;
-                    vinfo->lat1 = gmiInfo.lat1;
-                    vinfo->dlon = gmiInfo.dlon;
-                    vinfo->dlat = gmiInfo.dlat;
-
-                    // Fill lat/lon arrays (QVector copy).
-                    vinfo->lons = gmiInfo.lons;
-                    vinfo->lats = gmiInfo.lats;
-                    // TODO (bt, 08FEB2017) Adapt to set type according to the data read.
-                    vinfo->horizontalGridType = MHorizontalGridType::REGULAR_LONLAT_GRID;
-
-                    // Check if grid spans globe in longitude (cyclic in lon).
-                    double lonWest = MMOD(vinfo->lon0, 360.);
-                    double lonEast = MMOD(vinfo->lon1 + vinfo->dlon, 360.);
-                    vinfo->gridIsCyclicInLongitude =
-                            floatIsAlmostEqualRelativeAndAbs(
-                                lonWest, lonEast, M_LONLAT_RESOLUTION);
-                    vinfo->longitudinalIndexShiftForCyclicGrid = 0;
-
-                    if (levelType == HYBRID_SIGMA_PRESSURE_3D)
+                    MGribVariableInfo currentVInfo;
+                    currentVInfo.nlons = gmiInfo.nlons;
+                    currentVInfo.nlats = gmiInfo.nlats;
+                    currentVInfo.lon0 = gmiInfo.lon0;
+                    currentVInfo.lat0 = gmiInfo.lat0;
+                    currentVInfo.lon1 = gmiInfo.lon1;
+                    currentVInfo.lat1 = gmiInfo.lat1;
+                    currentVInfo.dlon = gmiInfo.dlon;
+                    currentVInfo.dlat = gmiInfo.dlat;
+
+                    if (!checkHorizontalConsistencyOfVariableToReference(
+                                availableDataFields[gmiInfo.levelType].value(
+                                    gmiInfo.variablename), &currentVInfo))
                     {
-                        vinfo->surfacePressureName = gmiInfo.surfacePressureName;
-                        vinfo->aki_hPa = gmiInfo.aki_hPa;
-                        vinfo->bki = gmiInfo.bki;
-                        vinfo->ak_hPa = gmiInfo.ak_hPa;
-                        vinfo->bk = gmiInfo.bk;
+                        LOG4CPLUS_ERROR(mlog, "found different geographical "
+                                        "region than previously used for "
+                                        "variable '"
+                                        + gmiInfo.variablename.toStdString()
+                                        + "'; skipping grib messages in file "
+                                        + gribFiles[i].toStdString());
+                        inconsistentVariables.insert(variableKey);
                     }
-
-                    // Insert the new MVariableInfo struct into the variable
-                    // name map..
-                    availableDataFields[levelType].insert(
-                                vinfo->variablename, vinfo);
-                    // ..and, if a CF standard name is available, into the std
-                    // name map.
-                    if (vinfo->standardname != "")
-                        availableDataFieldsByStdName[levelType].insert(
-                                    vinfo->standardname, vinfo);
                 }
+            }
+
+            if (inconsistentVariables.contains(variableKey)) continue;
+
+            registerGribIndexRecord(gmiInfo, gribFiles[i]);
+        }
+    }
 
-                long ensMember = gmiInfo.ensMember;
-                vinfo->availableMembers.insert(ensMember);
-                vinfo->availableMembers_bitfield |= (Q_UINT64_C(1) << ensMember);
 
-                // Get time values of this message.
-                QDateTime initTime = gmiInfo.initTime;
-                QDateTime validTime = gmiInfo.validTime;
+    // Perform checks, e.g. to make sure that for each data field all levels
+    // are present.
+    // =====================================================================
+
+    QString horizontalRefVarName = "";
+    MVerticalLevelType referenceLevelType;
+    LOG4CPLUS_DEBUG(mlog, "Checking consistency of indexed data fields...");
+    foreach (MVerticalLevelType levelType, availableDataFields.keys())
+    {
+        QStringList varNames = availableDataFields[levelType].keys();
+        QString referenceVarName = "";
+        QVector<double> referenceLevels;
+        foreach (QString varName, varNames)
+        {
+            // 1. Check if variable index is consistent in itself (i.e.
+            // the variable's vertical levels, time steps, etc. are all
+            // consistent.
+            // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+            if (!checkInternalConsistencyOfVariableIndex(
+                        availableDataFields[levelType][varName]))
+            {
+                delete availableDataFields[levelType].take(varName);
+                continue;
+            }
 
-                // Store filename and offset of grib message in index.
-                MGribDatafieldInfo *info = nullptr;
-                if (vinfo->timeMap[initTime][validTime].contains(ensMember))
+            // 2. Check if the variable is consistent to the "reference
+            // variable" (i.e. the first variable encountered) in this dataset
+            // (to make sure that all data fields of the data set are defined
+            // on the same grid etc.).
+            // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+            else if ( !disableGridConsistencyCheck )
+            {
+                if (horizontalRefVarName.isEmpty())
                 {
-                    info = &(vinfo->timeMap[initTime][validTime][ensMember]);
-                    if (info->filename != gribFileName)
-                    {
-                        LOG4CPLUS_ERROR(mlog, "found levels of the same "
-                                        "3D data field in different files"
-                                        "; skipping grib message");
-                        continue;
-                    }
+                    horizontalRefVarName = varName;
+                    referenceLevelType = levelType;
                 }
-                else
+
+                if (referenceLevels.isEmpty())
                 {
-                    info = &(vinfo->timeMap[initTime][validTime][ensMember]);
-                    info->filename = gribFileName;
+                    referenceVarName = varName;
+                    referenceLevels = availableDataFields[levelType][
+                            referenceVarName]->levels; // QVector copy
                 }
 
-                // Get vertical level.
-                long level = gmiInfo.level;
+                LOG4CPLUS_DEBUG(mlog, "Checking if variable '"
+                                << varName.toStdString()
+                                << "' ("
+                                << MStructuredGrid::verticalLevelTypeToString(
+                                    levelType).toStdString()
+                                << ") is consistent to the reference variable(s) '"
+                                << horizontalRefVarName.toStdString() << "'/'"
+                                << referenceVarName.toStdString() << "'...");
 
-                // Distinguish between ln surface pressure fields and surface
-                // pressure fields (in index files both are stored as
-                // surface_2D).
-                if (levelType == SURFACE_2D)
+                // Check consistency of vertical levels (QVector comparison).
+                if (availableDataFields[levelType][varName]->levels
+                        != referenceLevels)
                 {
-                    if (vinfo->variablename.startsWith("lnsp"))
-                    {
-                        setSurfacePressureFieldType("lnsp");
-                        level = 0;
-                        info->applyExp = true;
-                    }
-                    else if (vinfo->variablename.startsWith("sp"))
-                    {
-                        setSurfacePressureFieldType("sp");
-                        info->applyExp = false;
-                    }
+                    LOG4CPLUS_ERROR(mlog,
+                                    "ERROR: found difference in vertical levels to"
+                                    " reference variable '"
+                                    + referenceVarName.toStdString()
+                                    + "'; discarding variable: '"
+                                    + varName.toStdString() + "' [Dataset: "
+                                    + getIdentifier().toStdString() + "]");
+                    delete availableDataFields[levelType].take(varName);
+                    continue;
                 }
-                else
+
+                // Check consistency of horizontal coordinates.
+                // NOTE: Here we also determine a possible index shift in
+                // longitude for cyclic grids (last parameter set to "true").
+                else if (!checkHorizontalConsistencyOfVariableToReference(
+                             availableDataFields[referenceLevelType]
+                             [horizontalRefVarName],
+                             availableDataFields[levelType][varName],
+                             true))
                 {
-                    info->applyExp = false;
+                    LOG4CPLUS_ERROR(mlog,
+                                    "ERROR: found difference to reference"
+                                    " variable '"
+                                    + horizontalRefVarName.toStdString()
+                                    + "'; discarding variable: '"
+                                    + varName.toStdString() + "' [Dataset: "
+                                    + getIdentifier().toStdString() + "]");
+                    delete availableDataFields[levelType].take(varName);
+                    continue;
                 }
 
-                info->offsetForLevel[level] = gmiInfo.filePosition;
+                LOG4CPLUS_DEBUG(mlog, "... OK: variable '"
+                                << varName.toStdString()
+                                << "' is consistent to the reference variable(s).");
+            }
+        }
+    }
 
-                // Insert level into list of vertical levels for this
-                // variable.
-                if (!vinfo->levels.contains(level)) vinfo->levels << level;
+    // debugPrintLevelTypeMap(availableDataFields);
 
-                // That's it!
-            }
-        } // read index
+#ifdef ENABLE_MET3D_STOPWATCH
+    stopwatch.split();
+    LOG4CPLUS_DEBUG(mlog, "Directory scanned in "
+                    << stopwatch.getElapsedTime(MStopwatch::SECONDS)
+                    << " seconds.\n" << flush);
+#endif
+
+    //    gribReader->readGrid(
+    //                SURFACE_2D, "sp",
+    //                QDateTime::fromString("2012-10-17T00:00:00Z", Qt::ISODate),
+    //                QDateTime::fromString("2012-10-19T18:00:00Z", Qt::ISODate), 2
+    //                )->dumpGridData();
+    //    gribReader->readGrid(
+    //                PRESSURE_LEVELS_3D, "t",
+    //                QDateTime::fromString("2012-10-17T00:00:00Z", Qt::ISODate),
+    //                QDateTime::fromString("2012-10-19T18:00:00Z", Qt::ISODate), 2
+    //                )->dumpGridData();
+    //    gribReader->readGrid(
+    //                HYBRID_SIGMA_PRESSURE_3D, "t",
+    //                QDateTime::fromString("2012-10-15T00:00:00Z", Qt::ISODate),
+    //                QDateTime::fromString("2012-10-19T18:00:00Z", Qt::ISODate), 2
+    //                )->dumpGridData();
+}
 
-        // B) GRIB index file does not exist. Scan grib file and create index.
-        // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-        else
-        { // read from grib file and create new index
-            LOG4CPLUS_DEBUG(mlog, "Creating new index... please wait." << flush);
+MGribFileScanResult MGribReader::scanGribFile(const QString &gribFileName)
+{
+    MGribFileScanResult result;
 
-            // Open the file.
-            FILE* gribfile = NULL;
-            QByteArray ba = filePath.toLocal8Bit();
-            gribfile = fopen(ba.data(), "r");
-            if (!gribfile)
-            {
-                LOG4CPLUS_WARN(mlog, "Cannot open file "
-                               << filePath.toStdString() << ", skipping.");
-                continue;
-            }
+    LOG4CPLUS_DEBUG(mlog, "Scanning file "
+                    << gribFileName.toStdString() << " .." << flush);
 
-            if (ensembleIDIsSpecifiedInFileName)
-            {
-                ensembleIDFromFile = getEnsembleMemberIDFromFileName(gribFileName);
+    // First, read or create the grib index for fast access to messages.
+    // =================================================================
+
+    QString filePath = dataRoot.filePath(gribFileName);
+    QString fileIndexPath = QString("%1.met3d_grib_index").arg(filePath);
 
-                if (ensembleIDFromFile == -1)
+    // A) GRIB index file exists. Read from index.
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+    // If the grib index exists and is up to date, read it. Otherwise,
+    // (re-)create it and store it.
+    if (QFile::exists(fileIndexPath))
+    {
+        LOG4CPLUS_DEBUG(mlog, "Reading grib index for file "
+                        << gribFileName.toStdString() << " ..");
+
+        if (readGribIndex(fileIndexPath, filePath, &result.indexRecords))
+        {
+            return result;
+        }
+
+        LOG4CPLUS_WARN(mlog, "grib index of file "
+                       << gribFileName.toStdString() << " is "
+                       "outdated or invalid; re-creating index.");
+        result.indexRecords.clear();
+    } // read index
+
+    // B) No valid GRIB index file exists. Scan grib file and create index.
+    // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+    LOG4CPLUS_DEBUG(mlog, "Creating new index... please wait." << flush);
+
+    // Open the file.
+    FILE* gribfile = NULL;
+    QByteArray ba = filePath.toLocal8Bit();
+    gribfile = fopen(ba.data(), "r");
+    if (!gribfile)
+    {
+        LOG4CPLUS_WARN(mlog, "Cannot open file "
+                       << filePath.toStdString() << ", skipping.");
+        return result;
+    }
+
+    int ensembleIDFromFile = -1;
+    if (ensembleIDIsSpecifiedInFileName)
+    {
+        ensembleIDFromFile = getEnsembleMemberIDFromFileName(gribFileName);
+
+        if (ensembleIDFromFile == -1)
+        {
+            LOG4CPLUS_ERROR(mlog, "ERROR: ensemble tag found in file filter "
+                                  " but filter did not match file \""
+                            << gribFileName.toStdString()
+                            << "\" (currently only integer values are allowed"
+                               " as ensemble member specifiers)." << flush);
+            fclose(gribfile);
+            return result;
+        }
+    }
+
+    // Variables encountered in this file. The first message of a variable
+    // determines its properties; all further messages of the variable only
+    // store the variable name in the index (the catalogue of the reader is
+    // only modified in the serial merge phase of scanDataRoot()).
+    QMap<QPair<int, QString>, MGribVariableInfo> fileVariables;
+
+    // Loop over grib messages contained in the file.
+    grib_handle* gribHandle = NULL;
+    int err = 0;
+    int messageCount = 0;
+
+    try
+    {
+        forever
+        {
+            // Get current file position to store in the index for this
+            // message.
+            long filePosition = ftell(gribfile);
+
+            gribHandle = grib_handle_new_from_file(0, gribfile, &err);
+            if (gribHandle == NULL) break;
+
+            MGribMessageIndexInfo gmiInfo;
+
+            // Determine type of data fields (analysis, deterministic,
+            // ensemble). Append type to variable name so variables with
+            // the same name but different types can be distinguished).
+            // If ensemble members are stored implicitly, all variables
+            // read are of ensemble data type.
+            QString dataType = "";
+            if (!ensembleIDIsSpecifiedInFileName)
+            {
+                try {
+                    dataType = getGribStringKey(gribHandle, "ls.dataType");
+                }
+                catch (MGribError& e)
                 {
-                    LOG4CPLUS_ERROR(mlog, "ERROR: ensemble tag found in file filter "
-                                          " but filter did not match file \""
-                                    << gribFileName.toStdString()
-                                    << "\" (currently only integer values are allowed"
-                                       " as ensemble member specifiers)." << flush);
+                    LOG4CPLUS_WARN(mlog, "Unable to determine dataType of "
+                                         "grid (ECMWF uses an, fc, pf, cf), "
+                                         "skipping this field.");
+                    grib_handle_delete(gribHandle);
                     continue;
                 }
+                // Perturbed (pf) and control (cf) forecasts are combined
+                // into "ensemble" (ens) forecasts.
+                if ( (dataType == "pf") || (dataType == "cf"))
+                {
+                    dataType = "ens";
+                }
+            }
+            else
+            {
+                dataType = "ens";
             }
 
-            // Open a new index file.
-            QFile indexFile(fileIndexPath);
-            indexFile.open(QIODevice::WriteOnly);
-            QDataStream indexDataStream(&indexFile);
-            // Write index file header (version number "2" for now; this may
-            // be changed in the future when the index format changes).
-            indexDataStream << (qint32)2;
-            indexDataStream.setVersion(QDataStream::Qt_4_8);
-
-            // lnsp model level fix (ECMWF inconsistency: lnsp is stored on
-            // a single model level, not as a surface field...).
-            bool fixLNSPmodelLevel = false;
+            // Currently Met.3D can only handle data fields on a regular
+            // lat/lon grid in the horizontal.
+            QString gridType = getGribStringKey(gribHandle,
+                                                "geography.gridType");
+            LOG4CPLUS_DEBUG(mlog, "geography.gridType: "
+                            << gridType.toStdString());
+            if (gridType != "regular_ll")
+            {
+                LOG4CPLUS_WARN(mlog, "Met.3D can only handle 'regular_ll' "
+                               "grid, skipping this field.");
+                grib_handle_delete(gribHandle);
+                continue;
+            }
 
-            // Loop over grib messages contained in the file.
-            grib_handle* gribHandle = NULL;
-            int err = 0;
-            int messageCount = 0;
+            // Determine the type of the vertical level of the variable.
+            QString typeOfLevel = getGribStringKey(gribHandle,
+                                                   "vertical.typeOfLevel");
+
+            MVerticalLevelType levelType;
+            if (typeOfLevel == "surface")
+                levelType = SURFACE_2D;
+            else if (typeOfLevel == "isobaricInhPa")
+                levelType = PRESSURE_LEVELS_3D;
+            else if (typeOfLevel == "hybrid")
+                levelType = HYBRID_SIGMA_PRESSURE_3D;
+            else if (typeOfLevel == "potentialVorticity")
+                levelType = POTENTIAL_VORTICITY_2D;
+            else
+            {
+                // If neither of the above choices could be matched,
+                // discard this variable and continue.
+                LOG4CPLUS_WARN(mlog, "cannot recognize level type '"
+                               << typeOfLevel.toStdString()
+                               << "', skipping this field.");
+                grib_handle_delete(gribHandle);
+                continue;
+            }
+            gmiInfo.levelType = levelType;
+
+            // Determine the variable name.
+            QString shortName = getGribStringKey(gribHandle,
+                                                 "parameter.shortName");
+            QString varName = QString("%1 (%2)").arg(shortName).arg(dataType);
+
+            // Handle special case "lnsp". "lnsp" fields at ECMWF are
+            // stored on model level 1 (not as a surface field). In Met.3D,
+            // we re-cast as a surface field (which it is...). (The surface
+            // pressure field type is set in the merge phase, see
+            // registerGribIndexRecord().)
+            if (shortName == "lnsp" && levelType == HYBRID_SIGMA_PRESSURE_3D)
+            {
+                levelType = SURFACE_2D;
+                gmiInfo.levelType = levelType;
+            }
 
-            // Get current file position to store in the index for this message
-            // (see end of loop).
-            long filePosition = ftell(gribfile);
-            // LOG4CPLUS_DEBUG(mlog, "file position: " << filePosition);
+            // Look up the MGribVariableInfo struct of this variable in the
+            // current file or create a new one.
+            QPair<int, QString> variableKey(levelType, varName);
+            MGribVariableInfo* vinfo;
+            if (fileVariables.contains(variableKey))
+            {
+                vinfo = &fileVariables[variableKey];
+
+                MGribVariableInfo currentVInfo;
+                currentVInfo.nlons = getGribLongKey(gribHandle, "Ni");
+                currentVInfo.nlats = getGribLongKey(gribHandle, "Nj");
+                currentVInfo.lon0 = getGribDoubleKey(
+                            gribHandle, "longitudeOfFirstGridPointInDegrees");
+                currentVInfo.lat0 = getGribDoubleKey(
+                            gribHandle, "latitudeOfFirstGridPointInDegrees");
+                currentVInfo.lon1 = getGribDoubleKey(
+                            gribHandle, "longitudeOfLastGridPointInDegrees");
+                currentVInfo.lat1 = getGribDoubleKey(
+                            gribHandle, "latitudeOfLastGridPointInDegrees");
+                currentVInfo.dlon = getGribDoubleKey(
+                            gribHandle, "iDirectionIncrementInDegrees");
+                currentVInfo.dlat = getGribDoubleKey(
+                            gribHandle, "jDirectionIncrementInDegrees");
+
+                if (!checkHorizontalConsistencyOfVariableToReference(
+                            vinfo, &currentVInfo))
+                {
+                    LOG4CPLUS_ERROR(mlog, "found different geographical "
+                                    "region than previously used for "
+                                    "variable '" + varName.toStdString()
+                                    + "'; skipping grib message");
+                    grib_handle_delete(gribHandle);
+                    continue;
+                }
 
-            while ((gribHandle =
-                    grib_handle_new_from_file(0, gribfile, &err)) != NULL)
+                // Copy data to gmiInfo.
+                // NOTE: Only "variablename" is required as map key
+                // for vinfo when the index is read; all other variables
+                // can be ommitted -- they are only read from the first
+                // message of the current variable in this file. This saves
+                // a huge amount of data in the index!
+                gmiInfo.variablename = vinfo->variablename;
+                // end copy
+            }
+            else
             {
-                fixLNSPmodelLevel = false;
-                // LOG4CPLUS_DEBUG(mlog, "=========> Indexing message "
-                //                 << messageCount);
-
-                MGribMessageIndexInfo gmiInfo;
-
-                // Determine type of data fields (analysis, deterministic,
-                // ensemble). Append type to variable name so variables with
-                // the same name but different types can be distinguished).
-                // If ensemble members are stored implicitly, all variables 
-                // read are of ensemble data type.
-                QString dataType = "";
-                if (!ensembleIDIsSpecifiedInFileName)
+                vinfo = &fileVariables[variableKey];
+                vinfo->variablename = gmiInfo.variablename = varName;
+                vinfo->longname = gmiInfo.longname =
+                        getGribStringKey(gribHandle, "parameter.name");
+//TODO (mr, 02Oct2014): fill standard name field.
+                vinfo->standardname = gmiInfo.standardname = "";
+                vinfo->units = gmiInfo.units =
+                        getGribStringKey(gribHandle, "parameter.units");
+
+                if (dataType == "an") vinfo->fcType = ANALYSIS;
+                else if (dataType == "fc") vinfo->fcType = DETERMINISTIC_FORECAST;
+                else if (dataType == "ens") vinfo->fcType = ENSEMBLE_FORECAST;
+                else vinfo->fcType = INVALID_TYPE;
+                gmiInfo.fcType = vinfo->fcType;
+
+                vinfo->nlons = gmiInfo.nlons = getGribLongKey(
+                            gribHandle, "Ni");
+                vinfo->nlats = gmiInfo.nlats = getGribLongKey(
+                            gribHandle, "Nj");
+                vinfo->lon0 = gmiInfo.lon0 = getGribDoubleKey(
+                            gribHandle, "longitudeOfFirstGridPointInDegrees");
+                vinfo->lat0 = gmiInfo.lat0 = getGribDoubleKey(
+                            gribHandle, "latitudeOfFirstGridPointInDegrees");
+                vinfo->lon1 = gmiInfo.lon1 = getGribDoubleKey(
+                            gribHandle, "longitudeOfLastGridPointInDegrees");
+                vinfo->lat1 = gmiInfo.lat1 = getGribDoubleKey(
+                            gribHandle, "latitudeOfLastGridPointInDegrees");
+                vinfo->dlon = gmiInfo.dlon = getGribDoubleKey(
+                            gribHandle, "iDirectionIncrementInDegrees");
+                vinfo->dlat = gmiInfo.dlat = getGribDoubleKey(
+                            gribHandle, "jDirectionIncrementInDegrees");
+
+                // Fill lat/lon arrays.
+                vinfo->lons.resize(vinfo->nlons);
+                double lon0 = (vinfo->lon0 > vinfo->lon1) ?
+                            vinfo->lon0 - 360. : vinfo->lon0;
+                for (int ilon = 0; ilon < vinfo->nlons; ilon ++)
+                    vinfo->lons[ilon] = lon0 + ilon*vinfo->dlon;
+                gmiInfo.lons = vinfo->lons;
+
+                vinfo->lats.resize(vinfo->nlats);
+                for (int ilat = 0; ilat < vinfo->nlats; ilat ++)
+                    vinfo->lats[ilat] = vinfo->lat0 - ilat*vinfo->dlat;
+                gmiInfo.lats = vinfo->lats;
+
+                if (levelType == HYBRID_SIGMA_PRESSURE_3D)
                 {
-                    try {
-                        dataType = getGribStringKey(gribHandle, "ls.dataType");
+                    // The surface pressure field type is only known here if
+                    // it has been specified in the pipeline configuration;
+                    // otherwise the name is filled in during the merge
+                    // phase and the index is written there.
+                    if (surfacePressureFieldType != "")
+                    {
+                        gmiInfo.surfacePressureName =
+                                QString("%1 (%2)").arg(surfacePressureFieldType)
+                                .arg(dataType);
                     }
-                    catch (MGribError& e)
+                    else
                     {
-                        LOG4CPLUS_WARN(mlog, "Unable to determine dataType of "
-                                             "grid (ECMWF uses an, fc, pf, cf), "
-                                             "skipping this field.");
-                        grib_handle_delete(gribHandle);
-                        continue;
+                        result.indexNeedsUpdate = true;
                     }
-                    // LOG4CPLUS_DEBUG(mlog, "ls.dataType: " << dataType.toStdString());
-                    // Perturbed (pf) and control (cf) forecasts are combined into
-                    // "ensemble" (ens) forecasts.
-                    if ( (dataType == "pf") || (dataType == "cf"))
+
+                    // Read hybrid level coefficients.
+                    double *akbk = new double[300];
+                    size_t akbk_len = 300;
+
+                    // NOTE: Grib stores half level interface coefficients.
+                    GRIB_CHECK(grib_get_double_array(gribHandle, "pv",
+                                                     akbk, &akbk_len), 0);
+
+                    int numLevels = (akbk_len / 2) - 1; // -1 to exclude surface
+                    gmiInfo.aki_hPa.resize(numLevels+1);
+                    gmiInfo.bki.resize(numLevels+1);
+                    gmiInfo.ak_hPa.resize(numLevels);
+                    gmiInfo.bk.resize(numLevels);
+
+                    for (int il = 0; il <= numLevels; il++)
                     {
-                        dataType = "ens";
+                        gmiInfo.aki_hPa[il] = akbk[il] / 100.;
+                        gmiInfo.bki[il] = akbk[il + numLevels+1];
+
+                        if (il < numLevels)
+                        {
+                            // Compute full level coefficients.
+                            gmiInfo.ak_hPa[il] =
+                                    akbk[il] + (akbk[il+1]-akbk[il]) / 2.;
+                            gmiInfo.ak_hPa[il] /= 100.; // convert to hPa
+                            gmiInfo.bk[il] =
+                                    akbk[il + numLevels+1]
+                                    + ( akbk[il+1 + numLevels+1]
+                                    - akbk[il + numLevels+1] ) / 2.;
+                        }
                     }
+
+                    delete[] akbk;
                 }
-                else
+            }
+
+            // Determine ensemble member of this data field. Deterministic
+            // and analysis datafields are stored as member "0".
+            long ensMember = 0;
+            if (vinfo->fcType == ENSEMBLE_FORECAST)
+            {
+                if (ensembleIDIsSpecifiedInFileName)
                 {
-                    dataType = "ens";
+                    ensMember = ensembleIDFromFile;
                 }
-
-                // Currently Met.3D can only handle data fields on a regular
-                // lat/lon grid in the horizontal.
-                QString gridType = getGribStringKey(gribHandle, "geography.gridType");
-                LOG4CPLUS_DEBUG(mlog, "geography.gridType: " << gridType.toStdString());
-                if (gridType != "regular_ll")
+                else
                 {
-                    LOG4CPLUS_WARN(mlog, "Met.3D can only handle 'regular_ll' "
-                                   "grid, skipping this field.");
-                    grib_handle_delete(gribHandle);
-                    continue;
+                    ensMember = getGribLongKey(gribHandle,
+                                               "perturbationNumber");
                 }
+            }
+            gmiInfo.ensMember = ensMember;
+
+            // Get time values of this variable.
+            long dataDate = getGribLongKey(gribHandle, "time.dataDate");
+            long dataTime = getGribLongKey(gribHandle, "time.dataTime");
+
+            QString initTimeStr = QString("%1_%2").arg(dataDate)
+                    .arg(dataTime, 4, 10, QChar('0'));
+            QDateTime initTime = QDateTime::fromString(initTimeStr,
+                                                       "yyyyMMdd_hhmm");
+            initTime.setTimeSpec(Qt::UTC);
+            gmiInfo.initTime = initTime;
+
+            long validityDate = getGribLongKey(gribHandle,
+                                               "time.validityDate");
+            long validityTime = getGribLongKey(gribHandle,
+                                               "time.validityTime");
+
+            QString validTimeStr = QString("%1_%2").arg(validityDate)
+                    .arg(validityTime, 4, 10, QChar('0'));
+            QDateTime validTime = QDateTime::fromString(validTimeStr,
+                                                       "yyyyMMdd_hhmm");
+            validTime.setTimeSpec(Qt::UTC);
+            gmiInfo.validTime = validTime;
+
+            // Get vertical level and store the offset of the grib message
+            // in the index.
+            gmiInfo.level = getGribLongKey(gribHandle, "vertical.level");
+            gmiInfo.filePosition = filePosition;
+
+            // That's it!
+            grib_handle_delete(gribHandle);
+            messageCount++;
+
+            // Add index struct to index records.
+            result.indexRecords << gmiInfo;
+        } // for (grib messages)
+    }
+    catch (MException &e)
+    {
+        LOG4CPLUS_ERROR(mlog, "ERROR: cannot index file "
+                        << gribFileName.toStdString() << " (" << e.what()
+                        << "); skipping file.");
+        if (gribHandle != NULL) grib_handle_delete(gribHandle);
+        fclose(gribfile);
+        result.indexRecords.clear();
+        return result;
+    }
+
+    if (messageCount == 0)
+    {
+        LOG4CPLUS_DEBUG(mlog, "No grib messages found.");
+    }
+    else
+    {
+        LOG4CPLUS_DEBUG(mlog, "Indexed " << messageCount
+                        << " grib messages.");
+    }
+
+    fclose(gribfile);
 
-                // Determine the type of the vertical level of the variable.
-                QString typeOfLevel = getGribStringKey(gribHandle, "vertical.typeOfLevel");
-                // LOG4CPLUS_DEBUG(mlog, "vertical.typeOfLevel: " << typeOfLevel.toStdString());
-
-                MVerticalLevelType levelType;
-                if (typeOfLevel == "surface")
-                    levelType = SURFACE_2D;
-                else if (typeOfLevel == "isobaricInhPa")
-                    levelType = PRESSURE_LEVELS_3D;
-                else if (typeOfLevel == "hybrid")
-                    levelType = HYBRID_SIGMA_PRESSURE_3D;
-                else if (typeOfLevel == "potentialVorticity")
-                    levelType = POTENTIAL_VORTICITY_2D;
-                else
-                {
-                    // If neither of the above choices could be matched,
-                    // discard this variable and continue.
-                    LOG4CPLUS_WARN(mlog, "cannot recognize level type '"
-                                   << typeOfLevel.toStdString()
-                                   << "', skipping this field.");
-                    grib_handle_delete(gribHandle);
-                    continue;
-                }
-                gmiInfo.levelType = levelType;
+    // Indices that lack surface pressure names are written after the names
+    // have been determined in the merge phase.
+    if (!result.indexNeedsUpdate)
+    {
+        writeGribIndex(fileIndexPath, filePath, result.indexRecords);
+    }
 
-                // Determine the variable name.
-                QString shortName = getGribStringKey(gribHandle, "parameter.shortName");
-                // LOG4CPLUS_DEBUG(mlog, "parameter.shortName: " << shortName.toStdString());
-                QString varName = QString("%1 (%2)").arg(shortName).arg(dataType);
+    return result;
+}
 
-                // Handle special case "lnsp". "lnsp" fields at ECMWF are
-                // stored on model level 1 (not as a surface field). In Met.3D,
-                // we re-cast as a surface field (which it is...).
-                if (shortName == "lnsp" && levelType == HYBRID_SIGMA_PRESSURE_3D)
-                {
-                    levelType = SURFACE_2D;
-                    gmiInfo.levelType = levelType;
-                    fixLNSPmodelLevel = true;
-                    setSurfacePressureFieldType("lnsp");
 
-                }
-                else if (shortName == "sp")
-                {
-                    setSurfacePressureFieldType("sp");
-                }
+void MGribReader::registerGribIndexRecord(const MGribMessageIndexInfo &gmiInfo,
+                                          const QString &gribFileName)
+{
+    MVerticalLevelType levelType = gmiInfo.levelType;
 
-                // Create a new MVariableInfo struct and store availabe
-                // variable information in this field.
-                MGribVariableInfo* vinfo;
-                if (availableDataFields[levelType].contains(varName))
-                {
-                    vinfo = availableDataFields[levelType].value(varName);
+    // Create a new MVariableInfo struct and store available
+    // variable information in this field.
+    MGribVariableInfo* vinfo;
+    if (availableDataFields[levelType].contains(gmiInfo.variablename))
+    {
+        vinfo = availableDataFields[levelType].value(gmiInfo.variablename);
 
-                    MGribVariableInfo currentVInfo;
-                    currentVInfo.nlons = getGribLongKey(gribHandle, "Ni");
-                    currentVInfo.nlats = getGribLongKey(gribHandle, "Nj");
-                    currentVInfo.lon0 = getGribDoubleKey(
-                                gribHandle, "longitudeOfFirstGridPointInDegrees");
-                    currentVInfo.lat0 = getGribDoubleKey(
-                                gribHandle, "latitudeOfFirstGridPointInDegrees");
-                    currentVInfo.lon1 = getGribDoubleKey(
-                                gribHandle, "longitudeOfLastGridPointInDegrees");
-                    currentVInfo.lat1 = getGribDoubleKey(
-                                gribHandle, "latitudeOfLastGridPointInDegrees");
-                    currentVInfo.dlon = getGribDoubleKey(
-                                gribHandle, "iDirectionIncrementInDegrees");
-                    currentVInfo.dlat = getGribDoubleKey(
-                                gribHandle, "jDirectionIncrementInDegrees");
+        // Domain checks have already been run on index creation;
+        // skip them here (see below).
+    }
+    else
+    {
+        vinfo = new MGribVariableInfo();
+        vinfo->variablename = gmiInfo.variablename;
+        vinfo->longname = gmiInfo.longname;
+        vinfo->standardname = gmiInfo.standardname;
+        vinfo->units = gmiInfo.units;
+        vinfo->fcType = gmiInfo.fcType;
+
+        vinfo->nlons = gmiInfo.nlons;
+        vinfo->nlats = gmiInfo.nlats;
+        vinfo->lon0 = gmiInfo.lon0;
+        vinfo->lat0 = gmiInfo.lat0;
+        vinfo->lon1 = gmiInfo.lon1;
+        vinfo->lat1 = gmiInfo.lat1;
+        vinfo->dlon = gmiInfo.dlon;
+        vinfo->dlat = gmiInfo.dlat;
+
+        // Fill lat/lon arrays (QVector copy).
+        vinfo->lons = gmiInfo.lons;
+        vinfo->lats = gmiInfo.lats;
+        // TODO (bt, 08FEB2017) Adapt to set type according to the data read.
+        vinfo->horizontalGridType = MHorizontalGridType::REGULAR_LONLAT_GRID;
+
+        // Check if grid spans globe in longitude (cyclic in lon).
+        double lonWest = MMOD(vinfo->lon0, 360.);
+        double lonEast = MMOD(vinfo->lon1 + vinfo->dlon, 360.);
+        vinfo->gridIsCyclicInLongitude =
+                floatIsAlmostEqualRelativeAndAbs(
+                    lonWest, lonEast, M_LONLAT_RESOLUTION);
+        vinfo->longitudinalIndexShiftForCyclicGrid = 0;
+
+        if (levelType == HYBRID_SIGMA_PRESSURE_3D)
+        {
+            vinfo->surfacePressureName = gmiInfo.surfacePressureName;
+            vinfo->aki_hPa = gmiInfo.aki_hPa;
+            vinfo->bki = gmiInfo.bki;
+            vinfo->ak_hPa = gmiInfo.ak_hPa;
+            vinfo->bk = gmiInfo.bk;
+        }
 
-                    if (!checkHorizontalConsistencyOfVariableToReference(
-                                vinfo, &currentVInfo))
-                    {
-                        LOG4CPLUS_ERROR(mlog, "found different geographical "
-                                        "region than previously used for "
-                                        "variable '" + varName.toStdString()
-                                        + "'; skipping grib message");
-                        grib_handle_delete(gribHandle);
-                        continue;
-                    }
+        // Insert the new MVariableInfo struct into the variable
+        // name map..
+        availableDataFields[levelType].insert(
+                    vinfo->variablename, vinfo);
+        // ..and, if a CF standard name is available, into the std
+        // name map.
+        if (vinfo->standardname != "")
+            availableDataFieldsByStdName[levelType].insert(
+                        vinfo->standardname, vinfo);
+    }
 
-                    // Copy data to gmiInfo.
-                    // NOTE: Only "variablename" is required as map key
-                    // for vinfo when the index is read; all other variables
-                    // can be ommitted -- they are only read from the first
-                    // message of the current variable (when a new vinfo is
-                    // created). This saves a huge amount of data in the index!
-                    gmiInfo.variablename = vinfo->variablename;
-                    // end copy
-                }
-                else
-                {
-                    vinfo = new MGribVariableInfo();
-                    vinfo->variablename = gmiInfo.variablename = varName;
-                    vinfo->longname = gmiInfo.longname =
-                            getGribStringKey(gribHandle, "parameter.name");
-//TODO (mr, 02Oct2014): fill standard name field.
-                    vinfo->standardname = gmiInfo.standardname = "";
-                    vinfo->units = gmiInfo.units =
-                            getGribStringKey(gribHandle, "parameter.units");
-
-                    if (dataType == "an") vinfo->fcType = ANALYSIS;
-                    else if (dataType == "fc") vinfo->fcType = DETERMINISTIC_FORECAST;
-                    else if (dataType == "ens") vinfo->fcType = ENSEMBLE_FORECAST;
-                    else vinfo->fcType = INVALID_TYPE;
-
-                    vinfo->nlons = gmiInfo.nlons = getGribLongKey(
-                                gribHandle, "Ni");
-                    vinfo->nlats = gmiInfo.nlats = getGribLongKey(
-                                gribHandle, "Nj");
-                    vinfo->lon0 = gmiInfo.lon0 = getGribDoubleKey(
-                                gribHandle, "longitudeOfFirstGridPointInDegrees");
-                    vinfo->lat0 = gmiInfo.lat0 = getGribDoubleKey(
-                                gribHandle, "latitudeOfFirstGridPointInDegrees");
-                    vinfo->lon1 = gmiInfo.lon1 = getGribDoubleKey(
-                                gribHandle, "longitudeOfLastGridPointInDegrees");
-                    vinfo->lat1 = gmiInfo.lat1 = getGribDoubleKey(
-                                gribHandle, "latitudeOfLastGridPointInDegrees");
-                    vinfo->dlon = gmiInfo.dlon = getGribDoubleKey(
-                                gribHandle, "iDirectionIncrementInDegrees");
-                    vinfo->dlat = gmiInfo.dlat = getGribDoubleKey(
-                                gribHandle, "jDirectionIncrementInDegrees");
-
-                    // Check if grid spans globe in longitude (cyclic in lon).
-                    double lonWest = MMOD(vinfo->lon0, 360.);
-                    double lonEast = MMOD(vinfo->lon1 + vinfo->dlon, 360.);
-                    vinfo->gridIsCyclicInLongitude =
-                            floatIsAlmostEqualRelativeAndAbs(
-                                lonWest, lonEast, M_LONLAT_RESOLUTION);
-
-                    // Fill lat/lon arrays.
-                    vinfo->lons.resize(vinfo->nlons);
-                    double lon0 = (vinfo->lon0 > vinfo->lon1) ?
-                                vinfo->lon0 - 360. : vinfo->lon0;
-                    for (int ilon = 0; ilon < vinfo->nlons; ilon ++)
-                        vinfo->lons[ilon] = lon0 + ilon*vinfo->dlon;
-                    gmiInfo.lons = vinfo->lons;
-
-                    vinfo->lats.resize(vinfo->nlats);
-                    for (int ilat = 0; ilat < vinfo->nlats; ilat ++)
-                        vinfo->lats[ilat] = vinfo->lat0 - ilat*vinfo->dlat;
-                    gmiInfo.lats = vinfo->lats;
-
-                    if (levelType == HYBRID_SIGMA_PRESSURE_3D)
-                    {
-                        detectSurfacePressureFieldType(&availableFiles);
+    long ensMember = gmiInfo.ensMember;
+    vinfo->availableMembers.insert(ensMember);
+    vinfo->availableMembers_bitfield |= (Q_UINT64_C(1) << ensMember);
 
-                        vinfo->surfacePressureName =
-                                gmiInfo.surfacePressureName =
-                                QString("%1 (%2)").arg(surfacePressureFieldType)
-                                .arg(dataType);
+    // Get time values of this message.
+    QDateTime initTime = gmiInfo.initTime;
+    QDateTime validTime = gmiInfo.validTime;
 
-                        // Read hybrid level coefficients.
-                        double *akbk = new double[300];
-                        size_t akbk_len = 300;
+    // Store filename and offset of grib message in index.
+    MGribDatafieldInfo *info = nullptr;
+    if (vinfo->timeMap[initTime][validTime].contains(ensMember))
+    {
+        info = &(vinfo->timeMap[initTime][validTime][ensMember]);
+        if (info->filename != gribFileName)
+        {
+            LOG4CPLUS_ERROR(mlog, "found levels of the same "
+                            "3D data field in different files"
+                            "; skipping grib message");
+            return;
+        }
+    }
+    else
+    {
+        info = &(vinfo->timeMap[initTime][validTime][ensMember]);
+        info->filename = gribFileName;
+    }
 
-                        // NOTE: Grib stores half level interface coefficients.
-                        GRIB_CHECK(grib_get_double_array(gribHandle, "pv",
-                                                         akbk, &akbk_len), 0);
+    // Get vertical level.
+    long level = gmiInfo.level;
 
-                        int numLevels = (akbk_len / 2) - 1; // -1 to exclude surface
-                        vinfo->aki_hPa.resize(numLevels+1);
-                        vinfo->bki.resize(numLevels+1);
-                        vinfo->ak_hPa.resize(numLevels);
-                        vinfo->bk.resize(numLevels);
+    // Distinguish between ln surface pressure fields and surface
+    // pressure fields (in index files both are stored as
+    // surface_2D).
+    if (levelType == SURFACE_2D)
+    {
+        if (vinfo->variablename.startsWith("lnsp"))
+        {
+            setSurfacePressureFieldType("lnsp");
+            level = 0;
+            info->applyExp = true;
+        }
+        else if (vinfo->variablename.startsWith("sp"))
+        {
+            setSurfacePressureFieldType("sp");
+            info->applyExp = false;
+        }
+    }
+    else
+    {
+        info->applyExp = false;
+    }
 
-                        for (int il = 0; il <= numLevels; il++)
-                        {
-                            vinfo->aki_hPa[il] = akbk[il] / 100.;
-                            vinfo->bki[il] = akbk[il + numLevels+1];
-
-                            if (il < numLevels)
-                            {
-                                // Compute full level coefficients.
-                                vinfo->ak_hPa[il] =
-                                        akbk[il] + (akbk[il+1]-akbk[il]) / 2.;
-                                vinfo->ak_hPa[il] /= 100.; // convert to hPa
-                                vinfo->bk[il] =
-                                        akbk[il + numLevels+1]
-                                        + ( akbk[il+1 + numLevels+1]
-                                        - akbk[il + numLevels+1] ) / 2.;
-                            }
-                        }
+    if (info->offsetForLevel.contains(level))
+    {
+        LOG4CPLUS_ERROR(mlog, "level " << level <<
+                        " of data field "
+                        << gmiInfo.variablename.toStdString()
+                        << " already exists; skipping grib message");
+        return;
+    }
+    info->offsetForLevel[level] = gmiInfo.filePosition;
 
-                        delete[] akbk;
+    // Insert level into list of vertical levels for this
+    // variable.
+    if (!vinfo->levels.contains(level)) vinfo->levels << level;
 
-                        gmiInfo.aki_hPa = vinfo->aki_hPa;
-                        gmiInfo.bki = vinfo->bki;
-                        gmiInfo.ak_hPa = vinfo->ak_hPa;
-                        gmiInfo.bk = vinfo->bk;
-                    }
+    // That's it!
+}
 
-                    // Insert the new MVariableInfo struct into the variable
-                    // name map..
-                    availableDataFields[levelType].insert(
-                                vinfo->variablename, vinfo);
-                    // ..and, if a CF standard name is available, into the std
-                    // name map.
-                    if (vinfo->standardname != "")
-                        availableDataFieldsByStdName[levelType].insert(
-                                    vinfo->standardname, vinfo);
-                }
 
-                // Determine ensemble member of this data field. Deterministic
-                // and analysis datafields are stored as member "0".
-                long ensMember = 0;
-                if (vinfo->fcType == ENSEMBLE_FORECAST)
-                {
-                    if (ensembleIDIsSpecifiedInFileName)
-                    {
-                        ensMember = ensembleIDFromFile;
-                    }
-                    else
-                    {
-                        ensMember = getGribLongKey(gribHandle,
-                                                   "perturbationNumber");
-                        // LOG4CPLUS_DEBUG(mlog, "perturbationNumber: " << ensMember);
-                    }
-                }
-                vinfo->availableMembers.insert(ensMember);
-                vinfo->availableMembers_bitfield |= (Q_UINT64_C(1) << ensMember);
-                gmiInfo.ensMember = ensMember;
-
-                // Get time values of this variable.
-                long dataDate = getGribLongKey(gribHandle, "time.dataDate");
-                // LOG4CPLUS_DEBUG(mlog, "time.dataDate: " << dataDate);
-                long dataTime = getGribLongKey(gribHandle, "time.dataTime");
-                // LOG4CPLUS_DEBUG(mlog, "time.dataTime: " << dataTime);
-
-                QString initTimeStr = QString("%1_%2").arg(dataDate)
-                        .arg(dataTime, 4, 10, QChar('0'));
-                QDateTime initTime = QDateTime::fromString(initTimeStr,
-                                                           "yyyyMMdd_hhmm");
-                initTime.setTimeSpec(Qt::UTC);
-                gmiInfo.initTime = initTime;
-
-                long validityDate = getGribLongKey(gribHandle, "time.validityDate");
-                // LOG4CPLUS_DEBUG(mlog, "time.validityDate: " << validityDate);
-
-                long validityTime = getGribLongKey(gribHandle, "time.validityTime");
-                // LOG4CPLUS_DEBUG(mlog, "time.validityTime: " << validityTime);
-
-                QString validTimeStr = QString("%1_%2").arg(validityDate)
-                        .arg(validityTime, 4, 10, QChar('0'));
-                QDateTime validTime = QDateTime::fromString(validTimeStr,
-                                                           "yyyyMMdd_hhmm");
-                validTime.setTimeSpec(Qt::UTC);
-                gmiInfo.validTime = validTime;
-
-                // Store filename and offset of grib message in index.
-                MGribDatafieldInfo *info = nullptr;
-                if (vinfo->timeMap[initTime][validTime].contains(ensMember))
-                {
-                    info = &(vinfo->timeMap[initTime][validTime][ensMember]);
-                    if (info->filename != gribFileName)
-                    {
-                        LOG4CPLUS_ERROR(mlog, "found levels of the same "
-                                        "3D data field in different files"
-                                        "; skipping grib message");
-                        grib_handle_delete(gribHandle);
-                        continue;
-                    }
-                }
-                else
-                {
-                    info = &(vinfo->timeMap[initTime][validTime][ensMember]);
-                    info->filename = gribFileName;
-                }
+// Layout of version 3 GRIB index files (all values little-endian); see
+// MGribMessageIndexInfo in gribreader.h.
+const char    GRIB_INDEX_MAGIC[8] = {'M','E','T','3','D','G','I','X'};
+const quint32 GRIB_INDEX_VERSION = 3;
+const qint64  GRIB_INDEX_HEADER_SIZE = 80;
+const qint64  GRIB_INDEX_VARIABLE_RECORD_SIZE = 144;
+const qint64  GRIB_INDEX_MESSAGE_RECORD_SIZE = 48;
 
-                // Get vertical level.
-                long level = gmiInfo.level = getGribLongKey(
-                            gribHandle, "vertical.level");
-                if (fixLNSPmodelLevel)
-                {
-                    level = 0;
-                }
-                info->applyExp = fixLNSPmodelLevel;
+template<typename T> inline T readLE(const uchar *p, qint64 offset)
+{ return qFromLittleEndian<T>(p + offset); }
 
-                // LOG4CPLUS_DEBUG(mlog, "vertical.level: " << level);
+inline double readLEDouble(const uchar *p, qint64 offset)
+{
+    quint64 bits = qFromLittleEndian<quint64>(p + offset);
+    double d; memcpy(&d, &bits, sizeof(double)); return d;
+}
 
-                if (info->offsetForLevel.keys().contains(level))
-                {
-                    LOG4CPLUS_ERROR(mlog, "level " << level <<
-                                    " of data field " << varName.toStdString()
-                                    << "already exists; skipping grib message");
-                    grib_handle_delete(gribHandle);
-                    continue;
-                }
-                info->offsetForLevel[level] = gmiInfo.filePosition =
-                        filePosition;
+template<typename T> inline void appendLE(QByteArray *ba, T value)
+{
+    uchar bytes[sizeof(T)];
+    qToLittleEndian<T>(value, bytes);
+    ba->append(reinterpret_cast<const char*>(bytes), sizeof(T));
+}
 
-                // Insert level into list of vertical levels for this
-                // variable.
-                if (!vinfo->levels.contains(level)) vinfo->levels << level;
+inline void appendLEDouble(QByteArray *ba, double value)
+{
+    quint64 bits; memcpy(&bits, &value, sizeof(double));
+    appendLE<quint64>(ba, bits);
+}
 
-                // That's it!
-                grib_handle_delete(gribHandle);
-                messageCount++;
 
-                // Write index struct to index file.
-                gmiInfo.writeToDataStream(&indexDataStream);
+bool MGribReader::readGribIndex(
+        const QString &indexPath, const QString &gribFilePath,
+        QVector<MGribMessageIndexInfo> *indexRecords)
+{
+    QFile indexFile(indexPath);
+    if (!indexFile.open(QIODevice::ReadOnly)) return false;
 
-                // Update current file position.
-                filePosition = ftell(gribfile);
-            } // for (grib messages)
+    const qint64 size = indexFile.size();
+    if (size < 4) return false;
 
-            if (messageCount == 0)
-            {
-                LOG4CPLUS_DEBUG(mlog, "No grib messages found.");
-            }
-            else
+    // Version 2 indices start with a big-endian qint32 version number and
+    // are read record by record; they are migrated to version 3 below.
+    // =====================================================================
+    {
+        QDataStream indexDataStream(&indexFile);
+        qint32 indexVersion;
+        indexDataStream >> indexVersion;
+        if (indexVersion == 2)
+        {
+            indexDataStream.setVersion(QDataStream::Qt_4_8);
+
+            MGribMessageIndexInfo gmiInfo;
+            while ( !indexDataStream.atEnd() )
             {
-                LOG4CPLUS_DEBUG(mlog, "Indexed " << messageCount
-                                << " grib messages.");
+                gmiInfo.readFromDataStream(&indexDataStream);
+                *indexRecords << gmiInfo;
             }
+            indexFile.close();
 
-            fclose(gribfile);
-        } // if (create new index)
+            LOG4CPLUS_DEBUG(mlog, "Migrating grib index to version "
+                            << GRIB_INDEX_VERSION << ".");
+            writeGribIndex(indexPath, gribFilePath, *indexRecords);
+            return true;
+        }
+    }
 
-#ifdef ENABLE_MET3D_STOPWATCH
-        stopwatch.split();
-        LOG4CPLUS_DEBUG(mlog, "File scanned in "
-                        << stopwatch.getLastSplitTime(MStopwatch::SECONDS)
-                        << " seconds.\n" << flush);
-#endif
-    } // for (files)
+    // Version 3: map the index into memory and validate it.
+    // =====================================================
+    if (size < GRIB_INDEX_HEADER_SIZE) return false;
+    const uchar *p = indexFile.map(0, size);
+    if (p == nullptr) return false;
 
-    deleteFileScanProgressDialog();
+    if (memcmp(p, GRIB_INDEX_MAGIC, 8) != 0
+            || readLE<quint32>(p, 8) != GRIB_INDEX_VERSION)
+    {
+        LOG4CPLUS_ERROR(mlog, "ERROR: grib index has unknown format or "
+                        "version; this version of Met.3D supports versions "
+                        "2 and " << GRIB_INDEX_VERSION << ".");
+        return false;
+    }
 
-    // Perform checks, e.g. to make sure that for each data field all levels
-    // are present.
-    // =====================================================================
+    // The index is only valid for the data file it has been created for.
+    QFileInfo gribFileInfo(gribFilePath);
+    if (readLE<qint64>(p, 24) != gribFileInfo.size()
+            || readLE<qint64>(p, 32)
+            != gribFileInfo.lastModified().toMSecsSinceEpoch())
+    {
+        return false;
+    }
 
-    QString horizontalRefVarName = "";
-    MVerticalLevelType referenceLevelType;
-    LOG4CPLUS_DEBUG(mlog, "Checking consistency of indexed data fields...");
-    foreach (MVerticalLevelType levelType, availableDataFields.keys())
+    const quint32 numVariables = readLE<quint32>(p, 12);
+    const quint32 numMessages = readLE<quint32>(p, 16);
+    const quint64 variableTableOffset = readLE<quint64>(p, 40);
+    const quint64 messageTableOffset = readLE<quint64>(p, 48);
+    const quint64 doubleTableOffset = readLE<quint64>(p, 56);
+    const quint64 stringTableOffset = readLE<quint64>(p, 64);
+    const quint64 stringTableSize = readLE<quint64>(p, 72);
+
+    if (variableTableOffset + numVariables * GRIB_INDEX_VARIABLE_RECORD_SIZE
+            > quint64(size)
+            || messageTableOffset + numMessages * GRIB_INDEX_MESSAGE_RECORD_SIZE
+            > quint64(size)
+            || doubleTableOffset > stringTableOffset
+            || stringTableOffset + stringTableSize > quint64(size))
     {
-        QStringList varNames = availableDataFields[levelType].keys();
-        QString referenceVarName = "";
-        QVector<double> referenceLevels;
-        foreach (QString varName, varNames)
+        return false;
+    }
+    const quint64 numDoubles = (stringTableOffset - doubleTableOffset) / 8;
+
+    // Decode the variable records. Message records only store the
+    // message-specific fields and refer to their variable record.
+    QVector<MGribMessageIndexInfo> variables(numVariables);
+    for (quint32 v = 0; v < numVariables; v++)
+    {
+        const uchar *r = p + variableTableOffset
+                + v * GRIB_INDEX_VARIABLE_RECORD_SIZE;
+        MGribMessageIndexInfo &var = variables[v];
+
+        var.levelType = MVerticalLevelType(readLE<quint32>(r, 0));
+        var.fcType = MECMWFForecastType(readLE<quint32>(r, 4));
+
+        QString *strings[5] = { &var.variablename, &var.longname,
+                                &var.standardname, &var.units,
+                                &var.surfacePressureName };
+        for (int i = 0; i < 5; i++)
         {
-            // 1. Check if variable index is consistent in itself (i.e.
-            // the variable's vertical levels, time steps, etc. are all
-            // consistent.
-            // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-            if (!checkInternalConsistencyOfVariableIndex(
-                        availableDataFields[levelType][varName]))
+            quint64 stringOffset = readLE<quint32>(r, 8 + 4 * i);
+            if (stringOffset + 4 > stringTableSize) return false;
+            const uchar *sp = p + stringTableOffset + stringOffset;
+            quint32 length = readLE<quint32>(sp, 0);
+            if (stringOffset + 4 + length > stringTableSize) return false;
+            *strings[i] = QString::fromUtf8(
+                        reinterpret_cast<const char*>(sp + 4), length);
+        }
+
+        var.nlons = readLE<quint64>(r, 32);
+        var.nlats = readLE<quint64>(r, 40);
+        var.lon0 = readLEDouble(r, 48);
+        var.lat0 = readLEDouble(r, 56);
+        var.lon1 = readLEDouble(r, 64);
+        var.lat1 = readLEDouble(r, 72);
+        var.dlon = readLEDouble(r, 80);
+        var.dlat = readLEDouble(r, 88);
+
+        QVector<double> *arrays[6] = { &var.lats, &var.lons, &var.aki_hPa,
+                                       &var.bki, &var.ak_hPa, &var.bk };
+        for (int i = 0; i < 6; i++)
+        {
+            quint64 first = readLE<quint32>(r, 96 + 8 * i);
+            quint64 count = readLE<quint32>(r, 100 + 8 * i);
+            if (first + count > numDoubles) return false;
+            arrays[i]->resize(count);
+            for (quint64 n = 0; n < count; n++)
             {
-                delete availableDataFields[levelType].take(varName);
-                continue;
+                (*arrays[i])[n] = readLEDouble(
+                            p, doubleTableOffset + (first + n) * 8);
             }
+        }
+    }
 
-            // 2. Check if the variable is consistent to the "reference
-            // variable" (i.e. the first variable encountered) in this dataset
-            // (to make sure that all data fields of the data set are defined
-            // on the same grid etc.).
-            // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-            else if ( !disableGridConsistencyCheck )
-            {
-                if (horizontalRefVarName.isEmpty())
-                {
-                    horizontalRefVarName = varName;
-                    referenceLevelType = levelType;
-                }
+    for (quint32 m = 0; m < numMessages; m++)
+    {
+        const uchar *r = p + messageTableOffset
+                + m * GRIB_INDEX_MESSAGE_RECORD_SIZE;
+        if (readLE<quint32>(r, 0) >= numVariables) return false;
+    }
 
-                if (referenceLevels.isEmpty())
-                {
-                    referenceVarName = varName;
-                    referenceLevels = availableDataFields[levelType][
-                            referenceVarName]->levels; // QVector copy
-                }
+    // All records are valid; decode the messages.
+    indexRecords->reserve(numMessages);
+    for (quint32 m = 0; m < numMessages; m++)
+    {
+        const uchar *r = p + messageTableOffset
+                + m * GRIB_INDEX_MESSAGE_RECORD_SIZE;
+        MGribMessageIndexInfo &gmiInfo = variables[readLE<quint32>(r, 0)];
+
+        gmiInfo.ensMember = readLE<qint64>(r, 8);
+        gmiInfo.initTime = QDateTime::fromMSecsSinceEpoch(
+                    readLE<qint64>(r, 16), Qt::UTC);
+        gmiInfo.validTime = QDateTime::fromMSecsSinceEpoch(
+                    readLE<qint64>(r, 24), Qt::UTC);
+        gmiInfo.level = readLE<quint64>(r, 32);
+        gmiInfo.filePosition = readLE<quint64>(r, 40);
+
+        *indexRecords << gmiInfo;
+    }
 
-                LOG4CPLUS_DEBUG(mlog, "Checking if variable '"
-                                << varName.toStdString()
-                                << "' ("
-                                << MStructuredGrid::verticalLevelTypeToString(
-                                    levelType).toStdString()
-                                << ") is consistent to the reference variable(s) '"
-                                << horizontalRefVarName.toStdString() << "'/'"
-                                << referenceVarName.toStdString() << "'...");
+    return true;
+}
 
-                // Check consistency of vertical levels (QVector comparison).
-                if (availableDataFields[levelType][varName]->levels
-                        != referenceLevels)
-                {
-                    LOG4CPLUS_ERROR(mlog,
-                                    "ERROR: found difference in vertical levels to"
-                                    " reference variable '"
-                                    + referenceVarName.toStdString()
-                                    + "'; discarding variable: '"
-                                    + varName.toStdString() + "' [Dataset: "
-                                    + getIdentifier().toStdString() + "]");
-                    delete availableDataFields[levelType].take(varName);
-                    continue;
-                }
 
-                // Check consistency of horizontal coordinates.
-                // NOTE: Here we also determine a possible index shift in
-                // longitude for cyclic grids (last parameter set to "true").
-                else if (!checkHorizontalConsistencyOfVariableToReference(
-                             availableDataFields[referenceLevelType]
-                             [horizontalRefVarName],
-                             availableDataFields[levelType][varName],
-                             true))
+bool MGribReader::writeGribIndex(
+        const QString &indexPath, const QString &gribFilePath,
+        const QVector<MGribMessageIndexInfo> &indexRecords)
+{
+    // Collect one variable record per (level type, variable), taken from
+    // the first message record of the variable, as well as the string and
+    // double tables.
+    QByteArray variableTable, messageTable, doubleTable, stringTable;
+    QHash<QString, quint32> stringOffsets;
+    QMap<QPair<int, QString>, quint32> variableIndices;
+    quint32 numDoubles = 0;
+
+    foreach (const MGribMessageIndexInfo &gmiInfo, indexRecords)
+    {
+        QPair<int, QString> key(gmiInfo.levelType, gmiInfo.variablename);
+        if (!variableIndices.contains(key))
+        {
+            variableIndices.insert(key, variableIndices.size());
+
+            appendLE<quint32>(&variableTable, quint32(gmiInfo.levelType));
+            appendLE<quint32>(&variableTable, quint32(gmiInfo.fcType));
+
+            const QString *strings[5] = {
+                &gmiInfo.variablename, &gmiInfo.longname,
+                &gmiInfo.standardname, &gmiInfo.units,
+                &gmiInfo.surfacePressureName };
+            for (int i = 0; i < 5; i++)
+            {
+                if (!stringOffsets.contains(*strings[i]))
                 {
-                    LOG4CPLUS_ERROR(mlog,
-                                    "ERROR: found difference to reference"
-                                    " variable '"
-                                    + horizontalRefVarName.toStdString()
-                                    + "'; discarding variable: '"
-                                    + varName.toStdString() + "' [Dataset: "
-                                    + getIdentifier().toStdString() + "]");
-                    delete availableDataFields[levelType].take(varName);
-                    continue;
+                    QByteArray utf8 = strings[i]->toUtf8();
+                    stringOffsets.insert(*strings[i], stringTable.size());
+                    appendLE<quint32>(&stringTable, utf8.size());
+                    stringTable.append(utf8);
                 }
-
-                LOG4CPLUS_DEBUG(mlog, "... OK: variable '"
-                                << varName.toStdString()
-                                << "' is consistent to the reference variable(s).");
+                appendLE<quint32>(&variableTable,
+                                  stringOffsets.value(*strings[i]));
+            }
+            appendLE<quint32>(&variableTable, 0); // reserved
+
+            appendLE<quint64>(&variableTable, gmiInfo.nlons);
+            appendLE<quint64>(&variableTable, gmiInfo.nlats);
+            appendLEDouble(&variableTable, gmiInfo.lon0);
+            appendLEDouble(&variableTable, gmiInfo.lat0);
+            appendLEDouble(&variableTable, gmiInfo.lon1);
+            appendLEDouble(&variableTable, gmiInfo.lat1);
+            appendLEDouble(&variableTable, gmiInfo.dlon);
+            appendLEDouble(&variableTable, gmiInfo.dlat);
+
+            const QVector<double> *arrays[6] = {
+                &gmiInfo.lats, &gmiInfo.lons, &gmiInfo.aki_hPa,
+                &gmiInfo.bki, &gmiInfo.ak_hPa, &gmiInfo.bk };
+            for (int i = 0; i < 6; i++)
+            {
+                appendLE<quint32>(&variableTable, numDoubles);
+                appendLE<quint32>(&variableTable, arrays[i]->size());
+                foreach (double d, *arrays[i]) appendLEDouble(&doubleTable, d);
+                numDoubles += arrays[i]->size();
             }
         }
+
+        appendLE<quint32>(&messageTable, variableIndices.value(key));
+        appendLE<quint32>(&messageTable, 0); // reserved
+        appendLE<qint64>(&messageTable, gmiInfo.ensMember);
+        appendLE<qint64>(&messageTable, gmiInfo.initTime.toMSecsSinceEpoch());
+        appendLE<qint64>(&messageTable, gmiInfo.validTime.toMSecsSinceEpoch());
+        appendLE<quint64>(&messageTable, gmiInfo.level);
+        appendLE<quint64>(&messageTable, gmiInfo.filePosition);
     }
 
-    // debugPrintLevelTypeMap(availableDataFields);
+    QFileInfo gribFileInfo(gribFilePath);
+    const quint64 variableTableOffset = GRIB_INDEX_HEADER_SIZE;
+    const quint64 messageTableOffset =
+            variableTableOffset + variableTable.size();
+    const quint64 doubleTableOffset = messageTableOffset + messageTable.size();
+    const quint64 stringTableOffset = doubleTableOffset + doubleTable.size();
+
+    QByteArray header;
+    header.append(GRIB_INDEX_MAGIC, 8);
+    appendLE<quint32>(&header, GRIB_INDEX_VERSION);
+    appendLE<quint32>(&header, variableIndices.size());
+    appendLE<quint32>(&header, indexRecords.size());
+    appendLE<quint32>(&header, 0); // reserved
+    appendLE<qint64>(&header, gribFileInfo.size());
+    appendLE<qint64>(&header, gribFileInfo.lastModified().toMSecsSinceEpoch());
+    appendLE<quint64>(&header, variableTableOffset);
+    appendLE<quint64>(&header, messageTableOffset);
+    appendLE<quint64>(&header, doubleTableOffset);
+    appendLE<quint64>(&header, stringTableOffset);
+    appendLE<quint64>(&header, stringTable.size());
+
+    // The index is written to a temporary file that replaces the old index
+    // when complete, so that concurrent readers (which memory-map the
+    // index) never see a truncated or partially written file.
+    QSaveFile indexFile(indexPath);
+    if (indexFile.open(QIODevice::WriteOnly))
+    {
+        indexFile.write(header);
+        indexFile.write(variableTable);
+        indexFile.write(messageTable);
+        indexFile.write(doubleTable);
+        indexFile.write(stringTable);
 
-#ifdef ENABLE_MET3D_STOPWATCH
-    stopwatch.split();
-    LOG4CPLUS_DEBUG(mlog, "Directory scanned in "
-                    << stopwatch.getElapsedTime(MStopwatch::SECONDS)
-                    << " seconds.\n" << flush);
-#endif
+        if (indexFile.commit()) return true;
+    }
 
-    //    gribReader->readGrid(
-    //                SURFACE_2D, "sp",
-    //                QDateTime::fromString("2012-10-17T00:00:00Z", Qt::ISODate),
-    //                QDateTime::fromString("2012-10-19T18:00:00Z", Qt::ISODate), 2
-    //                )->dumpGridData();
-    //    gribReader->readGrid(
-    //                PRESSURE_LEVELS_3D, "t",
-    //                QDateTime::fromString("2012-10-17T00:00:00Z", Qt::ISODate),
-    //                QDateTime::fromString("2012-10-19T18:00:00Z", Qt::ISODate), 2
-    //                )->dumpGridData();
-    //    gribReader->readGrid(
-    //                HYBRID_SIGMA_PRESSURE_3D, "t",
-    //                QDateTime::fromString("2012-10-15T00:00:00Z", Qt::ISODate),
-    //                QDateTime::fromString("2012-10-19T18:00:00Z", Qt::ISODate), 2
-    //                )->dumpGridData();
+    LOG4CPLUS_WARN(mlog, "Cannot write grib index "
+                   << indexPath.toStdString() << ".");
+    return false;
 }
 
 
@@ -2138,45 +2535,6 @@ bool MGribReader::checkHorizontalConsistencyOfVariableToReference(
 ***                        MGribMessageIndexInfo                            ***
 *******************************************************************************/
 
-void MGribMessageIndexInfo::writeToDataStream(QDataStream *dataStream)
-{
-    (*dataStream) << (quint32)levelType;
-    (*dataStream) << variablename;
-    (*dataStream) << longname;
-    (*dataStream) << standardname;
-    (*dataStream) << units;
-    (*dataStream) << (quint32)fcType;
-    (*dataStream) << surfacePressureName;
-    (*dataStream) << nlons;
-    (*dataStream) << nlats;
-    (*dataStream) << lon0;
-    (*dataStream) << lat0;
-    (*dataStream) << lon1;
-    (*dataStream) << lat1;
-    (*dataStream) << dlon;
-    (*dataStream) << dlat;
-    (*dataStream) << lats;
-    (*dataStream) << lons;
-    (*dataStream) << aki_hPa;
-    (*dataStream) << bki;
-    (*dataStream) << ak_hPa;
-    (*dataStream) << bk;
-    (*dataStream) << ensMember;
-    (*dataStream) << initTime;
-    (*dataStream) << validTime;
-    (*dataStream) << level;
-    (*dataStream) << filePosition;
-
-//    QString msg = QString("Wrote %1/IT%2/VT%3/MEM%4/LEV%5")
-//            .arg(variablename)
-//            .arg(initTime.toString(Qt::ISODate))
-//            .arg(validTime.toString(Qt::ISODate))
-//            .arg(ensMember)
-//            .arg(level);
-//    LOG4CPLUS_DEBUG(mlog, msg.toStdString());
-}
-
-
 void MGribMessageIndexInfo::readFromDataStream(QDataStream *dataStream)
 {
     lats.clear();
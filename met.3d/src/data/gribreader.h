@@ -113,10 +113,12 @@ typedef QMap<MVerticalLevelType, MGribVariableNameMap> MGribLevelTypeMap;
 
 struct MGribFileInfo
 {
-    FILE *gribFile;
-
-    // Mutex to lock access to the file.
-    QMutex accessMutex;
+    // The file is mapped into memory once when it is accessed for the first
+    // time; GRIB messages are decoded directly from the mapping. The mapping
+    // is read-only, hence no locking is required to access it.
+    QFile gribFile;
+    const char *mappedData;
+    qint64 mappedSize;
 };
 
 typedef QHash<QString, MGribFileInfo*> MGribOpenFileMap;
@@ -124,6 +126,29 @@ typedef QHash<QString, MGribFileInfo*> MGribOpenFileMap;
 /**
   Struct that stores a grib message's "important" data fields for the file
   index (the index consists of structs of this type).
+
+  Index files (version 3) use a flat little-endian binary layout that is
+  memory-mapped when read:
+
+    header (80 bytes): magic "MET3DGIX", version (quint32), number of
+        variable and message records (quint32 each), reserved (quint32),
+        size and last modification time (ms since epoch) of the indexed
+        GRIB file (qint64 each; the index is re-created if they do not
+        match), byte offsets of variable, message and double tables and of
+        the string table, size of the string table (quint64 each).
+    variable records (144 bytes): level type, forecast type, offsets of
+        the five name/unit strings into the string table, reserved
+        (quint32 each), nlons, nlats (quint64), lon0, lat0, lon1, lat1,
+        dlon, dlat (double), (first index, count) into the double table of
+        lats, lons, aki_hPa, bki, ak_hPa, bk (quint32 each).
+    message records (48 bytes): variable record index, reserved (quint32),
+        ensemble member, init and valid time in ms since epoch (qint64),
+        level, file position (quint64).
+    double table: all coordinate and coefficient arrays.
+    string table: UTF-8 strings, each preceded by its length (quint32).
+
+  Version 2 indices (QDataStream serialisation of this struct) are still
+  read and migrated to version 3.
  */
 struct MGribMessageIndexInfo
 {
@@ -150,11 +175,26 @@ struct MGribMessageIndexInfo
     quint64 level;
     quint64 filePosition;
 
-    void writeToDataStream(QDataStream *dataStream);
     void readFromDataStream(QDataStream *dataStream);
 };
 
 
+/**
+  Result of indexing a single GRIB file in the parallel phase of
+  @ref MGribReader::scanDataRoot(): the index records of the messages
+  contained in the file (empty if the file could not be read).
+ */
+struct MGribFileScanResult
+{
+    MGribFileScanResult() : indexNeedsUpdate(false) {}
+
+    QVector<MGribMessageIndexInfo> indexRecords;
+    bool indexNeedsUpdate; // the surface pressure names of hybrid variables
+                           // are missing; the index is written once they
+                           // have been determined in the merge phase
+};
+
+
 /**
   @brief Reader for ECMWF Grib files that are retrieved from the ECMWF MARS
   system (or passed from Metview).
@@ -219,14 +259,77 @@ protected:
     void copyLonLatCoordinateDataToGridObject(
             MStructuredGrid *grid, MGribVariableInfo* vinfo);
 
+    /**
+      Helper method for @ref readGrid(): GRIB messages cannot be decoded
+      partially, hence fields restricted to a sub-domain are decoded entirely
+      and cropped afterwards. Returns @p grid if the sub-domain covers the
+      entire grid, otherwise a new grid containing the sub-domain (@p grid
+      is deleted).
+     */
+    MStructuredGrid* cropGridToSubDomain(MStructuredGrid *grid,
+                                         const MSubDomain& subDomain);
+
+    /**
+      Helper method for @ref readGrid(): decodes the GRIB message at byte
+      @p offset of the memory-mapped file @p finfo and stores the values
+      (shifted in longitude if required by @p vinfo) in the @p nvalues floats
+      at @p levelData. @p valueBuffer is a scratch buffer that can be reused
+      across calls. Can be called concurrently for the same file. Returns
+      false if the message could not be decoded.
+     */
+    bool decodeGribMessageToLevel(MGribFileInfo *finfo, long offset,
+                                  MGribVariableInfo *vinfo, bool applyExp,
+                                  float *levelData, unsigned int nvalues,
+                                  QVector<double> *valueBuffer);
+
     MStructuredGrid* readGrid(MVerticalLevelType levelType,
                               const QString&     variableName,
                               const QDateTime&   initTime,
                               const QDateTime&   validTime,
-                              unsigned int       ensembleMember);
+                              unsigned int       ensembleMember,
+                              const MSubDomain&  subDomain);
 
+    /**
+      Indexes all GRIB files in the data root. The files are read (or, if
+      no valid index exists, scanned) concurrently by @ref scanGribFile();
+      the resulting index records are merged serially and in file order
+      into @ref availableDataFields.
+     */
     void scanDataRoot();
 
+    /**
+      Parallel per-file phase of @ref scanDataRoot(): reads the GRIB index
+      of @p gribFileName or, if it is outdated or missing, scans the GRIB
+      messages of the file and writes a new index. Does not modify the
+      catalogue of available data fields; can be called concurrently.
+     */
+    MGribFileScanResult scanGribFile(const QString& gribFileName);
+
+    /**
+      Reads the GRIB index @p indexPath of the GRIB file @p gribFilePath
+      and appends the indexed messages to @p indexRecords. Version 3
+      indices are memory-mapped and validated against size and modification
+      time of the GRIB file; version 2 indices are migrated to version 3.
+      Returns false if the index is outdated or invalid and needs to be
+      re-created.
+     */
+    bool readGribIndex(const QString& indexPath, const QString& gribFilePath,
+                       QVector<MGribMessageIndexInfo> *indexRecords);
+
+    /**
+      Writes @p indexRecords to the version 3 GRIB index @p indexPath of the
+      GRIB file @p gribFilePath (see @ref MGribMessageIndexInfo).
+     */
+    bool writeGribIndex(const QString& indexPath, const QString& gribFilePath,
+                        const QVector<MGribMessageIndexInfo>& indexRecords);
+
+    /**
+      Inserts the GRIB message described by the index record @p gmiInfo
+      into @ref availableDataFields.
+     */
+    void registerGribIndexRecord(const MGribMessageIndexInfo& gmiInfo,
+                                 const QString& gribFileName);
+
     bool isValidGribFile(QString path);
 
     QStringList getGribIndexStringKeyList(grib_index* gribIndex, QString key);
@@ -262,8 +365,9 @@ protected:
      We need the sp/lnsp information to correctly set the "surfacePressureName"
      variable of hybrid sigma pressure grids. The information is stored in
      the internal variable->grib message mapping as well as in the index files.
-     Hence, sp/lnsp currently needs to be detected BEFORE any hybrid grids
-     are scanned in @ref scanDataRoot().
+     Hence, if sp/lnsp is not contained in the data set, it needs to be
+     detected in @ref scanDataRoot() before the index records of hybrid
+     grids are merged.
      */
     void detectSurfacePressureFieldType(QStringList *availableFiles);
 
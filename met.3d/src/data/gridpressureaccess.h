@@ -0,0 +1,235 @@
+/******************************************************************************
+**
+**  This file is part of Met.3D -- a research environment for the
+**  three-dimensional visual exploration of numerical ensemble weather
+**  prediction data.
+**
+**  Copyright 2015-2020 Marc Rautenhaus
+**
+**  Regional Computing Center, Visualization
+**  Universitaet Hamburg, Hamburg, Germany
+**
+**  Met.3D is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Met.3D is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Met.3D.  If not, see <http://www.gnu.org/licenses/>.
+**
+*******************************************************************************/
+#ifndef GRIDPRESSUREACCESS_H
+#define GRIDPRESSUREACCESS_H
+
+// standard library imports
+#include <vector>
+
+// related third party imports
+#include <QtCore>
+
+// local application imports
+#include "data/structuredgrid.h"
+
+
+namespace Met3D
+{
+
+/**
+  @file gridpressureaccess.h
+
+  Non-virtual accessors to the pressure (hPa) at the grid points of the
+  different @ref MStructuredGrid types. Numerical kernels that evaluate the
+  pressure at (almost) every grid point are implemented as templates on the
+  accessor type; the accessor is selected once per grid with
+  @ref getPressureAccessType(). All accessors provide
+
+    float getPressure(unsigned int k, unsigned int j, unsigned int i) const;
+
+  which returns exactly the value of @ref MStructuredGrid::getPressure() but
+  can be inlined into the kernel loops.
+
+  An accessor holds pointers into the grid (and its surface or auxiliary
+  pressure field); it must not outlive the grid it has been created for.
+ */
+
+enum MPressureAccessType
+{
+    LEVEL_PRESSURE_ACCESS = 0,
+    HYBRID_SIGMA_PRESSURE_ACCESS = 1,
+    PRESSURE_FIELD_ACCESS = 2,
+    GENERIC_PRESSURE_ACCESS = 3
+};
+
+
+/**
+  Pressure of grids whose levels are constant in the horizontal
+  (@ref MRegularLonLatStructuredPressureGrid, @ref MRegularLonLatLnPGrid).
+  The level pressures are tabulated on construction; this in particular
+  avoids an exp() per call for ln(p) grids.
+ */
+class MLevelPressureAccess
+{
+public:
+    explicit MLevelPressureAccess(const MStructuredGrid *grid)
+        : levelPressure_hPa(grid->getNumLevels())
+    {
+        for (unsigned int k = 0; k < grid->getNumLevels(); k++)
+        {
+            levelPressure_hPa[k] = grid->getPressure(k, 0, 0);
+        }
+    }
+
+    inline float getPressure(unsigned int k, unsigned int j,
+                             unsigned int i) const
+    { Q_UNUSED(j); Q_UNUSED(i); return levelPressure_hPa[k]; }
+
+private:
+    std::vector<float> levelPressure_hPa;
+};
+
+
+/**
+  Pressure of @ref MLonLatHybridSigmaPressureGrid instances, p = ak + bk *
+  psfc, read directly from the coefficient arrays and the surface pressure
+  field.
+ */
+class MHybridSigmaPressureAccess
+{
+public:
+    explicit MHybridSigmaPressureAccess(
+            const MLonLatHybridSigmaPressureGrid *grid)
+        : ak_hPa(grid->ak_hPa),
+          bk(grid->bk),
+          psfc_Pa(grid->surfacePressure->getData()),
+          nlons(grid->getNumLons())
+    {
+    }
+
+    inline float getPressure(unsigned int k, unsigned int j,
+                             unsigned int i) const
+    {
+        // Same arithmetic (and rounding) as
+        // MLonLatHybridSigmaPressureGrid::getPressure().
+        float psfc_hPa = psfc_Pa[INDEX2yx(j, i, nlons)] / 100.;
+        float p_hPa = ak_hPa[k] + bk[k] * psfc_hPa;
+        return p_hPa;
+    }
+
+private:
+    const double *ak_hPa;
+    const double *bk;
+    const float  *psfc_Pa;
+    unsigned int  nlons;
+};
+
+
+/**
+  Pressure of grids that store the pressure of each grid point in a 3D
+  field: @ref MLonLatAuxiliaryPressureGrid instances (auxiliary pressure
+  field) and @ref MLonLatHybridSigmaPressureGrid instances whose pressure
+  field has been computed (@ref
+  MLonLatHybridSigmaPressureGrid::getPressureField_hPa()).
+ */
+class MPressureFieldAccess
+{
+public:
+    explicit MPressureFieldAccess(const MStructuredGrid *grid)
+        : p_hPa(nullptr),
+          nlons(grid->getNumLons()),
+          nlatsnlons(grid->getNumLats() * grid->getNumLons())
+    {
+        if (const MLonLatAuxiliaryPressureGrid *auxGrid =
+                dynamic_cast<const MLonLatAuxiliaryPressureGrid*>(grid))
+        {
+            p_hPa = auxGrid->auxPressureField_hPa->getData();
+        }
+        else if (const MLonLatHybridSigmaPressureGrid *hybridGrid =
+                 dynamic_cast<const MLonLatHybridSigmaPressureGrid*>(grid))
+        {
+            p_hPa = hybridGrid->pressureField.load()->data;
+        }
+    }
+
+    inline float getPressure(unsigned int k, unsigned int j,
+                             unsigned int i) const
+    { return p_hPa[INDEX3zyx_2(k, j, i, nlatsnlons, nlons)]; }
+
+private:
+    const float  *p_hPa;
+    unsigned int  nlons;
+    unsigned int  nlatsnlons;
+};
+
+
+/**
+  Fallback for all other grid types: forwards to the virtual
+  @ref MStructuredGrid::getPressure().
+ */
+class MGenericPressureAccess
+{
+public:
+    explicit MGenericPressureAccess(const MStructuredGrid *grid)
+        : grid(grid)
+    {
+    }
+
+    inline float getPressure(unsigned int k, unsigned int j,
+                             unsigned int i) const
+    { return grid->getPressure(k, j, i); }
+
+private:
+    const MStructuredGrid *grid;
+};
+
+
+/**
+  Returns the accessor type to be used for @p grid. Kernels dispatch on the
+  result and construct the corresponding accessor, e.g.
+
+    case HYBRID_SIGMA_PRESSURE_ACCESS:
+        kernel(MHybridSigmaPressureAccess(
+                   static_cast<MLonLatHybridSigmaPressureGrid*>(grid)), ...);
+
+  Hybrid sigma-pressure grids whose pressure field has been computed are
+  accessed through their pressure field.
+ */
+inline MPressureAccessType getPressureAccessType(const MStructuredGrid *grid)
+{
+    switch (grid->getLevelType())
+    {
+    case PRESSURE_LEVELS_3D:
+    case LOG_PRESSURE_LEVELS_3D:
+        if (dynamic_cast<const MRegularLonLatStructuredPressureGrid*>(grid)
+                || dynamic_cast<const MRegularLonLatLnPGrid*>(grid))
+        {
+            return LEVEL_PRESSURE_ACCESS;
+        }
+        break;
+    case HYBRID_SIGMA_PRESSURE_3D:
+        if (const MLonLatHybridSigmaPressureGrid *hybridGrid =
+                dynamic_cast<const MLonLatHybridSigmaPressureGrid*>(grid))
+        {
+            return hybridGrid->hasPressureField()
+                    ? PRESSURE_FIELD_ACCESS : HYBRID_SIGMA_PRESSURE_ACCESS;
+        }
+        break;
+    case AUXILIARY_PRESSURE_3D:
+        if (dynamic_cast<const MLonLatAuxiliaryPressureGrid*>(grid))
+        {
+            return PRESSURE_FIELD_ACCESS;
+        }
+        break;
+    default:
+        break;
+    }
+    return GENERIC_PRESSURE_ACCESS;
+}
+
+} // namespace Met3D
+
+#endif // GRIDPRESSUREACCESS_H
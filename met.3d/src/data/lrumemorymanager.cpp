@@ -143,15 +143,7 @@ bool MLRUMemoryManager::storeData(
     // Test if the system memory limit will be exceeded by adding the new data
     // item. If so, remove some of the released data items.
     unsigned int itemMemoryUsage_kb = item->getMemorySize_kb();
-    while ((systemMemoryUsage_kb + itemMemoryUsage_kb >= systemMemoryLimit_kb)
-           && !releasedDataItemsQueue.empty())
-    {
-        MDataRequest removeKey = releasedDataItemsQueue.takeFirst();
-        referenceCounter.take(removeKey);
-        MAbstractDataItem* removeItem = releasedDataItems.take(removeKey);
-        systemMemoryUsage_kb -= removeItem->getMemorySize_kb();
-        delete removeItem;
-    }
+    removeReleasedDataItems(itemMemoryUsage_kb);
 
     // If not enough memory could be freed throw an exception.
     if ( systemMemoryUsage_kb + itemMemoryUsage_kb >= systemMemoryLimit_kb )
@@ -190,6 +182,11 @@ bool MLRUMemoryManager::containsData(
                     << "; reference counter set to "
                     << referenceCounter[request]);
 #endif
+        // The item may just have been made active by another thread that
+        // has not yet restored it.
+        MAbstractDataItem *item = activeDataItems[request];
+        memoryCacheLocker.unlock();
+        restoreActiveItem(item);
         return true;
     }
 
@@ -202,6 +199,7 @@ bool MLRUMemoryManager::containsData(
         MAbstractDataItem *item = releasedDataItems.take(request);
         activeDataItems.insert(request, item);
         referenceCounter[request] = 1;
+        item->isReleasedToCache = false;
         //updateStatusDisplay(); // # of active/released items has changed
 #ifdef DEBUG_OUTPUT_MEMORYMANAGER
     LOG4CPLUS_DEBUG(mlog, "containsData() for request "
@@ -209,6 +207,10 @@ bool MLRUMemoryManager::containsData(
                     << "; reference counter set to "
                     << referenceCounter[request]);
 #endif
+        // If the item has been compacted on release, expand it again. This
+        // is done without blocking the cache; active items are not deleted.
+        memoryCacheLocker.unlock();
+        restoreActiveItem(item);
         return true;
     }
 
@@ -276,9 +278,18 @@ void MLRUMemoryManager::releaseData(
             // Move the data grid in system memory to the list of released
             // objects. It might be deleted by the storeData() method if memory
             // is required.
-            releasedDataItems.insert(request, activeDataItems.take(request));
+            MAbstractDataItem *item = activeDataItems.take(request);
+            releasedDataItems.insert(request, item);
             releasedDataItemsQueue.push_back(request);
+            item->isReleasedToCache = true;
             //updateStatusDisplay(); // # of active/released items has changed
+
+            // Give the item the chance to reduce its memory footprint while
+            // it is cached. This is done without blocking the cache; the
+            // item is protected from deletion until it has been compacted.
+            itemsBeingCompacted[item] += 1;
+            memoryCacheLocker.unlock();
+            compactReleasedItem(item);
         }
     }
     else
@@ -305,9 +316,17 @@ void MLRUMemoryManager::clearCache()
 {
     QMutexLocker memoryCacheLocker( &(this->memoryCacheMutex) );
 
-    while ( !releasedDataItemsQueue.empty() )
+    // Items that are being compacted by another thread remain in the cache.
+    int i = 0;
+    while ( i < releasedDataItemsQueue.size() )
     {
-        MDataRequest removeKey = releasedDataItemsQueue.takeFirst();
+        MDataRequest removeKey = releasedDataItemsQueue[i];
+        if (itemsBeingCompacted.contains(releasedDataItems.value(removeKey)))
+        {
+            i++;
+            continue;
+        }
+        releasedDataItemsQueue.removeAt(i);
         referenceCounter.take(removeKey);
         MAbstractDataItem* removeItem = releasedDataItems.take(removeKey);
         systemMemoryUsage_kb -= removeItem->getMemorySize_kb();
@@ -383,6 +402,81 @@ void MLRUMemoryManager::dumpMemoryContent()
 }
 
 
+void MLRUMemoryManager::removeReleasedDataItems(
+        unsigned int requiredMemory_kb)
+{
+    // Items that are being compacted by another thread are skipped.
+    int i = 0;
+    while ((systemMemoryUsage_kb + requiredMemory_kb >= systemMemoryLimit_kb)
+           && i < releasedDataItemsQueue.size())
+    {
+        MDataRequest removeKey = releasedDataItemsQueue[i];
+        if (itemsBeingCompacted.contains(releasedDataItems.value(removeKey)))
+        {
+            i++;
+            continue;
+        }
+        releasedDataItemsQueue.removeAt(i);
+        referenceCounter.take(removeKey);
+        MAbstractDataItem* removeItem = releasedDataItems.take(removeKey);
+        systemMemoryUsage_kb -= removeItem->getMemorySize_kb();
+        delete removeItem;
+    }
+}
+
+
+void MLRUMemoryManager::compactReleasedItem(MAbstractDataItem *item)
+{
+    int memoryChange_kb = 0;
+
+    QMutexLocker itemLocker(&(item->cacheStateMutex));
+    // If the item has been requested again since it was released, it must
+    // not be compacted.
+    if (item->isReleasedToCache && !item->isCompactedForCache)
+    {
+        const int activeMemoryUsage_kb = int(item->getMemorySize_kb());
+        item->compactForCache();
+        item->isCompactedForCache = true;
+        memoryChange_kb = int(item->getMemorySize_kb()) - activeMemoryUsage_kb;
+    }
+    // Do not lock the cache mutex while the item is locked; threads that
+    // hold the cache mutex may wait for the item.
+    itemLocker.unlock();
+
+    QMutexLocker memoryCacheLocker( &(this->memoryCacheMutex) );
+    systemMemoryUsage_kb += memoryChange_kb;
+    if (--itemsBeingCompacted[item] == 0) itemsBeingCompacted.remove(item);
+}
+
+
+void MLRUMemoryManager::restoreActiveItem(MAbstractDataItem *item)
+{
+    int memoryChange_kb = 0;
+
+    // If another thread is compacting or restoring the item, this waits
+    // until it has finished.
+    QMutexLocker itemLocker(&(item->cacheStateMutex));
+    if (item->isCompactedForCache)
+    {
+        const int cachedMemoryUsage_kb = int(item->getMemorySize_kb());
+        item->restoreFromCache();
+        item->isCompactedForCache = false;
+        memoryChange_kb = int(item->getMemorySize_kb()) - cachedMemoryUsage_kb;
+    }
+    itemLocker.unlock();
+
+    if (memoryChange_kb != 0)
+    {
+        // Restoring may exceed the memory limit, in which case other
+        // released items are removed (an item that is still in memory is
+        // never declined).
+        QMutexLocker memoryCacheLocker( &(this->memoryCacheMutex) );
+        systemMemoryUsage_kb += memoryChange_kb;
+        removeReleasedDataItems(0);
+    }
+}
+
+
 MDataRequest MLRUMemoryManager::addOwnerToRequest(
         MMemoryManagementUsingObject* owner, MDataRequest request)
 {
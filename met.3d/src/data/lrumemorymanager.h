@@ -122,6 +122,11 @@ protected:
     /** Amount of currently consumed memory. */
     unsigned int systemMemoryUsage_kb;
 
+    /** Released items whose compaction (see @ref compactReleasedItem()) is
+        still in progress, with the number of pending compactions. These
+        items must not be deleted. */
+    QHash<MAbstractDataItem*, int> itemsBeingCompacted;
+
     /** Mutex to protect the above defined cache dictionaries. A single mutex
         is sufficient, as all QHast, QList and int objects need to be in sync
         and hence need to be protected together. */
@@ -141,6 +146,29 @@ protected:
 
     void dumpMemoryContent();
 
+    /**
+      Deletes released items, least recently released first, until an
+      additional @p requiredMemory_kb fit into the memory limit or no
+      released items are left. Call with @ref memoryCacheMutex locked.
+     */
+    void removeReleasedDataItems(unsigned int requiredMemory_kb);
+
+    /**
+      Calls @ref MAbstractDataItem::compactForCache() on the released
+      @p item unless it has been requested again in the mean time, and
+      updates the memory usage. Call with @ref memoryCacheMutex unlocked
+      after the item has been added to @ref itemsBeingCompacted.
+     */
+    void compactReleasedItem(MAbstractDataItem *item);
+
+    /**
+      Calls @ref MAbstractDataItem::restoreFromCache() on the active
+      @p item if it is compacted, or waits until another thread has
+      restored it, and updates the memory usage. Call with @ref
+      memoryCacheMutex unlocked.
+     */
+    void restoreActiveItem(MAbstractDataItem *item);
+
     MDataRequest addOwnerToRequest(
             MMemoryManagementUsingObject* owner, MDataRequest request);
 };
@@ -176,6 +176,31 @@ const QStringList& MMemoryManagedDataSource::requiredKeys()
 }
 
 
+QString MMemoryManagedDataSource::dataSignature()
+{
+    QStringList signatures;
+
+    QString localSignature = locallyDataSignature();
+    if (!localSignature.isEmpty()) signatures << localSignature;
+
+    QReadLocker readLocker(&registeredDataSourcesLock);
+
+    for (auto it = registeredDataSources.constBegin();
+         it != registeredDataSources.constEnd(); ++it)
+    {
+        QString signature = it.value()->dataSignature();
+        if (!signature.isEmpty() && !signatures.contains(signature))
+        {
+            signatures << signature;
+        }
+    }
+
+    // Make the result independent of the order of registration.
+    signatures.sort();
+    return signatures.join(";");
+}
+
+
 /******************************************************************************
 ***                          PROTECTED METHODS                              ***
 *******************************************************************************/
@@ -205,6 +230,21 @@ void MMemoryManagedDataSource::registerInputSource(
 }
 
 
+void MMemoryManagedDataSource::deregisterInputSource(
+        MAbstractDataSource *source)
+{
+    if (source == nullptr) return;
+
+    QWriteLocker writeLocker(&registeredDataSourcesLock);
+
+    QStringList keys = registeredDataSources.uniqueKeys();
+    for (int i = 0; i < keys.size(); i++)
+        registeredDataSources.remove(keys[i], source);
+
+    requiredRequestKeys.clear();
+}
+
+
 void MMemoryManagedDataSource::deregisterPrefixedInputSources()
 {
     QWriteLocker writeLocker(&registeredDataSourcesLock);
@@ -267,7 +307,7 @@ void MMemoryManagedDataSource::reserveData(MDataRequest request, int numRequests
 void MMemoryManagedDataSource::updateRequiredKeys()
 {
     requiredRequestKeys.clear();
-    requiredRequestKeys << locallyRequiredKeys();
+    requiredRequestKeys << locallyRequiredKeys() << locallyOptionalKeys();
 
     QReadLocker readLocker(&registeredDataSourcesLock);
 
@@ -70,6 +70,12 @@ public:
 
     const QStringList& requiredKeys();
 
+    /**
+      Combines @ref locallyDataSignature() with the signatures of all
+      registered input sources.
+     */
+    QString dataSignature();
+
     /**
      Produces the data item corresponding to @p request.
 
@@ -91,6 +97,21 @@ protected:
      */
     virtual const QStringList locallyRequiredKeys() = 0;
 
+    /**
+      Returns a list with keys the data source evaluates if they are present
+      in a request, but that may be omitted. Optional keys are kept when a
+      request is reduced to @ref requiredKeys(), but are not checked for in
+      the request.
+     */
+    virtual const QStringList locallyOptionalKeys() { return QStringList(); }
+
+    /**
+      Data readers return a string identifying the files they read from (see
+      @ref dataSignature()). Processing sources do not need to implement
+      this method.
+     */
+    virtual QString locallyDataSignature() { return QString(); }
+
     /**
       Derived classes should call this method for every data source they use as
       input. If the optional prefix is specified, the source's request keys are
@@ -98,6 +119,14 @@ protected:
      */
     void registerInputSource(MAbstractDataSource *source, QString prefix = "");
 
+    /**
+      Removes @p source from the registry (under all prefixes). Derived
+      classes whose input can be replaced call this method for the previous
+      input so that @ref requiredKeys() and @ref dataSignature() only
+      reflect the current inputs.
+     */
+    void deregisterInputSource(MAbstractDataSource *source);
+
     /**
       Removes all data sources with prefixes from the registry.
      */
@@ -0,0 +1,208 @@
+/******************************************************************************
+**
+**  This file is part of Met.3D -- a research environment for the
+**  three-dimensional visual exploration of numerical ensemble weather
+**  prediction data.
+**
+**  Copyright 2015-2020 Marc Rautenhaus
+**
+**  Regional Computing Center, Visualization
+**  Universitaet Hamburg, Hamburg, Germany
+**
+**  Met.3D is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Met.3D is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Met.3D.  If not, see <http://www.gnu.org/licenses/>.
+**
+*******************************************************************************/
+#include "minmaxbrickindex.h"
+
+// standard library imports
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+// related third party imports
+#include <log4cplus/loggingmacros.h>
+
+// local application imports
+#include "util/mutil.h"
+#include "data/datarequest.h"
+
+#define MEASURE_CPU_TIME
+
+using namespace std;
+
+namespace Met3D
+{
+
+/******************************************************************************
+***                     CONSTRUCTOR / DESTRUCTOR                            ***
+*******************************************************************************/
+
+MMinMaxBrickIndex::MMinMaxBrickIndex(const float *values, uint32_t dimX,
+                                     uint32_t dimY, uint32_t dimZ,
+                                     uint32_t brickSize)
+    : MAbstractDataItem(),
+      brickSize(std::max(brickSize, uint32_t(1))),
+      nx(dimX > 0 ? dimX - 1 : 0),
+      ny(dimY > 0 ? dimY - 1 : 0),
+      nz(dimZ > 0 ? dimZ - 1 : 0)
+{
+#ifdef MEASURE_CPU_TIME
+    auto start = std::chrono::system_clock::now();
+#endif
+
+    const uint32_t bs = this->brickSize;
+    nbx = (nx + bs - 1) / bs;
+    nby = (ny + bs - 1) / bs;
+    nbz = (nz + bs - 1) / bs;
+
+    const size_t numBricks = size_t(nbx) * nby * nbz;
+    const float inf = std::numeric_limits<float>::infinity();
+    minValues.assign(numBricks, inf);
+    maxValues.assign(numBricks, -inf);
+
+#pragma omp parallel for collapse(2)
+    for (uint32_t bk = 0; bk < nbz; bk++)
+    {
+        for (uint32_t bj = 0; bj < nby; bj++)
+        {
+            for (uint32_t bi = 0; bi < nbx; bi++)
+            {
+                // The corners of the voxels of a brick include the grid
+                // points of the upper boundary, which are shared with the
+                // neighbouring brick.
+                const uint32_t k1 = std::min((bk + 1) * bs, nz);
+                const uint32_t j1 = std::min((bj + 1) * bs, ny);
+                const uint32_t i1 = std::min((bi + 1) * bs, nx);
+
+                float minValue = inf;
+                float maxValue = -inf;
+
+                for (uint32_t k = bk * bs; k <= k1; k++)
+                {
+                    for (uint32_t j = bj * bs; j <= j1; j++)
+                    {
+                        const float *row =
+                                values + (size_t(k) * dimY + j) * dimX;
+
+                        for (uint32_t i = bi * bs; i <= i1; i++)
+                        {
+                            const float v = row[i];
+                            // Marching cubes classifies NaN as "not below"
+                            // the isovalue, which the maximum needs to
+                            // reflect.
+                            if (std::isnan(v)) { maxValue = inf; continue; }
+                            minValue = std::min(minValue, v);
+                            maxValue = std::max(maxValue, v);
+                        }
+                    }
+                }
+
+                const size_t brick = (size_t(bk) * nby + bj) * nbx + bi;
+                minValues[brick] = minValue;
+                maxValues[brick] = maxValue;
+            }
+        }
+    }
+
+#ifdef MEASURE_CPU_TIME
+    auto end = std::chrono::system_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                end - start);
+    LOG4CPLUS_DEBUG(mlog, "Min/max brick index of " << numBricks
+                    << " bricks built in " << elapsed.count() << "ms");
+#endif
+}
+
+
+/******************************************************************************
+***                            PUBLIC METHODS                               ***
+*******************************************************************************/
+
+unsigned int MMinMaxBrickIndex::getMemorySize_kb()
+{
+    return (sizeof(MMinMaxBrickIndex)
+            + (minValues.size() + maxValues.size()) * sizeof(float)) / 1024;
+}
+
+
+void MMinMaxBrickIndex::getCandidateBricks(
+        float isovalue, uint32_t k0, uint32_t k1,
+        std::vector<uint32_t>& bricks) const
+{
+    if (k1 <= k0 || nbz == 0) { return; }
+
+    const uint32_t bk0 = k0 / brickSize;
+    const uint32_t bk1 = std::min((k1 - 1) / brickSize + 1, nbz);
+
+    for (uint32_t bk = bk0; bk < bk1; bk++)
+    {
+        const uint32_t first = bk * nby * nbx;
+        const uint32_t last = first + nby * nbx;
+
+        for (uint32_t brick = first; brick < last; brick++)
+        {
+            if (isCandidate(brick, isovalue)) { bricks.push_back(brick); }
+        }
+    }
+}
+
+
+void MMinMaxBrickIndex::getBrickVoxelRange(uint32_t brick,
+                                           uint32_t& k0, uint32_t& k1,
+                                           uint32_t& j0, uint32_t& j1,
+                                           uint32_t& i0, uint32_t& i1) const
+{
+    const uint32_t bi = brick % nbx;
+    const uint32_t bj = (brick / nbx) % nby;
+    const uint32_t bk = brick / (nbx * nby);
+
+    k0 = bk * brickSize;
+    k1 = std::min(k0 + brickSize, nz);
+    j0 = bj * brickSize;
+    j1 = std::min(j0 + brickSize, ny);
+    i0 = bi * brickSize;
+    i1 = std::min(i0 + brickSize, nx);
+}
+
+
+MMinMaxBrickIndex* MMinMaxBrickIndex::getIndex(
+        MAbstractMemoryManager *memoryManager,
+        MMemoryManagementUsingObject *owner, MStructuredGrid *grid,
+        uint32_t brickSize)
+{
+    MDataRequestHelper rh(grid->getGeneratingRequest());
+    rh.insert("MINMAX_BRICKS", int(brickSize));
+    MDataRequest request = rh.request();
+
+    // containsData() and storeData() both place a reference on the item.
+    if (!memoryManager->containsData(owner, request))
+    {
+        MMinMaxBrickIndex *index = new MMinMaxBrickIndex(
+                    grid->getData(), grid->getNumLons(), grid->getNumLats(),
+                    grid->getNumLevels(), brickSize);
+        index->setGeneratingRequest(request);
+
+        if (!memoryManager->storeData(owner, index))
+        {
+            // Another thread has stored the same index in the mean time.
+            delete index;
+        }
+    }
+
+    return static_cast<MMinMaxBrickIndex*>(
+                memoryManager->getData(owner, request));
+}
+
+} // namespace Met3D
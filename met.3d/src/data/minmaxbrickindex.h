@@ -0,0 +1,135 @@
+/******************************************************************************
+**
+**  This file is part of Met.3D -- a research environment for the
+**  three-dimensional visual exploration of numerical ensemble weather
+**  prediction data.
+**
+**  Copyright 2015-2020 Marc Rautenhaus
+**
+**  Regional Computing Center, Visualization
+**  Universitaet Hamburg, Hamburg, Germany
+**
+**  Met.3D is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Met.3D is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Met.3D.  If not, see <http://www.gnu.org/licenses/>.
+**
+*******************************************************************************/
+#ifndef MINMAXBRICKINDEX_H
+#define MINMAXBRICKINDEX_H
+
+// standard library imports
+#include <vector>
+
+// related third party imports
+#include <QtCore>
+
+// local application imports
+#include "data/abstractdataitem.h"
+#include "data/abstractmemorymanager.h"
+#include "data/structuredgrid.h"
+
+
+namespace Met3D
+{
+
+/**
+  @brief MMinMaxBrickIndex partitions the voxels of a structured grid into
+  bricks of (at most) brickSize^3 voxels and stores the minimum and maximum
+  of the grid values at the corners of the voxels of each brick.
+
+  The index is built once per scalar field and allows an isosurface
+  extraction (@ref MMarchingCubes::setMinMaxBrickIndex()) to skip all bricks
+  that cannot contain a voxel intersected by the isosurface. Repeated
+  extractions with different isovalues (e.g. while dragging an isovalue
+  slider) hence only visit the bricks along the surface.
+
+  The classification is conservative with respect to the marching cubes
+  voxel classification (value < isovalue): missing values (NaN) are
+  treated as values above any isovalue.
+
+  The index is a data item so that it can be cached in the memory manager
+  alongside the grid it has been computed from (see @ref getIndex()).
+ */
+class MMinMaxBrickIndex : public MAbstractDataItem
+{
+public:
+    /**
+      Builds the index of the scalar field @p values with @p dimX x @p dimY x
+      @p dimZ grid points (memory layout of @ref MStructuredGrid, i.e. k, j,
+      i with i running fastest).
+     */
+    MMinMaxBrickIndex(const float *values, uint32_t dimX, uint32_t dimY,
+                      uint32_t dimZ, uint32_t brickSize = 8);
+
+    unsigned int getMemorySize_kb() override;
+
+    uint32_t getBrickSize() const { return brickSize; }
+
+    uint32_t getNumBricks() const { return uint32_t(minValues.size()); }
+
+    /**
+      Returns true if the index has been built for a grid of the given
+      dimensions.
+     */
+    bool hasDimensions(uint32_t dimX, uint32_t dimY, uint32_t dimZ) const
+    { return dimX == nx + 1 && dimY == ny + 1 && dimZ == nz + 1; }
+
+    /**
+      Returns true if brick @p brick may contain voxels intersected by the
+      isosurface @p isovalue, i.e. if it contains corner values both below
+      and not below @p isovalue.
+     */
+    bool isCandidate(uint32_t brick, float isovalue) const
+    { return minValues[brick] < isovalue && !(maxValues[brick] < isovalue); }
+
+    /**
+      Appends the candidate bricks for @p isovalue that contain voxel layers
+      in the range [@p k0, @p k1) to @p bricks.
+     */
+    void getCandidateBricks(float isovalue, uint32_t k0, uint32_t k1,
+                            std::vector<uint32_t>& bricks) const;
+
+    /**
+      Returns the voxel range [@p k0, @p k1) x [@p j0, @p j1) x [@p i0,
+      @p i1) of brick @p brick.
+     */
+    void getBrickVoxelRange(uint32_t brick,
+                            uint32_t& k0, uint32_t& k1,
+                            uint32_t& j0, uint32_t& j1,
+                            uint32_t& i0, uint32_t& i1) const;
+
+    /**
+      Returns the index of @p grid stored by @p owner in @p memoryManager.
+      The index is built and stored if it is not yet available. The request
+      of the index is the generating request of @p grid with the additional
+      key "MINMAX_BRICKS"; the index is hence shared by all extractions from
+      the same grid. The returned index needs to be released with
+      @ref MAbstractMemoryManager::releaseData().
+     */
+    static MMinMaxBrickIndex* getIndex(MAbstractMemoryManager *memoryManager,
+                                       MMemoryManagementUsingObject *owner,
+                                       MStructuredGrid *grid,
+                                       uint32_t brickSize = 8);
+
+private:
+    uint32_t brickSize;
+    // Number of voxels and number of bricks in each dimension.
+    uint32_t nx, ny, nz;
+    uint32_t nbx, nby, nbz;
+
+    std::vector<float> minValues;
+    std::vector<float> maxValues;
+};
+
+} // namespace Met3D
+
+#endif // MINMAXBRICKINDEX_H
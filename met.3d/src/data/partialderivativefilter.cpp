@@ -34,7 +34,7 @@
 #include <log4cplus/loggingmacros.h>
 
 // local application imports
-#include "gxfw/nwpactorvariableproperties.h"
+#include "data/gridpressureaccess.h"
 #include "util/mutil.h"
 #include "util/mexception.h"
 #include "util/metroutines.h"
@@ -66,6 +66,7 @@ MStructuredGrid *MPartialDerivativeFilter::produceData(Met3D::MDataRequest reque
     // Examples: DERIVATIVE=D/LON, =D2/LAT
     QStringList parameterList = rh.value("GRADIENT").split("/");
     rh.removeAll(locallyRequiredKeys());
+    addStencilHaloToSubDomain(&rh);
     // The first parameter passes the filter type.
     MGradientProperties::GradientModeTypes filterType =
             static_cast<MGradientProperties::GradientModeTypes>(
@@ -98,12 +99,100 @@ MStructuredGrid *MPartialDerivativeFilter::produceData(Met3D::MDataRequest reque
     LOG4CPLUS_DEBUG(mlog, "Vertical level type:"
                     << levelType.toUtf8().constData());
 
+    // The kernels evaluate the pressure of each grid point several times;
+    // read it from the (shared) pressure field of hybrid grids.
+    if (MLonLatHybridSigmaPressureGrid *hybridGrid =
+            dynamic_cast<MLonLatHybridSigmaPressureGrid*>(inputGrid))
+    {
+        hybridGrid->getPressureField_hPa();
+    }
+
+    // Dispatch to the kernels specialised for the pressure representation of
+    // the input grid.
+    switch (getPressureAccessType(inputGrid))
+    {
+    case LEVEL_PRESSURE_ACCESS:
+        computeGradient(MLevelPressureAccess(inputGrid), request, filterType,
+                        inputGrid, geoPotGrid, resultGrid);
+        break;
+    case HYBRID_SIGMA_PRESSURE_ACCESS:
+        computeGradient(MHybridSigmaPressureAccess(
+                            static_cast<MLonLatHybridSigmaPressureGrid*>(
+                                inputGrid)),
+                        request, filterType, inputGrid, geoPotGrid,
+                        resultGrid);
+        break;
+    case PRESSURE_FIELD_ACCESS:
+        computeGradient(MPressureFieldAccess(inputGrid), request, filterType,
+                        inputGrid, geoPotGrid, resultGrid);
+        break;
+    default:
+        computeGradient(MGenericPressureAccess(inputGrid), request, filterType,
+                        inputGrid, geoPotGrid, resultGrid);
+    }
+    inputSource->releaseData(inputGrid);
+    resultGrid->copyDoubleDataToFloat();
+    return resultGrid;
+}
+
+
+
+MTask *MPartialDerivativeFilter::createTaskGraph(MDataRequest request)
+{
+    assert(inputSource != nullptr);
+    MTask* task = new MTask(request, this);
+    // Simply request the variable that was requested from this data source
+    //(we're requesting the unsmoothed field and pass on the smoothed
+    //version).
+    MDataRequestHelper rh(request);
+    rh.removeAll(locallyRequiredKeys());
+    addStencilHaloToSubDomain(&rh);
+    task->addParent(inputSource->getTaskGraph(rh.request()));
+    return task;
+}
+
+/******************************************************************************
+***                          PROTECTED METHODS                              ***
+*******************************************************************************/
+
+const QStringList MPartialDerivativeFilter::locallyRequiredKeys()
+{
+    return (QStringList() << "GRADIENT");
+}
+
+
+/******************************************************************************
+***                           PRIVATE METHODS                               ***
+*******************************************************************************/
+
+void MPartialDerivativeFilter::addStencilHaloToSubDomain(
+        MDataRequestHelper *rh)
+{
+    if (!rh->contains("SUBDOMAIN")) return;
+
+    MSubDomain subDomain = MSubDomain::fromRequestValue(
+                rh->value("SUBDOMAIN"));
+    if (!subDomain.isValid()) return;
+
+    subDomain.expandByGridPoints(2);
+    rh->insert("SUBDOMAIN", subDomain.toRequestValue());
+}
+
+
+template<typename PressureAccess>
+void MPartialDerivativeFilter::computeGradient(
+        const PressureAccess &pressure, MDataRequest request,
+        MGradientProperties::GradientModeTypes filterType,
+        MStructuredGrid *inputGrid, MStructuredGrid *geoPotGrid,
+        MStructuredGrid *resultGrid)
+{
     switch (filterType)
     {
     case MGradientProperties::DLON:
     {
         computePartialDerivativeLongitude(inputGrid, resultGrid);
-        computePressureCoordinateTransormationLongitude(inputGrid, resultGrid);
+        computePressureCoordinateTransormationLongitude(pressure, inputGrid,
+                                                        resultGrid);
         break;
     }
     case MGradientProperties::DLON_LAGRANTO:
@@ -120,7 +209,8 @@ MStructuredGrid *MPartialDerivativeFilter::produceData(Met3D::MDataRequest reque
     case MGradientProperties::DLAT:
     {
         computePartialDerivativeLatitude(inputGrid, resultGrid);
-        computePressureCoordinateTransormationLatitude(inputGrid, resultGrid);
+        computePressureCoordinateTransormationLatitude(pressure, inputGrid,
+                                                       resultGrid);
         break;
     }
     case MGradientProperties::DLAT_LAGRANTO:
@@ -136,7 +226,7 @@ MStructuredGrid *MPartialDerivativeFilter::produceData(Met3D::MDataRequest reque
     }
     case MGradientProperties::DP:
     {
-        computePartialDerivativeVertical(inputGrid, resultGrid);
+        computePartialDerivativeVertical(pressure, inputGrid, resultGrid);
         break;
     }
     case MGradientProperties::DZ:
@@ -149,19 +239,19 @@ MStructuredGrid *MPartialDerivativeFilter::produceData(Met3D::MDataRequest reque
     {
         computeSecondHorizontalDerivative(inputGrid, resultGrid, "lon");
         computeHorizontalPressureLevelTransformationForSecondDerivativeLon(
-                    inputGrid, resultGrid);
+                    pressure, inputGrid, resultGrid);
         break;
     }
     case MGradientProperties::D2LAT:
     {
         computeSecondHorizontalDerivative(inputGrid, resultGrid, "lat");
         computeHorizontalPressureLevelTransformationForSecondDerivativeLat(
-                    inputGrid, resultGrid);
+                    pressure, inputGrid, resultGrid);
         break;
     }
     case MGradientProperties::D2P:
     {
-        computeSecondVerticalDerivative(inputGrid, resultGrid);
+        computeSecondVerticalDerivative(pressure, inputGrid, resultGrid);
         break;
     }
     case MGradientProperties::D2Z:
@@ -170,37 +260,38 @@ MStructuredGrid *MPartialDerivativeFilter::produceData(Met3D::MDataRequest reque
                                                        resultGrid);
         break;
     }
+    case MGradientProperties::DP_D2P:
+    {
+        MStructuredGrid *firstDerivativeGrid =
+                createAndInitializeResultGrid(inputGrid);
+        firstDerivativeGrid->initializeDoubleData();
+        computeFirstAndSecondVerticalDerivative(pressure, inputGrid,
+                                                firstDerivativeGrid,
+                                                resultGrid);
+        firstDerivativeGrid->copyDoubleDataToFloat();
+        firstDerivativeGrid->deleteDoubleData();
+
+        // Store the first derivative under the request it would have been
+        // computed for with GRADIENT=DP. "storeData()" places a reference on
+        // the item (also if the same item has been stored by another thread
+        // in the mean time, then our copy is deleted); this reference is
+        // handed to the result grid.
+        MDataRequestHelper rhDP(request);
+        rhDP.insert("GRADIENT", int(MGradientProperties::DP));
+        firstDerivativeGrid->setGeneratingRequest(rhDP.request());
+        if ( !memoryManager->storeData(this, firstDerivativeGrid) )
+        {
+            delete firstDerivativeGrid;
+        }
+        resultGrid->setCompanionGrid(static_cast<MStructuredGrid*>(
+                    memoryManager->getData(this, rhDP.request())));
+        break;
+    }
     default:
         LOG4CPLUS_DEBUG(mlog, "This gradient filter does not exists."
-                        << gradientModeName.toUtf8().constData());
+                        << MGradientProperties::gradientModeToString(
+                            filterType).toUtf8().constData());
     }
-    inputSource->releaseData(inputGrid);
-    resultGrid->copyDoubleDataToFloat();
-    return resultGrid;
-}
-
-
-
-MTask *MPartialDerivativeFilter::createTaskGraph(MDataRequest request)
-{
-    assert(inputSource != nullptr);
-    MTask* task = new MTask(request, this);
-    // Simply request the variable that was requested from this data source
-    //(we're requesting the unsmoothed field and pass on the smoothed
-    //version).
-    MDataRequestHelper rh(request);
-    rh.removeAll(locallyRequiredKeys());
-    task->addParent(inputSource->getTaskGraph(rh.request()));
-    return task;
-}
-
-/******************************************************************************
-***                          PROTECTED METHODS                              ***
-*******************************************************************************/
-
-const QStringList MPartialDerivativeFilter::locallyRequiredKeys()
-{
-    return (QStringList() << "GRADIENT");
 }
 
 
@@ -432,8 +523,10 @@ void MPartialDerivativeFilter::computePartialDerivativeLatitudeSobel(
 }
 
 
+template<typename PressureAccess>
 void MPartialDerivativeFilter::computePartialDerivativeVertical(
-        MStructuredGrid *inputGrid, MStructuredGrid *resultGrid)
+        const PressureAccess &pressure, MStructuredGrid *inputGrid,
+        MStructuredGrid *resultGrid)
 {
     const int nLon = inputGrid->getNumLons();
     const int nLat = inputGrid->getNumLats();
@@ -452,8 +545,8 @@ void MPartialDerivativeFilter::computePartialDerivativeVertical(
                 kN = std::min(k + 1, nLev - 1);
                 df = inputGrid->getValue_double(kN, j, i)
                         - inputGrid->getValue_double(kP, j, i);
-                dp = inputGrid->getPressure(kN, j, i)
-                        - inputGrid->getPressure(kP, j, i);
+                dp = pressure.getPressure(kN, j, i)
+                        - pressure.getPressure(kP, j, i);
                 //When df is zero, then the result should be zero, else it wouldn't be defined
                 float result;
                 if(df == 0)
@@ -473,8 +566,10 @@ void MPartialDerivativeFilter::computePartialDerivativeVertical(
 }
 
 
+template<typename PressureAccess>
 void MPartialDerivativeFilter::computePartialDerivativePressureLongitude(
-            MStructuredGrid *inputGrid, MStructuredGrid *resultGrid)
+        const PressureAccess &pressure, MStructuredGrid *inputGrid,
+        MStructuredGrid *resultGrid)
 {
     const int nLon = inputGrid->getNumLons();
     const int nLat = inputGrid->getNumLats();
@@ -495,18 +590,18 @@ void MPartialDerivativeFilter::computePartialDerivativePressureLongitude(
             {
                 iP = std::max(i - 1, 0);
                 iN = std::min(i + 1, nLon - 1);
-                dpdx = (inputGrid->getPressure(k, j, iN)
-                      - inputGrid->getPressure(k, j, iP))
+                dpdx = (pressure.getPressure(k, j, iN)
+                      - pressure.getPressure(k, j, iP))
                       / (dx * double(abs(iN - iP)));
                 resultGrid->setValue_double(k, j, i, dpdx);
             }
             if (periodicBC[0])
             {
-                dpdx = (inputGrid->getPressure(k, j, 1)
-                      - inputGrid->getPressure(k, j, nLon - 1)) / (2 * dx);
+                dpdx = (pressure.getPressure(k, j, 1)
+                      - pressure.getPressure(k, j, nLon - 1)) / (2 * dx);
                 resultGrid->setValue_double(k, j, 0, dpdx);
-                dpdx = (inputGrid->getPressure(k, j, 0)
-                      - inputGrid->getPressure(k, j, nLon - 2))  / (2 * dx);
+                dpdx = (pressure.getPressure(k, j, 0)
+                      - pressure.getPressure(k, j, nLon - 2))  / (2 * dx);
                 resultGrid->setValue_double(k, j, nLon - 1, dpdx);
             }
         }
@@ -514,8 +609,10 @@ void MPartialDerivativeFilter::computePartialDerivativePressureLongitude(
 }
 
 
+template<typename PressureAccess>
 void MPartialDerivativeFilter::computePartialDerivativePressureLatitude(
-        MStructuredGrid *inputGrid, MStructuredGrid *resultGrid)
+        const PressureAccess &pressure, MStructuredGrid *inputGrid,
+        MStructuredGrid *resultGrid)
 {
     const int nLon = inputGrid->getNumLons();
     const int nLat = inputGrid->getNumLats();
@@ -535,8 +632,8 @@ void MPartialDerivativeFilter::computePartialDerivativePressureLatitude(
             jN = std::min(j + 1, nLat - 1);
             for (int i = 0; i < nLon; i++)
             {
-                dpdy = (inputGrid->getPressure(k, jN, i)
-                      - inputGrid->getPressure(k, jP, i))
+                dpdy = (pressure.getPressure(k, jN, i)
+                      - pressure.getPressure(k, jP, i))
                       / (dy * double(abs(jN - jP)));
                 resultGrid->setValue_double(k, j, i, dpdy);
             }
@@ -546,8 +643,8 @@ void MPartialDerivativeFilter::computePartialDerivativePressureLatitude(
             for (int i = 0; i < nLon; i++)
             {
                 iOpp = ((i + (nLon / 2)) % (nLon));
-                dpdy = (inputGrid->getPressure(k, 1, i)
-                    - inputGrid->getPressure(k, 0, iOpp)) / (2 * dy);
+                dpdy = (pressure.getPressure(k, 1, i)
+                    - pressure.getPressure(k, 0, iOpp)) / (2 * dy);
                 resultGrid->setValue_double(k, 0, i, dpdy);
             }
         }
@@ -556,8 +653,8 @@ void MPartialDerivativeFilter::computePartialDerivativePressureLatitude(
             for (int i = 0; i < nLon; i++)
             {
                 iOpp = ((i + (nLon / 2)) % (nLon));
-                dpdy = (inputGrid->getPressure(k, nLat - 1, iOpp)
-                    - inputGrid->getPressure(k, nLat -  2, i)) / (2 * dy);
+                dpdy = (pressure.getPressure(k, nLat - 1, iOpp)
+                    - pressure.getPressure(k, nLat -  2, i)) / (2 * dy);
                 resultGrid->setValue_double(k, nLat - 1, i, dpdy);
             }
         }
@@ -565,8 +662,10 @@ void MPartialDerivativeFilter::computePartialDerivativePressureLatitude(
 }
 
 
+template<typename PressureAccess>
 void MPartialDerivativeFilter::computePressureCoordinateTransormationLongitude(
-        MStructuredGrid *inputGrid, MStructuredGrid *resultGrid)
+        const PressureAccess &pressure, MStructuredGrid *inputGrid,
+        MStructuredGrid *resultGrid)
 {
     MStructuredGrid *dfdp = createAndInitializeResultGrid(inputGrid);
     dfdp->copyFloatDataToDouble();
@@ -578,8 +677,8 @@ void MPartialDerivativeFilter::computePressureCoordinateTransormationLongitude(
     const int nLat = inputGrid->getNumLats();
     const int nLev = inputGrid->getNumLevels();
 
-    computePartialDerivativeVertical(inputGrid, dfdp);
-    computePartialDerivativePressureLongitude(inputGrid, dpdx);
+    computePartialDerivativeVertical(pressure, inputGrid, dfdp);
+    computePartialDerivativePressureLongitude(pressure, inputGrid, dpdx);
 
 #pragma omp parallel for
     for (int k = 0; k < nLev; k++)
@@ -600,8 +699,10 @@ void MPartialDerivativeFilter::computePressureCoordinateTransormationLongitude(
 }
 
 
+template<typename PressureAccess>
 void MPartialDerivativeFilter::computePressureCoordinateTransormationLatitude(
-        MStructuredGrid *inputGrid, MStructuredGrid *resultGrid)
+        const PressureAccess &pressure, MStructuredGrid *inputGrid,
+        MStructuredGrid *resultGrid)
 {
     MStructuredGrid *dfdp = createAndInitializeResultGrid(inputGrid);
     dfdp->copyFloatDataToDouble();
@@ -612,8 +713,8 @@ void MPartialDerivativeFilter::computePressureCoordinateTransormationLatitude(
     const int nLat = inputGrid->getNumLats();
     const int nLev = inputGrid->getNumLevels();
 
-    computePartialDerivativeVertical(inputGrid, dfdp);
-    computePartialDerivativePressureLatitude(inputGrid, dpdy);
+    computePartialDerivativeVertical(pressure, inputGrid, dfdp);
+    computePartialDerivativePressureLatitude(pressure, inputGrid, dpdy);
 
 #pragma omp parallel for
     for (int k = 0; k < nLev; k++)
@@ -1008,8 +1109,10 @@ void MPartialDerivativeFilter::computeSecondHorizontalDerivative(
 }
 
 
+template<typename PressureAccess>
 void MPartialDerivativeFilter::computeSecondVerticalDerivative(
-        MStructuredGrid *inputGrid, MStructuredGrid *resultGrid)
+        const PressureAccess &pressure, MStructuredGrid *inputGrid,
+        MStructuredGrid *resultGrid)
 {
     double d2f, dp2;
     int nLevel = inputGrid->getNumLevels();
@@ -1018,15 +1121,15 @@ void MPartialDerivativeFilter::computeSecondVerticalDerivative(
         for (unsigned int i = 0; i < inputGrid->getNumLons(); i++)
         {
             // upper and lower boundary
-            dp2 = computeDx2(inputGrid->getPressure(0, j, i)
-                             - inputGrid->getPressure(1, j, i));
+            dp2 = computeDx2(pressure.getPressure(0, j, i)
+                             - pressure.getPressure(1, j, i));
             d2f = computeD2f(inputGrid->getValue_double(2, j, i),
                              inputGrid->getValue_double(1, j, i),
                              inputGrid->getValue_double(0, j, i));
             resultGrid->setValue_double(0, j, i, (d2f / dp2));
 
-            dp2 = computeDx2(inputGrid->getPressure(nLevel - 2, j, i)
-                             - inputGrid->getPressure(nLevel - 1, j, i));
+            dp2 = computeDx2(pressure.getPressure(nLevel - 2, j, i)
+                             - pressure.getPressure(nLevel - 1, j, i));
             d2f = computeD2f(inputGrid->getValue_double(nLevel - 1, j, i),
                              inputGrid->getValue_double(nLevel - 2, j, i),
                              inputGrid->getValue_double(nLevel - 3, j, i));
@@ -1034,8 +1137,8 @@ void MPartialDerivativeFilter::computeSecondVerticalDerivative(
 
             for (int k = 1; k < nLevel - 1; k++)
             {
-                dp2 = computeDf2(inputGrid->getPressure(k - 1, j, i),
-                                 inputGrid->getPressure(k + 1, j, i));
+                dp2 = computeDf2(pressure.getPressure(k - 1, j, i),
+                                 pressure.getPressure(k + 1, j, i));
                 d2f = computeD2f(inputGrid->getValue_double(k - 1, j, i),
                                  inputGrid->getValue_double(k, j, i),
                                  inputGrid->getValue_double(k + 1, j, i));
@@ -1045,6 +1148,57 @@ void MPartialDerivativeFilter::computeSecondVerticalDerivative(
     }
 }
 
+template<typename PressureAccess>
+void MPartialDerivativeFilter::computeFirstAndSecondVerticalDerivative(
+        const PressureAccess &pressure, MStructuredGrid *inputGrid,
+        MStructuredGrid *firstDerivativeGrid,
+        MStructuredGrid *secondDerivativeGrid)
+{
+    const int nLon = inputGrid->getNumLons();
+    const int nLat = inputGrid->getNumLats();
+    const int nLev = inputGrid->getNumLevels();
+
+#pragma omp parallel
+    {
+        // Per-thread column buffers; pressure is evaluated only once per
+        // grid point (expensive for hybrid sigma-pressure grids).
+        QVector<double> p(nLev);
+        QVector<double> dfdp(nLev);
+
+#pragma omp for collapse(2)
+        for (int j = 0; j < nLat; j++)
+        {
+            for (int i = 0; i < nLon; i++)
+            {
+                for (int k = 0; k < nLev; k++)
+                {
+                    p[k] = pressure.getPressure(k, j, i);
+                }
+
+                for (int k = 0; k < nLev; k++)
+                {
+                    const int kP = std::max(k - 1, 0);
+                    const int kN = std::min(k + 1, nLev - 1);
+                    dfdp[k] = (inputGrid->getValue_double(kN, j, i)
+                               - inputGrid->getValue_double(kP, j, i))
+                            / (p[kN] - p[kP]);
+                    firstDerivativeGrid->setValue_double(k, j, i, dfdp[k]);
+                }
+
+                for (int k = 0; k < nLev; k++)
+                {
+                    const int kP = std::max(k - 1, 0);
+                    const int kN = std::min(k + 1, nLev - 1);
+                    secondDerivativeGrid->setValue_double(
+                                k, j, i, (dfdp[kN] - dfdp[kP])
+                                / (p[kN] - p[kP]));
+                }
+            }
+        }
+    }
+}
+
+
 void MPartialDerivativeFilter::computeSecondVerticalDerivativeGeometricHeight(
         MStructuredGrid *inputGrid, MStructuredGrid *geoPot,
         MStructuredGrid *resultGrid)
@@ -1084,8 +1238,10 @@ void MPartialDerivativeFilter::computeSecondVerticalDerivativeGeometricHeight(
 }
 
 
+template<typename PressureAccess>
 void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSecondDerivativeLon(
-        MStructuredGrid *inputGrid, MStructuredGrid *resultGrid)
+        const PressureAccess &pressure, MStructuredGrid *inputGrid,
+        MStructuredGrid *resultGrid)
 {
     unsigned int nLat = inputGrid->getNumLats();
     unsigned int nLon = inputGrid->getNumLons();
@@ -1114,19 +1270,19 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
                 // deviation of f in p dir
                 df_p = computeDf(inputGrid->getValue_double(k-1, j, i),
                                  inputGrid->getValue_double(k+1, j, i));
-                dp_p = computeDf(inputGrid->getPressure(k-1, j, i),
-                                 inputGrid->getPressure(k+1, j, i));
+                dp_p = computeDf(pressure.getPressure(k-1, j, i),
+                                 pressure.getPressure(k+1, j, i));
                 dfdp = df_p/dp_p;
 
                 // deviation of p in x dir
-                dp_x = computeDf(inputGrid->getPressure(k, j, i - 1),
-                                 inputGrid->getPressure(k, j, i + 1));
+                dp_x = computeDf(pressure.getPressure(k, j, i - 1),
+                                 pressure.getPressure(k, j, i + 1));
                 dpdx = dp_x/dx;
 
                 // second deviaion of p in x dir
-                d2p_x = computeD2f(inputGrid->getPressure(k, j, i - 1),
-                                   inputGrid->getPressure(k, j, i),
-                                   inputGrid->getPressure(k, j, i + 1));
+                d2p_x = computeD2f(pressure.getPressure(k, j, i - 1),
+                                   pressure.getPressure(k, j, i),
+                                   pressure.getPressure(k, j, i + 1));
                 d2pdx2 = d2p_x/dx2;
 
                 // second deviation of f in p dir
@@ -1145,19 +1301,19 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
             //i = 0
             df_p = computeDf(inputGrid->getValue_double(k-1, j, 0),
                              inputGrid->getValue_double(k+1, j, 0));
-            dp_p = computeDf(inputGrid->getPressure(k-1, j, 0),
-                             inputGrid->getPressure(k+1, j, 0));
+            dp_p = computeDf(pressure.getPressure(k-1, j, 0),
+                             pressure.getPressure(k+1, j, 0));
             dfdp = df_p/dp_p;
 
             // deviation of p in x dir
-            dp_x = computeDf(inputGrid->getPressure(k, j, 0),
-                             inputGrid->getPressure(k, j, 1)) * 2.0;
+            dp_x = computeDf(pressure.getPressure(k, j, 0),
+                             pressure.getPressure(k, j, 1)) * 2.0;
             dpdx = dp_x/dx;
 
             // second deviaion of p in x dir
-            d2p_x = computeD2f(inputGrid->getPressure(k, j, 0),
-                               inputGrid->getPressure(k, j, 1),
-                               inputGrid->getPressure(k, j, 2));
+            d2p_x = computeD2f(pressure.getPressure(k, j, 0),
+                               pressure.getPressure(k, j, 1),
+                               pressure.getPressure(k, j, 2));
             d2pdx2 = d2p_x/dx2;
 
             // second deviation of f in p dir
@@ -1170,14 +1326,14 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
             if (periodicBC[0])
             {
                 // deviation of p in x dir
-                dp_x = computeDf(inputGrid->getPressure(k, j, nLon -1),
-                                 inputGrid->getPressure(k, j, 1));
+                dp_x = computeDf(pressure.getPressure(k, j, nLon -1),
+                                 pressure.getPressure(k, j, 1));
                 dpdx = dp_x/dx;
 
                 // second deviaion of p in x dir
-                d2p_x = computeD2f(inputGrid->getPressure(k, j, nLon - 1),
-                                   inputGrid->getPressure(k, j, 0),
-                                   inputGrid->getPressure(k, j, 1));
+                d2p_x = computeD2f(pressure.getPressure(k, j, nLon - 1),
+                                   pressure.getPressure(k, j, 0),
+                                   pressure.getPressure(k, j, 1));
                 d2pdx2 = d2p_x/dx2;
             }
             result = resultGrid->getValue_double(k, j, 0)
@@ -1189,19 +1345,19 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
             //i = nLon - 1
             df_p = computeDf(inputGrid->getValue_double(k-1, j, nLon - 1),
                              inputGrid->getValue_double(k+1, j, nLon - 1));
-            dp_p = computeDf(inputGrid->getPressure(k-1, j, nLon - 1),
-                             inputGrid->getPressure(k+1, j, nLon - 1));
+            dp_p = computeDf(pressure.getPressure(k-1, j, nLon - 1),
+                             pressure.getPressure(k+1, j, nLon - 1));
             dfdp = df_p/dp_p;
 
             // deviation of p in x dir
-            dp_x = computeDf(inputGrid->getPressure(k, j, nLon - 2),
-                             inputGrid->getPressure(k, j, nLon - 1)) * 2.0;
+            dp_x = computeDf(pressure.getPressure(k, j, nLon - 2),
+                             pressure.getPressure(k, j, nLon - 1)) * 2.0;
             dpdx = dp_x/dx;
 
             // second deviaion of p in x dir
-            d2p_x = computeD2f(inputGrid->getPressure(k, j, nLon - 3),
-                               inputGrid->getPressure(k, j, nLon - 2),
-                               inputGrid->getPressure(k, j, nLon - 1));
+            d2p_x = computeD2f(pressure.getPressure(k, j, nLon - 3),
+                               pressure.getPressure(k, j, nLon - 2),
+                               pressure.getPressure(k, j, nLon - 1));
             d2pdx2 = d2p_x/dx2;
 
             // second deviation of f in p dir
@@ -1214,14 +1370,14 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
             if (periodicBC[0])
             {
                 // deviation of p in x dir
-                dp_x = computeDf(inputGrid->getPressure(k, j, 0),
-                                 inputGrid->getPressure(k, j, nLon - 2));
+                dp_x = computeDf(pressure.getPressure(k, j, 0),
+                                 pressure.getPressure(k, j, nLon - 2));
                 dpdx = dp_x/dx;
 
                 // second deviaion of p in x dir
-                d2p_x = computeD2f(inputGrid->getPressure(k, j, 0),
-                                   inputGrid->getPressure(k, j, nLon - 1),
-                                   inputGrid->getPressure(k, j, nLon - 2));
+                d2p_x = computeD2f(pressure.getPressure(k, j, 0),
+                                   pressure.getPressure(k, j, nLon - 1),
+                                   pressure.getPressure(k, j, nLon - 2));
                 d2pdx2 = d2p_x/dx2;
             }
             result = resultGrid->getValue_double(k, j, nLon - 1)
@@ -1245,19 +1401,19 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
             // deviation of f in p dir
             df_p = computeDf(inputGrid->getValue_double(0, j, i),
                              inputGrid->getValue_double(1, j, i)) * 2;
-            dp_p = computeDf(inputGrid->getPressure(0, j, i),
-                             inputGrid->getPressure(1, j, i)) * 2;
+            dp_p = computeDf(pressure.getPressure(0, j, i),
+                             pressure.getPressure(1, j, i)) * 2;
             dfdp = df_p/dp_p;
 
             // deviation of p in x dir
-            dp_x = computeDf(inputGrid->getPressure(0, j, i - 1),
-                             inputGrid->getPressure(0, j, i + 1));
+            dp_x = computeDf(pressure.getPressure(0, j, i - 1),
+                             pressure.getPressure(0, j, i + 1));
             dpdx = dp_x/dx;
 
             // second deviaion of p in x dir
-            d2p_x = computeD2f(inputGrid->getPressure(0, j, i - 1),
-                               inputGrid->getPressure(0, j, i),
-                               inputGrid->getPressure(0, j, i + 1));
+            d2p_x = computeD2f(pressure.getPressure(0, j, i - 1),
+                               pressure.getPressure(0, j, i),
+                               pressure.getPressure(0, j, i + 1));
             d2pdx2 = d2p_x/dx2;
 
             // second deviation of f in p dir
@@ -1276,19 +1432,19 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
         //i = 0
         df_p = computeDf(inputGrid->getValue_double(0, j, 0),
                          inputGrid->getValue_double(1, j, 0)) * 2.0;
-        dp_p = computeDf(inputGrid->getPressure(0, j, 0),
-                         inputGrid->getPressure(1, j, 0)) * 2.0;
+        dp_p = computeDf(pressure.getPressure(0, j, 0),
+                         pressure.getPressure(1, j, 0)) * 2.0;
         dfdp = df_p/dp_p;
 
         // deviation of p in x dir
-        dp_x = computeDf(inputGrid->getPressure(0, j, 0),
-                         inputGrid->getPressure(0, j, 1)) * 2.0;
+        dp_x = computeDf(pressure.getPressure(0, j, 0),
+                         pressure.getPressure(0, j, 1)) * 2.0;
         dpdx = dp_x/dx;
 
         // second deviaion of p in x dir
-        d2p_x = computeD2f(inputGrid->getPressure(0, j, 0),
-                           inputGrid->getPressure(0, j, 1),
-                           inputGrid->getPressure(0, j, 2));
+        d2p_x = computeD2f(pressure.getPressure(0, j, 0),
+                           pressure.getPressure(0, j, 1),
+                           pressure.getPressure(0, j, 2));
         d2pdx2 = d2p_x/dx2;
 
         // second deviation of f in p dir
@@ -1301,14 +1457,14 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
         if (periodicBC[0])
         {
             // deviation of p in x dir
-            dp_x = computeDf(inputGrid->getPressure(0, j, nLon -1),
-                             inputGrid->getPressure(0, j, 1));
+            dp_x = computeDf(pressure.getPressure(0, j, nLon -1),
+                             pressure.getPressure(0, j, 1));
             dpdx = dp_x/dx;
 
             // second deviaion of p in x dir
-            d2p_x = computeD2f(inputGrid->getPressure(0, j, nLon - 1),
-                               inputGrid->getPressure(0, j, 0),
-                               inputGrid->getPressure(0, j, 1));
+            d2p_x = computeD2f(pressure.getPressure(0, j, nLon - 1),
+                               pressure.getPressure(0, j, 0),
+                               pressure.getPressure(0, j, 1));
             d2pdx2 = d2p_x/dx2;
         }
         result = resultGrid->getValue_double(0, j, 0)
@@ -1320,19 +1476,19 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
         //i = nLon - 1
         df_p = computeDf(inputGrid->getValue_double(0, j, nLon - 1),
                          inputGrid->getValue_double(1, j, nLon - 1)) * 2.0;
-        dp_p = computeDf(inputGrid->getPressure(0, j, nLon - 1),
-                         inputGrid->getPressure(1, j, nLon - 1)) * 2.0;
+        dp_p = computeDf(pressure.getPressure(0, j, nLon - 1),
+                         pressure.getPressure(1, j, nLon - 1)) * 2.0;
         dfdp = df_p/dp_p;
 
         // deviation of p in x dir
-        dp_x = computeDf(inputGrid->getPressure(0, j, nLon - 2),
-                         inputGrid->getPressure(0, j, nLon - 1)) * 2.0;
+        dp_x = computeDf(pressure.getPressure(0, j, nLon - 2),
+                         pressure.getPressure(0, j, nLon - 1)) * 2.0;
         dpdx = dp_x/dx;
 
         // second deviaion of p in x dir
-        d2p_x = computeD2f(inputGrid->getPressure(0, j, nLon - 3),
-                           inputGrid->getPressure(0, j, nLon - 2),
-                           inputGrid->getPressure(0, j, nLon - 1));
+        d2p_x = computeD2f(pressure.getPressure(0, j, nLon - 3),
+                           pressure.getPressure(0, j, nLon - 2),
+                           pressure.getPressure(0, j, nLon - 1));
         d2pdx2 = d2p_x/dx2;
 
         // second deviation of f in p dir
@@ -1345,14 +1501,14 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
         if (periodicBC[0])
         {
             // deviation of p in x dir
-            dp_x = computeDf(inputGrid->getPressure(0, j, 0),
-                             inputGrid->getPressure(0, j, nLon - 2));
+            dp_x = computeDf(pressure.getPressure(0, j, 0),
+                             pressure.getPressure(0, j, nLon - 2));
             dpdx = dp_x/dx;
 
             // second deviaion of p in x dir
-            d2p_x = computeD2f(inputGrid->getPressure(0, j, 0),
-                               inputGrid->getPressure(0, j, nLon - 1),
-                               inputGrid->getPressure(0, j, nLon - 2));
+            d2p_x = computeD2f(pressure.getPressure(0, j, 0),
+                               pressure.getPressure(0, j, nLon - 1),
+                               pressure.getPressure(0, j, nLon - 2));
             d2pdx2 = d2p_x/dx2;
         }
         result = resultGrid->getValue_double(0, j, nLon - 1)
@@ -1375,19 +1531,19 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
             // deviation of f in p dir
             df_p = computeDf(inputGrid->getValue_double(nLev - 2, j, i),
                              inputGrid->getValue_double(nLev - 1, j, i)) * 2;
-            dp_p = computeDf(inputGrid->getPressure(nLev - 2, j, i),
-                             inputGrid->getPressure(nLev - 1, j, i)) * 2;
+            dp_p = computeDf(pressure.getPressure(nLev - 2, j, i),
+                             pressure.getPressure(nLev - 1, j, i)) * 2;
             dfdp = df_p/dp_p;
 
             // deviation of p in x dir
-            dp_x = computeDf(inputGrid->getPressure(nLev - 1, j, i - 1),
-                             inputGrid->getPressure(nLev - 1, j, i + 1));
+            dp_x = computeDf(pressure.getPressure(nLev - 1, j, i - 1),
+                             pressure.getPressure(nLev - 1, j, i + 1));
             dpdx = dp_x/dx;
 
             // second deviaion of p in x dir
-            d2p_x = computeD2f(inputGrid->getPressure(nLev - 1, j, i - 1),
-                               inputGrid->getPressure(nLev - 1, j, i),
-                               inputGrid->getPressure(nLev - 1, j, i + 1));
+            d2p_x = computeD2f(pressure.getPressure(nLev - 1, j, i - 1),
+                               pressure.getPressure(nLev - 1, j, i),
+                               pressure.getPressure(nLev - 1, j, i + 1));
             d2pdx2 = d2p_x/dx2;
 
             // second deviation of f in p dir
@@ -1406,19 +1562,19 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
         //i = 0
         df_p = computeDf(inputGrid->getValue_double(nLev - 2, j, 0),
                          inputGrid->getValue_double(nLev - 1, j, 0)) * 2.0;
-        dp_p = computeDf(inputGrid->getPressure(nLev - 2, j, 0),
-                         inputGrid->getPressure(nLev - 1, j, 0)) * 2.0;
+        dp_p = computeDf(pressure.getPressure(nLev - 2, j, 0),
+                         pressure.getPressure(nLev - 1, j, 0)) * 2.0;
         dfdp = df_p/dp_p;
 
         // deviation of p in x dir
-        dp_x = computeDf(inputGrid->getPressure(nLev - 1, j, 0),
-                         inputGrid->getPressure(nLev - 1, j, 1)) * 2.0;
+        dp_x = computeDf(pressure.getPressure(nLev - 1, j, 0),
+                         pressure.getPressure(nLev - 1, j, 1)) * 2.0;
         dpdx = dp_x/dx;
 
         // second deviaion of p in x dir
-        d2p_x = computeD2f(inputGrid->getPressure(nLev - 1, j, 0),
-                           inputGrid->getPressure(nLev - 1, j, 1),
-                           inputGrid->getPressure(nLev - 1, j, 2));
+        d2p_x = computeD2f(pressure.getPressure(nLev - 1, j, 0),
+                           pressure.getPressure(nLev - 1, j, 1),
+                           pressure.getPressure(nLev - 1, j, 2));
         d2pdx2 = d2p_x/dx2;
 
         // second deviation of f in p dir
@@ -1431,14 +1587,14 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
         if (periodicBC[0])
         {
             // deviation of p in x dir
-            dp_x = computeDf(inputGrid->getPressure(nLev - 1, j, nLon -1),
-                             inputGrid->getPressure(nLev - 1, j, 1));
+            dp_x = computeDf(pressure.getPressure(nLev - 1, j, nLon -1),
+                             pressure.getPressure(nLev - 1, j, 1));
             dpdx = dp_x/dx;
 
             // second deviaion of p in x dir
-            d2p_x = computeD2f(inputGrid->getPressure(nLev - 1, j, nLon - 1),
-                               inputGrid->getPressure(nLev - 1, j, 0),
-                               inputGrid->getPressure(nLev - 1, j, 1));
+            d2p_x = computeD2f(pressure.getPressure(nLev - 1, j, nLon - 1),
+                               pressure.getPressure(nLev - 1, j, 0),
+                               pressure.getPressure(nLev - 1, j, 1));
             d2pdx2 = d2p_x/dx2;
         }
         result = resultGrid->getValue_double(nLev - 1, j, 0)
@@ -1449,19 +1605,19 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
         //i = nLon - 1
         df_p = computeDf(inputGrid->getValue_double(nLev - 2, j, nLon - 1),
                          inputGrid->getValue_double(nLev - 1, j, nLon - 1)) * 2.0;
-        dp_p = computeDf(inputGrid->getPressure(nLev - 2, j, nLon - 1),
-                         inputGrid->getPressure(nLev - 1, j, nLon - 1)) * 2.0;
+        dp_p = computeDf(pressure.getPressure(nLev - 2, j, nLon - 1),
+                         pressure.getPressure(nLev - 1, j, nLon - 1)) * 2.0;
         dfdp = df_p/dp_p;
 
         // deviation of p in x dir
-        dp_x = computeDf(inputGrid->getPressure(nLev - 1, j, nLon - 2),
-                         inputGrid->getPressure(nLev - 1, j, nLon - 1)) * 2.0;
+        dp_x = computeDf(pressure.getPressure(nLev - 1, j, nLon - 2),
+                         pressure.getPressure(nLev - 1, j, nLon - 1)) * 2.0;
         dpdx = dp_x/dx;
 
         // second deviaion of p in x dir
-        d2p_x = computeD2f(inputGrid->getPressure(nLev - 1, j, nLon - 3),
-                           inputGrid->getPressure(nLev - 1, j, nLon - 2),
-                           inputGrid->getPressure(nLev - 1, j, nLon - 1));
+        d2p_x = computeD2f(pressure.getPressure(nLev - 1, j, nLon - 3),
+                           pressure.getPressure(nLev - 1, j, nLon - 2),
+                           pressure.getPressure(nLev - 1, j, nLon - 1));
         d2pdx2 = d2p_x/dx2;
 
         // second deviation of f in p dir
@@ -1474,14 +1630,14 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
         if (periodicBC[0])
         {
             // deviation of p in x dir
-            dp_x = computeDf(inputGrid->getPressure(nLev - 1, j, 0),
-                             inputGrid->getPressure(nLev - 1, j, nLon - 2));
+            dp_x = computeDf(pressure.getPressure(nLev - 1, j, 0),
+                             pressure.getPressure(nLev - 1, j, nLon - 2));
             dpdx = dp_x/dx;
 
             // second deviaion of p in x dir
-            d2p_x = computeD2f(inputGrid->getPressure(nLev - 1, j, 0),
-                               inputGrid->getPressure(nLev - 1, j, nLon - 1),
-                               inputGrid->getPressure(nLev - 1, j, nLon - 2));
+            d2p_x = computeD2f(pressure.getPressure(nLev - 1, j, 0),
+                               pressure.getPressure(nLev - 1, j, nLon - 1),
+                               pressure.getPressure(nLev - 1, j, nLon - 2));
             d2pdx2 = d2p_x/dx2;
         }
         result = resultGrid->getValue_double(nLev - 1, j, nLon - 1)
@@ -1492,8 +1648,10 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
 }
 
 
+template<typename PressureAccess>
 void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSecondDerivativeLat(
-        MStructuredGrid *inputGrid, MStructuredGrid *resultGrid)
+        const PressureAccess &pressure, MStructuredGrid *inputGrid,
+        MStructuredGrid *resultGrid)
 {
     unsigned int nLat = inputGrid->getNumLats();
     unsigned int nLon = inputGrid->getNumLons();
@@ -1523,19 +1681,19 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
                 // deviation of f in p dir
                 df_p = computeDf(inputGrid->getValue_double(k-1, j, i),
                                  inputGrid->getValue_double(k+1, j, i));
-                dp_p = computeDf(inputGrid->getPressure(k-1, j, i),
-                                 inputGrid->getPressure(k+1, j, i));
+                dp_p = computeDf(pressure.getPressure(k-1, j, i),
+                                 pressure.getPressure(k+1, j, i));
                 dfdp = df_p/dp_p;
 
                 // deviation of p in y dir
-                dp_y = computeDf(inputGrid->getPressure(k, j - 1, i),
-                                 inputGrid->getPressure(k, j - 1, i));
+                dp_y = computeDf(pressure.getPressure(k, j - 1, i),
+                                 pressure.getPressure(k, j - 1, i));
                 dpdy = dp_y/dy;
 
                 // second deviaion of p in y dir
-                d2p_y = computeD2f(inputGrid->getPressure(k, j - 1, i),
-                                   inputGrid->getPressure(k, j, i),
-                                   inputGrid->getPressure(k, j + 1, i));
+                d2p_y = computeD2f(pressure.getPressure(k, j - 1, i),
+                                   pressure.getPressure(k, j, i),
+                                   pressure.getPressure(k, j + 1, i));
                 d2pdy2 = d2p_y/dy2;
 
                 // second deviation of f in p dir
@@ -1554,19 +1712,19 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
             //j = 0
             df_p = computeDf(inputGrid->getValue_double(k - 1, 0, i),
                              inputGrid->getValue_double(k + 1, 0, i));
-            dp_p = computeDf(inputGrid->getPressure(k - 1, 0, i),
-                             inputGrid->getPressure(k + 1, 0, i));
+            dp_p = computeDf(pressure.getPressure(k - 1, 0, i),
+                             pressure.getPressure(k + 1, 0, i));
             dfdp = df_p/dp_p;
 
             // deviation of p in y dir
-            dp_y = computeDf(inputGrid->getPressure(k, 0, i),
-                             inputGrid->getPressure(k, 1, i)) * 2.0;
+            dp_y = computeDf(pressure.getPressure(k, 0, i),
+                             pressure.getPressure(k, 1, i)) * 2.0;
             dpdy = dp_y/dy;
 
             // second deviaion of p in y dir
-            d2p_y = computeD2f(inputGrid->getPressure(k, 0, i),
-                               inputGrid->getPressure(k, 1, i),
-                               inputGrid->getPressure(k, 2, i));
+            d2p_y = computeD2f(pressure.getPressure(k, 0, i),
+                               pressure.getPressure(k, 1, i),
+                               pressure.getPressure(k, 2, i));
             d2pdy2 = d2p_y/dy2;
 
             // second deviation of f in p dir
@@ -1580,14 +1738,14 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
             {
                 iOpp = ((i + (nLon / 2)) % (nLon - 1));
                 // deviation of p in y dir
-                dp_y = computeDf(inputGrid->getPressure(k, 0, iOpp),
-                                 inputGrid->getPressure(k, 1, i));
+                dp_y = computeDf(pressure.getPressure(k, 0, iOpp),
+                                 pressure.getPressure(k, 1, i));
                 dpdy = dp_y/dy;
 
                 // second deviaion of p in y dir
-                d2p_y = computeD2f(inputGrid->getPressure(k, 0, iOpp),
-                                   inputGrid->getPressure(k, 0, i),
-                                   inputGrid->getPressure(k, 1, i));
+                d2p_y = computeD2f(pressure.getPressure(k, 0, iOpp),
+                                   pressure.getPressure(k, 0, i),
+                                   pressure.getPressure(k, 1, i));
                 d2pdy2 = d2p_y/dy2;
             }
             result = resultGrid->getValue_double(k, 0, i)
@@ -1599,19 +1757,19 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
             //i = nLon - 1
             df_p = computeDf(inputGrid->getValue_double(k-1, nLat - 1, i),
                              inputGrid->getValue_double(k+1, nLat - 1, i));
-            dp_p = computeDf(inputGrid->getPressure(k-1, nLat - 1, i),
-                             inputGrid->getPressure(k+1, nLat - 1, i));
+            dp_p = computeDf(pressure.getPressure(k-1, nLat - 1, i),
+                             pressure.getPressure(k+1, nLat - 1, i));
             dfdp = df_p/dp_p;
 
             // deviation of p in y dir
-            dp_y = computeDf(inputGrid->getPressure(k, nLat - 2, i),
-                             inputGrid->getPressure(k, nLat - 1, i)) * 2.0;
+            dp_y = computeDf(pressure.getPressure(k, nLat - 2, i),
+                             pressure.getPressure(k, nLat - 1, i)) * 2.0;
             dpdy = dp_y/dy;
 
             // second deviaion of p in y dir
-            d2p_y = computeD2f(inputGrid->getPressure(k, nLat - 3, i),
-                               inputGrid->getPressure(k, nLat - 2, i),
-                               inputGrid->getPressure(k, nLat - 1, i));
+            d2p_y = computeD2f(pressure.getPressure(k, nLat - 3, i),
+                               pressure.getPressure(k, nLat - 2, i),
+                               pressure.getPressure(k, nLat - 1, i));
             d2pdy2 = d2p_y/dy2;
 
             // second deviation of f in p dir
@@ -1625,14 +1783,14 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
             {
                 iOpp = ((i + (nLon / 2)) % (nLon - 1));
                 // deviation of p in y dir
-                dp_y = computeDf(inputGrid->getPressure(k, nLat - 2, i),
-                                 inputGrid->getPressure(k, nLat - 1, iOpp));
+                dp_y = computeDf(pressure.getPressure(k, nLat - 2, i),
+                                 pressure.getPressure(k, nLat - 1, iOpp));
                 dpdy = dp_y/dy;
 
                 // second deviaion of p in y dir
-                d2p_y = computeD2f(inputGrid->getPressure(k, nLat - 2, i),
-                                   inputGrid->getPressure(k, nLat - 1, i),
-                                   inputGrid->getPressure(k, nLat - 1, iOpp));
+                d2p_y = computeD2f(pressure.getPressure(k, nLat - 2, i),
+                                   pressure.getPressure(k, nLat - 1, i),
+                                   pressure.getPressure(k, nLat - 1, iOpp));
                 d2pdy2 = d2p_y/dy2;
             }
             result = resultGrid->getValue_double(k, nLat - 1, i)
@@ -1651,19 +1809,19 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
             // deviation of f in p dir
             df_p = computeDf(inputGrid->getValue_double(0, j, i),
                              inputGrid->getValue_double(1, j, i)) * 2;
-            dp_p = computeDf(inputGrid->getPressure(0, j, i),
-                             inputGrid->getPressure(1, j, i)) * 2;
+            dp_p = computeDf(pressure.getPressure(0, j, i),
+                             pressure.getPressure(1, j, i)) * 2;
             dfdp = df_p/dp_p;
 
             // deviation of p in y dir
-            dp_y = computeDf(inputGrid->getPressure(0, j - 1, i),
-                             inputGrid->getPressure(0, j + 1, i));
+            dp_y = computeDf(pressure.getPressure(0, j - 1, i),
+                             pressure.getPressure(0, j + 1, i));
             dpdy = dp_y/dy;
 
             // second deviaion of p in y dir
-            d2p_y = computeD2f(inputGrid->getPressure(0, j - 1, i),
-                               inputGrid->getPressure(0, j, i),
-                               inputGrid->getPressure(0, j + 1, i));
+            d2p_y = computeD2f(pressure.getPressure(0, j - 1, i),
+                               pressure.getPressure(0, j, i),
+                               pressure.getPressure(0, j + 1, i));
             d2pdy2 = d2p_y/dy2;
 
             // second deviation of f in p dir
@@ -1681,19 +1839,19 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
         //j = 0
         df_p = computeDf(inputGrid->getValue_double(0, 0, i),
                          inputGrid->getValue_double(1, 0, i)) * 2.0;
-        dp_p = computeDf(inputGrid->getPressure(0, 0, i),
-                         inputGrid->getPressure(1, 0, i)) * 2.0;
+        dp_p = computeDf(pressure.getPressure(0, 0, i),
+                         pressure.getPressure(1, 0, i)) * 2.0;
         dfdp = df_p/dp_p;
 
         // deviation of p in y dir
-        dp_y = computeDf(inputGrid->getPressure(0, 0, i),
-                         inputGrid->getPressure(0, 1, i)) * 2.0;
+        dp_y = computeDf(pressure.getPressure(0, 0, i),
+                         pressure.getPressure(0, 1, i)) * 2.0;
         dpdy = dp_y/dy;
 
         // second deviaion of p in y dir
-        d2p_y = computeD2f(inputGrid->getPressure(0, 0, i),
-                           inputGrid->getPressure(0, 1, i),
-                           inputGrid->getPressure(0, 2, i));
+        d2p_y = computeD2f(pressure.getPressure(0, 0, i),
+                           pressure.getPressure(0, 1, i),
+                           pressure.getPressure(0, 2, i));
         d2pdy2 = d2p_y/dy2;
 
         // second deviation of f in p dir
@@ -1707,14 +1865,14 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
         {
             iOpp = ((i + (nLon / 2)) % (nLon - 1));
             // deviation of p in y dir
-            dp_y = computeDf(inputGrid->getPressure(0, 0, iOpp),
-                             inputGrid->getPressure(0, 1, i));
+            dp_y = computeDf(pressure.getPressure(0, 0, iOpp),
+                             pressure.getPressure(0, 1, i));
             dpdy = dp_y/dy;
 
             // second deviaion of p in y dir
-            d2p_y = computeD2f(inputGrid->getPressure(0, 0, iOpp),
-                               inputGrid->getPressure(0, 0, i),
-                               inputGrid->getPressure(0, 1, i));
+            d2p_y = computeD2f(pressure.getPressure(0, 0, iOpp),
+                               pressure.getPressure(0, 0, i),
+                               pressure.getPressure(0, 1, i));
             d2pdy2 = d2p_y/dy2;
         }
         result = resultGrid->getValue_double(0, 0, i)
@@ -1726,19 +1884,19 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
         //j = nLat - 1
         df_p = computeDf(inputGrid->getValue_double(0, nLat - 1, i),
                          inputGrid->getValue_double(1, nLat - 1, i)) * 2.0;
-        dp_p = computeDf(inputGrid->getPressure(0, nLat - 1, i),
-                         inputGrid->getPressure(1, nLat - 1, i)) * 2.0;
+        dp_p = computeDf(pressure.getPressure(0, nLat - 1, i),
+                         pressure.getPressure(1, nLat - 1, i)) * 2.0;
         dfdp = df_p/dp_p;
 
         // deviation of p in y dir
-        dp_y = computeDf(inputGrid->getPressure(0, nLat - 2, i),
-                         inputGrid->getPressure(0, nLat - 1, i)) * 2.0;
+        dp_y = computeDf(pressure.getPressure(0, nLat - 2, i),
+                         pressure.getPressure(0, nLat - 1, i)) * 2.0;
         dpdy = dp_y/dy;
 
         // second deviaion of p in y dir
-        d2p_y = computeD2f(inputGrid->getPressure(0, nLat - 3, i),
-                           inputGrid->getPressure(0, nLat - 3, i),
-                           inputGrid->getPressure(0, nLat - 3, i));
+        d2p_y = computeD2f(pressure.getPressure(0, nLat - 3, i),
+                           pressure.getPressure(0, nLat - 3, i),
+                           pressure.getPressure(0, nLat - 3, i));
         d2pdy2 = d2p_y/dy2;
 
         // second deviation of f in p dir
@@ -1752,14 +1910,14 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
         {
             iOpp = ((i + (nLon / 2)) % (nLon - 1));
             // deviation of p in y dir
-            dp_y = computeDf(inputGrid->getPressure(0, nLat - 2, i),
-                             inputGrid->getPressure(0, nLat - 1, iOpp));
+            dp_y = computeDf(pressure.getPressure(0, nLat - 2, i),
+                             pressure.getPressure(0, nLat - 1, iOpp));
             dpdy = dp_y/dy;
 
             // second deviaion of p in y dir
-            d2p_y = computeD2f(inputGrid->getPressure(0, nLat - 2, i),
-                               inputGrid->getPressure(0, nLat - 1, i),
-                               inputGrid->getPressure(0, nLat - 1, iOpp));
+            d2p_y = computeD2f(pressure.getPressure(0, nLat - 2, i),
+                               pressure.getPressure(0, nLat - 1, i),
+                               pressure.getPressure(0, nLat - 1, iOpp));
             d2pdy2 = d2p_y/dy2;
         }
 
@@ -1778,19 +1936,19 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
             // deviation of f in p dir
             df_p = computeDf(inputGrid->getValue_double(nLev - 2, j, i),
                              inputGrid->getValue_double(nLev - 1, j, i)) * 2;
-            dp_p = computeDf(inputGrid->getPressure(nLev - 2, j, i),
-                             inputGrid->getPressure(nLev - 1, j, i)) * 2;
+            dp_p = computeDf(pressure.getPressure(nLev - 2, j, i),
+                             pressure.getPressure(nLev - 1, j, i)) * 2;
             dfdp = df_p/dp_p;
 
             // deviation of p in y dir
-            dp_y = computeDf(inputGrid->getPressure(nLev - 1, j - 1, i),
-                             inputGrid->getPressure(nLev - 1, j + 1, i));
+            dp_y = computeDf(pressure.getPressure(nLev - 1, j - 1, i),
+                             pressure.getPressure(nLev - 1, j + 1, i));
             dpdy = dp_y/dy;
 
             // second deviaion of p in y dir
-            d2p_y = computeD2f(inputGrid->getPressure(nLev - 1, j - 1, i),
-                               inputGrid->getPressure(nLev - 1, j, i),
-                               inputGrid->getPressure(nLev - 1, j + 1, i));
+            d2p_y = computeD2f(pressure.getPressure(nLev - 1, j - 1, i),
+                               pressure.getPressure(nLev - 1, j, i),
+                               pressure.getPressure(nLev - 1, j + 1, i));
             d2pdy2 = d2p_y/dy2;
 
             // second deviation of f in p dir
@@ -1809,19 +1967,19 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
         //j = 0
         df_p = computeDf(inputGrid->getValue_double(nLev - 2, 0, i),
                          inputGrid->getValue_double(nLev - 1, 0, i)) * 2.0;
-        dp_p = computeDf(inputGrid->getPressure(nLev - 2, 0, i),
-                         inputGrid->getPressure(nLev - 1, 0, i)) * 2.0;
+        dp_p = computeDf(pressure.getPressure(nLev - 2, 0, i),
+                         pressure.getPressure(nLev - 1, 0, i)) * 2.0;
         dfdp = df_p/dp_p;
 
         // deviation of p in y dir
-        dp_y = computeDf(inputGrid->getPressure(nLev - 1, 0, i),
-                         inputGrid->getPressure(nLev - 1, 1, i)) * 2.0;
+        dp_y = computeDf(pressure.getPressure(nLev - 1, 0, i),
+                         pressure.getPressure(nLev - 1, 1, i)) * 2.0;
         dpdy = dp_y/dy;
 
         // second deviaion of p in y dir
-        d2p_y = computeD2f(inputGrid->getPressure(nLev - 1, 0, i),
-                           inputGrid->getPressure(nLev - 1, 1, i),
-                           inputGrid->getPressure(nLev - 1, 2, i));
+        d2p_y = computeD2f(pressure.getPressure(nLev - 1, 0, i),
+                           pressure.getPressure(nLev - 1, 1, i),
+                           pressure.getPressure(nLev - 1, 2, i));
         d2pdy2 = d2p_y/dy2;
 
         // second deviation of f in p dir
@@ -1835,14 +1993,14 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
         {
             iOpp = ((i + (nLon / 2)) % (nLon - 1));
             // deviation of p in y dir
-            dp_y = computeDf(inputGrid->getPressure(nLev - 1, 0, iOpp),
-                             inputGrid->getPressure(nLev - 1, 1, i));
+            dp_y = computeDf(pressure.getPressure(nLev - 1, 0, iOpp),
+                             pressure.getPressure(nLev - 1, 1, i));
             dpdy = dp_y/dy;
 
             // second deviaion of p in y dir
-            d2p_y = computeD2f(inputGrid->getPressure(nLev - 1, 0, iOpp),
-                               inputGrid->getPressure(nLev - 1, 0, i),
-                               inputGrid->getPressure(nLev - 1, 1, i));
+            d2p_y = computeD2f(pressure.getPressure(nLev - 1, 0, iOpp),
+                               pressure.getPressure(nLev - 1, 0, i),
+                               pressure.getPressure(nLev - 1, 1, i));
             d2pdy2 = d2p_y/dy2;
         }
         result = resultGrid->getValue_double(nLev - 1, 0, i)
@@ -1854,19 +2012,19 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
         //j = nLat - 1
         df_p = computeDf(inputGrid->getValue_double(nLev - 2, nLat -1, i),
                          inputGrid->getValue_double(nLev - 1, nLat - 1, i)) * 2.0;
-        dp_p = computeDf(inputGrid->getPressure(nLev - 2, nLat - 1, i),
-                         inputGrid->getPressure(nLev - 1, nLat - 1, i)) * 2.0;
+        dp_p = computeDf(pressure.getPressure(nLev - 2, nLat - 1, i),
+                         pressure.getPressure(nLev - 1, nLat - 1, i)) * 2.0;
         dfdp = df_p/dp_p;
 
         // deviation of p in y dir
-        dp_y = computeDf(inputGrid->getPressure(nLev - 1, nLat - 2, i),
-                         inputGrid->getPressure(nLev - 1, nLat - 1, i)) * 2.0;
+        dp_y = computeDf(pressure.getPressure(nLev - 1, nLat - 2, i),
+                         pressure.getPressure(nLev - 1, nLat - 1, i)) * 2.0;
         dpdy = dp_y/dy;
 
         // second deviaion of p in y dir
-        d2p_y = computeD2f(inputGrid->getPressure(nLev - 1, nLat - 3, i),
-                           inputGrid->getPressure(nLev - 1, nLat - 2, i),
-                           inputGrid->getPressure(nLev - 1, nLat - 2, i));
+        d2p_y = computeD2f(pressure.getPressure(nLev - 1, nLat - 3, i),
+                           pressure.getPressure(nLev - 1, nLat - 2, i),
+                           pressure.getPressure(nLev - 1, nLat - 2, i));
         d2pdy2 = d2p_y/dy2;
 
         // second deviation of f in p dir
@@ -1880,14 +2038,14 @@ void MPartialDerivativeFilter::computeHorizontalPressureLevelTransformationForSe
         {
             iOpp = ((i + (nLon / 2)) % (nLon - 1));
             // deviation of p in y dir
-            dp_y = computeDf(inputGrid->getPressure(nLev - 1, nLat - 2, i),
-                             inputGrid->getPressure(nLev - 1, nLat - 1, iOpp));
+            dp_y = computeDf(pressure.getPressure(nLev - 1, nLat - 2, i),
+                             pressure.getPressure(nLev - 1, nLat - 1, iOpp));
             dpdy = dp_y/dy;
 
             // second deviaion of p in y dir
-            d2p_y = computeD2f(inputGrid->getPressure(nLev - 1, nLat - 2, i),
-                               inputGrid->getPressure(nLev - 1, nLat - 1, i),
-                               inputGrid->getPressure(nLev - 1, nLat - 1, iOpp));
+            d2p_y = computeD2f(pressure.getPressure(nLev - 1, nLat - 2, i),
+                               pressure.getPressure(nLev - 1, nLat - 1, i),
+                               pressure.getPressure(nLev - 1, nLat - 1, iOpp));
             d2pdy2 = d2p_y/dy2;
         }
 
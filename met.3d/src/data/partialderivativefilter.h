@@ -39,12 +39,20 @@
 #include "structuredgridensemblefilter.h"
 #include "structuredgrid.h"
 #include "datarequest.h"
+#include "gxfw/nwpactorvariableproperties.h"
 
 namespace Met3D
 {
 
 /**
   @brief MPartialDerivativeFilter implements gradient computation for gridded data.
+
+  The fused mode GRADIENT=DP_D2P computes the first and second vertical
+  derivative in a single pass over each grid column. The returned grid
+  contains the second derivative; the first derivative is stored in the
+  memory manager under the corresponding GRADIENT=DP request and attached to
+  the result as its companion grid (see @ref
+  MStructuredGrid::getCompanionGrid()).
  */
 class MPartialDerivativeFilter
         : public MSingleInputProcessingWeatherPredictionDataSource
@@ -69,6 +77,29 @@ protected:
     MWeatherPredictionDataSource* geoPotSource;
 
 private:
+    /**
+     * @brief addStencilHaloToSubDomain If the request @p rh is restricted to
+     * a sub-domain (key SUBDOMAIN), enlarges the sub-domain by the extent of
+     * the finite difference stencils (two grid points, as second derivatives
+     * are computed from first derivatives), so that central differences are
+     * used up to the boundary of the requested sub-domain.
+     * @param rh request helper of the input request
+     */
+    void addStencilHaloToSubDomain(MDataRequestHelper *rh);
+
+    /**
+     * @brief computeGradient Computes the gradient @p filterType of
+     * @p inputGrid. Called by @ref produceData() with the accessor matching
+     * the vertical grid type of @p inputGrid (see gridpressureaccess.h), so
+     * that the pressure evaluations in the kernels are inlined.
+     */
+    template<typename PressureAccess>
+    void computeGradient(
+            const PressureAccess &pressure, MDataRequest request,
+            MGradientProperties::GradientModeTypes filterType,
+            MStructuredGrid *inputGrid, MStructuredGrid *geoPotGrid,
+            MStructuredGrid *resultGrid);
+
     /**
      * @brief computePartialDerivativeLongitude Computes the horizontal partial
      * derivative in longitudinal direction using central and at boundaries
@@ -113,11 +144,14 @@ private:
      * @brief computePartialDerivativeVertical Computes the vertical partial
      * derivative using central and at boundaries
      * forward or backward finite differences.
+     * @param pressure pressure accessor of the input grid
      * @param inputGrid pointer to the input grid
      * @param resultGrid pointer to the result grid
      */
+    template<typename PressureAccess>
     void computePartialDerivativeVertical(
-            MStructuredGrid *inputGrid, MStructuredGrid *resultGrid);
+            const PressureAccess &pressure, MStructuredGrid *inputGrid,
+            MStructuredGrid *resultGrid);
 
     /**
      * @brief computePartialDerivativeVerticalGeometricHeight Computes the
@@ -135,28 +169,38 @@ private:
      * @brief computePartialDerivativePressureLongitude Computes the horizontal
      * partial derivative of pressure in longitudinal direction using central
      * and at boundaries forward or backward finite differences.
+     * @param pressure pressure accessor of the input grid
      * @param inputGrid pointer to the input grid
      * @param resultGrid pointer to the result grid
      */
+    template<typename PressureAccess>
     void computePartialDerivativePressureLongitude(
-            MStructuredGrid *inputGrid, MStructuredGrid *resultGrid);
+            const PressureAccess &pressure, MStructuredGrid *inputGrid,
+            MStructuredGrid *resultGrid);
 
     /**
      * @brief computePartialDerivativePressureLongitude Computes the horizontal
      * partial derivative of pressure in latitudinal direction using central
      * and at boundaries forward or backward finite differences.
+     * @param pressure pressure accessor of the input grid
      * @param inputGrid pointer to the input grid
      * @param resultGrid pointer to the result grid
      */
+    template<typename PressureAccess>
     void computePartialDerivativePressureLatitude(
-            MStructuredGrid *inputGrid, MStructuredGrid *resultGrid);
+            const PressureAccess &pressure, MStructuredGrid *inputGrid,
+            MStructuredGrid *resultGrid);
 
 
+    template<typename PressureAccess>
     void computePressureCoordinateTransormationLongitude(
-            MStructuredGrid *inputGrid, MStructuredGrid *resultGrid);
+            const PressureAccess &pressure, MStructuredGrid *inputGrid,
+            MStructuredGrid *resultGrid);
 
+    template<typename PressureAccess>
     void computePressureCoordinateTransormationLatitude(
-            MStructuredGrid *inputGrid, MStructuredGrid *resultGrid);
+            const PressureAccess &pressure, MStructuredGrid *inputGrid,
+            MStructuredGrid *resultGrid);
 
     /**
      * @brief periodicBoundaryTreatment test if periodic boundaries are present.
@@ -196,11 +240,31 @@ private:
     /**
      * @brief computeSecondVerticalDerivative Compute the second vertical
      * derivative
+     * @param pressure pressure accessor of the input grid
      * @param inputGrid pointer to the input grid
      * @param resultGrid pointer to the result grid
      */
+    template<typename PressureAccess>
     void computeSecondVerticalDerivative(
-            MStructuredGrid *inputGrid, MStructuredGrid *resultGrid);
+            const PressureAccess &pressure, MStructuredGrid *inputGrid,
+            MStructuredGrid *resultGrid);
+
+
+    /**
+     * @brief computeFirstAndSecondVerticalDerivative Computes the first
+     * vertical derivative and, from it, the second vertical derivative while
+     * traversing each grid column once. Yields the same values as applying
+     * @ref computePartialDerivativeVertical() twice.
+     * @param pressure pressure accessor of the input grid
+     * @param inputGrid pointer to the input grid
+     * @param firstDerivativeGrid pointer to the result grid of d/dp
+     * @param secondDerivativeGrid pointer to the result grid of d2/dp2
+     */
+    template<typename PressureAccess>
+    void computeFirstAndSecondVerticalDerivative(
+            const PressureAccess &pressure, MStructuredGrid *inputGrid,
+            MStructuredGrid *firstDerivativeGrid,
+            MStructuredGrid *secondDerivativeGrid);
 
 
     /**
@@ -221,11 +285,14 @@ private:
      * computes a vertical coordination transformation of horizontal gradient.
      * It transforms the gradient from native vertical coordinate system
      * to pressure coordinate system.
+     * @param pressure pressure accessor of the input grid
      * @param inputGrid pointer to the input grid
      * @param resultGrid pointer to the result grid
      */
+    template<typename PressureAccess>
     void computeHorizontalPressureLevelTransformationForSecondDerivativeLon(
-            MStructuredGrid *inputGrid, MStructuredGrid *resultGrid);
+            const PressureAccess &pressure, MStructuredGrid *inputGrid,
+            MStructuredGrid *resultGrid);
 
 
     /**
@@ -234,11 +301,14 @@ private:
      * computes a vertical coordination transformation of horizontal gradient.
      * It transforms the gradient from native vertical coordinate system
      * to pressure coordinate system.
+     * @param pressure pressure accessor of the input grid
      * @param inputGrid pointer to the input grid
      * @param resultGrid pointer to the result grid
      */
+    template<typename PressureAccess>
     void computeHorizontalPressureLevelTransformationForSecondDerivativeLat(
-            MStructuredGrid *inputGrid, MStructuredGrid *resultGrid);
+            const PressureAccess &pressure, MStructuredGrid *inputGrid,
+            MStructuredGrid *resultGrid);
 
 
     inline double computeDf(const double xm1, const double xp1)
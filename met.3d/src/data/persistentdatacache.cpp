@@ -0,0 +1,346 @@
+/******************************************************************************
+**
+**  This file is part of Met.3D -- a research environment for the
+**  three-dimensional visual exploration of numerical ensemble weather
+**  prediction data.
+**
+**  Copyright 2015-2020 Marc Rautenhaus
+**
+**  Regional Computing Center, Visualization
+**  Universitaet Hamburg, Hamburg, Germany
+**
+**  Met.3D is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Met.3D is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Met.3D.  If not, see <http://www.gnu.org/licenses/>.
+**
+*******************************************************************************/
+#include "persistentdatacache.h"
+
+// standard library imports
+
+// related third party imports
+#include <log4cplus/loggingmacros.h>
+
+// local application imports
+#include "util/mutil.h"
+
+namespace Met3D
+{
+
+// Layout of a cache file: header, numBlocks block descriptors, block data.
+// Blocks start at multiples of BLOCK_ALIGNMENT bytes so that arrays of
+// vectors can be accessed directly in the mapped memory.
+static const char   CACHE_FILE_MAGIC[4] = { 'M', '3', 'D', 'C' };
+static const quint32 CACHE_FILE_VERSION = 1;
+static const qint64 BLOCK_ALIGNMENT = 16;
+
+struct MPersistentCacheFileHeader
+{
+    char    magic[4];
+    quint32 version;
+    quint32 numBlocks;
+    quint32 reserved;
+};
+
+struct MPersistentCacheBlockDescriptor
+{
+    quint64 offset;
+    quint64 size;
+};
+
+
+inline qint64 alignedOffset(qint64 offset)
+{
+    return ((offset + BLOCK_ALIGNMENT - 1) / BLOCK_ALIGNMENT) * BLOCK_ALIGNMENT;
+}
+
+
+/******************************************************************************
+***                     CONSTRUCTOR / DESTRUCTOR                            ***
+*******************************************************************************/
+
+MPersistentDataCache* MPersistentDataCache::instance = nullptr;
+
+
+MPersistentDataCache::MPersistentDataCache()
+    : enabled(false)
+{
+}
+
+
+MPersistentCacheEntry::MPersistentCacheEntry(const QString& filename)
+    : file(filename),
+      mappedData(nullptr)
+{
+}
+
+
+MPersistentCacheEntry::~MPersistentCacheEntry()
+{
+    if (mappedData) file.unmap(mappedData);
+    file.close();
+}
+
+
+/******************************************************************************
+***                            PUBLIC METHODS                               ***
+*******************************************************************************/
+
+MPersistentDataCache* MPersistentDataCache::getInstance()
+{
+    // Called during initialisation; the first call happens before any
+    // worker thread has been started.
+    if (MPersistentDataCache::instance == nullptr)
+    {
+        MPersistentDataCache::instance = new MPersistentDataCache();
+    }
+
+    return MPersistentDataCache::instance;
+}
+
+
+void MPersistentDataCache::setCacheDirectory(const QString& path)
+{
+    QWriteLocker writeLocker(&lock);
+
+    enabled = false;
+    if (path.isEmpty()) return;
+
+    if (!QDir().mkpath(path) || !QFileInfo(path).isWritable())
+    {
+        LOG4CPLUS_WARN(mlog, "Cannot write to persistent cache directory "
+                       << path.toStdString() << "; persistent caching of "
+                          "derived data is disabled.");
+        return;
+    }
+
+    cacheDirectory = QDir(path);
+    enabled = true;
+
+    LOG4CPLUS_INFO(mlog, "Persistent cache directory for derived data: "
+                   << cacheDirectory.absolutePath().toStdString());
+}
+
+
+bool MPersistentDataCache::isEnabled()
+{
+    QReadLocker readLocker(&lock);
+    return enabled;
+}
+
+
+QString MPersistentDataCache::key(const QString& itemType,
+                                  MDataRequest request,
+                                  const QString& dataSignature)
+{
+    if (!isEnabled() || dataSignature.isEmpty()) return QString();
+
+    QCryptographicHash sha1(QCryptographicHash::Sha1);
+    sha1.addData(itemType.toUtf8());
+    sha1.addData("\n", 1);
+    sha1.addData(request.toUtf8());
+    sha1.addData("\n", 1);
+    sha1.addData(dataSignature.toUtf8());
+
+    // The type is used as file name prefix to allow users to clean up the
+    // cache selectively.
+    QString typeName = itemType.section("/", 0, 0);
+    return typeName + "_" + sha1.result().toHex();
+}
+
+
+bool MPersistentDataCache::contains(const QString& key)
+{
+    if (key.isEmpty()) return false;
+    return QFile::exists(cacheFileName(key));
+}
+
+
+bool MPersistentDataCache::store(const QString& key,
+                                 const QVector<MPersistentCacheBlock>& blocks)
+{
+    if (key.isEmpty()) return false;
+
+    const QString filename = cacheFileName(key);
+
+    // Write to a temporary file unique to this thread first; rename it when
+    // complete.
+    const QString tmpFilename = QString("%1.%2.tmp").arg(filename)
+            .arg(quintptr(QThread::currentThreadId()));
+
+    MPersistentCacheFileHeader header;
+    memcpy(header.magic, CACHE_FILE_MAGIC, 4);
+    header.version = CACHE_FILE_VERSION;
+    header.numBlocks = blocks.size();
+    header.reserved = 0;
+
+    QVector<MPersistentCacheBlockDescriptor> descriptors(blocks.size());
+    qint64 offset = sizeof(header)
+            + blocks.size() * sizeof(MPersistentCacheBlockDescriptor);
+    for (int i = 0; i < blocks.size(); i++)
+    {
+        offset = alignedOffset(offset);
+        descriptors[i].offset = offset;
+        descriptors[i].size = blocks[i].size;
+        offset += blocks[i].size;
+    }
+
+    QFile file(tmpFilename);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        LOG4CPLUS_WARN(mlog, "Cannot write persistent cache file "
+                       << tmpFilename.toStdString());
+        return false;
+    }
+
+    bool success = file.write(reinterpret_cast<const char*>(&header),
+                              sizeof(header)) == sizeof(header);
+    const qint64 descriptorSize =
+            blocks.size() * sizeof(MPersistentCacheBlockDescriptor);
+    success = success && file.write(
+                reinterpret_cast<const char*>(descriptors.constData()),
+                descriptorSize) == descriptorSize;
+
+    for (int i = 0; i < blocks.size() && success; i++)
+    {
+        success = file.seek(descriptors[i].offset)
+                && file.write(static_cast<const char*>(blocks[i].data),
+                              blocks[i].size) == blocks[i].size;
+    }
+    file.close();
+
+    // If another thread has stored the same item in the mean time, rename()
+    // fails and the temporary file is removed.
+    if (!success || !QFile::rename(tmpFilename, filename))
+    {
+        QFile::remove(tmpFilename);
+        return QFile::exists(filename);
+    }
+
+    return true;
+}
+
+
+MPersistentCacheEntry* MPersistentDataCache::load(const QString& key)
+{
+    if (key.isEmpty()) return nullptr;
+
+    const QString filename = cacheFileName(key);
+    if (!QFile::exists(filename)) return nullptr;
+
+    MPersistentCacheEntry *entry = new MPersistentCacheEntry(filename);
+    const qint64 fileSize = entry->file.size();
+
+    if (entry->file.open(QIODevice::ReadOnly)
+            && fileSize >= qint64(sizeof(MPersistentCacheFileHeader)))
+    {
+        entry->mappedData = entry->file.map(0, fileSize);
+    }
+
+    bool valid = (entry->mappedData != nullptr);
+    const MPersistentCacheFileHeader *header =
+            reinterpret_cast<const MPersistentCacheFileHeader*>(
+                entry->mappedData);
+
+    valid = valid && memcmp(header->magic, CACHE_FILE_MAGIC, 4) == 0
+            && header->version == CACHE_FILE_VERSION
+            && qint64(sizeof(MPersistentCacheFileHeader)
+                      + header->numBlocks
+                      * sizeof(MPersistentCacheBlockDescriptor)) <= fileSize;
+
+    if (valid)
+    {
+        const MPersistentCacheBlockDescriptor *descriptors =
+                reinterpret_cast<const MPersistentCacheBlockDescriptor*>(
+                    entry->mappedData + sizeof(MPersistentCacheFileHeader));
+
+        for (quint32 i = 0; i < header->numBlocks && valid; i++)
+        {
+            valid = descriptors[i].offset <= quint64(fileSize)
+                    && descriptors[i].size
+                    <= quint64(fileSize) - descriptors[i].offset;
+            entry->blocks.append(MPersistentCacheBlock(
+                                     entry->mappedData + descriptors[i].offset,
+                                     descriptors[i].size));
+        }
+    }
+
+    if (!valid)
+    {
+        LOG4CPLUS_WARN(mlog, "Ignoring invalid persistent cache file "
+                       << filename.toStdString());
+        delete entry;
+        return nullptr;
+    }
+
+    return entry;
+}
+
+
+bool MPersistentDataCache::prepareEntry(
+        const QString& key, const MPersistentCacheEntryValidator& isValid)
+{
+    if (key.isEmpty()) return false;
+
+    QMutexLocker preparedLocker(&preparedEntriesMutex);
+
+    // An entry prepared by a previous task graph that has not been executed
+    // (e.g. cancelled) can be reused.
+    if (preparedEntries.contains(key)) return true;
+
+    if (!QFile::exists(cacheFileName(key))) return false;
+
+    MPersistentCacheEntry *entry = load(key);
+    if (entry == nullptr || !isValid(entry))
+    {
+        delete entry;
+        LOG4CPLUS_WARN(mlog, "Removing invalid persistent cache file "
+                       << cacheFileName(key).toStdString()
+                       << "; the data item will be recomputed.");
+        QFile::remove(cacheFileName(key));
+        return false;
+    }
+
+    preparedEntries.insert(key, entry);
+    return true;
+}
+
+
+MPersistentCacheEntry* MPersistentDataCache::takePreparedEntry(
+        const QString& key)
+{
+    QMutexLocker preparedLocker(&preparedEntriesMutex);
+    return preparedEntries.take(key);
+}
+
+
+void MPersistentDataCache::remove(const QString& key)
+{
+    if (key.isEmpty()) return;
+
+    QMutexLocker preparedLocker(&preparedEntriesMutex);
+    delete preparedEntries.take(key);
+    QFile::remove(cacheFileName(key));
+}
+
+
+/******************************************************************************
+***                           PRIVATE METHODS                               ***
+*******************************************************************************/
+
+QString MPersistentDataCache::cacheFileName(const QString& key)
+{
+    QReadLocker readLocker(&lock);
+    return cacheDirectory.absoluteFilePath(key + ".m3dc");
+}
+
+} // namespace Met3D
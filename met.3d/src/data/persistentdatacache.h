@@ -0,0 +1,201 @@
+/******************************************************************************
+**
+**  This file is part of Met.3D -- a research environment for the
+**  three-dimensional visual exploration of numerical ensemble weather
+**  prediction data.
+**
+**  Copyright 2015-2020 Marc Rautenhaus
+**
+**  Regional Computing Center, Visualization
+**  Universitaet Hamburg, Hamburg, Germany
+**
+**  Met.3D is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Met.3D is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Met.3D.  If not, see <http://www.gnu.org/licenses/>.
+**
+*******************************************************************************/
+#ifndef PERSISTENTDATACACHE_H
+#define PERSISTENTDATACACHE_H
+
+// standard library imports
+#include <functional>
+
+// related third party imports
+#include <QtCore>
+
+// local application imports
+#include "data/datarequest.h"
+
+
+namespace Met3D
+{
+
+/**
+  @brief A contiguous block of memory that is written to or has been read
+  from a persistent cache file.
+ */
+struct MPersistentCacheBlock
+{
+    MPersistentCacheBlock() : data(nullptr), size(0) {}
+    MPersistentCacheBlock(const void *data, qint64 size)
+        : data(data), size(size) {}
+
+    const void *data;
+    qint64 size;
+};
+
+
+/**
+  @brief A cache file that has been memory-mapped by @ref
+  MPersistentDataCache::load(). The blocks stay valid until the entry is
+  deleted.
+ */
+class MPersistentCacheEntry
+{
+public:
+    ~MPersistentCacheEntry();
+
+    int getNumBlocks() const { return blocks.size(); }
+
+    const void* getBlock(int i) const { return blocks[i].data; }
+
+    qint64 getBlockSize(int i) const { return blocks[i].size; }
+
+private:
+    friend class MPersistentDataCache;
+
+    MPersistentCacheEntry(const QString& filename);
+
+    QFile file;
+    uchar *mappedData;
+    QVector<MPersistentCacheBlock> blocks;
+};
+
+
+/**
+  Checks whether a cache entry contains a valid data item of the expected
+  type (e.g. block count and sizes).
+ */
+typedef std::function<bool(const MPersistentCacheEntry*)>
+MPersistentCacheEntryValidator;
+
+
+/**
+  @brief MPersistentDataCache stores derived data items (e.g. tropopause
+  meshes) as binary files in a cache directory, so that they survive the
+  session and can be loaded instead of being recomputed.
+
+  A cache file is identified by a key computed in @ref key() from the type
+  of the data item, its generating request and the "data signature" of the
+  producing pipeline (see @ref MAbstractDataSource::dataSignature()), which
+  contains the data root directories and the latest file modification times
+  of all readers the item depends on. Modified input files hence lead to a
+  cache miss; stale files are not deleted automatically.
+
+  Data items are stored as a list of raw memory blocks (@ref store()). On a
+  cache hit, the file is memory-mapped (@ref load()) and the data item is
+  constructed directly from the mapped blocks. Files are written to a
+  temporary file first and renamed afterwards, so that concurrent readers
+  never see partially written files.
+
+  The cache is disabled until a cache directory has been set with @ref
+  setCacheDirectory() (frontend configuration, "persistentCacheDirectory").
+  All methods are thread-safe.
+ */
+class MPersistentDataCache
+{
+public:
+    /**
+      Returns the (singleton) instance of the persistent cache.
+     */
+    static MPersistentDataCache* getInstance();
+
+    /**
+      Sets the directory in which cache files are stored. An empty @p path
+      disables the cache.
+     */
+    void setCacheDirectory(const QString& path);
+
+    bool isEnabled();
+
+    /**
+      Computes the cache key of the data item of type @p itemType (include a
+      format version, e.g. "MTropopauseTriangleMeshSelection/1") generated
+      by @p request in a pipeline with data signature @p dataSignature.
+      Returns an empty key if the cache is disabled or if @p dataSignature
+      is empty (i.e. the inputs of the item are unknown).
+     */
+    QString key(const QString& itemType, MDataRequest request,
+                const QString& dataSignature);
+
+    /**
+      Returns true if a cache file for @p key exists.
+     */
+    bool contains(const QString& key);
+
+    /**
+      Writes @p blocks to the cache file of @p key. Returns false if the
+      file could not be written.
+     */
+    bool store(const QString& key,
+               const QVector<MPersistentCacheBlock>& blocks);
+
+    /**
+      Memory-maps the cache file of @p key. Returns a null pointer if no
+      valid file exists; the caller needs to delete the returned entry.
+     */
+    MPersistentCacheEntry* load(const QString& key);
+
+    /**
+      Memory-maps the cache file of @p key and checks it with @p isValid.
+      Returns true if the file contains a valid item; the mapped entry is
+      then kept until it is taken with @ref takePreparedEntry(). Invalid
+      files are removed, so that the item is recomputed and stored again.
+
+      Data sources call this method in createTaskGraph() to decide whether
+      the inputs of an item need to be computed; produceData() then takes
+      the entry that has been validated.
+     */
+    bool prepareEntry(const QString& key,
+                      const MPersistentCacheEntryValidator& isValid);
+
+    /**
+      Returns the entry prepared for @p key with @ref prepareEntry(), or a
+      null pointer if none has been prepared. The caller needs to delete
+      the returned entry.
+     */
+    MPersistentCacheEntry* takePreparedEntry(const QString& key);
+
+    /**
+      Removes the cache file of @p key (and a prepared entry of @p key).
+     */
+    void remove(const QString& key);
+
+private:
+    MPersistentDataCache();
+
+    QString cacheFileName(const QString& key);
+
+    static MPersistentDataCache *instance;
+
+    QDir cacheDirectory;
+    bool enabled;
+    QReadWriteLock lock;
+
+    /** Entries validated by @ref prepareEntry(), not yet taken. */
+    QHash<QString, MPersistentCacheEntry*> preparedEntries;
+    QMutex preparedEntriesMutex;
+};
+
+} // namespace Met3D
+
+#endif // PERSISTENTDATACACHE_H
@@ -297,7 +297,8 @@ MStructuredGrid* MProbABLTrajectoriesSource::produceData(
             } // switch (levtype)
 
             result->setToZero();
-            result->enableFlags(); // allocate flags bitfield
+            // Allocate flags bitfield (one flag per member).
+            result->enableFlags(qBound(1, memberTo + 1, 64));
 
             foreach (unsigned int m, trajectorySource->availableEnsembleMembers())
                 result->setAvailableMember(m);
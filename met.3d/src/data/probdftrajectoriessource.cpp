@@ -259,7 +259,8 @@ MStructuredGrid* MProbDFTrajectoriesSource::produceData(
                 result->setLat(i, startGrid->getLats()[i*sy]);
 
             result->setToZero();
-            result->enableFlags(); // allocate flags bitfield
+            // Allocate flags bitfield (one flag per member).
+            result->enableFlags(qBound(1, memberTo + 1, 64));
 
             foreach (unsigned int m, trajectorySource->availableEnsembleMembers())
                 result->setAvailableMember(m);
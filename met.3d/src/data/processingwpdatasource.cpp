@@ -127,6 +127,7 @@ MProcessingWeatherPredictionDataSource::createAndInitializeResultGrid(
         result->levels[i] = templateGrid->levels[i];
 
     result->setAvailableMembers(templateGrid->getAvailableMembers());
+    result->setSubDomainIndexOffset(templateGrid->getSubDomainIndexOffset());
 
     if (templateGrid->leveltype == HYBRID_SIGMA_PRESSURE_3D)
     {
@@ -193,12 +194,48 @@ MProcessingWeatherPredictionDataSource::createAndInitializeResultGrid(
 }
 
 
+MRegularLonLatGrid*
+MProcessingWeatherPredictionDataSource::createHorizontalResultGrid(
+        MStructuredGrid *templateGrid, const QString& variableName)
+{
+    MRegularLonLatGrid *result = new MRegularLonLatGrid(
+                templateGrid->getNumLats(), templateGrid->getNumLons());
+
+    result->setHorizontalGridType(templateGrid->getHorizontalGridType());
+    for (unsigned int i = 0; i < templateGrid->nlons; i++)
+        result->lons[i] = templateGrid->lons[i];
+    for (unsigned int j = 0; j < templateGrid->nlats; j++)
+        result->lats[j] = templateGrid->lats[j];
+
+    result->setAvailableMembers(templateGrid->getAvailableMembers());
+    result->setMetaData(templateGrid->getInitTime(),
+                        templateGrid->getValidTime(),
+                        variableName,
+                        templateGrid->getEnsembleMember());
+    return result;
+}
+
+
+void MProcessingWeatherPredictionDataSource::storeAdditionalResult(
+        MStructuredGrid *grid, MDataRequest request)
+{
+    grid->setGeneratingRequest(request);
+
+    if (!memoryManager->storeData(this, grid)) delete grid;
+
+    // Release the data in any case; even a failed storeData() will reserve
+    // an instance of the data item.
+    memoryManager->releaseData(memoryManager->getData(this, request));
+}
+
+
 /******************************************************************************
 ***                     CONSTRUCTOR / DESTRUCTOR                            ***
 *******************************************************************************/
 
 MSingleInputProcessingWeatherPredictionDataSource::MSingleInputProcessingWeatherPredictionDataSource()
-    : MProcessingWeatherPredictionDataSource()
+    : MProcessingWeatherPredictionDataSource(),
+      inputSource(nullptr)
 {
 }
 
@@ -210,6 +247,7 @@ MSingleInputProcessingWeatherPredictionDataSource::MSingleInputProcessingWeather
 void MSingleInputProcessingWeatherPredictionDataSource::setInputSource(
         MWeatherPredictionDataSource* s)
 {
+    if (inputSource != s) deregisterInputSource(inputSource);
     inputSource = s;
     registerInputSource(inputSource);
     enablePassThrough(s);
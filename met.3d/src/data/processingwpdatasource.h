@@ -64,6 +64,23 @@ protected:
     virtual MStructuredGrid *createAndInitializeResultGrid(
             MStructuredGrid *templateGrid);
 
+    /**
+      Creates a new two-dimensional @ref MRegularLonLatGrid on the horizontal
+      grid of @p templateGrid (which can be three-dimensional). Time and
+      member information are copied from @p templateGrid, the variable name
+      is set to @p variableName.
+     */
+    MRegularLonLatGrid *createHorizontalResultGrid(
+            MStructuredGrid *templateGrid, const QString& variableName);
+
+    /**
+      Places @p grid, a result that has been computed together with the
+      requested one, in the memory manager under @p request, so that a later
+      request for it does not trigger a recomputation. If an identical item
+      is already cached, @p grid is deleted.
+     */
+    void storeAdditionalResult(MStructuredGrid *grid, MDataRequest request);
+
 };
 
 
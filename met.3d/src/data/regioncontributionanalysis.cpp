@@ -155,7 +155,7 @@ MAnalysisResult* MRegionContributionAnalysis::produceData(MDataRequest request)
                                    probGrid->getNumLats(),
                                    probGrid->getNumLons());
     visitationGrid.setToZero();
-    visitationGrid.enableFlags();
+    visitationGrid.enableFlags(qBound(1, result->memberInfo.size(), 64));
 
     // Store the probability region in the visitation grid; used in
     // singleMemberRegionGrowing().
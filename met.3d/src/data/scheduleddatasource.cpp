@@ -166,6 +166,7 @@ void MScheduledDataSource::processRequest(MDataRequest request,
     if (item)
     {
         item->setGeneratingRequest(rh.request());
+        prepareDataItemForStorage(item);
 
         // Store the item in the memory manager. If the item cannot be stored
         // (this happens if another thread has in the mean time stored the same
@@ -84,6 +84,15 @@ protected:
 
     void enablePassThrough(MAbstractDataSource *s) override;
 
+    /**
+      Called by @ref processRequest() for each item returned by @ref
+      produceData(), before the item is stored in the memory manager. Derived
+      classes can override the method to configure how the item is kept in
+      memory. The default implementation does nothing.
+     */
+    virtual void prepareDataItemForStorage(MAbstractDataItem *item)
+    { Q_UNUSED(item); }
+
 private:
     QMutex resultMutex;
 };
@@ -78,6 +78,7 @@ MStructuredGrid *MSmoothFilter::produceData(MDataRequest request)
     QString smoothParameter = rh.value("SMOOTH");
     QStringList parameterList = smoothParameter.split("/");
     rh.removeAll(locallyRequiredKeys());
+    addFilterHaloToSubDomain(&rh, smoothParameter);
     // The first parameter passes the filter type.
     MSmoothProperties::SmoothModeTypes filterType =
             static_cast<MSmoothProperties::SmoothModeTypes>(
@@ -506,7 +507,9 @@ MTask *MSmoothFilter::createTaskGraph(MDataRequest request)
     //(we're requesting the unsmoothed field and pass on the smoothed
     //version).
     MDataRequestHelper rh(request);
+    QString smoothParameter = rh.value("SMOOTH");
     rh.removeAll(locallyRequiredKeys());
+    addFilterHaloToSubDomain(&rh, smoothParameter);
     task->addParent(inputSource->getTaskGraph(rh.request()));
     return task;
 }
@@ -526,6 +529,35 @@ const QStringList MSmoothFilter::locallyRequiredKeys()
 ***                          PRIVATE METHODS                                ***
 *******************************************************************************/
 
+void MSmoothFilter::addFilterHaloToSubDomain(MDataRequestHelper *rh,
+                                             const QString& smoothParameter)
+{
+    if (!rh->contains("SUBDOMAIN")) return;
+
+    MSubDomain subDomain = MSubDomain::fromRequestValue(
+                rh->value("SUBDOMAIN"));
+    if (!subDomain.isValid()) return;
+
+    QStringList parameterList = smoothParameter.split("/");
+    switch (static_cast<MSmoothProperties::SmoothModeTypes>(
+                parameterList[0].toInt()))
+    {
+    case MSmoothProperties::GAUSS_DISTANCE:
+    case MSmoothProperties::BOX_BLUR_DISTANCE_FAST:
+        subDomain.expandByDistance_km(3. * parameterList[1].toDouble());
+        break;
+    case MSmoothProperties::UNIFORM_WEIGHTED_GRIDPOINTS:
+        subDomain.expandByGridPoints(parameterList[2].toUInt());
+        break;
+    default:
+        subDomain.expandByGridPoints(3 * parameterList[2].toUInt());
+        break;
+    }
+
+    rh->insert("SUBDOMAIN", subDomain.toRequestValue());
+}
+
+
 //*************************** GAUSSIAN SMOOTHING *******************************
 
 void MSmoothFilter::computeExponential(
@@ -60,6 +60,18 @@ protected:
 
 private:
 
+    /**
+     * @brief addFilterHaloToSubDomain If the request @p rh is restricted to a
+     * sub-domain (key SUBDOMAIN), enlarges the sub-domain by the extent of
+     * the filter kernel (three standard deviations or the filter radius)
+     * so that the smoothed values inside the requested sub-domain do not
+     * depend on its boundary.
+     * @param rh request helper of the input request
+     * @param smoothParameter value of the SMOOTH key
+     */
+    void addFilterHaloToSubDomain(MDataRequestHelper *rh,
+                                  const QString& smoothParameter);
+
 //*************************** GAUSSIAN SMOOTHING *******************************
 
     //Julian M: ExponentialFilter vertikal anwenden
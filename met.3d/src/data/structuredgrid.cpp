@@ -31,6 +31,9 @@
 #include "structuredgrid.h"
 
 // standard library imports
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <iostream>
 #include <limits>
 
@@ -55,6 +58,217 @@ using namespace netCDF::exceptions;
 namespace Met3D
 {
 
+/******************************************************************************
+***                        MStructuredGridStatistics                        ***
+*******************************************************************************/
+
+MStructuredGridStatistics::MStructuredGridStatistics()
+    : min(numeric_limits<float>::max()),
+      max(numeric_limits<float>::lowest()),
+      mean(M_MISSING_VALUE),
+      numValidValues(0),
+      histogram(NUM_HISTOGRAM_BINS, 0)
+{
+}
+
+
+/******************************************************************************
+***                               MSubDomain                                ***
+*******************************************************************************/
+
+MSubDomain::MSubDomain()
+    : westLon(0.),
+      southLat(0.),
+      eastLon(0.),
+      northLat(0.),
+      bottomPressure_hPa(0.),
+      topPressure_hPa(0.),
+      haloGridPoints(0),
+      valid(false)
+{
+}
+
+
+MSubDomain MSubDomain::fromRequestValue(const QString& value)
+{
+    MSubDomain subDomain;
+
+    QStringList args = value.split("/", QString::SkipEmptyParts);
+    if (args.size() != 4 && args.size() != 5
+            && args.size() != 6 && args.size() != 7)
+    {
+        return subDomain;
+    }
+
+    bool ok = true;
+    double v[6] = { 0., 0., 0., 0., 0., 0. };
+    int numCoordinates = (args.size() >= 6) ? 6 : 4;
+    for (int n = 0; n < numCoordinates && ok; n++)
+    {
+        v[n] = args[n].toDouble(&ok);
+    }
+    if (args.size() == 5 || args.size() == 7)
+    {
+        bool okHalo = true;
+        subDomain.haloGridPoints = args.last().toUInt(&okHalo);
+        ok = ok && okHalo;
+    }
+    if (!ok) return MSubDomain();
+
+    subDomain.westLon = v[0];
+    subDomain.southLat = std::min(v[1], v[3]);
+    subDomain.eastLon = (v[2] < v[0]) ? v[2] + 360. : v[2];
+    subDomain.northLat = std::max(v[1], v[3]);
+    subDomain.bottomPressure_hPa = std::max(v[4], v[5]);
+    subDomain.topPressure_hPa = std::min(v[4], v[5]);
+    subDomain.valid = true;
+    return subDomain;
+}
+
+
+QString MSubDomain::toRequestValue() const
+{
+    if (!valid) return QString();
+
+    return QString("%1/%2/%3/%4/%5/%6/%7").arg(westLon).arg(southLat)
+            .arg(eastLon).arg(northLat).arg(bottomPressure_hPa)
+            .arg(topPressure_hPa).arg(haloGridPoints);
+}
+
+
+void MSubDomain::expandByDistance_km(double distance_km)
+{
+    const double distance_deg =
+            distance_km / MetConstants::EARTH_RADIUS_km * 180. / M_PI;
+
+    southLat = std::max(southLat - distance_deg, -90.);
+    northLat = std::min(northLat + distance_deg, 90.);
+
+    // A distance in longitude increases towards the poles; use the latitude
+    // closest to a pole.
+    double cosLat = cos(std::max(fabs(southLat), fabs(northLat)) / 180. * M_PI);
+    if (cosLat < 0.01)
+    {
+        // Sub-domain covers a pole; all longitudes are required.
+        eastLon = westLon + 360.;
+    }
+    else
+    {
+        westLon -= distance_deg / cosLat;
+        eastLon += distance_deg / cosLat;
+    }
+}
+
+
+/**
+  Restricts the index range [*first, *first + *count) of the monotonic
+  coordinate @p axis to the values within [@p v0, @p v1] plus @p margin grid
+  points on each side. If no axis value lies within the interval, the grid
+  point closest to the interval is used. The range is not changed if the
+  interval does not overlap the axis.
+ */
+static void restrictAxisToInterval(const double *axis, unsigned int n,
+                                   double v0, double v1, unsigned int margin,
+                                   int *first, int *count)
+{
+    *first = 0;
+    *count = n;
+    if (n == 0) return;
+
+    const double vmin = std::min(v0, v1);
+    const double vmax = std::max(v0, v1);
+    if (vmax < std::min(axis[0], axis[n-1])
+            || vmin > std::max(axis[0], axis[n-1]))
+    {
+        return;
+    }
+
+    int i0 = n;
+    int i1 = -1;
+    for (unsigned int i = 0; i < n; i++)
+    {
+        if (axis[i] >= vmin && axis[i] <= vmax)
+        {
+            i0 = std::min(i0, int(i));
+            i1 = std::max(i1, int(i));
+        }
+    }
+
+    if (i1 < 0)
+    {
+        // The interval lies between two neighbouring grid points; use the
+        // grid point closest to it.
+        i0 = 0;
+        for (unsigned int i = 1; i < n; i++)
+        {
+            if (fabs(axis[i] - vmin) < fabs(axis[i0] - vmin)) i0 = i;
+        }
+        i1 = i0;
+    }
+
+    i0 = std::max(i0 - 1 - int(margin), 0);
+    i1 = std::min(i1 + 1 + int(margin), int(n) - 1);
+    *first = i0;
+    *count = i1 - i0 + 1;
+}
+
+
+void MSubDomain::computeIndexRanges(
+        const double *levels, unsigned int nlevs,
+        const double *lats, unsigned int nlats,
+        const double *lons, unsigned int nlons,
+        bool restrictLevels, MIndex3D *first, MIndex3D *count) const
+{
+    *first = MIndex3D(0, 0, 0);
+    *count = MIndex3D(nlevs, nlats, nlons);
+    if (!valid) return;
+
+    if (restrictLevels && hasPressureRange())
+    {
+        restrictAxisToInterval(levels, nlevs, bottomPressure_hPa,
+                               topPressure_hPa, haloGridPoints,
+                               &(first->k), &(count->k));
+    }
+
+    restrictAxisToInterval(lats, nlats, southLat, northLat, haloGridPoints,
+                           &(first->j), &(count->j));
+
+    if (nlons < 2 || eastLon - westLon >= 360.) return;
+
+    // Shift the sub-domain by multiples of 360 degrees to the position at
+    // which it overlaps the longitude axis most.
+    const double lonMin = lons[0];
+    const double lonMax = lons[nlons-1];
+    double bestShift = 0.;
+    double bestOverlap = -numeric_limits<double>::max();
+    for (int n = -2; n <= 2; n++)
+    {
+        double shift = n * 360.;
+        double overlap = std::min(eastLon + shift, lonMax)
+                - std::max(westLon + shift, lonMin);
+        if (overlap > bestOverlap)
+        {
+            bestOverlap = overlap;
+            bestShift = shift;
+        }
+    }
+
+    // A sub-domain that crosses the periodic boundary of a cyclic grid
+    // cannot be represented by a contiguous index range.
+    const double dlon = lons[1] - lons[0];
+    const bool cyclic = (lonMax - lonMin + dlon) >= 360. - M_LONLAT_RESOLUTION;
+    if (cyclic && (westLon + bestShift < lonMin
+                   || eastLon + bestShift > lonMax))
+    {
+        return;
+    }
+
+    restrictAxisToInterval(lons, nlons, westLon + bestShift,
+                           eastLon + bestShift, haloGridPoints,
+                           &(first->i), &(count->i));
+}
+
+
 /******************************************************************************
 ***                             MStructuredGrid                             ***
 *******************************************************************************/
@@ -79,12 +293,21 @@ MStructuredGrid::MStructuredGrid(MVerticalLevelType leveltype,
       data_double(nullptr),
       dataType(dataType),
       flags(nullptr),
+      numFlags(0),
+      flagsWordsPerRow((nlons + 31) / 32),
+      flagsWordsPerPlane(nlevs * nlats * ((nlons + 31) / 32)),
       flagsCanBeEnabled(true),
       contributingMembers(0),
       availableMembers(0),
       horizontalGridType(REGULAR_LONLAT_GRID),
       leveltype(leveltype),
-      minMaxAccel(nullptr)
+      minMaxAccel(nullptr),
+      companionGrid(nullptr),
+      subDomainIndexOffset(0, 0, 0),
+      cachedStoragePrecision(FLOAT32_STORAGE),
+      compactDataPrecision(FLOAT32_STORAGE),
+      compactData(nullptr),
+      statisticsValid(false)
 {
     lonlatID = getID() + "ll";
     flagsID = getID() + "fl";
@@ -115,10 +338,19 @@ MStructuredGrid::~MStructuredGrid()
             delete minMaxAccel;
     }
 
+    if (companionGrid)
+    {
+        if (companionGrid->getMemoryManager())
+            companionGrid->getMemoryManager()->releaseData(companionGrid);
+        else
+            delete companionGrid;
+    }
+
     delete[] levels;
     delete[] lats;
     delete[] lons;
     delete[] data;
+    delete[] compactData;
     deleteDoubleData();
     if (flags != nullptr) delete[] flags;
 }
@@ -137,9 +369,11 @@ unsigned int MStructuredGrid::getMemorySize_kb()
 
     return ( sizeof(MStructuredGrid)
              + (nlevs + nlats + nlons) * sizeof(double)
-             + nvalues * sizeof(float)
+             + ((data != nullptr) ? (nvalues * sizeof(float)) : 0)
+             + ((compactData != nullptr) ? (nvalues * sizeof(quint16)) : 0)
+             + compactLevelOffsets.size() * 2 * sizeof(double)
              + ((data_double != nullptr) ? (nvalues * sizeof(double)) : 0)
-             + ((flags != nullptr) ? nvalues : 0) * sizeof(quint64)
+             + numFlags * flagsWordsPerPlane * sizeof(quint32)
              ) / 1024.;
 }
 
@@ -194,21 +428,94 @@ MVerticalLevelType MStructuredGrid::verticalLevelTypeFromConfigString(
 }
 
 
+MGridStoragePrecision MStructuredGrid::storagePrecisionFromConfigString(
+        const QString &str)
+{
+    if (str == "FLOAT16") return FLOAT16_STORAGE;
+    if (str == "SCALED_INT16") return SCALED_INT16_STORAGE;
+
+    return FLOAT32_STORAGE;
+}
+
+
 float MStructuredGrid::min()
 {
-    float min = numeric_limits<float>::max();
-    for (unsigned int i = 0; i < nvalues; i++)
-        if (data[i] != M_MISSING_VALUE && data[i] < min) min = data[i];
-    return min;
+    return getStatistics().min;
 }
 
 
 float MStructuredGrid::max()
 {
-    float max = numeric_limits<float>::lowest();
-    for (unsigned int i = 0; i < nvalues; i++)
-        if (data[i] != M_MISSING_VALUE && data[i] > max) max = data[i];
-    return max;
+    return getStatistics().max;
+}
+
+
+MStructuredGridStatistics MStructuredGrid::getStatistics()
+{
+    QMutexLocker locker(&statisticsMutex);
+    if (statisticsValid) return statistics;
+
+    // Fused reduction of minimum, maximum, sum and number of the valid
+    // values. Missing values and NaNs are masked by the comparisons, the
+    // loop body is free of branches so that it can be vectorised.
+    float minValue = numeric_limits<float>::max();
+    float maxValue = numeric_limits<float>::lowest();
+    double sum = 0.;
+    unsigned int numValidValues = 0;
+
+#pragma omp parallel for simd reduction(min:minValue) reduction(max:maxValue) \
+    reduction(+:sum, numValidValues)
+    for (unsigned int n = 0; n < nvalues; n++)
+    {
+        const float v = data[n];
+        const bool valid = (v != M_MISSING_VALUE) && (v == v);
+        minValue = (valid && v < minValue) ? v : minValue;
+        maxValue = (valid && v > maxValue) ? v : maxValue;
+        sum += valid ? v : 0.;
+        numValidValues += valid ? 1 : 0;
+    }
+
+    statistics.min = minValue;
+    statistics.max = maxValue;
+    statistics.mean = (numValidValues > 0) ? sum / numValidValues
+                                           : double(M_MISSING_VALUE);
+    statistics.numValidValues = numValidValues;
+
+    // Histogram of the valid values; requires the value range and hence a
+    // second pass. Each thread counts into its own bins.
+    const int numBins = MStructuredGridStatistics::NUM_HISTOGRAM_BINS;
+    statistics.histogram.fill(0, numBins);
+
+    if (numValidValues > 0)
+    {
+        const double binScale = (maxValue > minValue)
+                ? numBins / (double(maxValue) - double(minValue)) : 0.;
+
+#pragma omp parallel
+        {
+            QVector<unsigned int> threadHistogram(numBins, 0);
+
+#pragma omp for
+            for (unsigned int n = 0; n < nvalues; n++)
+            {
+                const float v = data[n];
+                if ((v == M_MISSING_VALUE) || (v != v)) continue;
+                int bin = int((v - minValue) * binScale);
+                threadHistogram[bin < numBins ? bin : numBins - 1]++;
+            }
+
+#pragma omp critical
+            {
+                for (int bin = 0; bin < numBins; bin++)
+                {
+                    statistics.histogram[bin] += threadHistogram[bin];
+                }
+            }
+        }
+    }
+
+    statisticsValid = true;
+    return statistics;
 }
 
 
@@ -219,6 +526,8 @@ void MStructuredGrid::maskRectangularRegion(unsigned int i0,
                                             unsigned int nj,
                                             unsigned int nk)
 {
+    invalidateStatistics();
+
     // Account for grids potentially being cyclic in longitude.
     i0 = i0 % nlons;
     unsigned int i1 = (i0 + ni) % nlons;
@@ -310,12 +619,14 @@ void MStructuredGrid::maskRectangularRegion(unsigned int i0,
 void MStructuredGrid::setToZero()
 {
     for (unsigned int i = 0; i < nvalues; i++) data[i] = 0.;
+    invalidateStatistics();
 }
 
 
 void MStructuredGrid::setToValue(float val)
 {
     for (unsigned int i = 0; i < nvalues; i++) data[i] = val;
+    invalidateStatistics();
 }
 
 
@@ -369,6 +680,130 @@ float MStructuredGrid::interpolateValue(QVector3D vec3_lonLatP)
 }
 
 
+void MStructuredGrid::interpolateValues(
+        const float *lon, const float *lat, const float *p_hPa,
+        float *values, unsigned int n)
+{
+    // Corner column values and horizontal interpolation weights of each
+    // position. Positions outside of the grid keep missing corner values
+    // and zero weights, which the horizontal interpolation below maps to
+    // M_MISSING_VALUE.
+    vector<float> scalar_i0j0(n, M_MISSING_VALUE);
+    vector<float> scalar_i1j0(n, M_MISSING_VALUE);
+    vector<float> scalar_i0j1(n, M_MISSING_VALUE);
+    vector<float> scalar_i1j1(n, M_MISSING_VALUE);
+    vector<float> mixI(n, 0.);
+    vector<float> mixJ(n, 0.);
+
+    // Bin the positions by grid cell (index of the north-west column) and
+    // sort them by pressure within each cell.
+    struct CellPosition
+    {
+        unsigned int cell;
+        float p_hPa;
+        unsigned int m;
+        bool operator<(const CellPosition &other) const
+        {
+            return (cell < other.cell)
+                    || ((cell == other.cell) && (p_hPa < other.p_hPa));
+        }
+    };
+
+    vector<CellPosition> cellPositions;
+    cellPositions.reserve(n);
+    vector<int> columnI1(n), columnJ1(n);
+
+    for (unsigned int m = 0; m < n; m++)
+    {
+        if (std::isnan(lon[m]) || std::isnan(lat[m])) continue;
+
+        int i, j, i1, j1;
+        float mixIm, mixJm;
+        findEnclosingHorizontalIndices(lon[m], lat[m], &i, &j, &i1, &j1,
+                                       &mixIm, &mixJm);
+
+        if ((i < 0) || (j < 0) || (i1 >= int(nlons)) || (j1 >= int(nlats)))
+            continue;
+
+        mixI[m] = MFRACT(mixIm);
+        mixJ[m] = MFRACT(mixJm);
+        columnI1[m] = i1;
+        columnJ1[m] = j1;
+
+        // NaN pressures are sorted to the end of the cell to keep a strict
+        // weak ordering.
+        CellPosition cp;
+        cp.cell = INDEX2yx(j, i, nlons);
+        cp.p_hPa = std::isnan(p_hPa[m]) ? numeric_limits<float>::infinity()
+                                        : p_hPa[m];
+        cp.m = m;
+        cellPositions.push_back(cp);
+    }
+
+    std::sort(cellPositions.begin(), cellPositions.end());
+
+    // Interpolate the four corner columns of each position to its pressure.
+    // The sorted positions are processed in blocks; within a block, the
+    // level bracket of the previous position is the hint for the next.
+    const int blockSize = 1024;
+    const int numPositions = int(cellPositions.size());
+    const int numBlocks = (numPositions + blockSize - 1) / blockSize;
+
+#pragma omp parallel for schedule(dynamic)
+    for (int block = 0; block < numBlocks; block++)
+    {
+        int klower_i0j0 = -1;
+        int klower_i1j0 = -1;
+        int klower_i0j1 = -1;
+        int klower_i1j1 = -1;
+
+        const int first = block * blockSize;
+        const int last = std::min(first + blockSize, numPositions);
+        for (int s = first; s < last; s++)
+        {
+            const unsigned int m = cellPositions[s].m;
+            const unsigned int j = cellPositions[s].cell / nlons;
+            const unsigned int i = cellPositions[s].cell % nlons;
+            const unsigned int j1 = columnJ1[m];
+            const unsigned int i1 = columnI1[m];
+
+            scalar_i0j0[m] = interpolateGridColumnToPressureWithHint(
+                        j , i , p_hPa[m], &klower_i0j0);
+            scalar_i1j0[m] = interpolateGridColumnToPressureWithHint(
+                        j , i1, p_hPa[m], &klower_i1j0);
+            scalar_i0j1[m] = interpolateGridColumnToPressureWithHint(
+                        j1, i , p_hPa[m], &klower_i0j1);
+            scalar_i1j1[m] = interpolateGridColumnToPressureWithHint(
+                        j1, i1, p_hPa[m], &klower_i1j1);
+        }
+    }
+
+    // Interpolate horizontally (same arithmetic as interpolateValue()).
+#pragma omp simd
+    for (unsigned int m = 0; m < n; m++)
+    {
+        float scalar_i0 = MMIX(scalar_i0j0[m], scalar_i0j1[m], mixJ[m]);
+        float scalar_i1 = MMIX(scalar_i1j0[m], scalar_i1j1[m], mixJ[m]);
+        values[m] = MMIX(scalar_i0, scalar_i1, mixI[m]);
+    }
+}
+
+
+void MStructuredGrid::interpolateValues(
+        const QVector3D *vec3_lonLatP, float *values, unsigned int n)
+{
+    vector<float> lon(n), lat(n), p_hPa(n);
+    for (unsigned int m = 0; m < n; m++)
+    {
+        lon[m] = vec3_lonLatP[m].x();
+        lat[m] = vec3_lonLatP[m].y();
+        p_hPa[m] = vec3_lonLatP[m].z();
+    }
+
+    interpolateValues(lon.data(), lat.data(), p_hPa.data(), values, n);
+}
+
+
 float MStructuredGrid::interpolateValueOnLevel(
         float lon, float lat, unsigned int k)
 {
@@ -800,18 +1235,16 @@ void MStructuredGrid::enableFlags(unsigned char numBits)
                 "Flags cannot be enabled after getMemorySize_kb() has been called.",
                 __FILE__, __LINE__);
 
-    // This can be changed later to a variable size field, e.g. with
-    // std::bitset (http://www.cplusplus.com/reference/bitset/bitset/) or
-    // 128bit etc. datatypews from boost::multiprecision
-    // (http://www.boost.org/doc/libs/1_55_0/libs/multiprecision/doc/html/boost_multiprecision/intro.html),
-    // or with boost::dynamic_bitset (http://www.boost.org/doc/libs/1_36_0/libs/dynamic_bitset/dynamic_bitset.html).
-    if (numBits != 64) throw MValueError(
-                "MStructuredGrid currently only supports 64bit flags.",
+    // Per-point flags are returned as quint64 by getFlags(), hence the
+    // upper limit of 64 bit-planes.
+    if (numBits < 1 || numBits > 64) throw MValueError(
+                "MStructuredGrid supports between 1 and 64 flags.",
                 __FILE__, __LINE__);
 
     if (flags == nullptr)
     {
-        flags = new quint64[nvalues];
+        numFlags = numBits;
+        flags = new quint32[numFlags * flagsWordsPerPlane];
         clearAllFlags();
     }
 }
@@ -819,14 +1252,50 @@ void MStructuredGrid::enableFlags(unsigned char numBits)
 
 unsigned char MStructuredGrid::flagsEnabled()
 {
-    return ((flags == nullptr) ? 0 : 64);
+    return numFlags;
+}
+
+
+unsigned char MStructuredGrid::numFlagsForMembers(
+        const QSet<unsigned int>& members)
+{
+    unsigned int maxMember = 0;
+    foreach (unsigned int m, members) maxMember = max(maxMember, m);
+    return min(maxMember + 1, 64u);
 }
 
 
 void MStructuredGrid::clearAllFlags()
 {
     if (flags == nullptr) return;
-    for (unsigned int n = 0; n < nvalues; n++) flags[n] = 0;
+    memset(flags, 0, numFlags * flagsWordsPerPlane * sizeof(quint32));
+}
+
+
+void MStructuredGrid::intersectFlags(MStructuredGrid *gridA,
+                                     MStructuredGrid *gridB)
+{
+    if (flags == nullptr) return;
+
+    if (gridA->nvalues != nvalues || gridB->nvalues != nvalues
+            || gridA->nlons != nlons || gridB->nlons != nlons)
+    {
+        throw MValueError("flags can only be intersected between grids of "
+                          "the same size", __FILE__, __LINE__);
+    }
+
+    const unsigned char numCommonFlags =
+            min(numFlags, min(gridA->numFlags, gridB->numFlags));
+    const unsigned int numCommonWords = numCommonFlags * flagsWordsPerPlane;
+
+#pragma omp parallel for
+    for (int w = 0; w < int(numCommonWords); w++)
+    {
+        flags[w] = gridA->flags[w] & gridB->flags[w];
+    }
+
+    memset(flags + numCommonWords, 0,
+           (numFlags - numCommonFlags) * flagsWordsPerPlane * sizeof(quint32));
 }
 
 
@@ -838,14 +1307,44 @@ GL::MTexture *MStructuredGrid::getFlagsTexture(QGLWidget *currentGLContext)
     GL::MTexture *t = static_cast<GL::MTexture*>(glRM->getGPUItem(flagsID));
     if (t) return t;
 
-    // No texture with this item's data exists. Create a new one.
-    t = new GL::MTexture(flagsID, GL_TEXTURE_3D, GL_RG32UI,
-                         nlons, nlats, nlevs);
+    if (flags == nullptr) return nullptr;
+
+    // No texture with this item's data exists. Create a new one. The flag
+    // bit-planes are tiled along the first and stacked along the third
+    // texture dimension so that the texture does not exceed the maximum
+    // 3D texture size.
+    glRM->makeCurrent();
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &maxTextureSize);
+
+    unsigned int tilesX, tilesZ;
+    if (!flagsTextureTiling(maxTextureSize, nlevs, &tilesX, &tilesZ))
+    {
+        LOG4CPLUS_ERROR(mlog, "cannot create flags texture: "
+                        << int(numFlags) << " flag planes of "
+                        << flagsWordsPerRow << "x" << nlats << "x" << nlevs
+                        << " words exceed the maximum 3D texture size of "
+                        << maxTextureSize << ".");
+        if (currentGLContext) currentGLContext->makeCurrent();
+        return nullptr;
+    }
+
+    t = new GL::MTexture(flagsID, GL_TEXTURE_3D, GL_R32UI,
+                         flagsWordsPerRow * tilesX, nlats, nlevs * tilesZ);
 
     if ( glRM->tryStoreGPUItem(t) )
     {
         // The new texture was successfully stored in the GPU memory manger.
-        // We can now upload the data.
+        // We can now upload the data. With a single tile per row the
+        // planes are uploaded as they are stored.
+        QVector<quint32> tiledFlags;
+        const quint32 *textureData = flags;
+        if (tilesX > 1)
+        {
+            tiledFlags = tiledFlagPlanes(tilesX, tilesZ);
+            textureData = tiledFlags.constData();
+        }
+
         glRM->makeCurrent();
 
         t->bindToLastTextureUnit();
@@ -857,18 +1356,18 @@ GL::MTexture *MStructuredGrid::getFlagsTexture(QGLWidget *currentGLContext)
         glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 
-        glTexImage3D(GL_TEXTURE_3D, 0, GL_RG32UI,
-                     nlons, nlats, nlevs,
-                     0, GL_RG_INTEGER,  GL_UNSIGNED_INT, flags);
+        glTexImage3D(GL_TEXTURE_3D, 0, GL_R32UI,
+                     flagsWordsPerRow * tilesX, nlats, nlevs * tilesZ,
+                     0, GL_RED_INTEGER,  GL_UNSIGNED_INT, textureData);
         CHECK_GL_ERROR;
-
-        if (currentGLContext) currentGLContext->makeCurrent();
     }
     else
     {
         delete t;
     }
 
+    if (currentGLContext) currentGLContext->makeCurrent();
+
     return static_cast<GL::MTexture*>(glRM->getGPUItem(flagsID));
 }
 
@@ -879,6 +1378,51 @@ void MStructuredGrid::releaseFlagsTexture()
 }
 
 
+bool MStructuredGrid::flagsTextureTiling(
+        GLint maxTextureSize, unsigned int planeHeight,
+        unsigned int *tilesX, unsigned int *tilesY) const
+{
+    if (maxTextureSize <= 0 || numFlags == 0) return false;
+
+    // Use as many tiles per row as fit into the texture width, then stack
+    // the required number of tile rows.
+    *tilesX = min(static_cast<unsigned int>(numFlags),
+                  static_cast<unsigned int>(maxTextureSize) / flagsWordsPerRow);
+    if (*tilesX == 0) return false;
+
+    *tilesY = (numFlags + *tilesX - 1) / *tilesX;
+    return quint64(*tilesY) * planeHeight <= quint64(maxTextureSize);
+}
+
+
+QVector<quint32> MStructuredGrid::tiledFlagPlanes(unsigned int tilesX,
+                                                  unsigned int tilesY) const
+{
+    const unsigned int rowsPerPlane = flagsWordsPerPlane / flagsWordsPerRow;
+    const unsigned int wordsPerTextureRow = flagsWordsPerRow * tilesX;
+
+    QVector<quint32> tiled(wordsPerTextureRow * rowsPerPlane * tilesY, 0);
+
+#pragma omp parallel for
+    for (int f = 0; f < int(numFlags); f++)
+    {
+        const quint32 *plane = flags + f * flagsWordsPerPlane;
+        quint32 *tile = tiled.data()
+                + (f / tilesX) * rowsPerPlane * wordsPerTextureRow
+                + (f % tilesX) * flagsWordsPerRow;
+
+        for (unsigned int row = 0; row < rowsPerPlane; row++)
+        {
+            memcpy(tile + row * wordsPerTextureRow,
+                   plane + row * flagsWordsPerRow,
+                   flagsWordsPerRow * sizeof(quint32));
+        }
+    }
+
+    return tiled;
+}
+
+
 unsigned int MStructuredGrid::getNumContributingMembers() const
 {
     unsigned int n = 0;
@@ -1197,6 +1741,175 @@ void MStructuredGrid::deleteDoubleData()
 }
 
 
+/******************************************************************************
+***                          PROTECTED METHODS                              ***
+*******************************************************************************/
+
+// Reserved 16 bit codes of the compact storage modes. The half precision
+// missing value code is a NaN pattern that floatToHalf() never produces.
+static const quint16 HALF_MISSING_VALUE = 0x7dff;
+static const quint16 SCALED_INT16_MISSING_VALUE = 0xffff;
+static const quint16 SCALED_INT16_NAN = 0xfffe;
+static const quint16 SCALED_INT16_MAX_CODE = 0xfffd;
+
+void MStructuredGrid::compactForCache()
+{
+    if (cachedStoragePrecision == FLOAT32_STORAGE || dataType == DOUBLE
+            || data == nullptr)
+    {
+        return;
+    }
+
+    if (cachedStoragePrecision == FLOAT16_STORAGE)
+    {
+        // Values outside of the half precision range (e.g. pressure in Pa)
+        // would become infinite; keep such grids in full precision.
+        MStructuredGridStatistics s = getStatistics();
+        if (s.numValidValues > 0 && (s.min < -65504.f || s.max > 65504.f))
+        {
+            return;
+        }
+
+        compactData = new quint16[nvalues];
+#pragma omp parallel for
+        for (unsigned int n = 0; n < nvalues; n++)
+        {
+            compactData[n] = (data[n] == M_MISSING_VALUE)
+                    ? HALF_MISSING_VALUE : floatToHalf(data[n]);
+        }
+    }
+    else
+    {
+        // Offset and scale per level, from the range of the valid values.
+        QVector<double> offsets(nlevs, 0.);
+        QVector<double> scales(nlevs, 0.);
+        double *levelOffsets = offsets.data();
+        double *levelScales = scales.data();
+        bool representable = true;
+
+#pragma omp parallel for reduction(&&:representable)
+        for (unsigned int k = 0; k < nlevs; k++)
+        {
+            const float *level = &data[k * nlatsnlons];
+            float minValue = numeric_limits<float>::max();
+            float maxValue = numeric_limits<float>::lowest();
+            for (unsigned int n = 0; n < nlatsnlons; n++)
+            {
+                const float v = level[n];
+                if (v == M_MISSING_VALUE || v != v) continue;
+                minValue = std::min(minValue, v);
+                maxValue = std::max(maxValue, v);
+            }
+
+            if (minValue <= maxValue)
+            {
+                levelOffsets[k] = minValue;
+                levelScales[k] = (double(maxValue) - double(minValue))
+                        / SCALED_INT16_MAX_CODE;
+                representable = representable
+                        && std::isfinite(levelOffsets[k])
+                        && std::isfinite(levelScales[k]);
+            }
+        }
+
+        if (!representable) return;
+
+        compactData = new quint16[nvalues];
+#pragma omp parallel for
+        for (unsigned int k = 0; k < nlevs; k++)
+        {
+            const float *level = &data[k * nlatsnlons];
+            quint16 *compactLevel = &compactData[k * nlatsnlons];
+            const double offset = levelOffsets[k];
+            const double invScale =
+                    (levelScales[k] > 0.) ? 1. / levelScales[k] : 0.;
+            for (unsigned int n = 0; n < nlatsnlons; n++)
+            {
+                const float v = level[n];
+                if (v == M_MISSING_VALUE)
+                {
+                    compactLevel[n] = SCALED_INT16_MISSING_VALUE;
+                }
+                else if (v != v)
+                {
+                    compactLevel[n] = SCALED_INT16_NAN;
+                }
+                else
+                {
+                    compactLevel[n] = quint16(std::min(
+                            (v - offset) * invScale + 0.5,
+                            double(SCALED_INT16_MAX_CODE)));
+                }
+            }
+        }
+
+        compactLevelOffsets = offsets;
+        compactLevelScales = scales;
+    }
+
+    compactDataPrecision = cachedStoragePrecision;
+    delete[] data;
+    data = nullptr;
+
+    // The statistics are recomputed from the unpacked values on access
+    // after restoreFromCache().
+    invalidateStatistics();
+}
+
+
+void MStructuredGrid::restoreFromCache()
+{
+    if (compactData == nullptr) return;
+
+    data = new float[nvalues];
+
+#pragma omp parallel for
+    for (unsigned int k = 0; k < nlevs; k++)
+    {
+        float *level = &data[k * nlatsnlons];
+        const quint16 *compactLevel = &compactData[k * nlatsnlons];
+
+        if (compactDataPrecision == FLOAT16_STORAGE)
+        {
+            for (unsigned int n = 0; n < nlatsnlons; n++)
+            {
+                level[n] = (compactLevel[n] == HALF_MISSING_VALUE)
+                        ? M_MISSING_VALUE : halfToFloat(compactLevel[n]);
+            }
+        }
+        else
+        {
+            const double offset = compactLevelOffsets.at(k);
+            const double scale = compactLevelScales.at(k);
+            for (unsigned int n = 0; n < nlatsnlons; n++)
+            {
+                const quint16 c = compactLevel[n];
+                if (c == SCALED_INT16_MISSING_VALUE)
+                {
+                    level[n] = M_MISSING_VALUE;
+                }
+                else if (c == SCALED_INT16_NAN)
+                {
+                    level[n] = numeric_limits<float>::quiet_NaN();
+                }
+                else
+                {
+                    level[n] = float(offset + c * scale);
+                }
+            }
+        }
+    }
+
+    delete[] compactData;
+    compactData = nullptr;
+    compactLevelOffsets = QVector<double>();
+    compactLevelScales = QVector<double>();
+
+    // Unpacked values differ from the ones the statistics were computed of.
+    invalidateStatistics();
+}
+
+
 /******************************************************************************
 *******************************************************************************/
 /******************************************************************************
@@ -1592,14 +2305,43 @@ GL::MTexture *MRegularLonLatGrid::getFlagsTexture(QGLWidget *currentGLContext)
     GL::MTexture *t = static_cast<GL::MTexture*>(glRM->getGPUItem(flagsID));
     if (t) return t;
 
-    // No texture with this item's data exists. Create a new one.
-    t = new GL::MTexture(flagsID, GL_TEXTURE_2D, GL_RG32UI,
-                        nlons, nlats);
+    if (flags == nullptr) return nullptr;
+
+    // No texture with this item's data exists. Create a new one. The flag
+    // bit-planes are tiled along the first and stacked along the second
+    // texture dimension so that the texture does not exceed the maximum
+    // texture size.
+    glRM->makeCurrent();
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+
+    unsigned int tilesX, tilesY;
+    if (!flagsTextureTiling(maxTextureSize, nlats, &tilesX, &tilesY))
+    {
+        LOG4CPLUS_ERROR(mlog, "cannot create flags texture: "
+                        << int(numFlags) << " flag planes of "
+                        << flagsWordsPerRow << "x" << nlats
+                        << " words exceed the maximum texture size of "
+                        << maxTextureSize << ".");
+        if (currentGLContext) currentGLContext->makeCurrent();
+        return nullptr;
+    }
+
+    t = new GL::MTexture(flagsID, GL_TEXTURE_2D, GL_R32UI,
+                         flagsWordsPerRow * tilesX, nlats * tilesY);
 
     if ( glRM->tryStoreGPUItem(t) )
     {
         // The new texture was successfully stored in the GPU memory manger.
         // We can now upload the data.
+        QVector<quint32> tiledFlags;
+        const quint32 *textureData = flags;
+        if (tilesX > 1)
+        {
+            tiledFlags = tiledFlagPlanes(tilesX, tilesY);
+            textureData = tiledFlags.constData();
+        }
+
         glRM->makeCurrent();
 
         t->bindToLastTextureUnit();
@@ -1610,18 +2352,18 @@ GL::MTexture *MRegularLonLatGrid::getFlagsTexture(QGLWidget *currentGLContext)
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 
-        glTexImage3D(GL_TEXTURE_2D, 0, GL_RG32UI,
-                     nlons, nlats, nlevs,
-                     0, GL_RG_INTEGER,  GL_UNSIGNED_INT, flags);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI,
+                     flagsWordsPerRow * tilesX, nlats * tilesY,
+                     0, GL_RED_INTEGER,  GL_UNSIGNED_INT, textureData);
         CHECK_GL_ERROR;
-
-        if (currentGLContext) currentGLContext->makeCurrent();
     }
     else
     {
         delete t;
     }
 
+    if (currentGLContext) currentGLContext->makeCurrent();
+
     return static_cast<GL::MTexture*>(glRM->getGPUItem(flagsID));
 }
 
@@ -1646,6 +2388,7 @@ MLonLatHybridSigmaPressureGrid::MLonLatHybridSigmaPressureGrid(
       aki_hPa(nullptr),
       bki(nullptr),
       surfacePressure(nullptr),
+      pressureField(nullptr),
       cachedTopDataVolumePressure_hPa(M_MISSING_VALUE),
       cachedBottomDataVolumePressure_hPa(M_MISSING_VALUE)
 {
@@ -1686,6 +2429,7 @@ void MLonLatHybridSigmaPressureGrid::exchangeSurfacePressureGrid(
 {
     if (newSfcPressureGrid != nullptr)
     {
+        QMutexLocker pressureFieldLocker(&pressureFieldMutex);
         removeSurfacePressureField();
         surfacePressure = newSfcPressureGrid;
     }
@@ -1940,29 +2684,67 @@ void MLonLatHybridSigmaPressureGrid::findEnclosingModelLevels(
 float MLonLatHybridSigmaPressureGrid::interpolateGridColumnToPressure(
         unsigned int j, unsigned int i, float p_hPa)
 {
-    float psfc_hPa = surfacePressure->getValue(j, i) / 100.;
+    int klower = -1;
+    return interpolateGridColumnToPressureWithHint(j, i, p_hPa, &klower);
+}
 
-    // Initial position of klower and kupper.
-    int klower = 0;
-    int kupper = nlevs - 1;
 
-    // Perform the binary search.
-    while ((kupper-klower) > 1)
+float MLonLatHybridSigmaPressureGrid::interpolateGridColumnToPressureWithHint(
+        unsigned int j, unsigned int i, float p_hPa, int *klowerHint)
+{
+    float psfc_hPa = surfacePressure->getValue(j, i) / 100.;
+
+    // If the pressure field has been computed, read the column pressures
+    // from memory (same values as computed below).
+    const MMemoryManagedArray<float> *field = pressureField;
+    const float *pColumn_hPa = field ? &field->data[INDEX2yx(j, i, nlons)]
+                                     : nullptr;
+
+    // The binary search below yields the levels klower, kupper = klower+1
+    // with p(klower) <= p_hPa < p(kupper); the first (second) condition is
+    // dropped for the top (bottom) bracket. Since pressure increases with
+    // k, this bracket is unique -- if the hinted bracket fulfils the
+    // conditions, it is the result of the search.
+    int klower = *klowerHint;
+    int kupper = klower + 1;
+    const int kbottom = int(nlevs) - 1;
+
+    if ((klower < 0) || (kupper > kbottom)
+            || ((klower > 0) && !(p_hPa >= (pColumn_hPa
+                    ? pColumn_hPa[klower * nlatsnlons]
+                    : float(ak_hPa[klower] + bk[klower] * psfc_hPa))))
+            || ((kupper < kbottom) && (p_hPa >= (pColumn_hPa
+                    ? pColumn_hPa[kupper * nlatsnlons]
+                    : float(ak_hPa[kupper] + bk[kupper] * psfc_hPa)))))
     {
-        // Element midway between klower and kupper.
-        int kmid = (kupper+klower) / 2;
-        // Compute pressure at kmid.
-        float pressureAt_kmid_hPa = ak_hPa[kmid] + bk[kmid] * psfc_hPa;
+        // Initial position of klower and kupper.
+        klower = 0;
+        kupper = kbottom;
 
-        // Cut interval in half.
-        if (p_hPa >= pressureAt_kmid_hPa)
-            klower = kmid;
-        else
-            kupper = kmid;
+        // Perform the binary search.
+        while ((kupper-klower) > 1)
+        {
+            // Element midway between klower and kupper.
+            int kmid = (kupper+klower) / 2;
+            // Compute pressure at kmid.
+            float pressureAt_kmid_hPa = pColumn_hPa
+                    ? pColumn_hPa[kmid * nlatsnlons]
+                    : float(ak_hPa[kmid] + bk[kmid] * psfc_hPa);
+
+            // Cut interval in half.
+            if (p_hPa >= pressureAt_kmid_hPa)
+                klower = kmid;
+            else
+                kupper = kmid;
+        }
     }
 
-    float plower_hPa = ak_hPa[klower] + bk[klower] * psfc_hPa;
-    float pupper_hPa = ak_hPa[kupper] + bk[kupper] * psfc_hPa;
+    *klowerHint = klower;
+
+    float plower_hPa = pColumn_hPa ? pColumn_hPa[klower * nlatsnlons]
+                                   : ak_hPa[klower] + bk[klower] * psfc_hPa;
+    float pupper_hPa = pColumn_hPa ? pColumn_hPa[kupper * nlatsnlons]
+                                   : ak_hPa[kupper] + bk[kupper] * psfc_hPa;
     float ln_plower  = log(plower_hPa);
     float ln_pupper  = log(pupper_hPa);
     float ln_p       = log(p_hPa);
@@ -2007,6 +2789,10 @@ int MLonLatHybridSigmaPressureGrid::findLevel(
 {
     float psfc_hPa = surfacePressure->getValue(j, i) / 100.;
 
+    const MMemoryManagedArray<float> *field = pressureField;
+    const float *pColumn_hPa = field ? &field->data[INDEX2yx(j, i, nlons)]
+                                     : nullptr;
+
     // Binary search to find model levels k, k1 that enclose pressure level p.
     int k = 0;
     int k1 = nlevs - 1;
@@ -2016,7 +2802,9 @@ int MLonLatHybridSigmaPressureGrid::findLevel(
         // Element midway between k and k1.
         int kmid = (k1 + k) / 2;
         // Compute pressure at kmid.
-        float pressureAt_kmid_hPa = ak_hPa[kmid] + bk[kmid] * psfc_hPa;
+        float pressureAt_kmid_hPa = pColumn_hPa
+                ? pColumn_hPa[kmid * nlatsnlons]
+                : float(ak_hPa[kmid] + bk[kmid] * psfc_hPa);
 
         // Cut interval in half.
         if (p_hPa >= pressureAt_kmid_hPa) k = kmid; else k1 = kmid;
@@ -2029,12 +2817,81 @@ int MLonLatHybridSigmaPressureGrid::findLevel(
 float MLonLatHybridSigmaPressureGrid::getPressure(
          unsigned int k, unsigned int j, unsigned int i) const
 {
+    const MMemoryManagedArray<float> *field = pressureField;
+    if (field)
+    {
+        return field->data[INDEX3zyx_2(k, j, i, nlatsnlons, nlons)];
+    }
+
     float psfc_hPa = surfacePressure->getValue(j, i) / 100.;
     float p_hPa = ak_hPa[k] + bk[k] * psfc_hPa;
     return p_hPa;
 }
 
 
+const float* MLonLatHybridSigmaPressureGrid::getPressureField_hPa()
+{
+    if (pressureField) return pressureField.load()->data;
+
+    QMutexLocker pressureFieldLocker(&pressureFieldMutex);
+    // Another thread may have computed the field in the mean time.
+    if (pressureField) return pressureField.load()->data;
+
+    MAbstractMemoryManager *psfcMemoryManager =
+            surfacePressure->getMemoryManager();
+    MDataRequest request = getPressureFieldRequest();
+
+    // containsData() places a reference on the field if it has already been
+    // computed for another grid with the same surface pressure field.
+    if (psfcMemoryManager
+            && psfcMemoryManager->containsData(surfacePressure, request))
+    {
+        pressureField = static_cast<MMemoryManagedArray<float>*>(
+                    psfcMemoryManager->getData(surfacePressure, request));
+        return pressureField.load()->data;
+    }
+
+    MMemoryManagedArray<float> *field =
+            new MMemoryManagedArray<float>(nvalues);
+    field->setGeneratingRequest(request);
+
+    const float *psfc_Pa = surfacePressure->getData();
+#pragma omp parallel for
+    for (int k = 0; k < int(nlevs); k++)
+    {
+        for (unsigned int n = 0; n < nlatsnlons; n++)
+        {
+            // Same arithmetic as in the "computing" branch of getPressure().
+            float psfc_hPa = psfc_Pa[n] / 100.;
+            field->data[k * nlatsnlons + n] = ak_hPa[k] + bk[k] * psfc_hPa;
+        }
+    }
+
+    if (psfcMemoryManager)
+    {
+        try
+        {
+            // storeData() places a reference on the field; it is released in
+            // releasePressureField(). If another thread has stored the same
+            // field in the mean time, our copy is deleted.
+            if ( !psfcMemoryManager->storeData(surfacePressure, field) )
+            {
+                delete field;
+            }
+            field = static_cast<MMemoryManagedArray<float>*>(
+                        psfcMemoryManager->getData(surfacePressure, request));
+        }
+        catch (MMemoryError)
+        {
+            // Memory limit exceeded: keep the field private to this grid.
+        }
+    }
+
+    pressureField = field;
+    return field->data;
+}
+
+
 float MLonLatHybridSigmaPressureGrid::getSurfacePressure(
         unsigned int j, unsigned int i) const
 {
@@ -2045,6 +2902,8 @@ float MLonLatHybridSigmaPressureGrid::getSurfacePressure(
 void MLonLatHybridSigmaPressureGrid::setSurfacePressure(
         unsigned int j, unsigned int i, float v)
 {
+    // A previously computed pressure field is out of date.
+    releasePressureField();
     surfacePressure->setValue(j, i, v);
 }
 
@@ -2221,6 +3080,10 @@ QString MLonLatHybridSigmaPressureGrid::getPressureTexCoordID()
 
 void MLonLatHybridSigmaPressureGrid::removeSurfacePressureField()
 {
+    // The pressure field is derived from (and owned by) the surface pressure
+    // field.
+    releasePressureField();
+
     if (surfacePressure)
     {
         // Release surface pressure field if it has been registered to a memory
@@ -2239,6 +3102,38 @@ void MLonLatHybridSigmaPressureGrid::removeSurfacePressureField()
 }
 
 
+void MLonLatHybridSigmaPressureGrid::releasePressureField()
+{
+    MMemoryManagedArray<float> *field = pressureField.exchange(nullptr);
+    if (field == nullptr) return;
+
+    if (field->getMemoryManager())
+    {
+        field->getMemoryManager()->releaseData(field);
+    }
+    else
+    {
+        delete field;
+    }
+}
+
+
+MDataRequest MLonLatHybridSigmaPressureGrid::getPressureFieldRequest()
+{
+    // Grids with different hybrid coefficients may share the surface
+    // pressure field; include a hash of the coefficients in the key.
+    QByteArray akBytes(reinterpret_cast<const char*>(ak_hPa),
+                       nlevs * sizeof(double));
+    QByteArray bkBytes(reinterpret_cast<const char*>(bk),
+                       nlevs * sizeof(double));
+
+    MDataRequestHelper rh(surfacePressure->getGeneratingRequest());
+    rh.insert("AUXDATA", QString("HYBRIDPRESSURE_%1_%2_%3").arg(nlevs)
+              .arg(qHash(akBytes)).arg(qHash(bkBytes)));
+    return rh.request();
+}
+
+
 /******************************************************************************
 *******************************************************************************/
 /******************************************************************************
@@ -2286,29 +3181,53 @@ void MLonLatAuxiliaryPressureGrid::exchangeAuxiliaryPressureGrid(
 float MLonLatAuxiliaryPressureGrid::interpolateGridColumnToPressure(
         unsigned int j, unsigned int i, float p_hPa)
 {
-    // Initial position of klower and kupper.
-    int klower = 0;
-    int kupper = nlevs - 1;
+    int klower = -1;
+    return interpolateGridColumnToPressureWithHint(j, i, p_hPa, &klower);
+}
 
-    // Perform the binary search.
-    while ((kupper - klower) > 1)
+
+float MLonLatAuxiliaryPressureGrid::interpolateGridColumnToPressureWithHint(
+        unsigned int j, unsigned int i, float p_hPa, int *klowerHint)
+{
+    // Reuse the hinted bracket if it is the bracket the binary search would
+    // find (cf. MLonLatHybridSigmaPressureGrid).
+    int klower = *klowerHint;
+    int kupper = klower + 1;
+    const int kbottom = int(nlevs) - 1;
+
+    if ((klower < 0) || (kupper > kbottom)
+            || ((klower > 0)
+                && !(p_hPa >= auxPressureField_hPa->getValue(klower, j, i)))
+            || ((kupper < kbottom)
+                && (p_hPa >= auxPressureField_hPa->getValue(kupper, j, i))))
     {
-        // Element midway between klower and kupper.
-        int kmid = (kupper + klower) / 2;
-        // Compute pressure at kmid.
-        float pressureAt_kmid_hPa = auxPressureField_hPa->getValue(kmid, j, i);
+        // Initial position of klower and kupper.
+        klower = 0;
+        kupper = kbottom;
 
-        // Cut interval in half.
-        if (p_hPa >= pressureAt_kmid_hPa)
-        {
-            klower = kmid;
-        }
-        else
+        // Perform the binary search.
+        while ((kupper - klower) > 1)
         {
-            kupper = kmid;
+            // Element midway between klower and kupper.
+            int kmid = (kupper + klower) / 2;
+            // Compute pressure at kmid.
+            float pressureAt_kmid_hPa =
+                    auxPressureField_hPa->getValue(kmid, j, i);
+
+            // Cut interval in half.
+            if (p_hPa >= pressureAt_kmid_hPa)
+            {
+                klower = kmid;
+            }
+            else
+            {
+                kupper = kmid;
+            }
         }
     }
 
+    *klowerHint = klower;
+
     float plower_hPa = auxPressureField_hPa->getValue(klower, j, i);
     float pupper_hPa = auxPressureField_hPa->getValue(kupper, j, i);
 
@@ -32,6 +32,7 @@
 #define STRUCTUREDGRID_H
 
 // standard library imports
+#include <atomic>
 
 // related third party imports
 #include "GL/glew.h"
@@ -82,6 +83,17 @@ enum MDataType {
     DOUBLE = 1
 };
 
+/**
+  Precision in which the data field of an @ref MStructuredGrid is stored while
+  the grid is cached (i.e. released) in a memory manager, see @ref
+  MStructuredGrid::setCachedStoragePrecision().
+ */
+enum MGridStoragePrecision {
+    FLOAT32_STORAGE      = 0, // full precision, no compaction
+    FLOAT16_STORAGE      = 1, // IEEE 754 half precision
+    SCALED_INT16_STORAGE = 2  // 16 bit integers with per-level scale/offset
+};
+
 
 /******************************************************************************
 ***                              MACROS                                     ***
@@ -124,6 +136,96 @@ struct MIndex3D
 typedef QList<MIndex3D> MIndexedGridRegion;
 
 
+/**
+  Geographical region (and, optionally, pressure range) a data request is
+  restricted to. Passed through a pipeline in the optional request key
+  SUBDOMAIN with the value "westLon/southLat/eastLon/northLat" or
+  "westLon/southLat/eastLon/northLat/bottomPressure_hPa/topPressure_hPa",
+  optionally followed by "/haloGridPoints". Data readers only read the grid
+  points covering the sub-domain (see @ref computeIndexRanges()); filters
+  that require neighbouring grid points enlarge the sub-domain of their
+  input request by the required halo.
+ */
+struct MSubDomain
+{
+    MSubDomain();
+
+    /**
+      Parses a SUBDOMAIN request value. Returns an invalid sub-domain if
+      @p value is empty or cannot be parsed.
+     */
+    static MSubDomain fromRequestValue(const QString& value);
+
+    /** Encodes the sub-domain as SUBDOMAIN request value. */
+    QString toRequestValue() const;
+
+    bool isValid() const { return valid; }
+
+    bool hasPressureRange() const
+    { return (bottomPressure_hPa > 0.) && (topPressure_hPa > 0.); }
+
+    /**
+      Enlarges the horizontal extent of the sub-domain by (at least) @p
+      distance_km in all directions.
+     */
+    void expandByDistance_km(double distance_km);
+
+    /**
+      Enlarges the sub-domain by @p numGridPoints grid points in all
+      directions (the grid spacing is only known to the reader).
+     */
+    void expandByGridPoints(unsigned int numGridPoints)
+    { haloGridPoints += numGridPoints; }
+
+    /**
+      Computes the index ranges [first, first + count) of the vertical (k),
+      latitude (j) and longitude (i) axes of a grid that cover the
+      sub-domain, enlarged by one grid point on each side (so that values at
+      the boundary of the sub-domain can be interpolated) and by @ref
+      haloGridPoints. The vertical axis is only restricted if @p
+      restrictLevels is true (i.e. for pressure levels) and a pressure range
+      is set. Axes that do not overlap the sub-domain are not restricted, the
+      same holds for the longitude axis of a cyclic grid if the sub-domain
+      crosses the grid's periodic boundary. An invalid sub-domain covers the
+      entire grid.
+     */
+    void computeIndexRanges(const double *levels, unsigned int nlevs,
+                            const double *lats, unsigned int nlats,
+                            const double *lons, unsigned int nlons,
+                            bool restrictLevels,
+                            MIndex3D *first, MIndex3D *count) const;
+
+    double westLon, southLat, eastLon, northLat;
+    double bottomPressure_hPa, topPressure_hPa;
+    unsigned int haloGridPoints;
+    bool valid;
+};
+
+
+/**
+  Statistics of the valid (i.e. not missing and not NaN) values of the data
+  field of an @ref MStructuredGrid, see @ref
+  MStructuredGrid::getStatistics().
+ */
+struct MStructuredGridStatistics
+{
+    MStructuredGridStatistics();
+
+    /** Number of bins of @ref histogram. */
+    static const int NUM_HISTOGRAM_BINS = 64;
+
+    float min;
+    float max;
+    double mean;
+    unsigned int numValidValues;
+    /**
+      Number of valid values in each of @ref NUM_HISTOGRAM_BINS bins of equal
+      width between @ref min and @ref max (the last bin includes @ref max).
+     */
+    QVector<unsigned int> histogram;
+};
+
+
 /**
 
  */
@@ -181,17 +283,63 @@ public:
     static MVerticalLevelType verticalLevelTypeFromConfigString(const QString& str);
 
     /**
-      Minimum value of @ref data. This method requires O(nlevs * nlats * nlons)
-      time.
+      Convert a storage precision string as used in the pipeline configuration
+      ("FLOAT32", "FLOAT16", "SCALED_INT16") to an @ref MGridStoragePrecision.
+      Unknown strings return @ref FLOAT32_STORAGE.
+     */
+    static MGridStoragePrecision storagePrecisionFromConfigString(
+            const QString& str);
+
+    /**
+      Sets the precision in which @ref data is stored while this grid is
+      released in a memory manager. With @ref FLOAT16_STORAGE or @ref
+      SCALED_INT16_STORAGE, the data field is packed to 16 bit per value when
+      the last reference to the grid is released and unpacked when the grid
+      is requested again (see @ref compactForCache()). Both modes are lossy:
+      after unpacking, values are accurate to 11 significant bits or to
+      1/65533 of the value range of their level, respectively. The default is
+      @ref FLOAT32_STORAGE.
+     */
+    void setCachedStoragePrecision(MGridStoragePrecision precision)
+    { cachedStoragePrecision = precision; }
+
+    MGridStoragePrecision getCachedStoragePrecision() const
+    { return cachedStoragePrecision; }
+
+    /**
+      Minimum value of @ref data. The value is taken from @ref
+      getStatistics(), i.e. only the first call requires O(nlevs * nlats *
+      nlons) time.
      */
     float min();
 
     /**
-      Maximum value of @ref data. This method requires O(nlevs * nlats * nlons)
-      time.
+      Maximum value of @ref data. The value is taken from @ref
+      getStatistics(), i.e. only the first call requires O(nlevs * nlats *
+      nlons) time.
      */
     float max();
 
+    /**
+      Returns minimum, maximum, mean, number and histogram of the valid
+      values of @ref data. The statistics are computed in a parallel
+      reduction on the first call and are cached.
+
+      All setters of this class, as well as packing and unpacking the grid
+      in the memory manager cache, invalidate the cached statistics. Code
+      that writes to @ref data directly (friend classes, e.g. the derived
+      variable processors) needs to call @ref invalidateStatistics().
+     */
+    MStructuredGridStatistics getStatistics();
+
+    /**
+      Marks the cached statistics as outdated. A relaxed store suffices
+      (@ref getStatistics() reads the flag under @ref statisticsMutex) and
+      keeps the per-value setters as cheap as a plain store.
+     */
+    void invalidateStatistics()
+    { statisticsValid.store(false, std::memory_order_relaxed); }
+
     /**
       Mask a rectangular region so that all grid point data values outside of
       (i0,j0,k0)-->(i0+ni,j0+nj,k0+nk) are set to MISSING_VALUE.
@@ -230,12 +378,19 @@ public:
 
     inline void setValue(
             unsigned int k, unsigned int j, unsigned int i, float v)
-    { data[INDEX3zyx_2(k, j, i, nlatsnlons, nlons)] = v; }
+    {
+        data[INDEX3zyx_2(k, j, i, nlatsnlons, nlons)] = v;
+        invalidateStatistics();
+    }
 
-    inline void setValue(unsigned int n, float v) { data[n] = v; }
+    inline void setValue(unsigned int n, float v)
+    { data[n] = v; invalidateStatistics(); }
 
     inline void setValue(MIndex3D idx, float v)
-    { data[INDEX3zyx_2(idx.k, idx.j, idx.i, nlatsnlons, nlons)] = v; }
+    {
+        data[INDEX3zyx_2(idx.k, idx.j, idx.i, nlatsnlons, nlons)] = v;
+        invalidateStatistics();
+    }
 
     inline void setValue_double(
             unsigned int k, unsigned int j, unsigned int i, double v)
@@ -248,12 +403,19 @@ public:
 
     inline void addValue(
             unsigned int k, unsigned int j, unsigned int i, float v)
-    { data[INDEX3zyx_2(k, j, i, nlatsnlons, nlons)] += v; }
+    {
+        data[INDEX3zyx_2(k, j, i, nlatsnlons, nlons)] += v;
+        invalidateStatistics();
+    }
 
-    inline void addValue(unsigned int n, float v) { data[n] += v; }
+    inline void addValue(unsigned int n, float v)
+    { data[n] += v; invalidateStatistics(); }
 
     inline void addValue(MIndex3D idx, float v)
-    { data[INDEX3zyx_2(idx.k, idx.j, idx.i, nlatsnlons, nlons)] += v; }
+    {
+        data[INDEX3zyx_2(idx.k, idx.j, idx.i, nlatsnlons, nlons)] += v;
+        invalidateStatistics();
+    }
 
     inline void setLon(unsigned int i, double v) { lons[i] = v; }
     inline void setLat(unsigned int j, double v) { lats[j] = v; }
@@ -335,6 +497,28 @@ public:
 
     float interpolateValue(QVector3D vec3_lonLatP);
 
+    /**
+      Samples the data grid at the @p n positions (@p lon[m], @p lat[m],
+      @p p_hPa[m]) and writes the results to @p values. Each value is
+      identical to the result of @ref interpolateValue() at the same
+      position; use this method if many positions need to be sampled.
+
+      The positions are binned by the grid cell that contains them and are
+      sorted by pressure within each cell. The vertical level bracket found
+      in a grid column is passed on as a hint to the next position sampled
+      in that column (@ref interpolateGridColumnToPressureWithHint()), so
+      that the level search is skipped for most positions. The horizontal
+      interpolation is carried out in a separate, vectorisable pass.
+     */
+    void interpolateValues(const float *lon, const float *lat,
+                           const float *p_hPa, float *values, unsigned int n);
+
+    /**
+      Same as above for positions given as (lon, lat, p_hPa) vectors.
+     */
+    void interpolateValues(const QVector3D *vec3_lonLatP, float *values,
+                           unsigned int n);
+
     /**
       Implement this method in derived classes that know about their vertical
       coordinate. It is used by @ref interpolateValue(). If the derived class
@@ -344,6 +528,24 @@ public:
             unsigned int j, unsigned int i, float p_hPa)
     { Q_UNUSED(j); Q_UNUSED(i); Q_UNUSED(p_hPa); return M_MISSING_VALUE; }
 
+    /**
+      Same as @ref interpolateGridColumnToPressure(), used by @ref
+      interpolateValues(). @p klowerHint is the level index k of the bracket
+      [k, k+1] found in a previous call for this column (or -1). If @p p_hPa
+      is located in this bracket, the level search can be skipped. On
+      return, @p klowerHint contains the bracket of @p p_hPa.
+
+      The default implementation ignores the hint. Override this method in
+      derived classes whose level search is expensive; the result must not
+      depend on the hint.
+     */
+    virtual float interpolateGridColumnToPressureWithHint(
+            unsigned int j, unsigned int i, float p_hPa, int *klowerHint)
+    {
+        Q_UNUSED(klowerHint);
+        return interpolateGridColumnToPressure(j, i, p_hPa);
+    }
+
     /**
       Computes the pressure on grid level @p k at position (@p lon, @p lat).
 
@@ -494,9 +696,15 @@ public:
     */
 
     /**
-     Enable flags for this grid. If enabled, each grid point stores an
-     additional bitfield of width @p numBits that can be used for arbitrary
-     flags.
+     Enable flags for this grid. If enabled, each grid point stores @p
+     numBits additional bits that can be used for arbitrary flags (e.g. one
+     bit per ensemble member, see @ref numFlagsForMembers()).
+
+     The flags are stored as bit-planes, one plane per flag, in which the
+     flags of 32 consecutive grid points along a longitude row are packed
+     into one 32 bit word. Memory use hence scales with the number of flags
+     actually enabled, and operations on whole planes (@ref
+     clearAllFlags(), @ref intersectFlags()) process 32 grid points at once.
 
      @note Call this function DIRECTLY AFTER THE OBJECT CONSTRUCTION, before
      any other method is called. In particular, if flags are enabled after the
@@ -504,85 +712,115 @@ public:
      corrupted. The method throws an exception if called after @ref
      getMemorySize_kb().
 
-     @note Currently only 64bit-Flags are supported.
+     @note At most 64 flags are supported. Flag indices passed to the
+     set/clear/get methods that are not smaller than @p numBits (e.g. member
+     numbers >= 64) are ignored; @ref getFlag() returns false for them.
      */
     void enableFlags(unsigned char numBits=64);
 
     /** Returns the number of enabled flags (0 if no flags are enabled). */
     unsigned char flagsEnabled();
 
+    /**
+     Returns the number of flags required to store one flag per member of
+     @p members, with the member numbers used as flag indices. The result
+     is limited to 64; flags of members >= 64 are ignored.
+     */
+    static unsigned char numFlagsForMembers(const QSet<unsigned int>& members);
+
     /** Set flag @p f of grid value @p n.*/
-    inline void setFlag(unsigned int n, unsigned char f)
-    { flags[n] |= (Q_UINT64_C(1) << f); }
+    inline void setFlag(unsigned int n, unsigned int f)
+    {
+        if (f < numFlags)
+            flagWord(n / nlons, n % nlons, f) |= flagBitMask(n % nlons);
+    }
 
     inline void setFlag(
-            unsigned int k, unsigned int j, unsigned int i, unsigned char f)
-    { flags[INDEX3zyx_2(k, j, i, nlatsnlons, nlons)] |= (Q_UINT64_C(1) << f); }
+            unsigned int k, unsigned int j, unsigned int i, unsigned int f)
+    { if (f < numFlags) flagWord(k * nlats + j, i, f) |= flagBitMask(i); }
 
-    inline void setFlag(MIndex3D idx, unsigned char f)
-    { flags[INDEX3zyx_2(idx.k, idx.j, idx.i, nlatsnlons, nlons)] |=
-                (Q_UINT64_C(1) << f); }
+    inline void setFlag(MIndex3D idx, unsigned int f)
+    { setFlag(idx.k, idx.j, idx.i, f); }
 
     /** Set all flags of grid value @p n.*/
     inline void setFlags(unsigned int n, quint64 fl)
-    { flags[n] = fl; }
+    { setFlagsOfPoint(n / nlons, n % nlons, fl); }
 
     inline void setFlags(
             unsigned int k, unsigned int j, unsigned int i,quint64 fl)
-    { flags[INDEX3zyx_2(k, j, i, nlatsnlons, nlons)] = fl; }
+    { setFlagsOfPoint(k * nlats + j, i, fl); }
 
     inline void setFlags(MIndex3D idx, quint64 fl)
-    { flags[INDEX3zyx_2(idx.k, idx.j, idx.i, nlatsnlons, nlons)] = fl; }
+    { setFlagsOfPoint(idx.k * nlats + idx.j, idx.i, fl); }
 
     /** Clear flag @p f of grid value @p n.*/
-    inline void clearFlag(unsigned int n, unsigned char f)
-    { flags[n] &= ~(Q_UINT64_C(1) << f); }
+    inline void clearFlag(unsigned int n, unsigned int f)
+    {
+        if (f < numFlags)
+            flagWord(n / nlons, n % nlons, f) &= ~flagBitMask(n % nlons);
+    }
 
     inline void clearFlag(
-            unsigned int k, unsigned int j, unsigned int i, unsigned char f)
-    { flags[INDEX3zyx_2(k, j, i, nlatsnlons, nlons)] &= ~(Q_UINT64_C(1) << f); }
+            unsigned int k, unsigned int j, unsigned int i, unsigned int f)
+    { if (f < numFlags) flagWord(k * nlats + j, i, f) &= ~flagBitMask(i); }
 
-    inline void clearFlag(MIndex3D idx, unsigned char f)
-    { flags[INDEX3zyx_2(idx.k, idx.j, idx.i, nlatsnlons, nlons)] &=
-                ~(Q_UINT64_C(1) << f); }
+    inline void clearFlag(MIndex3D idx, unsigned int f)
+    { clearFlag(idx.k, idx.j, idx.i, f); }
 
     /** Clear all flags of grid value @p n.*/
     inline void clearFlags(unsigned int n)
-    { flags[n] = 0; }
+    { setFlagsOfPoint(n / nlons, n % nlons, 0); }
 
     inline void clearFlags(
             unsigned int k, unsigned int j, unsigned int i)
-    { flags[INDEX3zyx_2(k, j, i, nlatsnlons, nlons)] = 0; }
+    { setFlagsOfPoint(k * nlats + j, i, 0); }
 
     inline void clearFlags(MIndex3D idx)
-    { flags[INDEX3zyx_2(idx.k, idx.j, idx.i, nlatsnlons, nlons)] = 0; }
+    { setFlagsOfPoint(idx.k * nlats + idx.j, idx.i, 0); }
 
     void clearAllFlags();
 
+    /**
+     Sets the flags of this grid to the bitwise AND of the flags of @p gridA
+     and @p gridB, one 32 bit word (32 grid points) at a time. All three
+     grids need to be of the same size; flags not enabled in either input
+     grid are cleared.
+     */
+    void intersectFlags(MStructuredGrid *gridA, MStructuredGrid *gridB);
+
     /** Get flag @p f of grid value @p n.*/
-    inline bool getFlag(unsigned int n, unsigned char f)
-    { return (flags[n] & (Q_UINT64_C(1) << f)) > 0; }
+    inline bool getFlag(unsigned int n, unsigned int f)
+    { return f < numFlags && (flagWord(n / nlons, n % nlons, f)
+                              & flagBitMask(n % nlons)) > 0; }
 
     inline bool getFlag(
-            unsigned int k, unsigned int j, unsigned int i, unsigned char f)
-    { return (flags[INDEX3zyx_2(k, j, i, nlatsnlons, nlons)]
-                & (Q_UINT64_C(1) << f)) > 0; }
+            unsigned int k, unsigned int j, unsigned int i, unsigned int f)
+    { return f < numFlags
+                && (flagWord(k * nlats + j, i, f) & flagBitMask(i)) > 0; }
 
-    inline bool getFlag(MIndex3D idx, unsigned char f)
-    { return (flags[INDEX3zyx_2(idx.k, idx.j, idx.i, nlatsnlons, nlons)]
-                & (Q_UINT64_C(1) << f)) > 0; }
+    inline bool getFlag(MIndex3D idx, unsigned int f)
+    { return getFlag(idx.k, idx.j, idx.i, f); }
 
-    inline quint64 getFlags(unsigned int n) { return flags[n]; }
+    inline quint64 getFlags(unsigned int n)
+    { return getFlagsOfPoint(n / nlons, n % nlons); }
 
     inline quint64 getFlags(unsigned int k, unsigned int j, unsigned int i)
-    { return flags[INDEX3zyx_2(k, j, i, nlatsnlons, nlons)]; }
+    { return getFlagsOfPoint(k * nlats + j, i); }
 
     inline quint64 getFlags(MIndex3D idx)
-    { return flags[INDEX3zyx_2(idx.k, idx.j, idx.i, nlatsnlons, nlons)]; }
+    { return getFlagsOfPoint(idx.k * nlats + idx.j, idx.i); }
 
     /**
-      Returns the handle to a texture containing the flag data (3D int
-      texture). Needs to be released with @ref releaseFlagsTexture().
+      Returns the handle to a texture containing the flag data, or a
+      nullptr if no flags are enabled or the planes do not fit into a
+      texture. The bit-planes (see @ref enableFlags()) are uploaded as a 3D
+      GL_R32UI texture of tilesX x tilesZ plane tiles of size
+      (W = (nlons+31)/32, nlats, nlevs): bit i % 32 of texel
+      ((f % tilesX) * W + i / 32, j, (f / tilesX) * nlevs + k) is flag f of
+      grid point (k, j, i). tilesX is chosen as large as
+      GL_MAX_3D_TEXTURE_SIZE permits (see @ref flagsTextureTiling()), so
+      shaders obtain it as the texture width divided by W. Needs to be
+      released with @ref releaseFlagsTexture().
      */
     virtual GL::MTexture* getFlagsTexture(QGLWidget *currentGLContext = nullptr);
 
@@ -656,6 +894,28 @@ public:
 
     void deleteDoubleData();
 
+    /**
+      Attaches the memory managed grid @p grid that has been computed in the
+      same pass as this grid (e.g. the first derivative that is produced
+      together with the second derivative by @ref MPartialDerivativeFilter).
+      The caller hands one reference on @p grid over to this grid; it is
+      released when this grid is deleted, hence the companion grid is
+      available as long as this grid is in memory.
+     */
+    void setCompanionGrid(MStructuredGrid *grid) { companionGrid = grid; }
+
+    MStructuredGrid* getCompanionGrid() { return companionGrid; }
+
+    /**
+      Index of the first grid point of this grid in the full grid of the
+      data source if the grid has been restricted to a sub-domain (see @ref
+      MSubDomain), (0, 0, 0) otherwise.
+     */
+    void setSubDomainIndexOffset(MIndex3D offset)
+    { subDomainIndexOffset = offset; }
+
+    MIndex3D getSubDomainIndexOffset() const { return subDomainIndexOffset; }
+
 protected:
     friend class MClimateForecastReader; // NetCDF can read directly into data
                                          // fields.
@@ -687,7 +947,15 @@ protected:
     float   *data;
     double  *data_double;
     MDataType dataType;
-    quint64 *flags;
+    /**
+      Flag bit-planes (see @ref enableFlags()). Plane f starts at word
+      f * flagsWordsPerPlane; each longitude row of a plane occupies
+      flagsWordsPerRow words.
+     */
+    quint32 *flags;
+    unsigned char numFlags;
+    unsigned int flagsWordsPerRow;
+    unsigned int flagsWordsPerPlane;
     bool     flagsCanBeEnabled;
     quint64  contributingMembers;
     quint64  availableMembers;
@@ -706,6 +974,87 @@ protected:
     QString minMaxAccelID;
 
     MMemoryManagedArray<float>* minMaxAccel;
+
+    MStructuredGrid* companionGrid;
+
+    MIndex3D subDomainIndexOffset;
+
+    /**
+      Packs @ref data to @ref compactData if a 16 bit storage precision has
+      been set and the values can be represented (half precision: all valid
+      values within +-65504; scaled int16: all valid values finite). Grids
+      of type @ref DOUBLE are not packed, as the consumers of such grids
+      expect full precision. @ref data is deleted and nullptr while the grid
+      is packed.
+     */
+    void compactForCache() override;
+
+    /** Unpacks @ref compactData to @ref data (in parallel per level). */
+    void restoreFromCache() override;
+
+private:
+    /** 16 bit representation of @ref data while the grid is cached. */
+    MGridStoragePrecision cachedStoragePrecision;
+    MGridStoragePrecision compactDataPrecision;
+    quint16 *compactData;
+    /** Per-level offset and scale of @ref SCALED_INT16_STORAGE. */
+    QVector<double> compactLevelOffsets;
+    QVector<double> compactLevelScales;
+
+    /** Cache of @ref getStatistics(). */
+    MStructuredGridStatistics statistics;
+    std::atomic<bool> statisticsValid;
+    QMutex statisticsMutex;
+
+    /**
+      Computes the number of flag plane tiles along the x (@p tilesX) and
+      the stacking (@p tilesY) axis of the flags texture (see @ref
+      getFlagsTexture()), given the number of texels @p planeHeight a plane
+      occupies along the stacking axis and the maximum texture size @p
+      maxTextureSize. Returns false if the planes do not fit.
+     */
+    bool flagsTextureTiling(GLint maxTextureSize, unsigned int planeHeight,
+                            unsigned int *tilesX, unsigned int *tilesY) const;
+
+    /**
+      Returns the flag planes rearranged into @p tilesX tiles per texture
+      row (see @ref getFlagsTexture()), with unused tiles set to zero.
+     */
+    QVector<quint32> tiledFlagPlanes(unsigned int tilesX,
+                                     unsigned int tilesY) const;
+
+    /** Word of flag plane @p f that stores grid point @p i of row @p row
+        (row = k * nlats + j). */
+    inline quint32& flagWord(unsigned int row, unsigned int i, unsigned int f)
+    {
+        return flags[f * flagsWordsPerPlane + row * flagsWordsPerRow
+                     + (i >> 5)];
+    }
+
+    static inline quint32 flagBitMask(unsigned int i)
+    { return quint32(1) << (i & 31); }
+
+    inline quint64 getFlagsOfPoint(unsigned int row, unsigned int i)
+    {
+        quint64 fl = 0;
+        const quint32 mask = flagBitMask(i);
+        quint32 *word = &flagWord(row, i, 0);
+        for (unsigned char f = 0; f < numFlags; f++, word += flagsWordsPerPlane)
+        {
+            if (*word & mask) fl |= (Q_UINT64_C(1) << f);
+        }
+        return fl;
+    }
+
+    inline void setFlagsOfPoint(unsigned int row, unsigned int i, quint64 fl)
+    {
+        const quint32 mask = flagBitMask(i);
+        quint32 *word = &flagWord(row, i, 0);
+        for (unsigned char f = 0; f < numFlags; f++, word += flagsWordsPerPlane)
+        {
+            if (fl & (Q_UINT64_C(1) << f)) *word |= mask; else *word &= ~mask;
+        }
+    }
 };
 
 
@@ -792,7 +1141,7 @@ public:
     MRegularLonLatGrid(unsigned int nlats, unsigned int nlons);
 
     inline void setValue(unsigned int j, unsigned int i, float v)
-    { data[INDEX2yx(j, i, nlons)] = v; }
+    { data[INDEX2yx(j, i, nlons)] = v; invalidateStatistics(); }
 
     inline float getValue(unsigned int j, unsigned int i) const
     { return data[INDEX2yx(j, i, nlons)]; }
@@ -866,12 +1215,36 @@ public:
     float interpolateGridColumnToPressure(unsigned int j, unsigned int i,
                                           float p_hPa);
 
+    float interpolateGridColumnToPressureWithHint(
+            unsigned int j, unsigned int i, float p_hPa,
+            int *klowerHint) override;
+
     float levelPressureAtLonLat_hPa(float lon, float lat, unsigned int k) override;
 
     int findLevel(unsigned int j, unsigned int i, float p_hPa);
 
     float getPressure(unsigned int k, unsigned int j, unsigned int i) const override;
 
+    /**
+      Returns the 3D field of the pressure (hPa) at all grid points (same
+      layout as the data field). The field is computed on the first call and
+      is stored in the memory manager of the surface pressure field, with the
+      surface pressure field as owner; it is hence shared by all hybrid grids
+      that reference the same surface pressure field and have the same
+      ak/bk coefficients, and it counts against the memory limit.
+
+      Computing the field is opt-in: only after it has been requested do
+      @ref getPressure(), @ref findLevel() and @ref
+      interpolateGridColumnToPressure() read the pressure from memory instead
+      of recomputing it from ak, bk and surface pressure. Code that evaluates
+      pressure at many grid points (derivative filters, vertical regridding,
+      trajectory computation) should call this method once before its loops.
+     */
+    const float* getPressureField_hPa();
+
+    /** Returns true if the pressure field has been computed. */
+    bool hasPressureField() const { return pressureField != nullptr; }
+
     float getSurfacePressure(unsigned int j, unsigned int i) const override;
 
     void setSurfacePressure(unsigned int j, unsigned int i, float v) override;
@@ -908,6 +1281,8 @@ protected:
     friend class MDifferenceDataSource;
     friend class MProcessingWeatherPredictionDataSource;
     friend class MPotentialVorticityProcessor_LAGRANTOcalvar;
+    friend class MHybridSigmaPressureAccess;
+    friend class MPressureFieldAccess;
 
     void allocateInterfaceCoefficients();
 
@@ -932,6 +1307,21 @@ private:
      */
     void removeSurfacePressureField();
 
+    /**
+      Releases (if memory managed) or deletes the pressure field computed by
+      @ref getPressureField_hPa().
+     */
+    void releasePressureField();
+
+    /**
+      Request of the pressure field: the request of the surface pressure
+      field plus a key identifying the hybrid coefficients.
+     */
+    MDataRequest getPressureFieldRequest();
+
+    std::atomic<MMemoryManagedArray<float>*> pressureField;
+    QMutex pressureFieldMutex;
+
     QString pressureTexCoordID;
     double cachedTopDataVolumePressure_hPa;
     double cachedBottomDataVolumePressure_hPa;
@@ -961,6 +1351,10 @@ public:
     float interpolateGridColumnToPressure(unsigned int j, unsigned int i,
                                           float p_hPa);
 
+    float interpolateGridColumnToPressureWithHint(
+            unsigned int j, unsigned int i, float p_hPa,
+            int *klowerHint) override;
+
     float levelPressureAtLonLat_hPa(float lon, float lat, unsigned int k) override;
 
     int findLevel(unsigned int j, unsigned int i, float p_hPa);
@@ -996,6 +1390,7 @@ protected:
     friend class MClimateForecastReader;
     friend class MStructuredGridEnsembleFilter;
     friend class MProcessingWeatherPredictionDataSource;
+    friend class MPressureFieldAccess;
 
     MLonLatAuxiliaryPressureGrid *auxPressureField_hPa;
 
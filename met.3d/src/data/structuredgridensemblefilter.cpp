@@ -242,13 +242,16 @@ MStructuredGrid* MStructuredGridEnsembleFilter::produceData(MDataRequest request
             {
                 // First iteration.
                 minGrid = createAndInitializeResultGrid(memberGrid, selectedMembers);
-                minGrid->enableFlags(); // allocate flags bitfield
+                // Allocate flags bitfield (one flag per member).
+                const unsigned char numFlags =
+                        MStructuredGrid::numFlagsForMembers(selectedMembers);
+                minGrid->enableFlags(numFlags);
                 minGrid->setToValue(M_MISSING_VALUE);
                 maxGrid = createAndInitializeResultGrid(memberGrid, selectedMembers);
-                maxGrid->enableFlags();
+                maxGrid->enableFlags(numFlags);
                 maxGrid->setToValue(M_MISSING_VALUE);
                 dmaxminGrid = createAndInitializeResultGrid(memberGrid, selectedMembers);
-                dmaxminGrid->enableFlags();
+                dmaxminGrid->enableFlags(numFlags);
                 dmaxminGrid->setToValue(M_MISSING_VALUE);
             }
             else
@@ -285,14 +288,16 @@ MStructuredGrid* MStructuredGridEnsembleFilter::produceData(MDataRequest request
             inputSource->releaseData(memberGrid);
         } // loop over member
 
-        // Compute max-min.
+        // Compute max-min. The flags of grid points with missing values are
+        // zero in both min and max grid, hence the flags can be intersected
+        // plane-wise for the entire grid.
         for (unsigned int v = 0; v < dmaxminGrid->nvalues; v++)
             if ((maxGrid->data[v] != M_MISSING_VALUE)
                     && (minGrid->data[v] != M_MISSING_VALUE))
             {
                 dmaxminGrid->data[v] = maxGrid->data[v] - minGrid->data[v];
-                dmaxminGrid->setFlags(v, maxGrid->getFlags(v) & minGrid->getFlags(v));
             }
+        dmaxminGrid->intersectFlags(maxGrid, minGrid);
 
         finalizeAuxDataInResultGrid(minGrid);
         finalizeAuxDataInResultGrid(maxGrid);
@@ -377,7 +382,9 @@ MStructuredGrid* MStructuredGridEnsembleFilter::produceData(MDataRequest request
                 {
                     // First iteration.
                     result = createAndInitializeResultGrid(memberGrid, selectedMembers);
-                    result->enableFlags(); // allocate flags bitfield
+                    // Allocate flags bitfield (one flag per member).
+                    result->enableFlags(MStructuredGrid::numFlagsForMembers(
+                                            selectedMembers));
                     result->setToZero();
                     validMembersCounter = new MLonLatHybridSigmaPressureGrid(
                                 memberGrid->nlevs, memberGrid->nlats,
@@ -418,7 +425,9 @@ MStructuredGrid* MStructuredGridEnsembleFilter::produceData(MDataRequest request
                 {
                     // First iteration.
                     result = createAndInitializeResultGrid(memberGrid, selectedMembers);
-                    result->enableFlags(); // allocate flags bitfield
+                    // Allocate flags bitfield (one flag per member).
+                    result->enableFlags(MStructuredGrid::numFlagsForMembers(
+                                            selectedMembers));
                     result->setToZero();
                     validMembersCounter = new MLonLatHybridSigmaPressureGrid(
                                 memberGrid->nlevs, memberGrid->nlats,
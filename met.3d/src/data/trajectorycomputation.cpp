@@ -588,6 +588,7 @@ void MTrajectoryComputationSource::computeStreamLines(
         // get data at current time-step
         grids[0][v] = dataSource->getData(rh.request()); // timestep 0
         grids[1][v] = grids[0][v];                       // timestep 1 (link)
+        usePressureField(grids[0][v]);
 
         if (grids[0][v] == nullptr)
         {
@@ -610,22 +611,26 @@ void MTrajectoryComputationSource::computeStreamLines(
 
     // Sample auxiliary data at the seed position of each trajectory.
     const float timeIntWeight = 0;       //  value at first time-step
+    QVector<float> auxDataValues;
+    for (int w = 0; w < ch.auxVarNames.size(); ++w)
+    {
+        // Get index of aux. data field which is behind wind vars in
+        // list of grids.
+        uint gridIndex=numWindDataVars + w;
+
+        // Get auxiliary data, w, at the seed positions.
+        sampleAuxDataAtTrajectoryVertices(
+                    seedPos, timeIntWeight, ch.interpolationMethod, grids,
+                    gridIndex, validPosition, auxDataValues);
+        for (uint iStreamline = 0; iStreamline < ch.trajectoryCount;
+             ++iStreamline)
+        {
+            auxDataValuesPerVertexPerTrajectory[iStreamline][w] =
+                    auxDataValues[iStreamline];
+        }
+    }
     for (uint iStreamline = 0; iStreamline < ch.trajectoryCount; ++iStreamline)
     {
-       for (int w = 0; w < ch.auxVarNames.size(); ++w)
-       {
-           // Get index of aux. data field which is behind wind vars in
-           // list of grids.
-           uint gridIndex=numWindDataVars + w;
-
-           // Get auxiliary data, w, at this vertex.
-           float iAuxDataValue = sampleAuxDataAtTrajectoryVertex(
-                       seedPos[iStreamline],
-                       timeIntWeight, ch.interpolationMethod, grids,
-                       gridIndex, validPosition[iStreamline]);
-           auxDataValuesPerVertexPerTrajectory[iStreamline][w] = iAuxDataValue;
-
-       }
        // Store all auxiliary data variables at this vertex of the trajectory.
        cInfo.auxDataAtVertices[iStreamline].push_back(
                    auxDataValuesPerVertexPerTrajectory[iStreamline]);
@@ -754,6 +759,7 @@ void MTrajectoryComputationSource::computePathLines(
 
     // Create temporary vector to cache auxiliary data at vertex positions.
     QVector<QVector<float>> auxDataValuesPerVertexPerTrajectory(cInfo.numTrajectories,QVector<float>(numAuxDataVars));
+    QVector<float> auxDataValues;
 
     // Add start time step and seed points.
     cInfo.times.push_back(ch.validTimes.at(ch.startTimeStep));
@@ -806,6 +812,7 @@ void MTrajectoryComputationSource::computePathLines(
                     // command below) and set -- hence the check for a valid
                     // pointer above.
                     grids[t][v] = dataSource->getData(rh.request());
+                    usePressureField(grids[t][v]);
 
                     if (grids[t][v] == nullptr)
                     {
@@ -839,24 +846,26 @@ void MTrajectoryComputationSource::computePathLines(
         if (step == ch.startTimeStep)
         {
             const float timeIntWeight = 0; // value at first time-step
-            for (uint trajectory = 0; trajectory < ch.trajectoryCount;
-                 ++trajectory)
+            for (int w = 0; w < ch.auxVarNames.size(); ++w)
             {
-                for (int w = 0; w < ch.auxVarNames.size(); ++w)
-                {
-                    // Get index of aux. data field which is behind wind vars
-                    // in list of grids.
-                    uint gridIndex=numWindDataVars + w;
+                // Get index of aux. data field which is behind wind vars
+                // in list of grids.
+                uint gridIndex=numWindDataVars + w;
 
-                    // Get auxiliary data, w, at this vertex
-                    float iAuxDataValue = sampleAuxDataAtTrajectoryVertex(
-                                positions[trajectory], timeIntWeight,
-                                ch.interpolationMethod, grids, gridIndex,
-                                validPosition[trajectory]);
+                // Get auxiliary data, w, at the seed positions.
+                sampleAuxDataAtTrajectoryVertices(
+                            positions, timeIntWeight, ch.interpolationMethod,
+                            grids, gridIndex, validPosition, auxDataValues);
+                for (uint trajectory = 0; trajectory < ch.trajectoryCount;
+                     ++trajectory)
+                {
                     auxDataValuesPerVertexPerTrajectory[trajectory][w] =
-                            iAuxDataValue;
-
+                            auxDataValues[trajectory];
                 }
+            }
+            for (uint trajectory = 0; trajectory < ch.trajectoryCount;
+                 ++trajectory)
+            {
                 // Store all auxiliary data variables at this vertex of trajectory
                 cInfo.auxDataAtVertices[trajectory].push_back(
                             auxDataValuesPerVertexPerTrajectory[trajectory]);
@@ -915,37 +924,45 @@ void MTrajectoryComputationSource::computePathLines(
 
             // Save computed vertex position for the "current" time step.
             cInfo.vertices[iTrajectory].push_back(positions[iTrajectory]);
+         }
 
-            // Sample auxiliary data at current position and time-step
-            // particle positions are integrated from date time, t0, to next
-            // data time, t1, using n steps between the data-time steps.
-            // the positions on sub-grid-scales, i.e. at each of the n steps,
-            // are not saved and not plotted; instead only positions at
-            // time-steps of the data are saved. We want to sample the aux data
-            // at the time of the data, hence we set the time-ingetration
-            // weight to 1.
-            const float timeIntWeight = 1;
-            // Set the time interpolation weight to 1 for sampling at the time
-            // of the second data grid.
-            for (int w = 0; w < ch.auxVarNames.size(); ++w)
+        // Sample auxiliary data at current position and time-step
+        // particle positions are integrated from date time, t0, to next
+        // data time, t1, using n steps between the data-time steps.
+        // the positions on sub-grid-scales, i.e. at each of the n steps,
+        // are not saved and not plotted; instead only positions at
+        // time-steps of the data are saved. We want to sample the aux data
+        // at the time of the data, hence we set the time-ingetration
+        // weight to 1.
+        // The vertices of all trajectories are sampled at once.
+        const float timeIntWeight = 1;
+        // Set the time interpolation weight to 1 for sampling at the time
+        // of the second data grid.
+        for (int w = 0; w < ch.auxVarNames.size(); ++w)
+        {
+            // Set index of aux. data field which is behind the wind data
+            // grids in the list of grids.
+            uint gridIndex=numWindDataVars + w;
+
+            // Get the auxiliary data, w, at the vertices.
+            sampleAuxDataAtTrajectoryVertices(
+                        positions, timeIntWeight, ch.interpolationMethod,
+                        grids, gridIndex, validPosition, auxDataValues);
+            for (uint iTrajectory = 0; iTrajectory < ch.trajectoryCount;
+                 ++iTrajectory)
             {
-                // Set index of aux. data field which is behind the wind data
-                // grids in the list of grids.
-                uint gridIndex=numWindDataVars + w;
-
-                // Get the auxiliary data, w, at vertex.
-                float iAuxDataValue = sampleAuxDataAtTrajectoryVertex(
-                            positions[iTrajectory], timeIntWeight,
-                            ch.interpolationMethod, grids, gridIndex,
-                            validPosition[iTrajectory]);
-                auxDataValuesPerVertexPerTrajectory[iTrajectory][w]=
-                        iAuxDataValue;
+                auxDataValuesPerVertexPerTrajectory[iTrajectory][w] =
+                        auxDataValues[iTrajectory];
             }
+        }
+        for (uint iTrajectory = 0; iTrajectory < ch.trajectoryCount;
+             ++iTrajectory)
+        {
             // Store all auxiliary data variables at this vertex of
             // iTrajectory.
             cInfo.auxDataAtVertices[iTrajectory].push_back(
                         auxDataValuesPerVertexPerTrajectory[iTrajectory]);
-         }
+        }
 
         // Release data grid of previous time step (i.e. index [0]).
         for (int v = 0; v < (ch.varNames.size()+ch.auxVarNames.size()); ++v)
@@ -1175,6 +1192,63 @@ float MTrajectoryComputationSource::sampleAuxDataAtTrajectoryVertex(
 }
 
 
+void MTrajectoryComputationSource::sampleAuxDataAtTrajectoryVertices(
+        const QVector<QVector3D> &positions, float timeInterpolationValue,
+        TRAJECTORY_COMPUTATION_INTERPOLATION_METHOD method,
+        QVector<QVector<MStructuredGrid*>> &grids, uint indexAuxVar,
+        QVector<bool> &valid, QVector<float> &auxDataValues)
+{
+    const int numVertices = positions.size();
+    auxDataValues.resize(numVertices);
+
+    if (method != MET3D_INTERPOLATION)
+    {
+        // The vertices are independent. Obtain the data pointers before
+        // the parallel loop so that the vectors are not detached
+        // concurrently.
+        bool *validData = valid.data();
+        float *auxDataValuesData = auxDataValues.data();
+
+#pragma omp parallel for
+        for (int i = 0; i < numVertices; i++)
+        {
+            auxDataValuesData[i] = sampleAuxDataAtTrajectoryVertex(
+                        positions[i], timeInterpolationValue, method, grids,
+                        indexAuxVar, validData[i]);
+        }
+        return;
+    }
+
+    // Sample auxiliary data by linear interpolation to the positions for
+    // two time-steps (cf. sampleAuxDataAtTrajectoryVertex()).
+    QVector<float> auxDataT0(numVertices);
+    grids[0][indexAuxVar]->interpolateValues(
+                positions.constData(), auxDataT0.data(), numVertices);
+
+    QVector<float> auxDataT1 = auxDataT0;
+    if (grids[1][indexAuxVar] != grids[0][indexAuxVar])
+    {
+        grids[1][indexAuxVar]->interpolateValues(
+                    positions.constData(), auxDataT1.data(), numVertices);
+    }
+
+    for (int i = 0; i < numVertices; i++)
+    {
+        // Check for missing values.
+        if (IS_MISSING(auxDataT0[i]) || IS_MISSING(auxDataT1[i]))
+        {
+            valid[i] = false;
+            auxDataValues[i] = M_MISSING_VALUE;
+            continue;
+        }
+
+        // Interpolate in time.
+        auxDataValues[i] = MMIX(auxDataT0[i], auxDataT1[i],
+                                timeInterpolationValue);
+    }
+}
+
+
 QVector3D MTrajectoryComputationSource::convertWindVelocityFromMetricToSpherical(
         QVector3D velocity_ms_ms_Pas, QVector3D position_lon_lat_p)
 {
@@ -1188,6 +1262,19 @@ QVector3D MTrajectoryComputationSource::convertWindVelocityFromMetricToSpherical
 }
 
 
+void MTrajectoryComputationSource::usePressureField(MStructuredGrid *grid)
+{
+    // floatIndexAtPos() locates positions with binary searches over the
+    // grid column pressures; for hybrid grids read the pressure from the
+    // pressure field shared by all fields with the same surface pressure.
+    if (MLonLatHybridSigmaPressureGrid *hybridGrid =
+            dynamic_cast<MLonLatHybridSigmaPressureGrid*>(grid))
+    {
+        hybridGrid->getPressureField_hPa();
+    }
+}
+
+
 float MTrajectoryComputationSource::samplePressureAtFloatIndex(
         QVector3D index, MStructuredGrid *grid)
 {
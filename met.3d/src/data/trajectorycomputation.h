@@ -342,6 +342,27 @@ protected:
             QVector<QVector<MStructuredGrid*>> &grids, uint indexAuxVar,
             bool& valid);
 
+    /**
+      Same as @ref sampleAuxDataAtTrajectoryVertex() for the vertices
+      @p positions of all trajectories. The values are written to
+      @p auxDataValues, @p valid is set to false for the trajectories whose
+      vertex could not be sampled.
+
+      With @ref MET3D_INTERPOLATION the grids are sampled at all positions
+      at once (@ref MStructuredGrid::interpolateValues()).
+     */
+    void sampleAuxDataAtTrajectoryVertices(
+            const QVector<QVector3D> &positions, float timeInterpolationValue,
+            TRAJECTORY_COMPUTATION_INTERPOLATION_METHOD method,
+            QVector<QVector<MStructuredGrid*>> &grids, uint indexAuxVar,
+            QVector<bool> &valid, QVector<float> &auxDataValues);
+
+    /**
+      Requests the pressure field of @p grid if it is a hybrid sigma-pressure
+      grid (see @ref MLonLatHybridSigmaPressureGrid::getPressureField_hPa()).
+     */
+    void usePressureField(MStructuredGrid *grid);
+
     /**
       Performs tri-linear intperpolation to obtain the pressure value of
       @p grid at the float index position @p index.
@@ -482,69 +482,116 @@ void MTrajectoryReader::scanDataRoot()
     initializeFileScanProgressDialog(availableFiles.size());
 
     // For each file, extract information about the contained start time and
-    // valid times. Store these information in "availableTrajectories".
-    for (int i = 0; i < availableFiles.size(); i++)
+    // valid times.
+    QVector<MTrajectoryFileScanResult> scanResults =
+            scanFilesConcurrently<MTrajectoryFileScanResult>(
+                availableFiles, [this](const QString& filename)
     {
-        updateFileScanProgressDialog();
-        QString filename = availableFiles[i];
-
-        LOG4CPLUS_DEBUG_FMT(mlog, "\tParsing file %s ..",
-                            filename.toStdString().c_str());
-
-        // NetCDF library is not thread-safe (at least the regular C/C++
-        // interface is not; hence all NetCDF calls need to be serialized
-        // globally in Met.3D! (notes Feb2015).
-        QMutexLocker ncAccessMutexLocker(&staticNetCDFAccessMutex);
+        return scanTrajectoryFile(filename);
+    });
 
-        // Open the file.
-        NcFile *ncFile;
-        try
-        {
-            ncFile = new NcFile(dataRoot.filePath(filename).toStdString(),
-                                NcFile::read);
-        }
-        catch (NcException& e)
-        {
-            LOG4CPLUS_ERROR_FMT(mlog, "Cannot open file \"%s\"..",
-                                filename.toStdString().c_str());
-            continue;
-        }
+    deleteFileScanProgressDialog();
 
-        // Get start time and forecast init time of this file. Assume that
-        // there is a variable "pressure" from which the time variable can
-        // be found.
-        NcCFVar currCFVar(ncFile->getVar("pressure"));
-        QDateTime startTime = currCFVar.getBaseTime();
-        QDateTime initTime  = NcCFVar(currCFVar.getTimeVar())
-                .getTimeFromAttribute(QString("forecast_inittime"));
+    // Store these information in "availableTrajectories", in the order of
+    // the files.
+    for (int i = 0; i < availableFiles.size(); i++)
+    {
+        const MTrajectoryFileScanResult &result = scanResults[i];
+        if (!result.isValid) continue;
 
-        LOG4CPLUS_TRACE_FMT(mlog, "\tstart time: %s, init time: %s",
-                            startTime.toString(Qt::ISODate).toStdString().c_str(),
-                            initTime.toString(Qt::ISODate).toStdString().c_str());
+        QDateTime initTime = result.initTime;
+        QDateTime startTime = result.startTime;
 
         // Store the time values with the current filename in
         // "availableTrajectories".
-        availableTrajectories[initTime][startTime].filename = filename;
+        availableTrajectories[initTime][startTime].filename = availableFiles[i];
         availableTrajectories[initTime][startTime].isStartTime = true;
 
         // Add this valid (=start) time to all other valid times it overlaps
         // with. This might introduce wrong valid times -- they are removed
         // below.
-        QList<QDateTime> trajectoryTimes = currCFVar.getTimeValues();
-        for (int t = 0; t < trajectoryTimes.size(); t++)
+        for (int t = 0; t < result.trajectoryTimes.size(); t++)
         {
-            availableTrajectories[initTime][trajectoryTimes[t]]
+            availableTrajectories[initTime][result.trajectoryTimes[t]]
                     .validTimeOverlap.append(startTime);
         }
 
-        // Determine the available ensemble members.
-        NcDim        ensembleDim = ncFile->getDim("ensemble");
-        unsigned int numMembers  = ensembleDim.getSize();
-        for (unsigned int m = 0; m < numMembers; m++)
+        // Available ensemble members.
+        for (unsigned int m = 0; m < result.numMembers; m++)
         {
             availableMembers.insert(m);
         }
 
+        // Available auxiliary data variables.
+        foreach (QString varName, result.auxDataVariables)
+        {
+            availableAuxDataVariables.insert(varName);
+        }
+    } // for (files)
+
+    // After all files have been scanned remove wrong valid times (see above).
+    // (Do not use availableInitTimes() and availableValidTimes() as they
+    // would lock for read and produce a deadlock.)
+    QList<QDateTime> initTimes = availableTrajectories.keys();
+    for (int i = 0; i < initTimes.size(); i++)
+    {
+        QList<QDateTime> validTimes = availableTrajectories[initTimes[i]].keys();
+        for (int j = 0; j < validTimes.size(); j++)
+            if (!availableTrajectories[initTimes[i]][validTimes[j]].isStartTime)
+                availableTrajectories[initTimes[i]].remove(validTimes[j]);
+    }
+}
+
+
+MTrajectoryFileScanResult MTrajectoryReader::scanTrajectoryFile(
+        const QString& filename)
+{
+    MTrajectoryFileScanResult result;
+
+    LOG4CPLUS_DEBUG_FMT(mlog, "\tParsing file %s ..",
+                        filename.toStdString().c_str());
+
+    // NetCDF library is not thread-safe (at least the regular C/C++
+    // interface is not; hence all NetCDF calls need to be serialized
+    // globally in Met.3D! (notes Feb2015).
+    QMutexLocker ncAccessMutexLocker(&staticNetCDFAccessMutex);
+
+    // Open the file.
+    NcFile *ncFile;
+    try
+    {
+        ncFile = new NcFile(dataRoot.filePath(filename).toStdString(),
+                            NcFile::read);
+    }
+    catch (NcException& e)
+    {
+        LOG4CPLUS_ERROR_FMT(mlog, "Cannot open file \"%s\"..",
+                            filename.toStdString().c_str());
+        return result;
+    }
+
+    try
+    {
+        // Get start time and forecast init time of this file. Assume that
+        // there is a variable "pressure" from which the time variable can
+        // be found.
+        NcCFVar currCFVar(ncFile->getVar("pressure"));
+        result.startTime = currCFVar.getBaseTime();
+        result.initTime  = NcCFVar(currCFVar.getTimeVar())
+                .getTimeFromAttribute(QString("forecast_inittime"));
+
+        LOG4CPLUS_TRACE_FMT(mlog, "\tstart time: %s, init time: %s",
+                            result.startTime.toString(Qt::ISODate)
+                            .toStdString().c_str(),
+                            result.initTime.toString(Qt::ISODate)
+                            .toStdString().c_str());
+
+        result.trajectoryTimes = currCFVar.getTimeValues();
+
+        // Determine the number of ensemble members.
+        NcDim ensembleDim = ncFile->getDim("ensemble");
+        result.numMembers = ensembleDim.getSize();
+
         // Determine available auxiliary data variables.
         // Get auxiliary data along trajectories by screening
         // all available ncvars in the input file and picking
@@ -563,26 +610,20 @@ void MTrajectoryReader::scanDataRoot()
 
             if (auxDataIndicator == "yes")
             {
-                availableAuxDataVariables.insert(varName);
+                result.auxDataVariables << varName;
             }
         }
 
-        delete ncFile;
-    } // for (files)
-
-    deleteFileScanProgressDialog();
-
-    // After all files have been scanned remove wrong valid times (see above).
-    // (Do not use availableInitTimes() and availableValidTimes() as they
-    // would lock for read and produce a deadlock.)
-    QList<QDateTime> initTimes = availableTrajectories.keys();
-    for (int i = 0; i < initTimes.size(); i++)
+        result.isValid = true;
+    }
+    catch (NcException& e)
     {
-        QList<QDateTime> validTimes = availableTrajectories[initTimes[i]].keys();
-        for (int j = 0; j < validTimes.size(); j++)
-            if (!availableTrajectories[initTimes[i]][validTimes[j]].isStartTime)
-                availableTrajectories[initTimes[i]].remove(validTimes[j]);
+        LOG4CPLUS_ERROR_FMT(mlog, "Cannot read file \"%s\"; skipping file.",
+                            filename.toStdString().c_str());
     }
+
+    delete ncFile;
+    return result;
 }
 
 
@@ -111,6 +111,23 @@ struct MTrajectoryFileInfo
 typedef QHash<QString, MTrajectoryFileInfo*> MOpenTrajectoryFileMap;
 
 
+/**
+  Times, ensemble size and auxiliary variables of a single trajectory file,
+  determined in the parallel phase of @ref MTrajectoryReader::scanDataRoot().
+ */
+struct MTrajectoryFileScanResult
+{
+    MTrajectoryFileScanResult() : isValid(false), numMembers(0) {}
+
+    bool isValid; // false if the file could not be read
+    QDateTime startTime;
+    QDateTime initTime;
+    QList<QDateTime> trajectoryTimes;
+    unsigned int numMembers;
+    QStringList auxDataVariables;
+};
+
+
 /**
   @brief MTrajectoryReader reads particle trajectories from CF-similar LAGRANTO
   NetCDF files.
@@ -168,9 +185,17 @@ protected:
 
     /**
       Scans the root data directory to determine the available data sets.
+      The files are read concurrently by @ref scanTrajectoryFile(); the
+      results are merged in file order.
       */
     void scanDataRoot();
 
+    /**
+      Parallel per-file phase of @ref scanDataRoot(): reads times, ensemble
+      size and auxiliary variables of the trajectory file @p filename.
+     */
+    MTrajectoryFileScanResult scanTrajectoryFile(const QString& filename);
+
     /**
       Define the request keys required by this reader.
      */
@@ -86,6 +86,11 @@ MStructuredGrid* MVerticalRegridder::produceData(MDataRequest request)
 
     if (!inputGrid) return nullptr;
 
+    // interpolateGridColumnToPressure() searches the pressure of the input
+    // columns; read it from the pressure field shared by all fields with the
+    // same surface pressure.
+    inputGrid->getPressureField_hPa();
+
     MStructuredGrid *regriddedField = nullptr;
 
     if (levelType == "ML")
@@ -41,7 +41,8 @@ namespace Met3D
 *******************************************************************************/
 
 MWeatherPredictionDataSource::MWeatherPredictionDataSource()
-    : MScheduledDataSource()
+    : MScheduledDataSource(),
+      cachedStoragePrecision(FLOAT32_STORAGE)
 {
 }
 
@@ -56,5 +57,15 @@ MWeatherPredictionDataSource::MWeatherPredictionDataSource()
 ***                          PROTECTED METHODS                              ***
 *******************************************************************************/
 
+void MWeatherPredictionDataSource::prepareDataItemForStorage(
+        MAbstractDataItem *item)
+{
+    if (MStructuredGrid *grid = dynamic_cast<MStructuredGrid*>(item))
+    {
+        grid->setCachedStoragePrecision(cachedStoragePrecision);
+    }
+}
+
+
 
 } // namespace Met3D
@@ -121,8 +121,22 @@ public:
             const QString&     variableName)
     { Q_UNUSED(levelType); Q_UNUSED(variableName); return QString(); }
 
+    /**
+      Sets the precision in which the data fields of the grids produced by
+      this source are stored while the grids are cached in the memory
+      manager (see @ref MStructuredGrid::setCachedStoragePrecision()). The
+      default is @ref FLOAT32_STORAGE, i.e. cached grids are not compacted.
+     */
+    void setCachedStoragePrecision(MGridStoragePrecision precision)
+    { cachedStoragePrecision = precision; }
+
+    MGridStoragePrecision getCachedStoragePrecision()
+    { return cachedStoragePrecision; }
+
 protected:
+    void prepareDataItemForStorage(MAbstractDataItem *item) override;
 
+    MGridStoragePrecision cachedStoragePrecision;
 };
 
 
@@ -66,6 +66,7 @@ MStructuredGrid* MWeatherPredictionReader::produceData(MDataRequest request)
     QDateTime initTime         = rh.timeValue("INIT_TIME");
     QDateTime validTime        = rh.timeValue("VALID_TIME");
     unsigned int member        = rh.intValue("MEMBER");
+    MSubDomain subDomain = MSubDomain::fromRequestValue(rh.value("SUBDOMAIN"));
 
     if ((levtype == HYBRID_SIGMA_PRESSURE_3D) && (variable.endsWith("/PSFC")))
     {
@@ -80,7 +81,8 @@ MStructuredGrid* MWeatherPredictionReader::produceData(MDataRequest request)
     MStructuredGrid* result = nullptr;
     try
     {
-        result = readGrid(levtype, variable, initTime, validTime, member);
+        result = readGrid(levtype, variable, initTime, validTime, member,
+                          subDomain);
     }
     catch (const std::exception& e)
     {
@@ -112,7 +114,7 @@ MStructuredGrid* MWeatherPredictionReader::produceData(MDataRequest request)
             // Data field needs to be loaded from disk.
             MRegularLonLatGrid *psfc = static_cast<MRegularLonLatGrid*>(
                         readGrid(SURFACE_2D, psfcVar, initTime,
-                                 validTime, member)
+                                 validTime, member, subDomain)
                         );
             psfc->setGeneratingRequest(psfcRequest);
             if ( !memoryManager->storeData(this, psfc) )
@@ -158,7 +160,7 @@ MStructuredGrid* MWeatherPredictionReader::produceData(MDataRequest request)
             MLonLatAuxiliaryPressureGrid *auxPressureField_hPa =
                     static_cast<MLonLatAuxiliaryPressureGrid*>(
                         readGrid(AUXILIARY_PRESSURE_3D, pressureVar,
-                                 initTime, validTime, member)
+                                 initTime, validTime, member, subDomain)
                         );
             auxPressureField_hPa->setGeneratingRequest(auxPressureFieldRequest);
             if ( !memoryManager->storeData(this, auxPressureField_hPa) )
@@ -209,4 +211,18 @@ const QStringList MWeatherPredictionReader::locallyRequiredKeys()
             << "VALID_TIME" << "MEMBER");
 }
 
+
+const QStringList MWeatherPredictionReader::locallyOptionalKeys()
+{
+    return (QStringList() << "SUBDOMAIN");
+}
+
+
+QString MWeatherPredictionReader::locallyDataSignature()
+{
+    return QString("%1/%2@%3").arg(dataRoot.absolutePath())
+            .arg(dirFileFilters)
+            .arg(getDataRootLastModified().toMSecsSinceEpoch());
+}
+
 } // namespace Met3D
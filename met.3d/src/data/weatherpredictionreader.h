@@ -132,17 +132,27 @@ protected:
             const QString&     variableName) = 0;
 
     /**
-      Reads the requested data field from disk. The returned @ref
-      MStructuredGrid pointer needs to be deleted by the caller.
+      Reads the requested data field from disk. If @p subDomain is valid,
+      only the grid points covering the sub-domain (see @ref
+      MSubDomain::computeIndexRanges()) are read and the grid's sub-domain
+      index offset is set. The returned @ref MStructuredGrid pointer needs to
+      be deleted by the caller.
       */
     virtual MStructuredGrid* readGrid(MVerticalLevelType levelType,
                                       const QString&     variableName,
                                       const QDateTime&   initTime,
                                       const QDateTime&   validTime,
-                                      unsigned int       ensembleMember) = 0;
+                                      unsigned int       ensembleMember,
+                                      const MSubDomain&  subDomain
+                                      = MSubDomain()) = 0;
 
     const QStringList locallyRequiredKeys();
 
+    /** The optional key SUBDOMAIN (see @ref MSubDomain). */
+    const QStringList locallyOptionalKeys();
+
+    QString locallyDataSignature();
+
     /** Name of variable containing the auxiliary 3D pressure field.*/
     QString auxiliary3DPressureField;
 };
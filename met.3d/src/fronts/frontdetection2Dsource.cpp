@@ -178,6 +178,29 @@ M2DFrontSelection* MFrontDetection2DSource::produceData(MDataRequest request)
     auto start2 = std::chrono::system_clock::now();
 #endif
 
+    // Sample the attributes at all vertex positions at once.
+    const unsigned int numPositions = positions->size();
+    std::vector<float> tfpValues(numPositions);
+    std::vector<float> abzValues(numPositions);
+    std::vector<float> dDetectionVarDXValues(numPositions);
+    std::vector<float> dDetectionVarDYValues(numPositions);
+    std::vector<float> windUValues(numPositions);
+    std::vector<float> windVValues(numPositions);
+    tfpGrid->interpolateValues(
+                positions->constData(), tfpValues.data(), numPositions);
+    abzGrid->interpolateValues(
+                positions->constData(), abzValues.data(), numPositions);
+    dDetectionVarDXGrid->interpolateValues(
+                positions->constData(), dDetectionVarDXValues.data(),
+                numPositions);
+    dDetectionVarDYGrid->interpolateValues(
+                positions->constData(), dDetectionVarDYValues.data(),
+                numPositions);
+    windUGrid->interpolateValues(
+                positions->constData(), windUValues.data(), numPositions);
+    windVGrid->interpolateValues(
+                positions->constData(), windVValues.data(), numPositions);
+
 //#ifdef COMPUTE_PARALLEL
 //#pragma omp parallel for
 //#endif
@@ -193,15 +216,14 @@ M2DFrontSelection* MFrontDetection2DSource::produceData(MDataRequest request)
         Geometry::FrontLineVertex frontVertex;
 
         // get all relevant values at the position
-        const float tfp = tfpGrid->interpolateValue(position);
-        const float abz = abzGrid->interpolateValue(position);
+        const float tfp = tfpValues[k];
+        const float abz = abzValues[k];
 
         // compute front type (warm or cold)
-        QVector2D gradTheta(dDetectionVarDXGrid->interpolateValue(position),
-                            dDetectionVarDYGrid->interpolateValue(position));
+        QVector2D gradTheta(dDetectionVarDXValues[k],
+                            dDetectionVarDYValues[k]);
         gradTheta.normalize();
-        QVector2D wind(windUGrid->interpolateValue(position),
-                       windVGrid->interpolateValue(position));
+        QVector2D wind(windUValues[k], windVValues[k]);
         wind.normalize();
         const float type = float(QVector2D::dotProduct(-gradTheta, wind) >= 0);
 
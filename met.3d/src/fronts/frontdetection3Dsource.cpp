@@ -43,7 +43,8 @@
 using namespace Met3D;
 
 MFrontDetection3DSource::MFrontDetection3DSource()
-        : M3DFrontFilterSource()
+        : M3DFrontFilterSource(),
+          isosurfaceAlgorithm(MMarchingCubes::MARCHING_CUBES)
 {
 }
 
@@ -166,31 +167,26 @@ M3DFrontSelection* MFrontDetection3DSource::produceData(MDataRequest request)
 
     LOG4CPLUS_DEBUG(mlog, QString("[0] Number of voxel cells: %1 x %2 x %3").arg(nx).arg(ny).arg(nz).toStdString());
 
-    // QVector max size is 2GB (2000000000 bytes)
-    // Here we check if we can compute mc or if our data is too large
-    u_int32_t numEdges = (3 * fleGrid->getNumValues()
-                    - fleGrid->getNumLons() * fleGrid->getNumLevels()
-                    - fleGrid->getNumLons() * fleGrid->getNumLats()
-                    - fleGrid->getNumLats() * fleGrid->getNumLevels());
-    u_int32_t sizefloatQVector3d = numEdges * 3 * 4;
-    u_int32_t maxSizeQVector = 2000000000;
-    if (sizefloatQVector3d > maxSizeQVector)
-    {
-        LOG4CPLUS_DEBUG(mlog, "Your data set is too large to compute 3D fronts");
-        return new M3DFrontSelection();
-    }
-
     LOG4CPLUS_DEBUG(mlog, "[1] Compute voxels and isosurface triangle geometry...");
 
+    // The min/max brick index only depends on the FLE field and is reused
+    // when the isovalue is changed.
+    MMinMaxBrickIndex *fleBrickIndex =
+            MMinMaxBrickIndex::getIndex(memoryManager, this, fleGrid);
+
     MMarchingCubes mc(fleGrid, zGrid);
+    mc.setAlgorithm(isosurfaceAlgorithm);
+    mc.setMinMaxBrickIndex(fleBrickIndex);
     mc.computeMeshOnCPU(isovalue);
 
+    memoryManager->releaseData(fleBrickIndex);
+
     LOG4CPLUS_DEBUG(mlog, "[1] \t->done.");
 
-    QVector<Geometry::MTriangle>* triangles = mc.getFlattenTriangles();
-    QVector<QVector3D>* positions = mc.getFlattenInterPoints();
-    QVector<QVector3D>* normals   = mc.getFlattenInterNormals();
-    QVector<QVector3D>* normalsZ  = mc.getFlattenInterNormalsZ();
+    std::vector<Geometry::MTriangle>* triangles = mc.getFlattenTriangles();
+    std::vector<QVector3D>* positions = mc.getFlattenInterPoints();
+    std::vector<QVector3D>* normals   = mc.getFlattenInterNormals();
+    std::vector<QVector3D>* normalsZ  = mc.getFlattenInterNormalsZ();
 
     int p = positions->size();
     LOG4CPLUS_DEBUG(
@@ -209,6 +205,27 @@ M3DFrontSelection* MFrontDetection3DSource::produceData(MDataRequest request)
 
     const float minValue = fleGrid->min();
 
+    // Sample the attributes at all vertex positions at once.
+    const unsigned int numPositions = positions->size();
+    std::vector<float> tfpValues(numPositions);
+    std::vector<float> abzValues(numPositions);
+    std::vector<float> dDetectionVarDXValues(numPositions);
+    std::vector<float> dDetectionVarDYValues(numPositions);
+    std::vector<float> windUValues(numPositions);
+    std::vector<float> windVValues(numPositions);
+    tfpGrid->interpolateValues(
+                positions->data(), tfpValues.data(), numPositions);
+    abzGrid->interpolateValues(
+                positions->data(), abzValues.data(), numPositions);
+    dDetectionVarDXGrid->interpolateValues(
+                positions->data(), dDetectionVarDXValues.data(), numPositions);
+    dDetectionVarDYGrid->interpolateValues(
+                positions->data(), dDetectionVarDYValues.data(), numPositions);
+    windUGrid->interpolateValues(
+                positions->data(), windUValues.data(), numPositions);
+    windVGrid->interpolateValues(
+                positions->data(), windVValues.data(), numPositions);
+
 #ifdef COMPUTE_PARALLEL
 #pragma omp parallel for
 #endif
@@ -224,15 +241,14 @@ M3DFrontSelection* MFrontDetection3DSource::produceData(MDataRequest request)
         Geometry::FrontMeshVertex frontVertex;
 
         // get all relevant values at the position
-        const float tfp = tfpGrid->interpolateValue(position);
-        const float abz = abzGrid->interpolateValue(position);
+        const float tfp = tfpValues[k];
+        const float abz = abzValues[k];
 
         // compute front type (warm or cold)
-        QVector2D gradTheta(dDetectionVarDXGrid->interpolateValue(position),
-                            dDetectionVarDYGrid->interpolateValue(position));
+        QVector2D gradTheta(dDetectionVarDXValues[k],
+                            dDetectionVarDYValues[k]);
         gradTheta.normalize();
-        QVector2D wind(windUGrid->interpolateValue(position),
-                       windVGrid->interpolateValue(position));
+        QVector2D wind(windUValues[k], windVValues[k]);
         wind.normalize();
         const float type = float(QVector2D::dotProduct(-gradTheta, wind) >= 0);
 
@@ -42,6 +42,7 @@
 #include "frontlocationequationsource.h"
 #include "thermalfrontparametersource.h"
 #include "adjacentbarocliniczonesource.h"
+#include "util/mmarchingcubes.h"
 
 #include "gxfw/gl/shadereffect.h"
 
@@ -62,6 +63,13 @@ public:
     void setWindVSource(MWeatherPredictionDataSource* s);
     void setZSource(MWeatherPredictionDataSource* s);
 
+    /**
+      Selects the isosurface extraction algorithm for the front surfaces
+      (see @ref MMarchingCubes::Algorithm; default MARCHING_CUBES).
+     */
+    void setIsosurfaceAlgorithm(MMarchingCubes::Algorithm algorithm)
+    { isosurfaceAlgorithm = algorithm; }
+
     M3DFrontSelection* produceData(MDataRequest request) override;
 
     MTask *createTaskGraph(MDataRequest request) override;
@@ -91,6 +99,7 @@ private:
     MWeatherPredictionDataSource* windUSource;
     MWeatherPredictionDataSource* windVSource;
     MWeatherPredictionDataSource* zSource;
+    MMarchingCubes::Algorithm isosurfaceAlgorithm;
 };
 
 
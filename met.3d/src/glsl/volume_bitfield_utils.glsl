@@ -61,13 +61,43 @@ subroutine uniform sampleDataAllBitsAtPosType sampleDataAllBitsAtPos;
 subroutine uniform computeGradientBitfieldAtPosType computeGradientBitfieldAtPos;
 
 
+// The flags are stored as bit-planes (cf. MStructuredGrid::enableFlags()),
+// tiled into flagsVolume (cf. MStructuredGrid::getFlagsTexture()): with
+// W = (nLon + 31) / 32 words per plane row and tilesX = width(flagsVolume) / W
+// plane tiles per texture row, flag "bit" of grid point (i, j, k) is bit
+// i % 32 of texel ((bit % tilesX) * W + i / 32, j, (bit / tilesX) * nLev + k).
+int numFlagTilesX()
+{
+    int wordsPerRow = (textureSize(dataVolume, 0).x + 31) / 32;
+    return textureSize(flagsVolume, 0).x / wordsPerRow;
+}
+
+
+int numFlagPlanes()
+{
+    return numFlagTilesX()
+            * (textureSize(flagsVolume, 0).z / textureSize(dataVolume, 0).z);
+}
+
+
+ivec3 flagTexelCoord(in ivec3 gridPos, int bit, int tilesX)
+{
+    int wordsPerRow = (textureSize(dataVolume, 0).x + 31) / 32;
+    int nLev = textureSize(dataVolume, 0).z;
+    return ivec3((bit % tilesX) * wordsPerRow + gridPos.x / 32, gridPos.y,
+                 (bit / tilesX) * nLev + gridPos.z);
+}
+
+
 // method to obtain bits from current grid via int indices
 float fetchBit(in ivec3 gridPos, uint bit)
 {
-    uvec2 bitfield = texelFetch(flagsVolume, gridPos, 0).rg;
-    uint bitfieldPart = (bit < 32) ? bitfield.r : bitfield.g;
-    bit = uint(mod(bit,32));
-    bool bitIsSet = bool(bitfieldPart & (1 << bit));
+    if (int(bit) >= numFlagPlanes()) return 0.;
+
+    uint bitfieldPart = texelFetch(
+                flagsVolume,
+                flagTexelCoord(gridPos, int(bit), numFlagTilesX()), 0).r;
+    bool bitIsSet = bool(bitfieldPart & (1u << uint(gridPos.x % 32)));
     return (bitIsSet ? 1. : 0.);
 }
 
@@ -76,17 +106,20 @@ float[maxBits] fetchAllBits(in ivec3 gridPos)
 {
     float result[maxBits];
 
-    uvec2 bitfield = texelFetch(flagsVolume, gridPos, 0).rg;
+    int tilesX = numFlagTilesX();
+    uint numBits = min(maxBits, uint(numFlagPlanes()));
+    uint mask = 1u << uint(gridPos.x % 32);
 
-    for (uint bit = 0; bit < min(maxBits, 32); bit++)
+    for (uint bit = 0; bit < numBits; bit++)
     {
-        bool bitIsSet = bool(bitfield.r & (1 << bit));
-        result[bit] = (bitIsSet ? 1. : 0.);
+        uint bitfieldPart = texelFetch(
+                    flagsVolume,
+                    flagTexelCoord(gridPos, int(bit), tilesX), 0).r;
+        result[bit] = (bool(bitfieldPart & mask) ? 1. : 0.);
     }
-    for (uint bit = 32; bit < min(maxBits, 64); bit++)
+    for (uint bit = numBits; bit < maxBits; bit++)
     {
-        bool bitIsSet = bool(bitfield.g & (1 << (bit-32)));
-        result[bit] = (bitIsSet ? 1. : 0.);
+        result[bit] = 0.;
     }
 
     return result;
@@ -205,6 +205,13 @@ public:
      */
     void switchToBoundingBox(QString bBoxName);
 
+    /**
+      Returns the connection to the bounding box (used e.g. by request
+      properties that restrict data requests to the bounding box).
+     */
+    MBoundingBoxConnection *getBoundingBoxConnection()
+    { return bBoxConnection; }
+
 protected:
     /**
       Use this method to insert bounding box property as subproperty of @p parentGroup.
@@ -237,6 +244,7 @@ public:
     MBoundingBox *getBoundingBox() { return boundingBox; }
     QtProperty *getProperty() { return bBoxProperty; }
     MBoundingBoxInterface *getActor() { return actor; }
+    MBoundingBoxConnectionType getType() { return type; }
 
     // Methods to access bounding box coordinates.
 
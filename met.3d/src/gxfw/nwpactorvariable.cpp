@@ -3305,6 +3305,8 @@ void MNWP2DHorizontalActorVariable::updateContourIndicesFromTargetGrid(
     textureTargetGrid->bindToLastTextureUnit();
     glGetTexImage(GL_TEXTURE_2D, 0, GL_RED, GL_FLOAT,
                   targetGrid2D->data); CHECK_GL_ERROR;
+    // The grid is reused for every update; drop its cached min/max.
+    targetGrid2D->invalidateStatistics();
 
     // Set the current isovalue to the target grid's vertical coordinate.
     targetGrid2D->levels[0] = slicePosition_hPa;
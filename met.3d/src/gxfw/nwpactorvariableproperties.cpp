@@ -43,6 +43,8 @@
 #include "gxfw/mglresourcesmanager.h"
 #include "gxfw/nwpactorvariable.h"
 #include "gxfw/nwpmultivaractor.h"
+#include "gxfw/boundingbox/boundingbox.h"
+#include "data/structuredgrid.h"
 
 using namespace std;
 
@@ -88,6 +90,11 @@ void MRequestPropertiesFactory::updateProperties(
                 QStringList() << "REGRID",
                 propertiesList, keysRequiredByPipeline);
 
+    // MSubDomainProperties
+    updateTypedProperties<MSubDomainProperties>(
+                QStringList() << "SUBDOMAIN",
+                propertiesList, keysRequiredByPipeline);
+
     // MTrajectoryFilterProperties
     updateTypedProperties<MTrajectoryFilterProperties>(
                 QStringList() << "FILTER_PRESSURE_TIME" << "TRY_PRECOMPUTED"
@@ -340,6 +347,142 @@ void MVerticalRegridProperties::loadConfiguration(QSettings *settings)
 }
 
 
+/******************************************************************************
+***                        MSubDomainProperties                             ***
+*******************************************************************************/
+/******************************************************************************
+***                     CONSTRUCTOR / DESTRUCTOR                            ***
+*******************************************************************************/
+
+MSubDomainProperties::MSubDomainProperties(MNWPActorVariable *actorVar)
+    : MRequestProperties(actorVar),
+      restrictToBoundingBox(false)
+{
+    MNWPMultiVarActor *a = actorVar->getActor();
+    MQtProperties *properties = a->getQtProperties();
+
+    // Create and initialise QtProperties for the GUI.
+    // ===============================================
+    a->beginInitialiseQtProperties();
+
+    QtProperty *groupProperty = actorVar->getPropertyGroup("sub-domain");
+
+    restrictToBoundingBoxProperty = a->addProperty(
+                BOOL_PROPERTY, "restrict to bounding box", groupProperty);
+    properties->mBool()->setValue(restrictToBoundingBoxProperty,
+                                  restrictToBoundingBox);
+    restrictToBoundingBoxProperty->setToolTip(
+                "Only read and process the data inside the actor's bounding "
+                "box (plus the halo required by filters).");
+
+    a->endInitialiseQtProperties();
+}
+
+
+MSubDomainProperties::~MSubDomainProperties()
+{
+}
+
+
+/******************************************************************************
+***                            PUBLIC METHODS                               ***
+*******************************************************************************/
+
+bool MSubDomainProperties::onQtPropertyChanged(
+        QtProperty *property, bool *redrawWithoutDataRequest)
+{
+    Q_UNUSED(redrawWithoutDataRequest);
+
+    if (property == restrictToBoundingBoxProperty)
+    {
+        MQtProperties *properties = actorVariable->getActor()->getQtProperties();
+        restrictToBoundingBox =
+                properties->mBool()->value(restrictToBoundingBoxProperty);
+
+        if (actorVariable->getActor()->suppressActorUpdates()) return false;
+        actorVariable->triggerAsynchronousDataRequest(true);
+    }
+
+    return false;
+}
+
+
+void MSubDomainProperties::addToRequest(MDataRequestHelper *rh)
+{
+    if (!restrictToBoundingBox) return;
+
+    MBoundingBoxInterface *bBoxActor =
+            dynamic_cast<MBoundingBoxInterface*>(actorVariable->getActor());
+    if (bBoxActor == nullptr) return;
+
+    MBoundingBoxConnection *bBoxConnection =
+            bBoxActor->getBoundingBoxConnection();
+    if (bBoxConnection == nullptr
+            || bBoxConnection->getBoundingBox() == nullptr)
+    {
+        return;
+    }
+
+    MSubDomain subDomain;
+    if (bBoxConnection->getType() == MBoundingBoxConnectionType::VERTICAL)
+    {
+        // Vertical sections only use the vertical extent of the bounding
+        // box; their waypoints can be located anywhere.
+        subDomain.westLon = -180.;
+        subDomain.southLat = -90.;
+        subDomain.eastLon = 180.;
+        subDomain.northLat = 90.;
+    }
+    else
+    {
+        subDomain.westLon = bBoxConnection->westLon();
+        subDomain.southLat = bBoxConnection->southLat();
+        subDomain.eastLon = bBoxConnection->eastLon();
+        subDomain.northLat = bBoxConnection->northLat();
+    }
+
+    if (bBoxConnection->getType() != MBoundingBoxConnectionType::HORIZONTAL)
+    {
+        subDomain.bottomPressure_hPa = bBoxConnection->bottomPressure_hPa();
+        subDomain.topPressure_hPa = bBoxConnection->topPressure_hPa();
+    }
+
+    subDomain.valid = true;
+    rh->insert("SUBDOMAIN", subDomain.toRequestValue());
+}
+
+
+void MSubDomainProperties::actorPropertyChangeEvent(
+        MPropertyType::ChangeNotification ptype, void *value)
+{
+    Q_UNUSED(value);
+
+    if (ptype == MPropertyType::BoundingBox && restrictToBoundingBox)
+    {
+        actorVariable->triggerAsynchronousDataRequest(true);
+    }
+}
+
+
+void MSubDomainProperties::saveConfiguration(QSettings *settings)
+{
+    settings->beginGroup("SubDomain");
+    settings->setValue("restrictToBoundingBox", restrictToBoundingBox);
+    settings->endGroup();
+}
+
+
+void MSubDomainProperties::loadConfiguration(QSettings *settings)
+{
+    MQtProperties *properties = actorVariable->getActor()->getQtProperties();
+    settings->beginGroup("SubDomain");
+    properties->mBool()->setValue(
+                restrictToBoundingBoxProperty,
+                settings->value("restrictToBoundingBox", false).toBool());
+    settings->endGroup();
+}
+
+
 /******************************************************************************
 ***                     MTrajectoryFilterProperties                         ***
 *******************************************************************************/
@@ -1459,6 +1602,11 @@ MGradientProperties::GradientModeTypes MGradientProperties::stringToGradientMode
     {
         return DLAT_SOBEL;
     }
+    else if (gradientModeName
+             == "\u03B4\u03C8/\u03B4p+\u03B4\u00B2\u03C8/\u03B4p\u00B2")
+    {
+        return DP_D2P;
+    }
     else
     {
         return DISABLE_FILTER;
@@ -1484,6 +1632,7 @@ QString MGradientProperties::gradientModeToString(
         case D2Z: return "\u03B4\u00B2\u03C8/\u03B4z\u00B2";
         case DLON_SOBEL: return "\u03B4\u03C8/\u03B4lon_sobel";
         case DLAT_SOBEL: return "\u03B4\u03C8/\u03B4lat_sobel";
+        case DP_D2P: return "\u03B4\u03C8/\u03B4p+\u03B4\u00B2\u03C8/\u03B4p\u00B2";
     }
     return "disabled";
 }
@@ -47,7 +47,8 @@ class MNWPActorVariable;
 
 struct MPropertyType
 {
-    enum ChangeNotification { IsoValue = 0, VerticalRegrid = 1 };
+    enum ChangeNotification { IsoValue = 0, VerticalRegrid = 1,
+                              BoundingBox = 2 };
 };
 
 
@@ -156,6 +157,32 @@ protected:
 };
 
 
+/**
+  Restriction of the requested data to the bounding box of the actor
+  (request key SUBDOMAIN, see @ref MSubDomain).
+ */
+class MSubDomainProperties : public MRequestProperties
+{
+public:
+    MSubDomainProperties(MNWPActorVariable *actorVar);
+    ~MSubDomainProperties();
+    bool onQtPropertyChanged(QtProperty *property,
+                             bool *redrawWithoutDataRequest);
+    void addToRequest(MDataRequestHelper *rh);
+
+    void actorPropertyChangeEvent(
+            MPropertyType::ChangeNotification ptype, void *value);
+
+    void saveConfiguration(QSettings *settings);
+
+    void loadConfiguration(QSettings *settings);
+
+protected:
+    QtProperty *restrictToBoundingBoxProperty;
+    bool        restrictToBoundingBox;
+};
+
+
 /**
   Trajectory filtering.
  */
@@ -385,7 +412,10 @@ public:
         D2P = 9,
         D2Z = 10,
         DLON_SOBEL = 11,
-        DLAT_SOBEL = 12
+        DLAT_SOBEL = 12,
+        // Pipeline-internal: d/dp and d2/dp2 in one pass; the returned grid
+        // is d2/dp2, d/dp is its MStructuredGrid::getCompanionGrid().
+        DP_D2P = 13
     } GradientModeTypes;
     /**
      * @brief smoothModeToString this method converts the smooth mode from
@@ -35,6 +35,7 @@
 #include "util/mutil.h"
 #include "data/scheduler.h"
 #include "data/lrumemorymanager.h"
+#include "data/persistentdatacache.h"
 #include "gxfw/msystemcontrol.h"
 #include "mainwindow.h"
 #include "gxfw/synccontrol.h"
@@ -234,6 +235,10 @@ void MFrontendConfiguration::initializeFrontendFromConfigFile(
 
     sysMC->setMet3DWorkingDirectory(met3DWorkingDirectory);
 
+    MPersistentDataCache::getInstance()->setCacheDirectory(
+                expandEnvironmentVariables(
+                    config.value("persistentCacheDirectory", "").toString()));
+
     config.endGroup();
 
     // Initialize session manager.
@@ -72,6 +72,9 @@
 #include "fronts/frontlocationequationsource.h"
 #include "fronts/vectormagnitudesource.h"
 #include "fronts/gradvecmagpipelinefilter.h"
+#include "tropopause/tropopausedatasource.h"
+#include "tropopause/tropopausecolumnsource.h"
+#include "tropopause/tropopauseensemblesource.h"
 
 
 namespace Met3D
@@ -400,6 +403,8 @@ void MPipelineConfiguration::initializeDataPipelineFromConfigFile(
                 config.value("disableGridConsistencyCheck", "").toBool();
         QString inputVarsForDerivedVars =
                 config.value("inputVarsForDerivedVars", "").toString();
+        QString cachedDataPrecisionStr =
+                config.value("cachedDataPrecision", "FLOAT32").toString();
 
 //TODO (mr, 16Dec2015) -- compatibility code; remove in Met.3D version 2.0
         // If no fileFilter is specified but a domainID is specified use
@@ -440,6 +445,8 @@ void MPipelineConfiguration::initializeDataPipelineFromConfigFile(
                             ? "enabled" : "disabled"));
         LOG4CPLUS_DEBUG(mlog, "  input variables for derived variables="
                         << inputVarsForDerivedVars.toStdString());
+        LOG4CPLUS_DEBUG(mlog, "  cached data precision="
+                        << cachedDataPrecisionStr.toStdString());
 
         MNWPReaderFileFormat fileFormat = INVALID_FORMAT;
         if (fileFormatStr == "CF_NETCDF") fileFormat = CF_NETCDF;
@@ -450,6 +457,9 @@ void MPipelineConfiguration::initializeDataPipelineFromConfigFile(
         QStringList validGribSurfacePressureFieldTypes;
         validGribSurfacePressureFieldTypes << "auto" << "sp" << "lnsp";
 
+        QStringList validCachedDataPrecisions;
+        validCachedDataPrecisions << "FLOAT32" << "FLOAT16" << "SCALED_INT16";
+
         // Check parameter validity.
         if ( name.isEmpty()
              || path.isEmpty()
@@ -457,7 +467,8 @@ void MPipelineConfiguration::initializeDataPipelineFromConfigFile(
              || memoryManagerID.isEmpty()
              || (fileFormat == INVALID_FORMAT)
              || (fileFormat == ECMWF_GRIB && !validGribSurfacePressureFieldTypes
-                 .contains(gribSurfacePressureFieldType)))
+                 .contains(gribSurfacePressureFieldType))
+             || !validCachedDataPrecisions.contains(cachedDataPrecisionStr))
         {
             LOG4CPLUS_WARN(mlog, "invalid parameters encountered; skipping.");
             continue;
@@ -472,7 +483,9 @@ void MPipelineConfiguration::initializeDataPipelineFromConfigFile(
                     gribSurfacePressureFieldType,
                     convertGeometricHeightToPressure_ICAOStandard,
                     auxiliary3DPressureField, disableGridConsistencyCheck,
-                    inputVarsForDerivedVars);
+                    inputVarsForDerivedVars,
+                    MStructuredGrid::storagePrecisionFromConfigString(
+                        cachedDataPrecisionStr));
     }
 
     config.endArray();
@@ -689,14 +702,21 @@ void MPipelineConfiguration::initializeNWPPipeline(
         bool convertGeometricHeightToPressure_ICAOStandard,
         QString auxiliary3DPressureField,
         bool disableGridConsistencyCheck,
-        QString inputVarsForDerivedVars)
+        QString inputVarsForDerivedVars,
+        MGridStoragePrecision cachedDataPrecision)
 {
     const QString dataSourceId = name;
     const QString dataSourceIdDerived = dataSourceId + " derived";
+    const QString dataSourceIdTropopause = dataSourceId + " tropopause";
+    const QString dataSourceIdTropopauseColumns =
+            dataSourceIdTropopause + " columns";
 
     QStringList dataSourceIDs = QStringList()
             << (dataSourceId + QString(" ENSFilter"))
-            << dataSourceIdDerived + QString(" ENSFilter");
+            << dataSourceIdDerived + QString(" ENSFilter")
+            << dataSourceIdTropopause + QString(" ENSFilter")
+            << dataSourceIdTropopause + QString(" ENSStatistics")
+            << dataSourceIdTropopauseColumns + QString(" ENSFilter");
 
     if (enableProbabiltyRegionFilter)
     {
@@ -737,6 +757,7 @@ void MPipelineConfiguration::initializeNWPPipeline(
     nwpReaderENS->setMemoryManager(memoryManager);
     nwpReaderENS->setScheduler(scheduler);
     nwpReaderENS->setDataRoot(fileDir, fileFilter);
+    nwpReaderENS->setCachedStoragePrecision(cachedDataPrecision);
 
     MSmoothFilter *smoothFilter = new MSmoothFilter();
     smoothFilter->setMemoryManager(memoryManager);
@@ -813,6 +834,7 @@ void MPipelineConfiguration::initializeNWPPipeline(
             new MStructuredGridEnsembleFilter();
     ensFilter->setMemoryManager(memoryManager);
     ensFilter->setScheduler(scheduler);
+    ensFilter->setCachedStoragePrecision(cachedDataPrecision);
 
     if (!enableRegridding)
     {
@@ -859,11 +881,13 @@ void MPipelineConfiguration::initializeNWPPipeline(
             new MDerivedMetVarsDataSource();
     derivedMetVarsSource->setMemoryManager(memoryManager);
     derivedMetVarsSource->setScheduler(scheduler);
+    derivedMetVarsSource->setCachedStoragePrecision(cachedDataPrecision);
     derivedMetVarsSource->setInputSource(nwpReaderENS);
 
     QStringList derivedVarsMappingList =
             inputVarsForDerivedVars.split("/", QString::SkipEmptyParts);
 
+    QString temperatureVariableName;
     foreach (QString derivedVarsMappingString, derivedVarsMappingList)
     {
         QStringList derivedVarsMapping =
@@ -872,6 +896,11 @@ void MPipelineConfiguration::initializeNWPPipeline(
         {
             derivedMetVarsSource->setInputVariable(
                         derivedVarsMapping.at(0), derivedVarsMapping.at(1));
+
+            if (derivedVarsMapping.at(0) == "air_temperature")
+            {
+                temperatureVariableName = derivedVarsMapping.at(1);
+            }
         }
     }
 
@@ -932,6 +961,7 @@ void MPipelineConfiguration::initializeNWPPipeline(
             new MStructuredGridEnsembleFilter();
     ensFilterDerived->setMemoryManager(memoryManager);
     ensFilterDerived->setScheduler(scheduler);
+    ensFilterDerived->setCachedStoragePrecision(cachedDataPrecision);
 
     if (!enableRegridding)
     {
@@ -969,6 +999,59 @@ void MPipelineConfiguration::initializeNWPPipeline(
                                   probRegDetectorNWPDerived);
     }
 
+    // Pipeline for 2D tropopause fields (requires the temperature variable
+    // to be specified in the derived variables mapping).
+    // =====================================================================
+
+    if (!temperatureVariableName.isEmpty())
+    {
+        MTropopauseDataSource *tropopauseSource = new MTropopauseDataSource();
+        tropopauseSource->setMemoryManager(memoryManager);
+        tropopauseSource->setScheduler(scheduler);
+        tropopauseSource->setInputSource(nwpReaderENS);
+        tropopauseSource->setInputVariable(temperatureVariableName);
+
+        MStructuredGridEnsembleFilter *ensFilterTropopause =
+                new MStructuredGridEnsembleFilter();
+        ensFilterTropopause->setMemoryManager(memoryManager);
+        ensFilterTropopause->setScheduler(scheduler);
+        ensFilterTropopause->setInputSource(tropopauseSource);
+
+        sysMC->registerDataSource(dataSourceIdTropopause + QString(" ENSFilter"),
+                                  ensFilterTropopause);
+
+        // Mean, spread and probabilities of all selected members computed
+        // in a single pass with the members processed concurrently.
+        MTropopauseEnsembleSource *ensStatisticsTropopause =
+                new MTropopauseEnsembleSource();
+        ensStatisticsTropopause->setMemoryManager(memoryManager);
+        ensStatisticsTropopause->setScheduler(scheduler);
+        ensStatisticsTropopause->setInputSource(tropopauseSource);
+
+        sysMC->registerDataSource(
+                    dataSourceIdTropopause + QString(" ENSStatistics"),
+                    ensStatisticsTropopause);
+
+        // Multiple tropopauses and tropopause folds, computed in a single
+        // sweep over the temperature columns.
+        MTropopauseColumnSource *tropopauseColumnSource =
+                new MTropopauseColumnSource();
+        tropopauseColumnSource->setMemoryManager(memoryManager);
+        tropopauseColumnSource->setScheduler(scheduler);
+        tropopauseColumnSource->setInputSource(nwpReaderENS);
+        tropopauseColumnSource->setInputVariable(temperatureVariableName);
+
+        MStructuredGridEnsembleFilter *ensFilterTropopauseColumns =
+                new MStructuredGridEnsembleFilter();
+        ensFilterTropopauseColumns->setMemoryManager(memoryManager);
+        ensFilterTropopauseColumns->setScheduler(scheduler);
+        ensFilterTropopauseColumns->setInputSource(tropopauseColumnSource);
+
+        sysMC->registerDataSource(
+                    dataSourceIdTropopauseColumns + QString(" ENSFilter"),
+                    ensFilterTropopauseColumns);
+    }
+
     LOG4CPLUS_DEBUG(mlog, "Pipeline ''" << dataSourceId.toStdString()
                     << "'' has been initialized.");
 }
@@ -163,7 +163,9 @@ protected:
                                bool convertGeometricHeightToPressure_ICAOStandard,
                                QString auxiliary3DPressureField,
                                bool disableGridConsistencyCheck,
-                               QString inputVarsForDerivedVars);
+                               QString inputVarsForDerivedVars,
+                               MGridStoragePrecision cachedDataPrecision
+                               = FLOAT32_STORAGE);
 
     void initializePrecomputedTrajectoriesPipeline(
             QString name,
@@ -0,0 +1,450 @@
+/******************************************************************************
+**
+**  This file is part of Met.3D -- a research environment for the
+**  three-dimensional visual exploration of numerical ensemble weather
+**  prediction data.
+**
+**  Copyright 2015-2020 Marc Rautenhaus
+**  Copyright 2022      Julian Münsterberg
+**
+**  Regional Computing Center, Visualization
+**  Universitaet Hamburg, Hamburg, Germany
+**
+**  Met.3D is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Met.3D is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Met.3D.  If not, see <http://www.gnu.org/licenses/>.
+**
+*******************************************************************************/
+#include "tropopausecolumnsource.h"
+
+// standard library imports
+#include "assert.h"
+#include <chrono>
+
+// related third party imports
+#include <log4cplus/loggingmacros.h>
+#include <omp.h>
+
+// local application imports
+#include "util/mutil.h"
+#include "util/mexception.h"
+#include "util/metroutines.h"
+
+#define MEASURE_CPU_TIME
+
+using namespace std;
+
+namespace Met3D
+{
+
+/******************************************************************************
+***                     CONSTRUCTOR / DESTRUCTOR                            ***
+*******************************************************************************/
+
+MTropopauseColumnSource::MTropopauseColumnSource()
+    : MSingleInputProcessingWeatherPredictionDataSource()
+{
+}
+
+
+/******************************************************************************
+***                            PUBLIC METHODS                               ***
+*******************************************************************************/
+
+MStructuredGrid* MTropopauseColumnSource::produceData(MDataRequest request)
+{
+    assert(inputSource != nullptr);
+
+#ifdef MEASURE_CPU_TIME
+    auto start = std::chrono::system_clock::now();
+#endif
+
+    MDataRequestHelper rh(request);
+
+    int requestedRank = 0;
+    const int requestedField =
+            stringToColumnField(rh.value("VARIABLE"), &requestedRank);
+
+    if (requestedField < 0
+            || MVerticalLevelType(rh.intValue("LEVELTYPE")) != SURFACE_2D)
+    {
+        QString msg = QString("Variable %1 is not provided by the tropopause "
+                              "column data source.").arg(rh.value("VARIABLE"));
+        LOG4CPLUS_ERROR(mlog, msg.toStdString());
+        throw MBadDataFieldRequest(msg.toStdString(), __FILE__, __LINE__);
+    }
+
+    // Pressure range in which tropopauses are searched for (cf.
+    // MTropopauseFieldSource). The default upper bound is higher than for
+    // the primary tropopause to include secondary tropopauses above the
+    // subtropical jet.
+    const float searchBottom_hPa = rh.contains("TROPOPAUSE_SEARCH_BOTTOM")
+            ? rh.floatValue("TROPOPAUSE_SEARCH_BOTTOM") : 550.;
+    const float searchTop_hPa = rh.contains("TROPOPAUSE_SEARCH_TOP")
+            ? rh.floatValue("TROPOPAUSE_SEARCH_TOP") : 50.;
+
+    if (searchTop_hPa >= searchBottom_hPa)
+    {
+        QString msg = QString("Invalid tropopause search range %1-%2 hPa.")
+                .arg(searchBottom_hPa).arg(searchTop_hPa);
+        LOG4CPLUS_ERROR(mlog, msg.toStdString());
+        throw MBadDataFieldRequest(msg.toStdString(), __FILE__, __LINE__);
+    }
+
+    MStructuredGrid *temperatureGrid =
+            inputSource->getData(inputRequest(request));
+
+    // Per-layer grids, indexed by [field][rank], and per-column grids.
+    MRegularLonLatGrid *layerGrids[TEMPERATURE + 1][MAX_TROPOPAUSES];
+    for (int f = PRESSURE; f <= TEMPERATURE; f++)
+    {
+        for (int r = 0; r < MAX_TROPOPAUSES; r++)
+        {
+            layerGrids[f][r] = createHorizontalResultGrid(
+                        temperatureGrid,
+                        columnFieldToString(ColumnField(f), r));
+        }
+    }
+    MRegularLonLatGrid *countGrid = createHorizontalResultGrid(
+                temperatureGrid, columnFieldToString(NUM_TROPOPAUSES));
+    MRegularLonLatGrid *foldGrid = createHorizontalResultGrid(
+                temperatureGrid, columnFieldToString(FOLD));
+
+    const int nLev = temperatureGrid->getNumLevels();
+    const int nLat = temperatureGrid->getNumLats();
+    const int nLon = temperatureGrid->getNumLons();
+
+#pragma omp parallel
+    {
+        // Per-thread column buffers, ordered from the bottom upwards.
+        QVector<float> p_hPa(nLev);
+        QVector<float> T_K(nLev);
+        QVector<float> z_m(nLev);
+        float pTrop_hPa[MAX_TROPOPAUSES];
+        float zTrop_m[MAX_TROPOPAUSES];
+        float TTrop_K[MAX_TROPOPAUSES];
+
+#pragma omp for collapse(2)
+        for (int j = 0; j < nLat; j++)
+        {
+            for (int i = 0; i < nLon; i++)
+            {
+                const bool topDown = temperatureGrid->getPressure(0, j, i)
+                        < temperatureGrid->getPressure(nLev - 1, j, i);
+
+                for (int k = 0; k < nLev; k++)
+                {
+                    const int kGrid = topDown ? nLev - 1 - k : k;
+                    p_hPa[k] = temperatureGrid->getPressure(kGrid, j, i);
+                    T_K[k] = temperatureGrid->getValue(kGrid, j, i);
+                }
+
+                hypsometricColumnHeights_m(p_hPa.constData(), T_K.constData(),
+                                           nLev, z_m.data());
+
+                const int numTropopauses = wmoMultipleTropopauses(
+                            p_hPa.constData(), T_K.constData(),
+                            z_m.constData(), nLev,
+                            searchBottom_hPa, searchTop_hPa,
+                            MAX_TROPOPAUSES, pTrop_hPa, zTrop_m, TTrop_K);
+
+                const bool fold = isTropopauseFoldColumn(
+                            p_hPa.constData(), T_K.constData(),
+                            z_m.constData(), nLev, searchBottom_hPa,
+                            numTropopauses > 0 ? zTrop_m[0]
+                                               : M_MISSING_VALUE);
+
+                for (int r = 0; r < MAX_TROPOPAUSES; r++)
+                {
+                    const bool found = r < numTropopauses;
+                    layerGrids[PRESSURE][r]->setValue(
+                                j, i, found ? pTrop_hPa[r] : M_MISSING_VALUE);
+                    layerGrids[HEIGHT][r]->setValue(
+                                j, i, found ? zTrop_m[r] : M_MISSING_VALUE);
+                    layerGrids[TEMPERATURE][r]->setValue(
+                                j, i, found ? TTrop_K[r] : M_MISSING_VALUE);
+                }
+                countGrid->setValue(j, i, numTropopauses);
+                foldGrid->setValue(j, i, fold ? 1. : 0.);
+            }
+        }
+    }
+
+    inputSource->releaseData(temperatureGrid);
+
+    // Return the requested grid and cache all others.
+    MStructuredGrid *result = nullptr;
+    for (int f = PRESSURE; f <= FOLD; f++)
+    {
+        const int numFieldRanks = (f <= TEMPERATURE) ? MAX_TROPOPAUSES : 1;
+        for (int r = 0; r < numFieldRanks; r++)
+        {
+            MStructuredGrid *grid = (f == NUM_TROPOPAUSES) ? countGrid
+                    : (f == FOLD) ? foldGrid : layerGrids[f][r];
+
+            if (f == requestedField && r == requestedRank)
+            {
+                result = grid;
+            }
+            else
+            {
+                rh.insert("VARIABLE", columnFieldToString(ColumnField(f), r));
+                storeAdditionalResult(grid, rh.request());
+            }
+        }
+    }
+
+#ifdef MEASURE_CPU_TIME
+    auto end = std::chrono::system_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                end - start);
+    LOG4CPLUS_DEBUG(mlog, "Multiple tropopause column sweep done in "
+                    << elapsed.count() << "ms");
+#endif
+
+    return result;
+}
+
+
+MTask* MTropopauseColumnSource::createTaskGraph(MDataRequest request)
+{
+    assert(inputSource != nullptr);
+
+    MTask *task = new MTask(request, this);
+    task->addParent(inputSource->getTaskGraph(inputRequest(request)));
+
+    return task;
+}
+
+
+void MTropopauseColumnSource::setInputSource(MWeatherPredictionDataSource* s)
+{
+    if (inputSource != s) deregisterInputSource(inputSource);
+    inputSource = s;
+    registerInputSource(inputSource);
+}
+
+
+void MTropopauseColumnSource::setInputVariable(
+        QString temperatureVariableName)
+{
+    this->temperatureVariableName = temperatureVariableName;
+}
+
+
+QList<MVerticalLevelType> MTropopauseColumnSource::availableLevelTypes()
+{
+    QList<MVerticalLevelType> levelTypes;
+    if (inputLevelType() != SIZE_LEVELTYPES)
+    {
+        levelTypes << SURFACE_2D;
+    }
+    return levelTypes;
+}
+
+
+QStringList MTropopauseColumnSource::availableVariables(
+        MVerticalLevelType levelType)
+{
+    QStringList variables;
+    if (levelType == SURFACE_2D && inputLevelType() != SIZE_LEVELTYPES)
+    {
+        for (int f = PRESSURE; f <= FOLD; f++)
+        {
+            const int numFieldRanks =
+                    (f <= TEMPERATURE) ? MAX_TROPOPAUSES : 1;
+            for (int r = 0; r < numFieldRanks; r++)
+            {
+                variables << columnFieldToString(ColumnField(f), r);
+            }
+        }
+    }
+    return variables;
+}
+
+
+QSet<unsigned int> MTropopauseColumnSource::availableEnsembleMembers(
+        MVerticalLevelType levelType, const QString& variableName)
+{
+    assert(inputSource != nullptr);
+
+    int rank;
+    if (levelType != SURFACE_2D
+            || stringToColumnField(variableName, &rank) < 0)
+    {
+        return QSet<unsigned int>();
+    }
+    return inputSource->availableEnsembleMembers(inputLevelType(),
+                                                 temperatureVariableName);
+}
+
+
+QList<QDateTime> MTropopauseColumnSource::availableInitTimes(
+        MVerticalLevelType levelType, const QString& variableName)
+{
+    assert(inputSource != nullptr);
+
+    int rank;
+    if (levelType != SURFACE_2D
+            || stringToColumnField(variableName, &rank) < 0)
+    {
+        return QList<QDateTime>();
+    }
+    return inputSource->availableInitTimes(inputLevelType(),
+                                           temperatureVariableName);
+}
+
+
+QList<QDateTime> MTropopauseColumnSource::availableValidTimes(
+        MVerticalLevelType levelType, const QString& variableName,
+        const QDateTime& initTime)
+{
+    assert(inputSource != nullptr);
+
+    int rank;
+    if (levelType != SURFACE_2D
+            || stringToColumnField(variableName, &rank) < 0)
+    {
+        return QList<QDateTime>();
+    }
+    return inputSource->availableValidTimes(inputLevelType(),
+                                            temperatureVariableName, initTime);
+}
+
+
+QString MTropopauseColumnSource::variableLongName(
+        MVerticalLevelType levelType, const QString& variableName)
+{
+    Q_UNUSED(levelType);
+    return QString("%1 (WMO multiple tropopauses), computed from %2").arg(
+                variableName).arg(temperatureVariableName);
+}
+
+
+QString MTropopauseColumnSource::variableStandardName(
+        MVerticalLevelType levelType, const QString& variableName)
+{
+    Q_UNUSED(levelType);
+
+    int rank;
+    int field = stringToColumnField(variableName, &rank);
+    if (field >= PRESSURE && field <= TEMPERATURE)
+    {
+        // Names of all layers are derived from the CF standard names.
+        return columnFieldToString(ColumnField(field));
+    }
+    return QString();
+}
+
+
+QString MTropopauseColumnSource::variableUnits(
+        MVerticalLevelType levelType, const QString& variableName)
+{
+    Q_UNUSED(levelType);
+
+    int rank;
+    int field = stringToColumnField(variableName, &rank);
+    if (field >= PRESSURE && field <= TEMPERATURE)
+    {
+        return MTropopauseFieldSource::tropopauseFieldUnits(
+                    MTropopauseFieldSource::TropopauseField(field));
+    }
+    return QString();
+}
+
+
+QString MTropopauseColumnSource::columnFieldToString(ColumnField field,
+                                                     int rank)
+{
+    switch (field)
+    {
+    case PRESSURE:
+    case HEIGHT:
+    case TEMPERATURE:
+    {
+        QString name = MTropopauseFieldSource::tropopauseFieldToString(
+                    MTropopauseFieldSource::TropopauseField(field));
+        return (rank == 0) ? name : QString("%1_%2").arg(name).arg(rank + 1);
+    }
+    case NUM_TROPOPAUSES:
+        return "number_of_tropopauses";
+    case FOLD:
+        return "tropopause_fold_flag";
+    }
+    return "";
+}
+
+
+int MTropopauseColumnSource::stringToColumnField(const QString& variableName,
+                                                 int *rank)
+{
+    for (int f = PRESSURE; f <= FOLD; f++)
+    {
+        const int numFieldRanks = (f <= TEMPERATURE) ? MAX_TROPOPAUSES : 1;
+        for (int r = 0; r < numFieldRanks; r++)
+        {
+            if (variableName == columnFieldToString(ColumnField(f), r))
+            {
+                *rank = r;
+                return f;
+            }
+        }
+    }
+    return -1;
+}
+
+
+/******************************************************************************
+***                          PROTECTED METHODS                              ***
+*******************************************************************************/
+
+const QStringList MTropopauseColumnSource::locallyRequiredKeys()
+{
+    return (QStringList() << "LEVELTYPE" << "VARIABLE"
+            << "TROPOPAUSE_SEARCH_BOTTOM" << "TROPOPAUSE_SEARCH_TOP");
+}
+
+
+MDataRequest MTropopauseColumnSource::inputRequest(MDataRequest request)
+{
+    MDataRequestHelper rh(request);
+    rh.remove("TROPOPAUSE_SEARCH_BOTTOM");
+    rh.remove("TROPOPAUSE_SEARCH_TOP");
+    rh.insert("LEVELTYPE", inputLevelType());
+    rh.insert("VARIABLE", temperatureVariableName);
+    return rh.request();
+}
+
+
+MVerticalLevelType MTropopauseColumnSource::inputLevelType()
+{
+    assert(inputSource != nullptr);
+
+    QList<MVerticalLevelType> inputLevelTypes =
+            inputSource->availableLevelTypes();
+
+    const MVerticalLevelType preferredLevelTypes[] = {
+        HYBRID_SIGMA_PRESSURE_3D, AUXILIARY_PRESSURE_3D, PRESSURE_LEVELS_3D };
+
+    for (MVerticalLevelType levelType : preferredLevelTypes)
+    {
+        if (inputLevelTypes.contains(levelType)
+                && inputSource->availableVariables(levelType).contains(
+                    temperatureVariableName))
+        {
+            return levelType;
+        }
+    }
+    return SIZE_LEVELTYPES;
+}
+
+} // namespace Met3D
@@ -0,0 +1,154 @@
+/******************************************************************************
+**
+**  This file is part of Met.3D -- a research environment for the
+**  three-dimensional visual exploration of numerical ensemble weather
+**  prediction data.
+**
+**  Copyright 2015-2020 Marc Rautenhaus
+**  Copyright 2022      Julian Münsterberg
+**
+**  Regional Computing Center, Visualization
+**  Universitaet Hamburg, Hamburg, Germany
+**
+**  Met.3D is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Met.3D is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Met.3D.  If not, see <http://www.gnu.org/licenses/>.
+**
+*******************************************************************************/
+#ifndef MET_3D_TROPOPAUSECOLUMNSOURCE_H
+#define MET_3D_TROPOPAUSECOLUMNSOURCE_H
+
+// standard library imports
+
+// related third party imports
+#include <QtCore>
+
+// local application imports
+#include "data/processingwpdatasource.h"
+#include "data/structuredgrid.h"
+#include "data/datarequest.h"
+#include "tropopause/tropopausefieldsource.h"
+
+namespace Met3D
+{
+
+/**
+  @brief MTropopauseColumnSource finds all thermal tropopauses of each grid
+  column of a three-dimensional temperature field (WMO definition of
+  multiple tropopauses, see @ref wmoMultipleTropopauses()) and detects
+  tropopause folds below the primary tropopause (see @ref
+  isTropopauseFoldColumn()).
+
+  All results are computed in a single parallel sweep over the columns. As
+  @ref MTropopauseDataSource, the source publishes them as regular 2D
+  variables (level type SURFACE_2D) computed from the 3D temperature variable
+  set with @ref setInputVariable(); the variable names are returned by @ref
+  columnFieldToString(). Layers not present in a column are set to
+  M_MISSING_VALUE. The fields not requested are placed in the memory manager
+  as well.
+
+  The pressure range in which tropopauses are searched for can be set with
+  the optional request keys "TROPOPAUSE_SEARCH_BOTTOM" and
+  "TROPOPAUSE_SEARCH_TOP" (hPa; default 550 and 50 hPa).
+ */
+class MTropopauseColumnSource
+        : public MSingleInputProcessingWeatherPredictionDataSource
+{
+public:
+    enum ColumnField {
+        // Per-layer fields (one variable per tropopause layer).
+        PRESSURE        = MTropopauseFieldSource::PRESSURE,    // hPa
+        HEIGHT          = MTropopauseFieldSource::HEIGHT,      // m
+        TEMPERATURE     = MTropopauseFieldSource::TEMPERATURE, // K
+        // Per-column fields.
+        NUM_TROPOPAUSES = 3,   // number of tropopauses found in the column
+        FOLD            = 4    // 1 if the column is folded, 0 otherwise
+    };
+
+    /** Number of tropopause layers that are detected per column. */
+    static const int MAX_TROPOPAUSES = 3;
+
+    MTropopauseColumnSource();
+
+    MStructuredGrid* produceData(MDataRequest request) override;
+
+    MTask* createTaskGraph(MDataRequest request) override;
+
+    /**
+      Request pass-through is disabled; requests for the temperature field
+      are constructed by this source.
+     */
+    void setInputSource(MWeatherPredictionDataSource* s) override;
+
+    /**
+      Sets the name of the 3D temperature variable of the input source.
+     */
+    void setInputVariable(QString temperatureVariableName);
+
+    QList<MVerticalLevelType> availableLevelTypes() override;
+
+    QStringList availableVariables(MVerticalLevelType levelType) override;
+
+    QSet<unsigned int> availableEnsembleMembers(MVerticalLevelType levelType,
+                                                const QString& variableName) override;
+
+    QList<QDateTime> availableInitTimes(MVerticalLevelType levelType,
+                                        const QString& variableName) override;
+
+    QList<QDateTime> availableValidTimes(MVerticalLevelType levelType,
+                                         const QString& variableName,
+                                         const QDateTime& initTime) override;
+
+    QString variableLongName(MVerticalLevelType levelType,
+                             const QString&     variableName) override;
+
+    QString variableStandardName(MVerticalLevelType levelType,
+                             const QString&     variableName) override;
+
+    QString variableUnits(MVerticalLevelType levelType,
+                             const QString&     variableName) override;
+
+    /**
+      Returns the variable name of @p field of tropopause layer @p rank
+      (0 = primary, 1 = secondary, ...). The names of the primary tropopause
+      layer equal those of @ref MTropopauseFieldSource.
+     */
+    static QString columnFieldToString(ColumnField field, int rank = 0);
+
+    /**
+      Inverse of @ref columnFieldToString(). Returns -1 if @p variableName is
+      not the name of a column field; otherwise the rank of the layer is
+      written to @p rank.
+     */
+    static int stringToColumnField(const QString& variableName, int *rank);
+
+protected:
+    const QStringList locallyRequiredKeys() override;
+
+    /**
+      Returns the request for the temperature field that @p request is
+      computed from.
+     */
+    MDataRequest inputRequest(MDataRequest request);
+
+    /**
+      Returns the 3D level type of the input temperature variable, or
+      SIZE_LEVELTYPES if the input source does not provide it.
+     */
+    MVerticalLevelType inputLevelType();
+
+    QString temperatureVariableName;
+};
+
+} // namespace Met3D
+
+#endif // MET_3D_TROPOPAUSECOLUMNSOURCE_H
@@ -0,0 +1,249 @@
+/******************************************************************************
+**
+**  This file is part of Met.3D -- a research environment for the
+**  three-dimensional visual exploration of numerical ensemble weather
+**  prediction data.
+**
+**  Copyright 2015-2020 Marc Rautenhaus
+**  Copyright 2022      Julian Münsterberg
+**
+**  Regional Computing Center, Visualization
+**  Universitaet Hamburg, Hamburg, Germany
+**
+**  Met.3D is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Met.3D is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Met.3D.  If not, see <http://www.gnu.org/licenses/>.
+**
+*******************************************************************************/
+#include "tropopausedatasource.h"
+
+// standard library imports
+#include "assert.h"
+
+// related third party imports
+#include <log4cplus/loggingmacros.h>
+
+// local application imports
+#include "util/mutil.h"
+#include "util/mexception.h"
+
+using namespace std;
+
+namespace Met3D
+{
+
+/******************************************************************************
+***                     CONSTRUCTOR / DESTRUCTOR                            ***
+*******************************************************************************/
+
+MTropopauseDataSource::MTropopauseDataSource()
+    : MTropopauseFieldSource()
+{
+}
+
+
+/******************************************************************************
+***                            PUBLIC METHODS                               ***
+*******************************************************************************/
+
+void MTropopauseDataSource::setInputSource(MWeatherPredictionDataSource* s)
+{
+    if (inputSource != s) deregisterInputSource(inputSource);
+    inputSource = s;
+    registerInputSource(inputSource);
+}
+
+
+void MTropopauseDataSource::setInputVariable(QString temperatureVariableName)
+{
+    this->temperatureVariableName = temperatureVariableName;
+}
+
+
+QList<MVerticalLevelType> MTropopauseDataSource::availableLevelTypes()
+{
+    QList<MVerticalLevelType> levelTypes;
+    if (inputLevelType() != SIZE_LEVELTYPES)
+    {
+        levelTypes << SURFACE_2D;
+    }
+    return levelTypes;
+}
+
+
+QStringList MTropopauseDataSource::availableVariables(
+        MVerticalLevelType levelType)
+{
+    QStringList variables;
+    if (levelType == SURFACE_2D && inputLevelType() != SIZE_LEVELTYPES)
+    {
+        for (int f = PRESSURE; f <= TEMPERATURE; f++)
+        {
+            variables << tropopauseFieldToString(TropopauseField(f));
+        }
+    }
+    return variables;
+}
+
+
+QSet<unsigned int> MTropopauseDataSource::availableEnsembleMembers(
+        MVerticalLevelType levelType, const QString& variableName)
+{
+    assert(inputSource != nullptr);
+
+    if (!isTropopauseVariable(levelType, variableName))
+    {
+        return QSet<unsigned int>();
+    }
+    return inputSource->availableEnsembleMembers(inputLevelType(),
+                                                 temperatureVariableName);
+}
+
+
+QList<QDateTime> MTropopauseDataSource::availableInitTimes(
+        MVerticalLevelType levelType, const QString& variableName)
+{
+    assert(inputSource != nullptr);
+
+    if (!isTropopauseVariable(levelType, variableName))
+    {
+        return QList<QDateTime>();
+    }
+    return inputSource->availableInitTimes(inputLevelType(),
+                                           temperatureVariableName);
+}
+
+
+QList<QDateTime> MTropopauseDataSource::availableValidTimes(
+        MVerticalLevelType levelType, const QString& variableName,
+        const QDateTime& initTime)
+{
+    assert(inputSource != nullptr);
+
+    if (!isTropopauseVariable(levelType, variableName))
+    {
+        return QList<QDateTime>();
+    }
+    return inputSource->availableValidTimes(inputLevelType(),
+                                            temperatureVariableName, initTime);
+}
+
+
+QString MTropopauseDataSource::variableLongName(
+        MVerticalLevelType levelType, const QString& variableName)
+{
+    Q_UNUSED(levelType);
+    return QString("%1 (WMO lapse-rate), computed from %2").arg(
+                variableName).arg(temperatureVariableName);
+}
+
+
+QString MTropopauseDataSource::variableStandardName(
+        MVerticalLevelType levelType, const QString& variableName)
+{
+    Q_UNUSED(levelType);
+
+    // Variable names equal CF standard names.
+    return variableName;
+}
+
+
+QString MTropopauseDataSource::variableUnits(
+        MVerticalLevelType levelType, const QString& variableName)
+{
+    Q_UNUSED(levelType);
+
+    int field = stringToTropopauseField(variableName);
+    if (field < 0)
+    {
+        return QString();
+    }
+    return tropopauseFieldUnits(TropopauseField(field));
+}
+
+
+/******************************************************************************
+***                          PROTECTED METHODS                              ***
+*******************************************************************************/
+
+const QStringList MTropopauseDataSource::locallyRequiredKeys()
+{
+    return (QStringList() << "LEVELTYPE" << "VARIABLE");
+}
+
+
+MTropopauseFieldSource::TropopauseField MTropopauseDataSource::requestedField(
+        MDataRequest request)
+{
+    MDataRequestHelper rh(request);
+    int field = stringToTropopauseField(rh.value("VARIABLE"));
+    if (field < 0)
+    {
+        QString msg = QString("Variable %1 is not provided by the tropopause "
+                              "data source.").arg(rh.value("VARIABLE"));
+        LOG4CPLUS_ERROR(mlog, msg.toStdString());
+        throw MBadDataFieldRequest(msg.toStdString(), __FILE__, __LINE__);
+    }
+    return TropopauseField(field);
+}
+
+
+MDataRequest MTropopauseDataSource::inputRequest(MDataRequest request)
+{
+    MDataRequestHelper rh(request);
+    rh.removeAll(locallyOptionalKeys());
+    rh.insert("LEVELTYPE", inputLevelType());
+    rh.insert("VARIABLE", temperatureVariableName);
+    return rh.request();
+}
+
+
+MDataRequest MTropopauseDataSource::fieldRequest(MDataRequest request,
+                                                 TropopauseField field)
+{
+    MDataRequestHelper rh(request);
+    rh.insert("VARIABLE", tropopauseFieldToString(field));
+    return rh.request();
+}
+
+
+MVerticalLevelType MTropopauseDataSource::inputLevelType()
+{
+    assert(inputSource != nullptr);
+
+    QList<MVerticalLevelType> inputLevelTypes =
+            inputSource->availableLevelTypes();
+
+    const MVerticalLevelType preferredLevelTypes[] = {
+        HYBRID_SIGMA_PRESSURE_3D, AUXILIARY_PRESSURE_3D, PRESSURE_LEVELS_3D };
+
+    for (MVerticalLevelType levelType : preferredLevelTypes)
+    {
+        if (inputLevelTypes.contains(levelType)
+                && inputSource->availableVariables(levelType).contains(
+                    temperatureVariableName))
+        {
+            return levelType;
+        }
+    }
+    return SIZE_LEVELTYPES;
+}
+
+
+bool MTropopauseDataSource::isTropopauseVariable(
+        MVerticalLevelType levelType, const QString& variableName)
+{
+    return (levelType == SURFACE_2D)
+            && (stringToTropopauseField(variableName) >= 0);
+}
+
+} // namespace Met3D
@@ -0,0 +1,120 @@
+/******************************************************************************
+**
+**  This file is part of Met.3D -- a research environment for the
+**  three-dimensional visual exploration of numerical ensemble weather
+**  prediction data.
+**
+**  Copyright 2015-2020 Marc Rautenhaus
+**  Copyright 2022      Julian Münsterberg
+**
+**  Regional Computing Center, Visualization
+**  Universitaet Hamburg, Hamburg, Germany
+**
+**  Met.3D is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Met.3D is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Met.3D.  If not, see <http://www.gnu.org/licenses/>.
+**
+*******************************************************************************/
+#ifndef MET_3D_TROPOPAUSEDATASOURCE_H
+#define MET_3D_TROPOPAUSEDATASOURCE_H
+
+// standard library imports
+
+// related third party imports
+#include <QtCore>
+
+// local application imports
+#include "tropopause/tropopausefieldsource.h"
+
+namespace Met3D
+{
+
+/**
+  @brief MTropopauseDataSource publishes the tropopause fields of @ref
+  MTropopauseFieldSource as regular 2D variables ("tropopause_air_pressure",
+  "tropopause_altitude", "tropopause_air_temperature"; level type SURFACE_2D)
+  of a weather prediction data set, so that they can be requested by
+  horizontal sections, the ensemble filter etc. via the usual "LEVELTYPE" and
+  "VARIABLE" keys.
+
+  The fields are computed from the 3D temperature variable set with @ref
+  setInputVariable(). Model levels are preferred over pressure levels if the
+  input source provides both.
+ */
+class MTropopauseDataSource : public MTropopauseFieldSource
+{
+public:
+    MTropopauseDataSource();
+
+    /**
+      Request pass-through is disabled; requests for the temperature field
+      are constructed by this source.
+     */
+    void setInputSource(MWeatherPredictionDataSource* s) override;
+
+    /**
+      Sets the name of the 3D temperature variable of the input source.
+     */
+    void setInputVariable(QString temperatureVariableName);
+
+    QList<MVerticalLevelType> availableLevelTypes() override;
+
+    QStringList availableVariables(MVerticalLevelType levelType) override;
+
+    QSet<unsigned int> availableEnsembleMembers(MVerticalLevelType levelType,
+                                                const QString& variableName) override;
+
+    QList<QDateTime> availableInitTimes(MVerticalLevelType levelType,
+                                        const QString& variableName) override;
+
+    QList<QDateTime> availableValidTimes(MVerticalLevelType levelType,
+                                         const QString& variableName,
+                                         const QDateTime& initTime) override;
+
+    QString variableLongName(MVerticalLevelType levelType,
+                             const QString&     variableName) override;
+
+    QString variableStandardName(MVerticalLevelType levelType,
+                             const QString&     variableName) override;
+
+    QString variableUnits(MVerticalLevelType levelType,
+                             const QString&     variableName) override;
+
+protected:
+    const QStringList locallyRequiredKeys() override;
+
+    TropopauseField requestedField(MDataRequest request) override;
+
+    MDataRequest inputRequest(MDataRequest request) override;
+
+    MDataRequest fieldRequest(MDataRequest request,
+                              TropopauseField field) override;
+
+    /**
+      Returns the 3D level type of the input temperature variable, or
+      SIZE_LEVELTYPES if the input source does not provide it.
+     */
+    MVerticalLevelType inputLevelType();
+
+    /**
+      Returns true if @p levelType and @p variableName denote one of the
+      tropopause fields provided by this source.
+     */
+    bool isTropopauseVariable(MVerticalLevelType levelType,
+                              const QString& variableName);
+
+    QString temperatureVariableName;
+};
+
+} // namespace Met3D
+
+#endif // MET_3D_TROPOPAUSEDATASOURCE_H
@@ -48,6 +48,16 @@ MTropopauseDetectionActor::MTropopauseDetectionActor():
           detectionVariableIndexProperty(nullptr),
           detectionVariableIndex(0),
           detectionVariable(nullptr),
+          detectionMethodProperty(nullptr),
+          detectionMethod(MTropopauseDetectionSource::SECOND_DERIVATIVE_MC),
+          isosurfaceAlgorithmProperty(nullptr),
+          isosurfaceAlgorithm(MMarchingCubes::MARCHING_CUBES),
+          memoryLimitProperty(nullptr),
+          memoryLimit_MB(0),
+          pvThresholdProperty(nullptr),
+          pvThreshold_PVU(2.0),
+          minComponentAreaProperty(nullptr),
+          minComponentArea_km2(0.),
           displayOptionsGroupProperty(nullptr),
           renderTropopauseProperty(nullptr),
           renderTropopause(false),
@@ -121,6 +131,72 @@ MTropopauseDetectionActor::MTropopauseDetectionActor():
     detectionVariableIndexProperty->setToolTip(
                 "example: should be temperature");
 
+    QStringList detectionMethodNames;
+    detectionMethodNames
+            << MTropopauseDetectionSource::detectionMethodToString(
+                   MTropopauseDetectionSource::SECOND_DERIVATIVE_MC)
+            << MTropopauseDetectionSource::detectionMethodToString(
+                   MTropopauseDetectionSource::WMO_LAPSE_RATE)
+            << MTropopauseDetectionSource::detectionMethodToString(
+                   MTropopauseDetectionSource::DYNAMICAL_PV);
+    detectionMethodProperty = addProperty(
+            ENUM_PROPERTY, "detection method", inputVarGroupProperty);
+    properties->mEnum()->setEnumNames(detectionMethodProperty,
+                                      detectionMethodNames);
+    properties->mEnum()->setValue(detectionMethodProperty, detectionMethod);
+    detectionMethodProperty->setToolTip(
+                "Second derivative: isosurface of the second vertical\n"
+                "derivative of the detection variable (marching cubes).\n"
+                "WMO lapse rate: column scan of the temperature field for\n"
+                "the level at which the lapse rate drops below 2 K/km.\n"
+                "The detection variable needs to be temperature in K.\n"
+                "Dynamical: isosurface of the PV threshold bounding the\n"
+                "stratosphere. The detection variable needs to be taken\n"
+                "from a 'derived' data source that provides\n"
+                "ertel_potential_vorticity.");
+
+    pvThresholdProperty = addProperty(
+            DOUBLE_PROPERTY, "PV threshold (PVU)", inputVarGroupProperty);
+    properties->setDouble(pvThresholdProperty, pvThreshold_PVU,
+                          0.5, 10., 1, 0.1);
+    pvThresholdProperty->setToolTip(
+                "|PV| defining the dynamical tropopause (usually 1.5-3.5\n"
+                "PVU). Only used by the dynamical detection method.");
+
+    minComponentAreaProperty = addProperty(
+            DOUBLE_PROPERTY, "min. fragment area (km\u00B2)",
+            inputVarGroupProperty);
+    properties->setDouble(minComponentAreaProperty, minComponentArea_km2,
+                          0., 1.E7, 0, 1000.);
+    minComponentAreaProperty->setToolTip(
+                "Connected parts of the tropopause surface with a smaller\n"
+                "area are removed before the mesh is cached and uploaded.\n"
+                "0 = keep all parts.");
+
+    isosurfaceAlgorithmProperty = addProperty(
+            ENUM_PROPERTY, "isosurface algorithm", inputVarGroupProperty);
+    properties->mEnum()->setEnumNames(
+                isosurfaceAlgorithmProperty,
+                QStringList() << "marching cubes" << "flying edges");
+    properties->mEnum()->setValue(isosurfaceAlgorithmProperty,
+                                  isosurfaceAlgorithm);
+    isosurfaceAlgorithmProperty->setToolTip(
+                "Algorithm used to extract the tropopause isosurface.\n"
+                "Marching cubes respects the memory limit and skips grid\n"
+                "regions without surface. Flying edges processes the whole\n"
+                "grid in one pass and yields the same mesh in every run.");
+
+    memoryLimitProperty = addProperty(
+            INT_PROPERTY, "memory limit (MB)", inputVarGroupProperty);
+    properties->mInt()->setMinimum(memoryLimitProperty, 0);
+    properties->mInt()->setValue(memoryLimitProperty, memoryLimit_MB);
+    memoryLimitProperty->setToolTip(
+                "Approximate limit of the working memory used by marching\n"
+                "cubes to extract the tropopause mesh. Large grids are\n"
+                "processed in slabs of vertical levels to stay below the\n"
+                "limit. Not used by flying edges.\n"
+                "0 = no limit.");
+
 
     /**************************************************************************
                             Render OPTIONS
@@ -221,6 +297,14 @@ void MTropopauseDetectionActor::saveConfiguration(QSettings *settings)
 
     settings->setValue("renderTropopause", renderTropopause);
     settings->setValue("detectionVariableIndex", detectionVariableIndex);
+    settings->setValue("detectionMethod",
+                       MTropopauseDetectionSource::detectionMethodToString(
+                           detectionMethod));
+    settings->setValue("isosurfaceAlgorithm",
+                       int(isosurfaceAlgorithm));
+    settings->setValue("memoryLimit_MB", memoryLimit_MB);
+    settings->setValue("pvThreshold_PVU", pvThreshold_PVU);
+    settings->setValue("minComponentArea_km2", minComponentArea_km2);
     settings->setValue("tropopauseIsoValue", tropopauseIsoValue);
     settings->setValue("tropopauseColour", tropopauseColour);
     settings->setValue("useFDTransferFunction", useFDTransferFunction);
@@ -256,6 +340,28 @@ void MTropopauseDetectionActor::loadConfiguration(QSettings *settings)
     properties->mInt()->setValue(detectionVariableIndexProperty,
                                  detectionVariableIndex);
 
+    detectionMethod = MTropopauseDetectionSource::stringToDetectionMethod(
+                settings->value("detectionMethod").toString());
+    properties->mEnum()->setValue(detectionMethodProperty, detectionMethod);
+
+    isosurfaceAlgorithm = static_cast<MMarchingCubes::Algorithm>(
+                settings->value("isosurfaceAlgorithm",
+                                int(MMarchingCubes::MARCHING_CUBES)).toInt());
+    properties->mEnum()->setValue(isosurfaceAlgorithmProperty,
+                                  isosurfaceAlgorithm);
+    memoryLimitProperty->setEnabled(
+                isosurfaceAlgorithm == MMarchingCubes::MARCHING_CUBES);
+
+    memoryLimit_MB = settings->value("memoryLimit_MB", 0).toInt();
+    properties->mInt()->setValue(memoryLimitProperty, memoryLimit_MB);
+
+    pvThreshold_PVU = settings->value("pvThreshold_PVU", 2.0).toDouble();
+    properties->mDouble()->setValue(pvThresholdProperty, pvThreshold_PVU);
+
+    minComponentArea_km2 =
+            settings->value("minComponentArea_km2", 0.).toDouble();
+    properties->mDouble()->setValue(minComponentAreaProperty,
+                                    minComponentArea_km2);
 
     tropopauseIsoValue = settings->value("tropopauseIsoValue").toDouble();
     properties->mDouble()->setValue(tropopauseIsoProperty, tropopauseIsoValue);
@@ -624,6 +730,32 @@ void MTropopauseDetectionActor::onQtPropertyChanged(QtProperty *property)
                 variables[detectionVariableIndex]);
         emitActorChangedSignal();
     }
+    else if (property == detectionMethodProperty)
+    {
+        detectionMethod = static_cast<MTropopauseDetectionSource::DetectionMethod>(
+                    properties->mEnum()->value(detectionMethodProperty));
+    }
+    else if (property == isosurfaceAlgorithmProperty)
+    {
+        isosurfaceAlgorithm = static_cast<MMarchingCubes::Algorithm>(
+                    properties->mEnum()->value(isosurfaceAlgorithmProperty));
+        // The memory limit only applies to marching cubes.
+        memoryLimitProperty->setEnabled(
+                    isosurfaceAlgorithm == MMarchingCubes::MARCHING_CUBES);
+    }
+    else if (property == memoryLimitProperty)
+    {
+        memoryLimit_MB = properties->mInt()->value(memoryLimitProperty);
+    }
+    else if (property == pvThresholdProperty)
+    {
+        pvThreshold_PVU = properties->mDouble()->value(pvThresholdProperty);
+    }
+    else if (property == minComponentAreaProperty)
+    {
+        minComponentArea_km2 =
+                properties->mDouble()->value(minComponentAreaProperty);
+    }
     else if (property == tropopauseIsoProperty)
     {
         tropopauseIsoValue = properties->mSciDouble()->value(tropopauseIsoProperty);
@@ -830,7 +962,15 @@ void MTropopauseDetectionActor::triggerAsynchronousTropopauseRequest()
         glRM->releaseGPUItem(iboTropopause);
     }
     MDataRequestHelper rh = detectionVariable->constructAsynchronousDataRequest();
-    rh.insert("TROPOPAUSE_ISOVALUE", QString::number(tropopauseIsoValue));
+    // The dynamical method extracts the PV threshold isosurface.
+    const double isoValue =
+            (detectionMethod == MTropopauseDetectionSource::DYNAMICAL_PV)
+            ? pvThreshold_PVU : tropopauseIsoValue;
+    rh.insert("TROPOPAUSE_ISOVALUE", QString::number(isoValue));
+    rh.insert("TROPOPAUSE_METHOD", detectionMethod);
+    rh.insert("TROPOPAUSE_MIN_AREA", QString::number(minComponentArea_km2));
+    rh.insert("TROPOPAUSE_ISO_ALGORITHM", int(isosurfaceAlgorithm));
+    rh.insert("TROPOPAUSE_MC_MEMORY_LIMIT", memoryLimit_MB);
 
     tropopauseDetectionSource->setDetectionVariableSource(detectionVariable->dataSource);
 
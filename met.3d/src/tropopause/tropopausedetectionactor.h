@@ -186,6 +186,26 @@ private:
     uint8_t                     detectionVariableIndex;
     MNWP3DVolumeActorVariable*  detectionVariable;
 
+    //          |-- detection method
+    QtProperty*                                 detectionMethodProperty;
+    MTropopauseDetectionSource::DetectionMethod detectionMethod;
+
+    //          |-- isosurface extraction algorithm
+    QtProperty*                 isosurfaceAlgorithmProperty;
+    MMarchingCubes::Algorithm   isosurfaceAlgorithm;
+
+    //          |-- marching cubes memory limit
+    QtProperty*                 memoryLimitProperty;
+    int                         memoryLimit_MB;
+
+    //          |-- PV threshold of the dynamical tropopause
+    QtProperty*                 pvThresholdProperty;
+    double                      pvThreshold_PVU;
+
+    //          |-- culling of small mesh fragments
+    QtProperty*                 minComponentAreaProperty;
+    double                      minComponentArea_km2;
+
     // ************************ DISPLAY OPTIONS ********************************
     //      |-> display options
     QtProperty* displayOptionsGroupProperty;
@@ -35,143 +35,354 @@
 
 // local application imports
 #include <log4cplus/loggingmacros.h>
+#include "util/mutil.h"
+#include "util/mexception.h"
 
 #define COMPUTE_PARALLEL
 #define MEASURE_CPU_TIME
 #define qNaN (std::numeric_limits<float>::quiet_NaN())
+#define iNaN (std::numeric_limits<uint32_t>::max())
 
 
 using namespace Met3D;
-MDummyFilter::MDummyFilter()
-        : MSingleInputProcessingWeatherPredictionDataSource()
+
+
+////////////////////////////////////////////////////
+/// \brief MTropopauseDetectionSource::MTropopauseDetectionSource
+///////////////////////////////////////////////////////////////
+
+MTropopauseDetectionSource::MTropopauseDetectionSource()
+        : detectionVariableSource(nullptr),
+          detectionVarPartialDerivativeSource(new MPartialDerivativeFilter()),
+          tropopauseFieldSource(new MTropopauseFieldSource())
 {
+}
+
+
 
+void MTropopauseDetectionSource::setDetectionVariableSource(
+        MWeatherPredictionDataSource *s)
+{
+    // The data signature (and hence the persistent cache key) must only
+    // reflect the current detection variable.
+    if (detectionVariableSource != s)
+    {
+        deregisterInputSource(detectionVariableSource);
+    }
+    detectionVariableSource = s;
+    registerInputSource(detectionVariableSource);
+    initializeTDPipeline();
 }
-/******************************************************************************
-***                            PUBLIC METHODS                               ***
-*******************************************************************************/
 
-MStructuredGrid *MDummyFilter::produceData(Met3D::MDataRequest request)
+MTropopauseTriangleMeshSelection* MTropopauseDetectionSource::produceData(MDataRequest request)
 {
-    assert(inputSource != nullptr);
+    // If a valid persistently cached mesh exists, createTaskGraph() has
+    // prepared its cache entry and not scheduled any input computations;
+    // the mesh is mapped from disk.
+    MPersistentDataCache *persistentCache = MPersistentDataCache::getInstance();
+    const QString cacheKey = persistentCacheKey(request);
+
+    if (MPersistentCacheEntry *entry =
+            persistentCache->takePreparedEntry(cacheKey))
+    {
+        // The entry has been validated in createTaskGraph().
+        MTropopauseTriangleMeshSelection *tropopause =
+                MTropopauseTriangleMeshSelection::
+                createFromPersistentCacheEntry(entry);
+        delete entry;
+        return tropopause;
+    }
 
     MDataRequestHelper rh(request);
-    rh.removeAll(locallyRequiredKeys());
 
-    const int DP = MGradientProperties::DP;
-    rh.insert("GRADIENT", DP);
+    const DetectionMethod method = static_cast<DetectionMethod>(
+                rh.intValue("TROPOPAUSE_METHOD"));
+    const double minComponentArea_km2 =
+            rh.value("TROPOPAUSE_MIN_AREA").toDouble();
 
-    return inputSource->getData(rh.request());
-}
+    MTropopauseTriangleMeshSelection *tropopause = nullptr;
 
-void MDummyFilter::setInputSource(MWeatherPredictionDataSource* s)
-{
-    inputSource = s;
-    registerInputSource(inputSource);
-    //enablePassThrough(s);
+    if (method == WMO_LAPSE_RATE)
+    {
+        assert(tropopauseFieldSource != nullptr);
+
+        rh.removeAll(locallyRequiredKeys());
+        rh.insert("TROPOPAUSE_FIELD", MTropopauseFieldSource::PRESSURE);
+
+        MStructuredGrid* pTropGrid =
+                tropopauseFieldSource->getData(rh.request());
+
+        tropopause = triangulateTropopauseField(pTropGrid);
+
+        tropopauseFieldSource->releaseData(pTropGrid);
+    }
+    else if (method == DYNAMICAL_PV)
+    {
+        tropopause = produceDynamicalTropopauseMesh(rh);
+    }
+    else
+    {
+        tropopause = produceSecondDerivativeMesh(rh);
+    }
+
+    // Small spurious patches are removed before the mesh is cached and
+    // uploaded to the GPU.
+    if (minComponentArea_km2 > 0.)
+    {
+        tropopause->removeSmallComponents(minComponentArea_km2);
+    }
+
+    persistentCache->store(cacheKey, tropopause->getPersistentCacheBlocks());
+
+    return tropopause;
 }
 
-MTask *MDummyFilter::createTaskGraph(MDataRequest request)
+
+MTropopauseTriangleMeshSelection* MTropopauseDetectionSource::produceSecondDerivativeMesh(
+        MDataRequestHelper &rh)
 {
-    assert(inputSource != nullptr);
-    MTask* task = new MTask(request, this);
+    assert(detectionVarPartialDerivativeSource != nullptr);
 
-    MDataRequestHelper rh(request);
+    const double isovalue = rh.value("TROPOPAUSE_ISOVALUE").toFloat();
+    const MMarchingCubes::Algorithm isosurfaceAlgorithm =
+            static_cast<MMarchingCubes::Algorithm>(
+                rh.intValue("TROPOPAUSE_ISO_ALGORITHM"));
+    const unsigned int memoryLimit_MB =
+            rh.intValue("TROPOPAUSE_MC_MEMORY_LIMIT");
 
-    const int DP = MGradientProperties::DP;
-    rh.insert("GRADIENT", DP);
-    task->addParent(inputSource->getTaskGraph(rh.request()));
-    return task;
-}
+    rh.removeAll(locallyRequiredKeys());
 
+    const int DP_D2P = MGradientProperties::DP_D2P;
+    rh.insert("GRADIENT", DP_D2P);
 
+    // Both derivatives are computed in one pass; the first derivative is
+    // attached to the second derivative grid.
+    MStructuredGrid* secondDerivativeGrid = detectionVarPartialDerivativeSource->getData(rh.request());
+    MStructuredGrid* firstDerivativeGrid = secondDerivativeGrid->getCompanionGrid();
 
-/******************************************************************************
-***                          PROTECTED METHODS                              ***
-*******************************************************************************/
+    rh.remove("GRADIENT");
 
-const QStringList MDummyFilter::locallyRequiredKeys()
-{
-    return (QStringList());
-}
+    LOG4CPLUS_DEBUG(mlog, "[1] Compute voxels and isosurface triangle geometry...");
+    //MarchingCubes
+    // The min/max brick index only depends on the derivative field; changes
+    // of the isovalue only visit the bricks along the new surface. Flying
+    // edges does not use the index, hence it is only built for MC.
+    MMinMaxBrickIndex *brickIndex = nullptr;
+    if (isosurfaceAlgorithm == MMarchingCubes::MARCHING_CUBES)
+    {
+        brickIndex = MMinMaxBrickIndex::getIndex(
+                    memoryManager, this, secondDerivativeGrid);
+    }
 
+    MMarchingCubes mc(secondDerivativeGrid);
+    mc.setAlgorithm(isosurfaceAlgorithm);
+    mc.setMaxMemoryUsage_MB(memoryLimit_MB);
+    mc.setMinMaxBrickIndex(brickIndex);
+    const int firstDerivAttribute = mc.addAttributeGrid(firstDerivativeGrid);
+    mc.computeMeshOnCPU(isovalue);
 
-////////////////////////////////////////////////////
-/// \brief MTropopauseDetectionSource::MTropopauseDetectionSource
-///////////////////////////////////////////////////////////////
+    if (brickIndex) memoryManager->releaseData(brickIndex);
 
-MTropopauseDetectionSource::MTropopauseDetectionSource()
-        : detectionVarPartialDerivative1Source(new MPartialDerivativeFilter()),
-          detectionVarPartialDerivative2Source(new MPartialDerivativeFilter()),
-          dummy1(new MDummyFilter())
-{
-}
+    LOG4CPLUS_DEBUG(mlog, "[1] \t->done.");
 
+    MTropopauseTriangleMeshSelection *rawTropopause =
+            createMeshFromMarchingCubes(mc, firstDerivAttribute);
 
+    // Releasing the second derivative also releases its companion.
+    detectionVarPartialDerivativeSource->releaseData(secondDerivativeGrid);
+
+    return rawTropopause;
 
-void MTropopauseDetectionSource::setDetectionVariableSource(
-        MWeatherPredictionDataSource *s)
-{
-    detectionVariableSource = s;
-    registerInputSource(detectionVariableSource);
-    initializeTDPipeline();
 }
 
-MTropopauseTriangleMeshSelection* MTropopauseDetectionSource::produceData(MDataRequest request)
+
+MTropopauseTriangleMeshSelection* MTropopauseDetectionSource::produceDynamicalTropopauseMesh(
+        MDataRequestHelper &rh)
 {
-    assert(detectionVarPartialDerivative1Source != nullptr);
-    assert(detectionVarPartialDerivative2Source != nullptr);
+    assert(detectionVariableSource != nullptr);
 
-    MDataRequestHelper rh(request);
+    if (!providesPotentialVorticity(rh))
+    {
+        QString msg = QString("The dynamical tropopause requires %1 on "
+                              "hybrid sigma-pressure levels; use a 'derived' "
+                              "data source as detection variable source.")
+                .arg(PV_VARIABLE_NAME);
+        LOG4CPLUS_ERROR(mlog, msg.toStdString());
+        throw MBadDataFieldRequest(msg.toStdString(), __FILE__, __LINE__);
+    }
 
-    const double isovalue = rh.value("TROPOPAUSE_ISOVALUE").toFloat();
+    const float threshold_PVU = rh.value("TROPOPAUSE_ISOVALUE").toFloat();
+    const MMarchingCubes::Algorithm isosurfaceAlgorithm =
+            static_cast<MMarchingCubes::Algorithm>(
+                rh.intValue("TROPOPAUSE_ISO_ALGORITHM"));
+    const unsigned int memoryLimit_MB =
+            rh.intValue("TROPOPAUSE_MC_MEMORY_LIMIT");
 
     rh.removeAll(locallyRequiredKeys());
+    rh.insert("VARIABLE", PV_VARIABLE_NAME);
 
-    const int DP = MGradientProperties::DP;
-    rh.insert("GRADIENT", DP);
+    // PV is derived by MDerivedMetVarsDataSource (LAGRANTO libcalvar), in
+    // SI units.
+    MStructuredGrid *pvGrid = detectionVariableSource->getData(rh.request());
 
-    MStructuredGrid* firstDerivativeGrid = detectionVarPartialDerivative1Source->getData(rh.request());
+#ifdef MEASURE_CPU_TIME
+    auto start = std::chrono::system_clock::now();
+#endif
 
-    MStructuredGrid* secondDerivativeGrid = detectionVarPartialDerivative2Source->getData(rh.request());
+    const int nLev = pvGrid->getNumLevels();
+    const int nLat = pvGrid->getNumLats();
+    const int nLon = pvGrid->getNumLons();
+    const int nLatLon = nLat * nLon;
+    const size_t nValues = pvGrid->getNumValues();
 
+    // |PV| in PVU; the sign of PV changes with the hemisphere. Missing
+    // values are passed to marching cubes as NaN so that no surface is
+    // extracted across them.
+    std::vector<float> absPV_PVU(nValues);
+#ifdef COMPUTE_PARALLEL
+#pragma omp parallel for
+#endif
+    for (size_t n = 0; n < nValues; n++)
+    {
+        const float pv = pvGrid->getValue(n);
+        absPV_PVU[n] = IS_MISSING(pv) ? qNaN : std::fabs(pv) * 1.E6f;
+    }
 
-    rh.remove("GRADIENT");
+    // Stratospheric connectivity: only air with |PV| above the threshold
+    // that is connected to the model top (6-neighbourhood) is stratospheric.
+    // Isolated PV anomalies (cut-offs, diabatically generated PV in the
+    // lower troposphere) are set to zero so that they do not produce
+    // closed isosurfaces below the tropopause. The model top level is
+    // determined per column from the pressure of the first and last level.
+    std::vector<uint8_t> isStratospheric(nValues, 0);
+    std::vector<size_t> frontier;
+    for (int n = 0; n < nLatLon; n++)
+    {
+        const int j = n / nLon;
+        const int i = n % nLon;
+        const int kTop = (pvGrid->getPressure(0, j, i)
+                          < pvGrid->getPressure(nLev - 1, j, i)) ? 0 : nLev - 1;
+        const size_t index = size_t(kTop) * nLatLon + n;
+        if (absPV_PVU[index] >= threshold_PVU)
+        {
+            isStratospheric[index] = 1;
+            frontier.push_back(index);
+        }
+    }
 
-    // 1) Create voxel cells
-    const int nx = secondDerivativeGrid->getNumLons() - 1;
-    const int ny = secondDerivativeGrid->getNumLats() - 1;
-    const int nz = secondDerivativeGrid->getNumLevels() - 1;
-
-    // QVector max size is 2GB (2000000000 bytes)
-    // Here we check if we can compute mc or if our data is too large
-    u_int32_t numEdges = (3 * secondDerivativeGrid->getNumValues()
-                    - secondDerivativeGrid->getNumLons() * secondDerivativeGrid->getNumLevels()
-                    - secondDerivativeGrid->getNumLons() * secondDerivativeGrid->getNumLats()
-                    - secondDerivativeGrid->getNumLats() * secondDerivativeGrid->getNumLevels());
-    u_int32_t sizefloatQVector3d = numEdges * 3 * 4;
-    u_int32_t maxSizeQVector = 2000000000;
-    if (sizefloatQVector3d > maxSizeQVector)
+    // Breadth-first flood fill; the points of each front are processed in
+    // parallel. A point is added to the next front by the thread that
+    // marks it first.
+    while (!frontier.empty())
     {
-        LOG4CPLUS_DEBUG(mlog, "Your data set is too large to compute Tropopause");
-        return new MTropopauseTriangleMeshSelection(0,0);
+        std::vector<size_t> nextFrontier;
+
+#ifdef COMPUTE_PARALLEL
+#pragma omp parallel
+#endif
+        {
+            std::vector<size_t> localFrontier;
+
+#ifdef COMPUTE_PARALLEL
+#pragma omp for nowait
+#endif
+            for (size_t f = 0; f < frontier.size(); f++)
+            {
+                const size_t index = frontier[f];
+
+                const int k = int(index / nLatLon);
+                const int j = int((index % nLatLon) / nLon);
+                const int i = int(index % nLon);
+
+                const int neighbours[6][3] = {
+                    { k - 1, j, i }, { k + 1, j, i }, { k, j - 1, i },
+                    { k, j + 1, i }, { k, j, i - 1 }, { k, j, i + 1 } };
+
+                for (const auto &nb : neighbours)
+                {
+                    if (nb[0] < 0 || nb[0] >= nLev || nb[1] < 0
+                            || nb[1] >= nLat || nb[2] < 0 || nb[2] >= nLon)
+                    { continue; }
+
+                    const size_t nbIndex = INDEX3zyx_2(nb[0], nb[1], nb[2],
+                                                       nLatLon, nLon);
+                    if (!(absPV_PVU[nbIndex] >= threshold_PVU)) { continue; }
+
+                    uint8_t wasStratospheric;
+#ifdef COMPUTE_PARALLEL
+#pragma omp atomic capture
+#endif
+                    {
+                        wasStratospheric = isStratospheric[nbIndex];
+                        isStratospheric[nbIndex] = 1;
+                    }
+
+                    if (!wasStratospheric) { localFrontier.push_back(nbIndex); }
+                }
+            }
+
+#ifdef COMPUTE_PARALLEL
+#pragma omp critical
+#endif
+            nextFrontier.insert(nextFrontier.end(), localFrontier.begin(),
+                                localFrontier.end());
+        }
+
+        frontier.swap(nextFrontier);
     }
 
-    LOG4CPLUS_DEBUG(mlog, "[1] Compute voxels and isosurface triangle geometry...");
-    //MarchingCubes
-    MMarchingCubes mc(secondDerivativeGrid);
-    mc.computeMeshOnCPU(isovalue);
+#ifdef COMPUTE_PARALLEL
+#pragma omp parallel for
+#endif
+    for (size_t n = 0; n < nValues; n++)
+    {
+        if (!isStratospheric[n] && absPV_PVU[n] >= threshold_PVU)
+        {
+            absPV_PVU[n] = 0.f;
+        }
+    }
+
+#ifdef MEASURE_CPU_TIME
+    auto end = std::chrono::system_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    LOG4CPLUS_DEBUG(mlog, "[0] |PV| and stratospheric connectivity done in "
+                    << elapsed.count() << "ms");
+#endif
 
+    LOG4CPLUS_DEBUG(mlog, "[1] Compute voxels and isosurface triangle geometry...");
+    // The masked |PV| field is passed to marching cubes directly; no
+    // intermediate grid is created or cached.
+    MMarchingCubes mc(pvGrid);
+    mc.setAlgorithm(isosurfaceAlgorithm);
+    mc.setMaxMemoryUsage_MB(memoryLimit_MB);
+    mc.setScalarValues(absPV_PVU.data());
+    mc.computeMeshOnCPU(threshold_PVU);
     LOG4CPLUS_DEBUG(mlog, "[1] \t->done.");
 
-    QVector<Geometry::MTriangle>* triangles = mc.getFlattenTriangles();
-    QVector<QVector3D>* positions = mc.getFlattenInterPoints();
-    QVector<QVector3D>* normals   = mc.getFlattenInterNormals();
+    // The first-derivative filter only applies to the second derivative
+    // method.
+    MTropopauseTriangleMeshSelection *tropopause =
+            createMeshFromMarchingCubes(mc, -1);
+
+    detectionVariableSource->releaseData(pvGrid);
+
+    return tropopause;
+}
+
+
+MTropopauseTriangleMeshSelection* MTropopauseDetectionSource::createMeshFromMarchingCubes(
+        MMarchingCubes &mc, int firstDerivAttribute)
+{
+    std::vector<Geometry::MTriangle>* triangles = mc.getFlattenTriangles();
+    std::vector<QVector3D>* positions = mc.getFlattenInterPoints();
+    std::vector<QVector3D>* normals   = mc.getFlattenInterNormals();
+    std::vector<float>* firstDerivs = (firstDerivAttribute >= 0)
+            ? mc.getFlattenAttributes(firstDerivAttribute) : nullptr;
 
-    int p = positions->size();
     LOG4CPLUS_DEBUG(
                 mlog,
-                QString("[2] Compute integration values and create mesh of %1 values...").arg(p).toStdString());
+                QString("[2] Compute integration values and create mesh of %1 values...")
+                .arg(quint64(positions->size())).toStdString());
 #ifdef MEASURE_CPU_TIME
     auto start2 = std::chrono::system_clock::now();
 #endif
@@ -180,12 +391,10 @@ MTropopauseTriangleMeshSelection* MTropopauseDetectionSource::produceData(MDataR
                  positions->size(),
                  triangles->size());
 
-    //const float minValue = thirdDerivativeGrid->min();
-
 #ifdef COMPUTE_PARALLEL
 #pragma omp parallel for
 #endif
-    for (auto k = 0; k < positions->size(); ++k)
+    for (size_t k = 0; k < positions->size(); ++k)
     {
         // get current position
         QVector3D position = positions->at(k);
@@ -196,8 +405,8 @@ MTropopauseTriangleMeshSelection* MTropopauseDetectionSource::produceData(MDataR
         // initialize tropopause mesh vertex
         Geometry::TropopauseMeshVertex tropopauseVertex;
 
-        //compute first Derivative
-        const float firstDeriv = firstDerivativeGrid->interpolateValue(position);
+        // first derivative, interpolated along the voxel edge by MC
+        const float firstDeriv = firstDerivs ? firstDerivs->at(k) : 0.f;
 
         // all needed values are computed, fill tropopause vertex
         tropopauseVertex.position = position;
@@ -213,7 +422,7 @@ MTropopauseTriangleMeshSelection* MTropopauseDetectionSource::produceData(MDataR
 #pragma omp parallel for
 #endif
     // set triangles
-    for (int i = 0; i < triangles->size(); i++)
+    for (size_t i = 0; i < triangles->size(); i++)
     {
         rawTropopause->setTriangle(i, triangles->at(
                                           i));
@@ -226,13 +435,10 @@ MTropopauseTriangleMeshSelection* MTropopauseDetectionSource::produceData(MDataR
     LOG4CPLUS_DEBUG(mlog, "[2] \t->done in " << elapsed2.count() << "ms");
 #endif
 
-    detectionVarPartialDerivative1Source->releaseData(firstDerivativeGrid);
-    detectionVarPartialDerivative2Source->releaseData(secondDerivativeGrid);
-
     return rawTropopause;
-
 }
 
+
 MTropopauseTriangleMeshSelection* MTropopauseDetectionSource::getData(MDataRequest request)
 {
     return dynamic_cast<MTropopauseTriangleMeshSelection*>(MScheduledDataSource::getData(request));
@@ -242,20 +448,48 @@ MTropopauseTriangleMeshSelection* MTropopauseDetectionSource::getData(MDataReque
 MTask* MTropopauseDetectionSource::createTaskGraph(MDataRequest request)
 {
     assert(detectionVariableSource != nullptr);
-    assert(detectionVarPartialDerivative1Source != nullptr);
-    assert(detectionVarPartialDerivative2Source != nullptr);
-    assert(dummy1 != nullptr);
+    assert(detectionVarPartialDerivativeSource != nullptr);
+    assert(tropopauseFieldSource != nullptr);
 
     MTask* task =  new MTask(request, this);
+
+    // Persistently cached meshes do not require any input. Invalid cache
+    // files are removed by prepareEntry(), the mesh is then recomputed.
+    if (MPersistentDataCache::getInstance()->prepareEntry(
+                persistentCacheKey(request),
+                MTropopauseTriangleMeshSelection::isValidPersistentCacheEntry))
+    {
+        return task;
+    }
+
     MDataRequestHelper rh(request);
 
+    const DetectionMethod method = static_cast<DetectionMethod>(
+                rh.intValue("TROPOPAUSE_METHOD"));
+
     rh.removeAll(locallyRequiredKeys());
 
-    const int DP = MGradientProperties::DP;
-    rh.insert("GRADIENT", DP);
-    task->addParent(detectionVarPartialDerivative1Source->getTaskGraph(rh.request()));
-    task->addParent(dummy1->getTaskGraph(rh.request()));
-    task->addParent(detectionVarPartialDerivative2Source->getTaskGraph(rh.request()));
+    if (method == WMO_LAPSE_RATE)
+    {
+        rh.insert("TROPOPAUSE_FIELD", MTropopauseFieldSource::PRESSURE);
+        task->addParent(tropopauseFieldSource->getTaskGraph(rh.request()));
+        return task;
+    }
+
+    if (method == DYNAMICAL_PV)
+    {
+        // Invalid inputs are reported by produceData(); do not request a
+        // PV field that cannot be computed.
+        if (!providesPotentialVorticity(rh)) { return task; }
+
+        rh.insert("VARIABLE", PV_VARIABLE_NAME);
+        task->addParent(detectionVariableSource->getTaskGraph(rh.request()));
+        return task;
+    }
+
+    const int DP_D2P = MGradientProperties::DP_D2P;
+    rh.insert("GRADIENT", DP_D2P);
+    task->addParent(detectionVarPartialDerivativeSource->getTaskGraph(rh.request()));
     rh.remove("GRADIENT");
     return task;
 }
@@ -269,24 +503,210 @@ void MTropopauseDetectionSource::initializeTDPipeline()
         MAbstractScheduler *scheduler = sysMC->getScheduler("MultiThread");
         MAbstractMemoryManager *memoryManager = sysMC->getMemoryManager("NWP");
 
-        detectionVarPartialDerivative1Source->setScheduler(scheduler);
-        detectionVarPartialDerivative1Source->setMemoryManager(memoryManager);
-
-        detectionVarPartialDerivative2Source->setScheduler(scheduler);
-        detectionVarPartialDerivative2Source->setMemoryManager(memoryManager);
+        detectionVarPartialDerivativeSource->setScheduler(scheduler);
+        detectionVarPartialDerivativeSource->setMemoryManager(memoryManager);
 
-        dummy1->setScheduler(scheduler);
-        dummy1->setMemoryManager(memoryManager);
+        tropopauseFieldSource->setScheduler(scheduler);
+        tropopauseFieldSource->setMemoryManager(memoryManager);
 
         isInizialized = true;
     }
-    detectionVarPartialDerivative1Source->setInputSource(detectionVariableSource);
-    dummy1->setInputSource(detectionVarPartialDerivative1Source);
-    detectionVarPartialDerivative2Source->setInputSource(dummy1);
+    detectionVarPartialDerivativeSource->setInputSource(detectionVariableSource);
+    tropopauseFieldSource->setInputSource(detectionVariableSource);
+}
+
+
+MTropopauseTriangleMeshSelection* MTropopauseDetectionSource::triangulateTropopauseField(
+        MStructuredGrid *pTropGrid)
+{
+#ifdef MEASURE_CPU_TIME
+    auto start = std::chrono::system_clock::now();
+#endif
+
+    const int nLat = pTropGrid->getNumLats();
+    const int nLon = pTropGrid->getNumLons();
+
+    // Vertex index of each column; columns without tropopause do not become
+    // vertices.
+    QVector<uint32_t> vertexIndices(nLat * nLon, iNaN);
+    uint32_t numVertices = 0;
+    for (int n = 0; n < nLat * nLon; n++)
+    {
+        if (!IS_MISSING(pTropGrid->getValue(n)))
+        {
+            vertexIndices[n] = numVertices++;
+        }
+    }
+
+    // Each grid cell with four valid corners is split into two triangles;
+    // cells with three valid corners contribute a single triangle.
+    QVector<Geometry::MTriangle> triangles;
+    triangles.reserve(2 * numVertices);
+    for (int j = 0; j < nLat - 1; j++)
+    {
+        for (int i = 0; i < nLon - 1; i++)
+        {
+            const uint32_t v00 = vertexIndices[INDEX2yx(j, i, nLon)];
+            const uint32_t v01 = vertexIndices[INDEX2yx(j, i + 1, nLon)];
+            const uint32_t v10 = vertexIndices[INDEX2yx(j + 1, i, nLon)];
+            const uint32_t v11 = vertexIndices[INDEX2yx(j + 1, i + 1, nLon)];
+
+            const int numValid = (v00 != iNaN) + (v01 != iNaN)
+                    + (v10 != iNaN) + (v11 != iNaN);
+
+            if (numValid == 4)
+            {
+                triangles.append({ v00, v01, v11 });
+                triangles.append({ v00, v11, v10 });
+            }
+            else if (numValid == 3)
+            {
+                Geometry::MTriangle triangle = { 0, 0, 0 };
+                int c = 0;
+                for (uint32_t v : { v00, v01, v11, v10 })
+                {
+                    if (v != iNaN) { triangle.indices[c++] = v; }
+                }
+                triangles.append(triangle);
+            }
+        }
+    }
+
+    MTropopauseTriangleMeshSelection *tropopause =
+            new MTropopauseTriangleMeshSelection(numVertices,
+                                                 triangles.size());
+
+#ifdef COMPUTE_PARALLEL
+#pragma omp parallel for collapse(2)
+#endif
+    for (int j = 0; j < nLat; j++)
+    {
+        for (int i = 0; i < nLon; i++)
+        {
+            const uint32_t v = vertexIndices[INDEX2yx(j, i, nLon)];
+            if (v == iNaN) { continue; }
+
+            // Normal of the surface p - pTrop(lon, lat) = 0, oriented as the
+            // normals computed by MMarchingCubes.
+            const int iP = std::max(i - 1, 0);
+            const int iN = std::min(i + 1, nLon - 1);
+            const int jP = std::max(j - 1, 0);
+            const int jN = std::min(j + 1, nLat - 1);
+
+            float dpdlon = 0.;
+            const float pW = pTropGrid->getValue(INDEX2yx(j, iP, nLon));
+            const float pE = pTropGrid->getValue(INDEX2yx(j, iN, nLon));
+            if (!IS_MISSING(pW) && !IS_MISSING(pE) && iN != iP)
+            {
+                dpdlon = (pE - pW) / (pTropGrid->getLons()[iN]
+                                      - pTropGrid->getLons()[iP]);
+            }
+
+            float dpdlat = 0.;
+            const float pS = pTropGrid->getValue(INDEX2yx(jP, i, nLon));
+            const float pN = pTropGrid->getValue(INDEX2yx(jN, i, nLon));
+            if (!IS_MISSING(pS) && !IS_MISSING(pN) && jN != jP)
+            {
+                dpdlat = (pN - pS) / (pTropGrid->getLats()[jN]
+                                      - pTropGrid->getLats()[jP]);
+            }
+
+            Geometry::TropopauseMeshVertex tropopauseVertex;
+            tropopauseVertex.position = QVector3D(
+                        pTropGrid->getLons()[i], pTropGrid->getLats()[j],
+                        pTropGrid->getValue(INDEX2yx(j, i, nLon)));
+            tropopauseVertex.normal = QVector3D(dpdlon, dpdlat, -1.);
+            // The lapse-rate method does not compute vertical derivatives;
+            // the first-derivative filter only applies to the marching
+            // cubes method.
+            tropopauseVertex.firstDeriv = 0.;
+
+            tropopause->setVertex(v, tropopauseVertex);
+        }
+    }
+
+    for (int t = 0; t < triangles.size(); t++)
+    {
+        tropopause->setTriangle(t, triangles.at(t));
+    }
+
+#ifdef MEASURE_CPU_TIME
+    auto end = std::chrono::system_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    LOG4CPLUS_DEBUG(mlog, "Triangulated tropopause field (" << numVertices
+                    << " vertices, " << triangles.size() << " triangles) in "
+                    << elapsed.count() << "ms");
+#endif
+
+    return tropopause;
+}
+
+
+QString MTropopauseDetectionSource::detectionMethodToString(
+        DetectionMethod method)
+{
+    switch (method)
+    {
+    case SECOND_DERIVATIVE_MC:
+        return "second derivative (marching cubes)";
+    case WMO_LAPSE_RATE:
+        return "WMO lapse rate (column scan)";
+    case DYNAMICAL_PV:
+        return "dynamical (PV isosurface)";
+    }
+    return "";
+}
+
+
+MTropopauseDetectionSource::DetectionMethod
+MTropopauseDetectionSource::stringToDetectionMethod(QString method)
+{
+    if (method == "WMO lapse rate (column scan)")
+    {
+        return WMO_LAPSE_RATE;
+    }
+    if (method == "dynamical (PV isosurface)")
+    {
+        return DYNAMICAL_PV;
+    }
+    return SECOND_DERIVATIVE_MC;
+}
+
+
+bool MTropopauseDetectionSource::providesPotentialVorticity(
+        MDataRequestHelper &rh)
+{
+    // PV is computed by MDerivedMetVarsDataSource from model level fields
+    // only (see MPotentialVorticityProcessor_LAGRANTOcalvar).
+    return MVerticalLevelType(rh.intValue("LEVELTYPE"))
+            == HYBRID_SIGMA_PRESSURE_3D
+            && detectionVariableSource->availableVariables(
+                HYBRID_SIGMA_PRESSURE_3D).contains(PV_VARIABLE_NAME);
+}
+
+
+QString MTropopauseDetectionSource::persistentCacheKey(MDataRequest request)
+{
+    // createTaskGraph() and produceData() need to obtain the same key from
+    // the full and the reduced request, respectively.
+    MDataRequestHelper rh(request);
+    rh.removeAllKeysExcept(requiredKeys());
+    return MPersistentDataCache::getInstance()->key(
+                "MTropopauseTriangleMeshSelection/2", rh.request(),
+                dataSignature());
 }
 
 
 const QStringList MTropopauseDetectionSource::locallyRequiredKeys()
 {
-    return (QStringList() << "TROPOPAUSE_ISOVALUE");
+    return (QStringList() << "TROPOPAUSE_ISOVALUE" << "TROPOPAUSE_METHOD"
+            << "TROPOPAUSE_MIN_AREA" << "TROPOPAUSE_ISO_ALGORITHM"
+            << "TROPOPAUSE_MC_MEMORY_LIMIT");
+}
+
+
+const QStringList MTropopauseDetectionSource::locallyOptionalKeys()
+{
+    return (QStringList() << "TROPOPAUSE_SEARCH_BOTTOM"
+            << "TROPOPAUSE_SEARCH_TOP");
 }
@@ -39,32 +39,42 @@
 #include "data/partialderivativefilter.h"
 
 #include "tropopausesurfacemesh.h"
+#include "tropopausefieldsource.h"
+#include "util/mmarchingcubes.h"
 
 #include "gxfw/gl/shadereffect.h"
 
 namespace Met3D
 {
 
-class MDummyFilter
-        : public MSingleInputProcessingWeatherPredictionDataSource
-{
-public:
-    MDummyFilter();
-
-    MStructuredGrid* produceData(MDataRequest request);
-
-    void setInputSource(MWeatherPredictionDataSource* s);
-
-    MTask* createTaskGraph(MDataRequest request);
-protected:
-    const QStringList locallyRequiredKeys();
-
-};
-
-
 class MTropopauseDetectionSource : public MScheduledDataSource
 {
 public:
+    /**
+      Detection methods, passed with the request key "TROPOPAUSE_METHOD".
+      SECOND_DERIVATIVE_MC extracts the isosurface of the second vertical
+      derivative of the detection variable with marching cubes;
+      WMO_LAPSE_RATE scans each column of the temperature field for the WMO
+      lapse-rate tropopause and triangulates the resulting 2D field;
+      DYNAMICAL_PV extracts the isosurface of |PV| = TROPOPAUSE_ISOVALUE
+      (in PVU) bounding the stratospheric air connected to the model top.
+
+      Connected components of the resulting mesh with an area below
+      "TROPOPAUSE_MIN_AREA" (km^2; 0 disables culling) are removed.
+
+      The isosurface methods use the extraction algorithm passed with
+      "TROPOPAUSE_ISO_ALGORITHM" (see @ref MMarchingCubes::Algorithm).
+      MARCHING_CUBES limits its working memory to approximately
+      "TROPOPAUSE_MC_MEMORY_LIMIT" MB by processing the grid in slabs of
+      vertical layers (0 processes the grid in one pass); FLYING_EDGES
+      always processes the whole grid in one pass.
+     */
+    enum DetectionMethod {
+        SECOND_DERIVATIVE_MC = 0,
+        WMO_LAPSE_RATE       = 1,
+        DYNAMICAL_PV         = 2
+    };
+
     explicit MTropopauseDetectionSource();
 
     void setDetectionVariableSource(MWeatherPredictionDataSource* s);
@@ -77,16 +87,77 @@ public:
 
     MTask *createTaskGraph(MDataRequest request) override;
 
+    static QString detectionMethodToString(DetectionMethod method);
+
+    static DetectionMethod stringToDetectionMethod(QString method);
+
+    /**
+      Variable requested from the detection variable source by the
+      DYNAMICAL_PV method (computed by @ref
+      MPotentialVorticityProcessor_LAGRANTOcalvar).
+     */
+    static constexpr const char* PV_VARIABLE_NAME = "ertel_potential_vorticity";
+
 private:
     const QStringList locallyRequiredKeys() override;
+
+    /**
+      The WMO_LAPSE_RATE method passes the search range keys of @ref
+      MTropopauseFieldSource on to the field source.
+     */
+    const QStringList locallyOptionalKeys() override;
     void initializeTDPipeline();
 
+    /**
+      Returns the key under which the mesh generated by @p request is stored
+      in the @ref MPersistentDataCache (empty if persistent caching is
+      disabled).
+     */
+    QString persistentCacheKey(MDataRequest request);
+
+    /**
+      Produces the tropopause mesh with the marching cubes method.
+     */
+    MTropopauseTriangleMeshSelection* produceSecondDerivativeMesh(
+            MDataRequestHelper &rh);
+
+    /**
+      Produces the dynamical tropopause mesh. |PV|, the stratospheric
+      connectivity mask and the marching cubes extraction are computed in
+      this single task; only the PV field itself is taken from the pipeline.
+     */
+    MTropopauseTriangleMeshSelection* produceDynamicalTropopauseMesh(
+            MDataRequestHelper &rh);
+
+    /**
+      Returns true if the detection variable source provides PV on the
+      hybrid sigma-pressure levels requested by @p rh, as required by the
+      DYNAMICAL_PV method.
+     */
+    bool providesPotentialVorticity(MDataRequestHelper &rh);
+
+    /**
+      Copies the mesh computed by @p mc into a new tropopause mesh. The
+      vertex attribute @p firstDerivAttribute of @p mc is used as first
+      derivative; pass -1 if no such attribute exists.
+     */
+    static MTropopauseTriangleMeshSelection* createMeshFromMarchingCubes(
+            MMarchingCubes &mc, int firstDerivAttribute);
+
+    /**
+      Triangulates the 2D tropopause pressure field @p pTropGrid (as computed
+      by @ref MTropopauseFieldSource) into a height-field mesh. Columns
+      without tropopause are left out of the mesh.
+     */
+    static MTropopauseTriangleMeshSelection* triangulateTropopauseField(
+            MStructuredGrid *pTropGrid);
+
     MWeatherPredictionDataSource* detectionVariableSource;
-    MPartialDerivativeFilter* detectionVarPartialDerivative1Source;
-    MPartialDerivativeFilter* detectionVarPartialDerivative2Source;
+    // Computes d/dp and d2/dp2 of the detection variable in one pass
+    // (GRADIENT=DP_D2P).
+    MPartialDerivativeFilter* detectionVarPartialDerivativeSource;
 
-    MDummyFilter* dummy1;
-    MDummyFilter* dummy2;
+    MTropopauseFieldSource* tropopauseFieldSource;
 
     bool isInizialized = false;
 };
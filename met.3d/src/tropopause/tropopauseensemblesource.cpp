@@ -0,0 +1,280 @@
+/******************************************************************************
+**
+**  This file is part of Met.3D -- a research environment for the
+**  three-dimensional visual exploration of numerical ensemble weather
+**  prediction data.
+**
+**  Copyright 2015-2020 Marc Rautenhaus
+**  Copyright 2022      Julian Münsterberg
+**
+**  Regional Computing Center, Visualization
+**  Universitaet Hamburg, Hamburg, Germany
+**
+**  Met.3D is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Met.3D is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Met.3D.  If not, see <http://www.gnu.org/licenses/>.
+**
+*******************************************************************************/
+#include "tropopauseensemblesource.h"
+
+// standard library imports
+#include "assert.h"
+#include <chrono>
+
+// related third party imports
+#include <log4cplus/loggingmacros.h>
+
+// local application imports
+#include "util/mutil.h"
+#include "util/mexception.h"
+
+#define MEASURE_CPU_TIME
+
+using namespace std;
+
+namespace Met3D
+{
+
+/******************************************************************************
+***                     CONSTRUCTOR / DESTRUCTOR                            ***
+*******************************************************************************/
+
+MTropopauseEnsembleSource::MTropopauseEnsembleSource()
+    : MSingleInputProcessingWeatherPredictionDataSource()
+{
+}
+
+
+/******************************************************************************
+***                            PUBLIC METHODS                               ***
+*******************************************************************************/
+
+MStructuredGrid* MTropopauseEnsembleSource::produceData(MDataRequest request)
+{
+    assert(inputSource != nullptr);
+
+#ifdef MEASURE_CPU_TIME
+    auto start = std::chrono::system_clock::now();
+#endif
+
+    MDataRequestHelper rh(request);
+
+    // Parse request.
+    QSet<unsigned int> selectedMembers = rh.uintSetValue("SELECTED_MEMBERS");
+    QString operation = rh.value("ENS_OPERATION");
+
+    rh.removeAll(locallyRequiredKeys());
+
+    if (!isSupportedOperation(operation))
+    {
+        // createTaskGraph() has not requested any member fields.
+        QString msg = QString("Unsupported ensemble operation for tropopause "
+                              "fields: %1. Supported are MEAN, STDDEV and "
+                              "probabilities (P>threshold, P<threshold).")
+                .arg(operation);
+        LOG4CPLUS_ERROR(mlog, msg.toStdString());
+        throw MBadDataFieldRequest(msg.toStdString(), __FILE__, __LINE__);
+    }
+
+    // Probability operations are of the form "P>300" (see
+    // MStructuredGridEnsembleFilter).
+    QString probabilityOp;
+    float threshold = 0.;
+    if (operation.startsWith("P"))
+    {
+        probabilityOp = operation.mid(1, 1);
+        threshold = operation.mid(2).toFloat();
+    }
+    const bool exceedance = (probabilityOp == ">");
+    const bool computeProbability = !probabilityOp.isEmpty();
+
+    MStructuredGrid *mean   = nullptr;
+    MStructuredGrid *stddev = nullptr;
+    MStructuredGrid *prob   = nullptr;
+
+    // Incremental mean and standard deviation (Knuth, TAOCP Vol. 2, 4.2.2;
+    // see MStructuredGridEnsembleFilter). Accumulated in double precision,
+    // the member fields are only two-dimensional.
+    QVector<double> M;
+    QVector<double> S;
+    QVector<int> numValidMembers;
+    QVector<int> numExceedingMembers;
+
+    foreach (unsigned int m, selectedMembers)
+    {
+        rh.insert("MEMBER", m);
+
+        // The parent tasks created in createTaskGraph() have computed the
+        // member fields concurrently; here they are only fetched from the
+        // cache and released immediately after they have been accumulated.
+        MStructuredGrid *memberGrid = inputSource->getData(rh.request());
+
+        if (mean == nullptr)
+        {
+            // First iteration.
+            mean   = createAndInitializeResultGrid(memberGrid);
+            stddev = createAndInitializeResultGrid(memberGrid);
+            prob   = createAndInitializeResultGrid(memberGrid);
+            // Allocate flags bitfield (one flag per member).
+            prob->enableFlags(
+                    MStructuredGrid::numFlagsForMembers(selectedMembers));
+
+            const unsigned int n = memberGrid->getNumValues();
+            M.fill(0., n);
+            S.fill(0., n);
+            numValidMembers.fill(0, n);
+            numExceedingMembers.fill(0, n);
+        }
+
+        for (unsigned int v = 0; v < memberGrid->getNumValues(); v++)
+        {
+            const float x = memberGrid->getData()[v];
+            if (IS_MISSING(x)) continue;
+
+            const int k = ++numValidMembers[v];
+            const double prevMean = M[v];
+            //  M(k) = M(k-1) + (x(k) - M(k-1)) / k
+            M[v] = prevMean + (x - prevMean) / k;
+            //  S(k) = S(k-1) + (x(k) - M(k-1)) * (x(k) - M(k))
+            S[v] += (x - prevMean) * (x - M[v]);
+
+            if (computeProbability
+                    && (exceedance ? (x > threshold) : (x < threshold)))
+            {
+                numExceedingMembers[v]++;
+                prob->setFlag(v, m);
+            }
+        }
+
+        // Store that member m contributed to the result.
+        mean->setContributingMember(m);
+        stddev->setContributingMember(m);
+        prob->setContributingMember(m);
+
+        inputSource->releaseData(memberGrid);
+    }
+
+    if (mean == nullptr)
+    {
+        QString msg = QString("Request %1 does not select any ensemble "
+                              "member.").arg(request);
+        LOG4CPLUS_ERROR(mlog, msg.toStdString());
+        throw MBadDataFieldRequest(msg.toStdString(), __FILE__, __LINE__);
+    }
+
+    for (unsigned int v = 0; v < mean->getNumValues(); v++)
+    {
+        const int n = numValidMembers[v];
+
+        // Columns in which no member has a tropopause remain missing.
+        mean->setValue(v, (n > 0) ? float(M[v]) : M_MISSING_VALUE);
+        //   sigma = sqrt(S(n) / (n - 1))
+        stddev->setValue(v, (n > 1) ? float(sqrt(S[v] / (n - 1)))
+                                    : M_MISSING_VALUE);
+        prob->setValue(v, (n > 0 && computeProbability)
+                       ? float(numExceedingMembers[v]) / n : M_MISSING_VALUE);
+    }
+
+    // Return the requested field; the other fields are cached as well in
+    // case they are requested later (e.g. spread after mean). A probability
+    // field is only cached if its threshold is known.
+    MDataRequestHelper meanRh(request);
+    meanRh.insert("ENS_OPERATION", "MEAN");
+    MDataRequestHelper stddevRh(request);
+    stddevRh.insert("ENS_OPERATION", "STDDEV");
+
+    MStructuredGrid *result = nullptr;
+    if (operation == "MEAN")
+    {
+        result = mean;
+        storeAdditionalResult(stddev, stddevRh.request());
+        delete prob;
+    }
+    else if (operation == "STDDEV")
+    {
+        result = stddev;
+        storeAdditionalResult(mean, meanRh.request());
+        delete prob;
+    }
+    else
+    {
+        result = prob;
+        storeAdditionalResult(mean, meanRh.request());
+        storeAdditionalResult(stddev, stddevRh.request());
+    }
+
+#ifdef MEASURE_CPU_TIME
+    auto end = std::chrono::system_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                end - start);
+    LOG4CPLUS_DEBUG(mlog, "Ensemble tropopause reduction of "
+                    << selectedMembers.size() << " members done in "
+                    << elapsed.count() << "ms");
+#endif
+
+    return result;
+}
+
+
+MTask* MTropopauseEnsembleSource::createTaskGraph(MDataRequest request)
+{
+    assert(inputSource != nullptr);
+
+    MTask *task = new MTask(request, this);
+
+    MDataRequestHelper rh(request);
+    QSet<unsigned int> selectedMembers = rh.uintSetValue("SELECTED_MEMBERS");
+
+    // Requests with an unsupported operation are rejected in produceData();
+    // the member fields are not computed.
+    if (!isSupportedOperation(rh.value("ENS_OPERATION"))) return task;
+
+    rh.removeAll(locallyRequiredKeys());
+
+    // One independent parent per member: the scheduler processes the members
+    // in parallel.
+    foreach (unsigned int m, selectedMembers)
+    {
+        rh.insert("MEMBER", m);
+        task->addParent(inputSource->getTaskGraph(rh.request()));
+    }
+
+    return task;
+}
+
+
+/******************************************************************************
+***                          PROTECTED METHODS                              ***
+*******************************************************************************/
+
+const QStringList MTropopauseEnsembleSource::locallyRequiredKeys()
+{
+    return (QStringList() << "ENS_OPERATION" << "SELECTED_MEMBERS");
+}
+
+
+/******************************************************************************
+***                           PRIVATE METHODS                               ***
+*******************************************************************************/
+
+bool MTropopauseEnsembleSource::isSupportedOperation(const QString& operation)
+{
+    if (operation == "MEAN" || operation == "STDDEV") return true;
+
+    // Probability operations are of the form "P>300".
+    bool thresholdIsValid = false;
+    operation.mid(2).toFloat(&thresholdIsValid);
+    return (operation.startsWith("P>") || operation.startsWith("P<"))
+            && thresholdIsValid;
+}
+
+} // namespace Met3D
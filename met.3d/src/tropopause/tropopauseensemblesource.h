@@ -0,0 +1,87 @@
+/******************************************************************************
+**
+**  This file is part of Met.3D -- a research environment for the
+**  three-dimensional visual exploration of numerical ensemble weather
+**  prediction data.
+**
+**  Copyright 2015-2020 Marc Rautenhaus
+**  Copyright 2022      Julian Münsterberg
+**
+**  Regional Computing Center, Visualization
+**  Universitaet Hamburg, Hamburg, Germany
+**
+**  Met.3D is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Met.3D is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Met.3D.  If not, see <http://www.gnu.org/licenses/>.
+**
+*******************************************************************************/
+#ifndef MET_3D_TROPOPAUSEENSEMBLESOURCE_H
+#define MET_3D_TROPOPAUSEENSEMBLESOURCE_H
+
+// standard library imports
+
+// related third party imports
+#include <QtCore>
+
+// local application imports
+#include "data/processingwpdatasource.h"
+#include "data/structuredgrid.h"
+#include "data/datarequest.h"
+
+namespace Met3D
+{
+
+/**
+  @brief MTropopauseEnsembleSource reduces the two-dimensional tropopause
+  fields of a set of ensemble members (request key "SELECTED_MEMBERS") to
+  ensemble mean, ensemble spread (standard deviation) and the probability of
+  the tropopause field exceeding or falling below a threshold.
+
+  The input source is expected to deliver one @ref MRegularLonLatGrid per
+  member (e.g. @ref MTropopauseFieldSource). The operation is selected by the
+  request key "ENS_OPERATION" using the syntax of @ref
+  MStructuredGridEnsembleFilter: "MEAN", "STDDEV", "P>threshold" or
+  "P<threshold". For the tropopause pressure field, "P>300" hence denotes the
+  probability of the tropopause being located below the 300 hPa surface.
+
+  @ref createTaskGraph() adds one parent task per member, so that the
+  scheduler detects the tropopause of all members concurrently. Each member
+  task only holds its three-dimensional input while scanning it; the
+  reduction in @ref produceData() streams the resulting 2D fields member by
+  member and updates mean, spread and exceedance count incrementally in a
+  single pass. All three results are placed in the memory manager so that
+  switching between them does not trigger a recomputation.
+ */
+class MTropopauseEnsembleSource
+        : public MSingleInputProcessingWeatherPredictionDataSource
+{
+public:
+    MTropopauseEnsembleSource();
+
+    MStructuredGrid* produceData(MDataRequest request) override;
+
+    MTask* createTaskGraph(MDataRequest request) override;
+
+protected:
+    const QStringList locallyRequiredKeys() override;
+
+private:
+    /**
+      Returns true if @p operation is MEAN, STDDEV, P>threshold or
+      P<threshold.
+     */
+    static bool isSupportedOperation(const QString& operation);
+};
+
+} // namespace Met3D
+
+#endif // MET_3D_TROPOPAUSEENSEMBLESOURCE_H
@@ -0,0 +1,421 @@
+/******************************************************************************
+**
+**  This file is part of Met.3D -- a research environment for the
+**  three-dimensional visual exploration of numerical ensemble weather
+**  prediction data.
+**
+**  Copyright 2015-2020 Marc Rautenhaus
+**  Copyright 2022      Julian Münsterberg
+**
+**  Regional Computing Center, Visualization
+**  Universitaet Hamburg, Hamburg, Germany
+**
+**  Met.3D is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Met.3D is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Met.3D.  If not, see <http://www.gnu.org/licenses/>.
+**
+*******************************************************************************/
+#include "tropopausefieldsource.h"
+
+// standard library imports
+#include "assert.h"
+#include <chrono>
+
+// related third party imports
+#include <log4cplus/loggingmacros.h>
+#include <omp.h>
+
+// local application imports
+#include "util/mutil.h"
+#include "util/mexception.h"
+#include "util/metroutines.h"
+
+#define MEASURE_CPU_TIME
+
+using namespace std;
+
+namespace Met3D
+{
+
+/******************************************************************************
+***                     CONSTRUCTOR / DESTRUCTOR                            ***
+*******************************************************************************/
+
+MTropopauseFieldSource::MTropopauseFieldSource()
+    : MSingleInputProcessingWeatherPredictionDataSource()
+{
+}
+
+
+/******************************************************************************
+***                            PUBLIC METHODS                               ***
+*******************************************************************************/
+
+MStructuredGrid* MTropopauseFieldSource::produceData(MDataRequest request)
+{
+    assert(inputSource != nullptr);
+
+    const TropopauseField requested = requestedField(request);
+
+    // If the field has been cached persistently, createTaskGraph() has
+    // prepared its cache entry and not requested the temperature field.
+    MPersistentDataCache *persistentCache = MPersistentDataCache::getInstance();
+    const QString cacheKey = persistentCacheKey(request);
+
+    if (MPersistentCacheEntry *entry =
+            persistentCache->takePreparedEntry(cacheKey))
+    {
+        // The entry has been validated in createTaskGraph().
+        MRegularLonLatGrid *grid = createFromPersistentCacheEntry(entry);
+        delete entry;
+        return grid;
+    }
+
+    // Pressure range in which the tropopause is searched for. Restricting
+    // the search excludes lapse-rate minima in the boundary layer and in
+    // the stratosphere.
+    MDataRequestHelper rh(request);
+    const float searchBottom_hPa = rh.contains("TROPOPAUSE_SEARCH_BOTTOM")
+            ? rh.floatValue("TROPOPAUSE_SEARCH_BOTTOM") : 550.;
+    const float searchTop_hPa = rh.contains("TROPOPAUSE_SEARCH_TOP")
+            ? rh.floatValue("TROPOPAUSE_SEARCH_TOP") : 75.;
+
+    if (searchTop_hPa >= searchBottom_hPa)
+    {
+        QString msg = QString("Invalid tropopause search range %1-%2 hPa.")
+                .arg(searchBottom_hPa).arg(searchTop_hPa);
+        LOG4CPLUS_ERROR(mlog, msg.toStdString());
+        throw MBadDataFieldRequest(msg.toStdString(), __FILE__, __LINE__);
+    }
+
+    MStructuredGrid *temperatureGrid =
+            inputSource->getData(inputRequest(request));
+
+    MRegularLonLatGrid *fieldGrids[3];
+    for (int f = PRESSURE; f <= TEMPERATURE; f++)
+    {
+        fieldGrids[f] = createHorizontalResultGrid(
+                    temperatureGrid,
+                    tropopauseFieldToString(TropopauseField(f)));
+    }
+
+    computeWMOTropopause(temperatureGrid, searchBottom_hPa, searchTop_hPa,
+                         fieldGrids);
+
+    inputSource->releaseData(temperatureGrid);
+
+    // The fields that have not been requested are cached as well, e.g. for
+    // a horizontal section switching from tropopause pressure to height.
+    for (int f = PRESSURE; f <= TEMPERATURE; f++)
+    {
+        MDataRequest siblingRequest =
+                fieldRequest(request, TropopauseField(f));
+
+        storeInPersistentCache(fieldGrids[f],
+                               persistentCacheKey(siblingRequest));
+
+        if (f == requested) continue;
+        storeAdditionalResult(fieldGrids[f], siblingRequest);
+    }
+
+    return fieldGrids[requested];
+}
+
+
+MTask* MTropopauseFieldSource::createTaskGraph(MDataRequest request)
+{
+    assert(inputSource != nullptr);
+
+    MTask *task = new MTask(request, this);
+
+    // Persistently cached fields do not require the temperature field.
+    // Invalid cache files are removed by prepareEntry(), the field is then
+    // recomputed.
+    if (!MPersistentDataCache::getInstance()->prepareEntry(
+                persistentCacheKey(request), isValidPersistentCacheEntry))
+    {
+        task->addParent(inputSource->getTaskGraph(inputRequest(request)));
+    }
+
+    return task;
+}
+
+
+QString MTropopauseFieldSource::tropopauseFieldToString(TropopauseField field)
+{
+    switch (field)
+    {
+    case PRESSURE:
+        return "tropopause_air_pressure";
+    case HEIGHT:
+        return "tropopause_altitude";
+    case TEMPERATURE:
+        return "tropopause_air_temperature";
+    }
+    return "";
+}
+
+
+int MTropopauseFieldSource::stringToTropopauseField(const QString& fieldName)
+{
+    for (int f = PRESSURE; f <= TEMPERATURE; f++)
+    {
+        if (fieldName == tropopauseFieldToString(TropopauseField(f)))
+        {
+            return f;
+        }
+    }
+    return -1;
+}
+
+
+QString MTropopauseFieldSource::tropopauseFieldUnits(TropopauseField field)
+{
+    switch (field)
+    {
+    case PRESSURE:
+        return "hPa";
+    case HEIGHT:
+        return "m";
+    case TEMPERATURE:
+        return "K";
+    }
+    return "";
+}
+
+
+/******************************************************************************
+***                          PROTECTED METHODS                              ***
+*******************************************************************************/
+
+const QStringList MTropopauseFieldSource::locallyRequiredKeys()
+{
+    return (QStringList() << "TROPOPAUSE_FIELD");
+}
+
+
+const QStringList MTropopauseFieldSource::locallyOptionalKeys()
+{
+    return (QStringList() << "TROPOPAUSE_SEARCH_BOTTOM"
+            << "TROPOPAUSE_SEARCH_TOP");
+}
+
+
+MTropopauseFieldSource::TropopauseField MTropopauseFieldSource::requestedField(
+        MDataRequest request)
+{
+    MDataRequestHelper rh(request);
+    return static_cast<TropopauseField>(rh.intValue("TROPOPAUSE_FIELD"));
+}
+
+
+MDataRequest MTropopauseFieldSource::inputRequest(MDataRequest request)
+{
+    MDataRequestHelper rh(request);
+    rh.removeAll(locallyRequiredKeys());
+    rh.removeAll(locallyOptionalKeys());
+    return rh.request();
+}
+
+
+MDataRequest MTropopauseFieldSource::fieldRequest(MDataRequest request,
+                                                  TropopauseField field)
+{
+    MDataRequestHelper rh(request);
+    rh.insert("TROPOPAUSE_FIELD", field);
+    return rh.request();
+}
+
+
+QString MTropopauseFieldSource::persistentCacheKey(MDataRequest request)
+{
+    // createTaskGraph() and produceData() need to obtain the same key from
+    // the full and the reduced request, respectively.
+    MDataRequestHelper rh(request);
+    rh.removeAllKeysExcept(requiredKeys());
+    return MPersistentDataCache::getInstance()->key(
+                "MTropopauseFieldSource/1", rh.request(), dataSignature());
+}
+
+
+/******************************************************************************
+***                           PRIVATE METHODS                               ***
+*******************************************************************************/
+
+// Fixed-size part of a persistently cached tropopause field.
+struct MTropopauseFieldCacheHeader
+{
+    qint64  initTime_ms;
+    qint64  validTime_ms;
+    quint64 availableMembers;
+    qint32  ensembleMember;
+    qint32  horizontalGridType;
+    quint32 nlats;
+    quint32 nlons;
+};
+
+
+void MTropopauseFieldSource::storeInPersistentCache(MRegularLonLatGrid *grid,
+                                                    const QString& key)
+{
+    if (key.isEmpty()) return;
+
+    MTropopauseFieldCacheHeader header;
+    header.initTime_ms = grid->getInitTime().toMSecsSinceEpoch();
+    header.validTime_ms = grid->getValidTime().toMSecsSinceEpoch();
+    header.availableMembers = grid->getAvailableMembers();
+    header.ensembleMember = grid->getEnsembleMember();
+    header.horizontalGridType = grid->getHorizontalGridType();
+    header.nlats = grid->getNumLats();
+    header.nlons = grid->getNumLons();
+
+    QByteArray variableName = grid->getVariableName().toUtf8();
+
+    QVector<MPersistentCacheBlock> blocks;
+    blocks << MPersistentCacheBlock(&header, sizeof(header))
+           << MPersistentCacheBlock(variableName.constData(),
+                                    variableName.size())
+           << MPersistentCacheBlock(grid->getLats(),
+                                    header.nlats * sizeof(double))
+           << MPersistentCacheBlock(grid->getLons(),
+                                    header.nlons * sizeof(double))
+           << MPersistentCacheBlock(grid->getData(),
+                                    qint64(grid->getNumValues())
+                                    * sizeof(float));
+
+    MPersistentDataCache::getInstance()->store(key, blocks);
+}
+
+
+bool MTropopauseFieldSource::isValidPersistentCacheEntry(
+        const MPersistentCacheEntry *entry)
+{
+    if (entry->getNumBlocks() != 5
+            || entry->getBlockSize(0) != sizeof(MTropopauseFieldCacheHeader))
+    {
+        return false;
+    }
+
+    const MTropopauseFieldCacheHeader *header =
+            static_cast<const MTropopauseFieldCacheHeader*>(entry->getBlock(0));
+
+    return entry->getBlockSize(2) == qint64(header->nlats * sizeof(double))
+            && entry->getBlockSize(3) == qint64(header->nlons * sizeof(double))
+            && entry->getBlockSize(4)
+            == qint64(header->nlats) * header->nlons * sizeof(float);
+}
+
+
+MRegularLonLatGrid* MTropopauseFieldSource::createFromPersistentCacheEntry(
+        const MPersistentCacheEntry *entry)
+{
+    if (!isValidPersistentCacheEntry(entry)) return nullptr;
+
+    const MTropopauseFieldCacheHeader *header =
+            static_cast<const MTropopauseFieldCacheHeader*>(entry->getBlock(0));
+
+    MRegularLonLatGrid *grid =
+            new MRegularLonLatGrid(header->nlats, header->nlons);
+
+    grid->setHorizontalGridType(
+                MHorizontalGridType(header->horizontalGridType));
+    const double *lats = static_cast<const double*>(entry->getBlock(2));
+    const double *lons = static_cast<const double*>(entry->getBlock(3));
+    for (unsigned int j = 0; j < header->nlats; j++) grid->setLat(j, lats[j]);
+    for (unsigned int i = 0; i < header->nlons; i++) grid->setLon(i, lons[i]);
+
+    const float *values = static_cast<const float*>(entry->getBlock(4));
+    for (unsigned int v = 0; v < grid->getNumValues(); v++)
+    {
+        grid->MStructuredGrid::setValue(v, values[v]);
+    }
+
+    grid->setAvailableMembers(header->availableMembers);
+    grid->setMetaData(
+                QDateTime::fromMSecsSinceEpoch(header->initTime_ms).toUTC(),
+                QDateTime::fromMSecsSinceEpoch(header->validTime_ms).toUTC(),
+                QString::fromUtf8(static_cast<const char*>(entry->getBlock(1)),
+                                  entry->getBlockSize(1)),
+                header->ensembleMember);
+
+    return grid;
+}
+
+
+void MTropopauseFieldSource::computeWMOTropopause(
+        MStructuredGrid *temperatureGrid,
+        float searchBottom_hPa, float searchTop_hPa,
+        MRegularLonLatGrid **fieldGrids)
+{
+#ifdef MEASURE_CPU_TIME
+    auto start = std::chrono::system_clock::now();
+#endif
+
+    const int nLev = temperatureGrid->getNumLevels();
+    const int nLat = temperatureGrid->getNumLats();
+    const int nLon = temperatureGrid->getNumLons();
+
+#pragma omp parallel
+    {
+        // Per-thread column buffers, ordered from the bottom upwards.
+        QVector<float> p_hPa(nLev);
+        QVector<float> T_K(nLev);
+        QVector<float> z_m(nLev);
+
+#pragma omp for collapse(2)
+        for (int j = 0; j < nLat; j++)
+        {
+            for (int i = 0; i < nLon; i++)
+            {
+                // Level ordering differs between grid types (and for
+                // auxiliary pressure grids even between data sets).
+                const bool topDown = temperatureGrid->getPressure(0, j, i)
+                        < temperatureGrid->getPressure(nLev - 1, j, i);
+
+                for (int k = 0; k < nLev; k++)
+                {
+                    const int kGrid = topDown ? nLev - 1 - k : k;
+                    p_hPa[k] = temperatureGrid->getPressure(kGrid, j, i);
+                    T_K[k] = temperatureGrid->getValue(kGrid, j, i);
+                }
+
+                hypsometricColumnHeights_m(p_hPa.constData(), T_K.constData(),
+                                           nLev, z_m.data());
+
+                float pTrop_hPa, zTrop_m, TTrop_K;
+                int kTrop = wmoLapseRateTropopause(
+                            p_hPa.constData(), T_K.constData(),
+                            z_m.constData(), nLev, 0,
+                            searchBottom_hPa, searchTop_hPa,
+                            &pTrop_hPa, &zTrop_m, &TTrop_K);
+
+                if (kTrop < 0)
+                {
+                    pTrop_hPa = zTrop_m = TTrop_K = M_MISSING_VALUE;
+                }
+                fieldGrids[PRESSURE]->setValue(j, i, pTrop_hPa);
+                fieldGrids[HEIGHT]->setValue(j, i, zTrop_m);
+                fieldGrids[TEMPERATURE]->setValue(j, i, TTrop_K);
+            }
+        }
+    }
+
+#ifdef MEASURE_CPU_TIME
+    auto end = std::chrono::system_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                end - start);
+    LOG4CPLUS_DEBUG(mlog, "WMO tropopause column scan done in "
+                    << elapsed.count() << "ms");
+#endif
+}
+
+} // namespace Met3D
@@ -0,0 +1,162 @@
+/******************************************************************************
+**
+**  This file is part of Met.3D -- a research environment for the
+**  three-dimensional visual exploration of numerical ensemble weather
+**  prediction data.
+**
+**  Copyright 2015-2020 Marc Rautenhaus
+**  Copyright 2022      Julian Münsterberg
+**
+**  Regional Computing Center, Visualization
+**  Universitaet Hamburg, Hamburg, Germany
+**
+**  Met.3D is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Met.3D is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Met.3D.  If not, see <http://www.gnu.org/licenses/>.
+**
+*******************************************************************************/
+#ifndef MET_3D_TROPOPAUSEFIELDSOURCE_H
+#define MET_3D_TROPOPAUSEFIELDSOURCE_H
+
+// standard library imports
+
+// related third party imports
+#include <QtCore>
+
+// local application imports
+#include "data/processingwpdatasource.h"
+#include "data/structuredgrid.h"
+#include "data/datarequest.h"
+#include "data/persistentdatacache.h"
+
+namespace Met3D
+{
+
+/**
+  @brief MTropopauseFieldSource computes two-dimensional tropopause fields
+  (pressure, height, temperature) from a three-dimensional temperature field
+  by scanning each grid column once and applying the WMO lapse-rate criterion
+  (see @ref wmoLapseRateTropopause()).
+
+  The requested field is selected by the request key "TROPOPAUSE_FIELD"
+  (see @ref TropopauseField). The tropopause is searched for between the
+  optional request keys "TROPOPAUSE_SEARCH_BOTTOM" and "TROPOPAUSE_SEARCH_TOP"
+  (hPa; 550 and 75 hPa if omitted). The result is a @ref
+  MRegularLonLatGrid; columns without tropopause are set to M_MISSING_VALUE. Since a single scan yields
+  all fields, the fields that have not been requested are placed in the
+  memory manager as well.
+
+  Computed fields are also written to the @ref MPersistentDataCache (if
+  enabled); fields found there are read instead of requesting the
+  temperature field.
+
+  Subclasses can change how fields are requested by overriding @ref
+  requestedField(), @ref inputRequest() and @ref fieldRequest() (see @ref
+  MTropopauseDataSource).
+ */
+class MTropopauseFieldSource
+        : public MSingleInputProcessingWeatherPredictionDataSource
+{
+public:
+    enum TropopauseField {
+        PRESSURE    = 0,   // hPa
+        HEIGHT      = 1,   // m
+        TEMPERATURE = 2    // K
+    };
+
+    MTropopauseFieldSource();
+
+    MStructuredGrid* produceData(MDataRequest request) override;
+
+    MTask* createTaskGraph(MDataRequest request) override;
+
+    /**
+      Returns the CF standard name of @p field, which is also used as
+      variable name of the result grids.
+     */
+    static QString tropopauseFieldToString(TropopauseField field);
+
+    /**
+      Inverse of @ref tropopauseFieldToString(). Returns -1 if @p fieldName
+      is not the name of a tropopause field.
+     */
+    static int stringToTropopauseField(const QString& fieldName);
+
+    static QString tropopauseFieldUnits(TropopauseField field);
+
+protected:
+    const QStringList locallyRequiredKeys() override;
+
+    const QStringList locallyOptionalKeys() override;
+
+    /**
+      Returns the field requested by @p request.
+     */
+    virtual TropopauseField requestedField(MDataRequest request);
+
+    /**
+      Returns the request for the temperature field that @p request is
+      computed from.
+     */
+    virtual MDataRequest inputRequest(MDataRequest request);
+
+    /**
+      Returns the request under which @p field is stored if computed together
+      with the field requested by @p request.
+     */
+    virtual MDataRequest fieldRequest(MDataRequest request,
+                                      TropopauseField field);
+
+    /**
+      Returns the key under which the field generated by @p request is
+      stored in the @ref MPersistentDataCache (empty if persistent caching is
+      disabled).
+     */
+    QString persistentCacheKey(MDataRequest request);
+
+private:
+    /**
+      Scans all columns of @p temperatureGrid between @p searchBottom_hPa
+      and @p searchTop_hPa and writes tropopause pressure, height and
+      temperature to the corresponding entries of @p fieldGrids (indexed by
+      @ref TropopauseField).
+     */
+    void computeWMOTropopause(MStructuredGrid *temperatureGrid,
+                              float searchBottom_hPa, float searchTop_hPa,
+                              MRegularLonLatGrid **fieldGrids);
+
+    /**
+      Writes @p grid including its metadata to the persistent cache file
+      @p key.
+     */
+    static void storeInPersistentCache(MRegularLonLatGrid *grid,
+                                       const QString& key);
+
+    /**
+      Returns true if @p entry contains a grid written by @ref
+      storeInPersistentCache().
+     */
+    static bool isValidPersistentCacheEntry(
+            const MPersistentCacheEntry *entry);
+
+    /**
+      Creates a grid from a cache entry written by @ref
+      storeInPersistentCache(). Returns a null pointer if @p entry is not
+      valid.
+     */
+    static MRegularLonLatGrid* createFromPersistentCacheEntry(
+            const MPersistentCacheEntry *entry);
+};
+
+} // namespace Met3D
+
+#endif // MET_3D_TROPOPAUSEFIELDSOURCE_H
@@ -27,9 +27,18 @@
 
 #include "tropopausesurfacemesh.h"
 
+// standard library imports
+#include <atomic>
+#include <memory>
+
 // related third party imports
+#include <log4cplus/loggingmacros.h>
+#include <omp.h>
+
 #include "gxfw/gl/typedvertexbuffer.h"
 #include "gxfw/gl/indexbuffer.h"
+#include "util/mutil.h"
+#include "util/metroutines.h"
 
 #include <iostream>
 #include <fstream>
@@ -60,18 +69,21 @@ MTropopauseTriangleMeshSelection::~MTropopauseTriangleMeshSelection()
 
 unsigned int MTropopauseTriangleMeshSelection::getMemorySize_kb()
 {
-    const uint32_t classByteSize = sizeof(MTropopauseTriangleMeshSelection);
-
-    const uint32_t vertexByteSize =
-            numVertices * sizeof(Geometry::TropopauseMeshVertex);
+    // Meshes extracted from large grids exceed 4 GB; compute in 64 bit.
+    const quint64 classByteSize = sizeof(MTropopauseTriangleMeshSelection);
 
-    const uint32_t trianglesByteSize =
-            sizeof(Geometry::MTriangle) * numTriangles;
+    const quint64 vertexByteSize =
+            quint64(numVertices) * sizeof(Geometry::TropopauseMeshVertex);
 
+    const quint64 trianglesByteSize =
+            quint64(numTriangles) * sizeof(Geometry::MTriangle);
 
-    int totalSize_kb = (classByteSize + vertexByteSize + trianglesByteSize) / 1024;
+    const quint64 componentsByteSize =
+            quint64(triangleComponents.size()) * sizeof(uint32_t)
+            + quint64(components.size()) * sizeof(ComponentProperties);
 
-    return totalSize_kb;
+    return (classByteSize + vertexByteSize + trianglesByteSize
+            + componentsByteSize) / 1024;
 }
 
 
@@ -150,3 +162,283 @@ void MTropopauseTriangleMeshSelection::releaseIndexBuffer()
 {
     MGLResourcesManager::getInstance()->releaseGPUItem(getID());
 }
+
+
+/******************************************************************************
+***                        CONNECTED COMPONENTS                             ***
+*******************************************************************************/
+
+namespace
+{
+
+// Lock-free union-find: roots are linked with compare-and-swap, always from
+// the larger to the smaller index; find() halves the path.
+uint32_t findRoot(std::atomic<uint32_t> *parent, uint32_t x)
+{
+    while (true)
+    {
+        uint32_t p = parent[x].load(std::memory_order_relaxed);
+        if (p == x) { return x; }
+        const uint32_t gp = parent[p].load(std::memory_order_relaxed);
+        if (p != gp)
+        {
+            parent[x].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+        }
+        x = gp;
+    }
+}
+
+
+void unite(std::atomic<uint32_t> *parent, uint32_t a, uint32_t b)
+{
+    while (true)
+    {
+        a = findRoot(parent, a);
+        b = findRoot(parent, b);
+        if (a == b) { return; }
+        if (a < b) { std::swap(a, b); }
+
+        uint32_t expected = a;
+        if (parent[a].compare_exchange_strong(expected, b))
+        {
+            return;
+        }
+        // a is no longer a root; retry.
+    }
+}
+
+
+QVector3D toKilometres(const QVector3D &lonLatP, const float cosLat)
+{
+    const double DEG2RAD = M_PI / 180.;
+    return QVector3D(
+            lonLatP.x() * DEG2RAD * MetConstants::EARTH_RADIUS_km * cosLat,
+            lonLatP.y() * DEG2RAD * MetConstants::EARTH_RADIUS_km,
+            pressure2metre_standardICAO(lonLatP.z() * 100.) / 1000.);
+}
+
+} // namespace
+
+
+void MTropopauseTriangleMeshSelection::labelConnectedComponents()
+{
+    std::unique_ptr<std::atomic<uint32_t>[]> parent(
+                new std::atomic<uint32_t>[numVertices]);
+
+#pragma omp parallel for
+    for (int64_t v = 0; v < int64_t(numVertices); v++)
+    {
+        parent[v].store(uint32_t(v), std::memory_order_relaxed);
+    }
+
+#pragma omp parallel for
+    for (int64_t t = 0; t < int64_t(numTriangles); t++)
+    {
+        const Geometry::MTriangle &tri = triangles[t];
+        unite(parent.get(), tri.indices[0], tri.indices[1]);
+        unite(parent.get(), tri.indices[0], tri.indices[2]);
+    }
+
+    // Area and centroid pressure of each triangle. Horizontal distances are
+    // measured on the sphere, vertical distances in the ICAO standard
+    // atmosphere.
+    QVector<double> triangleArea_km2(numTriangles);
+    QVector<double> trianglePressure_hPa(numTriangles);
+    triangleComponents.resize(numTriangles);
+
+#pragma omp parallel for
+    for (int64_t t = 0; t < int64_t(numTriangles); t++)
+    {
+        const Geometry::MTriangle &tri = triangles[t];
+        const QVector3D &p0 = vertices[tri.indices[0]].position;
+        const QVector3D &p1 = vertices[tri.indices[1]].position;
+        const QVector3D &p2 = vertices[tri.indices[2]].position;
+
+        const float cosLat = std::cos(
+                    (p0.y() + p1.y() + p2.y()) / 3. / 180. * M_PI);
+        const QVector3D k0 = toKilometres(p0, cosLat);
+        const QVector3D e1 = toKilometres(p1, cosLat) - k0;
+        const QVector3D e2 = toKilometres(p2, cosLat) - k0;
+
+        triangleArea_km2[t] = 0.5 * QVector3D::crossProduct(e1, e2).length();
+        trianglePressure_hPa[t] = (p0.z() + p1.z() + p2.z()) / 3.;
+        triangleComponents[t] = findRoot(parent.get(), tri.indices[0]);
+    }
+
+    // Dense component labels; accumulate the component properties.
+    QVector<uint32_t> rootToComponent(numVertices, UINT32_MAX);
+    components.clear();
+    QVector<double> pressureSum;
+    QVector<double> unweightedPressureSum;
+
+    for (uint32_t t = 0; t < numTriangles; t++)
+    {
+        const uint32_t root = triangleComponents[t];
+        if (rootToComponent[root] == UINT32_MAX)
+        {
+            rootToComponent[root] = components.size();
+            components.append({ 0., 0., 0 });
+            pressureSum.append(0.);
+            unweightedPressureSum.append(0.);
+        }
+
+        const uint32_t c = rootToComponent[root];
+        triangleComponents[t] = c;
+        components[c].area_km2 += triangleArea_km2[t];
+        components[c].numTriangles++;
+        pressureSum[c] += triangleArea_km2[t] * trianglePressure_hPa[t];
+        unweightedPressureSum[c] += trianglePressure_hPa[t];
+    }
+
+    for (int c = 0; c < components.size(); c++)
+    {
+        components[c].meanPressure_hPa = (components[c].area_km2 > 0.)
+                ? pressureSum[c] / components[c].area_km2
+                : unweightedPressureSum[c] / components[c].numTriangles;
+    }
+
+    LOG4CPLUS_DEBUG(mlog, "Tropopause mesh: " << components.size()
+                    << " connected components.");
+}
+
+
+uint32_t MTropopauseTriangleMeshSelection::removeSmallComponents(
+        double minArea_km2)
+{
+    if (uint32_t(triangleComponents.size()) != numTriangles)
+    {
+        labelConnectedComponents();
+    }
+
+    // New component labels; UINT32_MAX marks removed components.
+    QVector<uint32_t> newComponentIndex(components.size(), UINT32_MAX);
+    QVector<ComponentProperties> keptComponents;
+    for (int c = 0; c < components.size(); c++)
+    {
+        if (components[c].area_km2 >= minArea_km2)
+        {
+            newComponentIndex[c] = keptComponents.size();
+            keptComponents.append(components[c]);
+        }
+    }
+
+    const uint32_t numRemovedComponents =
+            components.size() - keptComponents.size();
+    if (numRemovedComponents == 0) { return 0; }
+
+    // Compact triangles and collect the vertices they reference.
+    QVector<uint32_t> newVertexIndex(numVertices, UINT32_MAX);
+    QVector<uint32_t> keptTriangleComponents;
+    uint32_t newNumTriangles = 0;
+    uint32_t newNumVertices = 0;
+
+    for (uint32_t t = 0; t < numTriangles; t++)
+    {
+        const uint32_t c = newComponentIndex[triangleComponents[t]];
+        if (c == UINT32_MAX) { continue; }
+
+        Geometry::MTriangle tri = triangles[t];
+        for (int n = 0; n < 3; n++)
+        {
+            uint32_t &newIndex = newVertexIndex[tri.indices[n]];
+            if (newIndex == UINT32_MAX) { newIndex = newNumVertices++; }
+            tri.indices[n] = newIndex;
+        }
+        // In-place is safe since newNumTriangles <= t.
+        triangles[newNumTriangles++] = tri;
+        keptTriangleComponents.append(c);
+    }
+
+    Geometry::TropopauseMeshVertex *newVertices =
+            new Geometry::TropopauseMeshVertex[newNumVertices];
+#pragma omp parallel for
+    for (int64_t v = 0; v < int64_t(numVertices); v++)
+    {
+        if (newVertexIndex[v] != UINT32_MAX)
+        {
+            newVertices[newVertexIndex[v]] = vertices[v];
+        }
+    }
+
+    Geometry::MTriangle *newTriangles =
+            new Geometry::MTriangle[newNumTriangles];
+    std::copy(triangles, triangles + newNumTriangles, newTriangles);
+
+    LOG4CPLUS_DEBUG(mlog, "Tropopause mesh: removed " << numRemovedComponents
+                    << " components smaller than " << minArea_km2
+                    << " km^2; " << newNumVertices << " of " << numVertices
+                    << " vertices and " << newNumTriangles << " of "
+                    << numTriangles << " triangles remain.");
+
+    delete[] vertices;
+    delete[] triangles;
+    vertices = newVertices;
+    triangles = newTriangles;
+    numVertices = newNumVertices;
+    numTriangles = newNumTriangles;
+    triangleComponents = keptTriangleComponents;
+    components = keptComponents;
+
+    return numRemovedComponents;
+}
+
+
+QVector<MPersistentCacheBlock>
+MTropopauseTriangleMeshSelection::getPersistentCacheBlocks() const
+{
+    // Element counts are stored in the first two blocks; the component
+    // labels are not stored, they are recomputed on demand.
+
+    QVector<MPersistentCacheBlock> blocks;
+    blocks << MPersistentCacheBlock(&numVertices, sizeof(numVertices))
+           << MPersistentCacheBlock(&numTriangles, sizeof(numTriangles))
+           << MPersistentCacheBlock(
+                  vertices,
+                  qint64(numVertices) * sizeof(Geometry::TropopauseMeshVertex))
+           << MPersistentCacheBlock(
+                  triangles,
+                  qint64(numTriangles) * sizeof(Geometry::MTriangle));
+    return blocks;
+}
+
+
+bool MTropopauseTriangleMeshSelection::isValidPersistentCacheEntry(
+        const MPersistentCacheEntry *entry)
+{
+    if (entry->getNumBlocks() != 4
+            || entry->getBlockSize(0) != sizeof(uint32_t)
+            || entry->getBlockSize(1) != sizeof(uint32_t))
+    {
+        return false;
+    }
+
+    const uint32_t nVertices =
+            *static_cast<const uint32_t*>(entry->getBlock(0));
+    const uint32_t nTriangles =
+            *static_cast<const uint32_t*>(entry->getBlock(1));
+
+    return entry->getBlockSize(2)
+            == qint64(nVertices) * sizeof(Geometry::TropopauseMeshVertex)
+            && entry->getBlockSize(3)
+            == qint64(nTriangles) * sizeof(Geometry::MTriangle);
+}
+
+
+MTropopauseTriangleMeshSelection*
+MTropopauseTriangleMeshSelection::createFromPersistentCacheEntry(
+        const MPersistentCacheEntry *entry)
+{
+    if (!isValidPersistentCacheEntry(entry)) return nullptr;
+
+    const uint32_t nVertices =
+            *static_cast<const uint32_t*>(entry->getBlock(0));
+    const uint32_t nTriangles =
+            *static_cast<const uint32_t*>(entry->getBlock(1));
+
+    MTropopauseTriangleMeshSelection *mesh =
+            new MTropopauseTriangleMeshSelection(nVertices, nTriangles);
+    memcpy(mesh->vertices, entry->getBlock(2), entry->getBlockSize(2));
+    memcpy(mesh->triangles, entry->getBlock(3), entry->getBlockSize(3));
+
+    return mesh;
+}
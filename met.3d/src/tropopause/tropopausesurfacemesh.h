@@ -31,11 +31,13 @@
 // standard library imports
 
 // related third party imports
+#include <QVector>
 
 // local application imports
 #include "data/structuredgrid.h"
 #include "data/datarequest.h"
 #include "data/scheduleddatasource.h"
+#include "data/persistentdatacache.h"
 #include "gxfw/gl/indexbuffer.h"
 #include "util/geometry.h"
 
@@ -46,6 +48,17 @@ namespace Met3D
 class MTropopauseTriangleMeshSelection : public MAbstractDataItem
 {
 public:
+    /**
+      Properties of a connected component of the mesh, see @ref
+      labelConnectedComponents().
+     */
+    struct ComponentProperties
+    {
+        double   area_km2;
+        double   meanPressure_hPa; // area-weighted
+        uint32_t numTriangles;
+    };
+
     /**
       The constructor allocates the data array
 
@@ -99,6 +112,54 @@ public:
     void releaseVertexBuffer();
     void releaseIndexBuffer();
 
+    /**
+      Labels the connected components of the mesh (triangles that share a
+      vertex; marching cubes shares the vertices of adjacent triangles) with
+      a parallel union-find pass over the triangle indices, and computes
+      area and mean pressure of each component. Vertex positions are
+      expected in lon/lat/pressure (hPa) coordinates.
+     */
+    void labelConnectedComponents();
+
+    uint32_t getNumComponents() const { return components.size(); }
+
+    const ComponentProperties& getComponentProperties(uint32_t c) const
+    { return components[c]; }
+
+    /** Component label of triangle @p i (after labelling). */
+    uint32_t getTriangleComponent(uint32_t i) const
+    { return triangleComponents[i]; }
+
+    /**
+      Removes all components with an area smaller than @p minArea_km2
+      (labelling the components first if necessary) and compacts the vertex
+      and triangle arrays; unreferenced vertices are dropped. Needs to be
+      called before the mesh is stored in the memory manager and before
+      GPU buffers are created. Returns the number of removed components.
+     */
+    uint32_t removeSmallComponents(double minArea_km2);
+
+    /**
+      Returns vertex and triangle arrays as blocks to be written with @ref
+      MPersistentDataCache::store(). The blocks reference the mesh's memory.
+     */
+    QVector<MPersistentCacheBlock> getPersistentCacheBlocks() const;
+
+    /**
+      Returns true if @p entry contains the blocks of a mesh written with
+      @ref getPersistentCacheBlocks().
+     */
+    static bool isValidPersistentCacheEntry(
+            const MPersistentCacheEntry *entry);
+
+    /**
+      Creates a mesh from a cache file written with the blocks of @ref
+      getPersistentCacheBlocks(). Returns a null pointer if @p entry does
+      not contain a valid mesh.
+     */
+    static MTropopauseTriangleMeshSelection* createFromPersistentCacheEntry(
+            const MPersistentCacheEntry *entry);
+
 protected:
     Geometry::TropopauseMeshVertex *vertices;
     uint32_t                  numVertices;
@@ -106,6 +167,9 @@ protected:
     Geometry::MTriangle *triangles;
     uint32_t            numTriangles;
 
+    QVector<uint32_t>            triangleComponents;
+    QVector<ComponentProperties> components;
+
 private:
 
 };
@@ -32,6 +32,8 @@
 // standard library imports
 #include <iostream>
 #include <cmath>
+#include <algorithm>
+#include <cassert>
 
 // related third party imports
 #include <log4cplus/loggingmacros.h>
@@ -737,6 +739,347 @@ double relativeHumdity_Huang2018(double p_Pa, double T_K, double q_kgkg)
 }
 
 
+void hypsometricColumnHeights_m(const float *p_hPa, const float *T_K, int n,
+                                float *z_m)
+{
+    if (n < 1) return;
+
+    z_m[0] = pressure2metre_standardICAO(p_hPa[0] * 100.);
+
+    for (int k = 1; k < n; k++)
+    {
+        if (IS_MISSING(z_m[k-1]) || IS_MISSING(T_K[k-1])
+                || IS_MISSING(T_K[k]))
+        {
+            z_m[k] = M_MISSING_VALUE;
+            continue;
+        }
+
+        double layerMeanT_K = (T_K[k-1] + T_K[k]) / 2.;
+        z_m[k] = z_m[k-1] + geopotentialThicknessOfLayer_m(
+                    layerMeanT_K, p_hPa[k-1], p_hPa[k]);
+    }
+}
+
+
+/**
+  Linearly interpolates the column @p values, given at heights @p z_m
+  (increasing with index), to height @p zTarget_m.
+ */
+inline double interpolateColumnToHeight(const float *values, const float *z_m,
+                                        int n, double zTarget_m)
+{
+    int k = 0;
+    while (k < n - 2 && z_m[k+1] < zTarget_m) k++;
+
+    double mix = (zTarget_m - z_m[k]) / (z_m[k+1] - z_m[k]);
+    return values[k] + mix * (values[k+1] - values[k]);
+}
+
+
+int wmoLapseRateTropopause(const float *p_hPa, const float *T_K,
+                           const float *z_m, int n, int kStart,
+                           float pBottom_hPa, float pTop_hPa,
+                           float *pTrop_hPa, float *zTrop_m, float *TTrop_K)
+{
+    // Lapse-rate threshold and depth of the layer above the tropopause in
+    // which the mean lapse rate must not exceed the threshold.
+    const double CRITICAL_LAPSE_RATE_K_per_km = 2.;
+    const double CHECK_DEPTH_m = 2000.;
+
+    double prevLapseRate = M_MISSING_VALUE;
+    double prevMidHeight = M_MISSING_VALUE;
+
+    for (int k = std::max(kStart, 0); k < n - 1; k++)
+    {
+        if (p_hPa[k] < pTop_hPa) break;
+
+        if (IS_MISSING(T_K[k]) || IS_MISSING(T_K[k+1])
+                || IS_MISSING(z_m[k]) || IS_MISSING(z_m[k+1]))
+        {
+            prevLapseRate = M_MISSING_VALUE;
+            continue;
+        }
+
+        double dz_m = z_m[k+1] - z_m[k];
+        if (dz_m <= 0.) continue;
+
+        double lapseRate = -1000. * (T_K[k+1] - T_K[k]) / dz_m;
+        double midHeight = (z_m[k] + z_m[k+1]) / 2.;
+
+        if (p_hPa[k+1] > pBottom_hPa
+                || lapseRate > CRITICAL_LAPSE_RATE_K_per_km)
+        {
+            prevLapseRate = lapseRate;
+            prevMidHeight = midHeight;
+            continue;
+        }
+
+        // The lapse rate has dropped to the critical value. Locate the
+        // crossing between the previous and the current layer mid-point; if
+        // the previous layer is not available use the bottom of this layer.
+        double zTrop = z_m[k];
+        if (!IS_MISSING(prevLapseRate)
+                && prevLapseRate > CRITICAL_LAPSE_RATE_K_per_km)
+        {
+            double mix = (prevLapseRate - CRITICAL_LAPSE_RATE_K_per_km)
+                    / (prevLapseRate - lapseRate);
+            zTrop = prevMidHeight + mix * (midHeight - prevMidHeight);
+        }
+
+        double TTrop = interpolateColumnToHeight(T_K, z_m, n, zTrop);
+
+        // Check the mean lapse rate between the tropopause and all levels
+        // within the 2 km above (including the point 2 km above).
+        bool criterionFulfilled = true;
+        for (int kk = k + 1; kk < n && criterionFulfilled; kk++)
+        {
+            if (IS_MISSING(T_K[kk]) || IS_MISSING(z_m[kk])) break;
+            if (z_m[kk] - zTrop > CHECK_DEPTH_m) break;
+            if (z_m[kk] <= zTrop) continue;
+
+            double meanLapseRate = -1000. * (T_K[kk] - TTrop)
+                    / (z_m[kk] - zTrop);
+            criterionFulfilled = meanLapseRate <= CRITICAL_LAPSE_RATE_K_per_km;
+        }
+        if (criterionFulfilled && z_m[n-1] >= zTrop + CHECK_DEPTH_m)
+        {
+            double TCheck = interpolateColumnToHeight(
+                        T_K, z_m, n, zTrop + CHECK_DEPTH_m);
+            double meanLapseRate = -1000. * (TCheck - TTrop) / CHECK_DEPTH_m;
+            criterionFulfilled = meanLapseRate <= CRITICAL_LAPSE_RATE_K_per_km;
+        }
+
+        prevLapseRate = lapseRate;
+        prevMidHeight = midHeight;
+
+        if (!criterionFulfilled) continue;
+
+        // Pressure varies approximately exponentially with height;
+        // interpolate ln(p) linearly.
+        int kTrop = k;
+        while (kTrop > 0 && z_m[kTrop] > zTrop) kTrop--;
+        double mix = (zTrop - z_m[kTrop]) / (z_m[kTrop+1] - z_m[kTrop]);
+        double lnp = log(p_hPa[kTrop])
+                + mix * (log(p_hPa[kTrop+1]) - log(p_hPa[kTrop]));
+
+        *pTrop_hPa = exp(lnp);
+        *zTrop_m = zTrop;
+        *TTrop_K = TTrop;
+        return kTrop;
+    }
+
+    return -1;
+}
+
+
+int wmoMultipleTropopauses(const float *p_hPa, const float *T_K,
+                           const float *z_m, int n,
+                           float pBottom_hPa, float pTop_hPa,
+                           int maxTropopauses, float *pTrop_hPa,
+                           float *zTrop_m, float *TTrop_K)
+{
+    // Lapse rate that the mean lapse rate of the 1 km layer above the
+    // tropopause has to exceed before another tropopause can be defined.
+    const double UNSTABLE_LAPSE_RATE_K_per_km = 3.;
+    const double UNSTABLE_DEPTH_m = 1000.;
+
+    int numTropopauses = 0;
+    int kStart = 0;
+
+    while (numTropopauses < maxTropopauses)
+    {
+        int kTrop = wmoLapseRateTropopause(
+                    p_hPa, T_K, z_m, n, kStart, pBottom_hPa, pTop_hPa,
+                    &pTrop_hPa[numTropopauses], &zTrop_m[numTropopauses],
+                    &TTrop_K[numTropopauses]);
+        if (kTrop < 0) break;
+
+        const double zTrop = zTrop_m[numTropopauses];
+        numTropopauses++;
+
+        // Search for the lowest level above the tropopause from which the
+        // mean lapse rate to all higher levels within 1 km (including the
+        // point 1 km above) exceeds the threshold.
+        int kUnstable = -1;
+        for (int k = kTrop + 1; k < n - 1 && kUnstable < 0; k++)
+        {
+            if (p_hPa[k] < pTop_hPa) break;
+            if (IS_MISSING(T_K[k]) || IS_MISSING(z_m[k])) continue;
+            if (z_m[k] <= zTrop) continue;
+            if (z_m[n-1] < z_m[k] + UNSTABLE_DEPTH_m) break;
+
+            bool criterionFulfilled = true;
+            for (int kk = k + 1; kk < n && criterionFulfilled; kk++)
+            {
+                if (IS_MISSING(T_K[kk]) || IS_MISSING(z_m[kk]))
+                {
+                    criterionFulfilled = false;
+                    break;
+                }
+                if (z_m[kk] - z_m[k] > UNSTABLE_DEPTH_m) break;
+
+                double meanLapseRate = -1000. * (T_K[kk] - T_K[k])
+                        / (z_m[kk] - z_m[k]);
+                criterionFulfilled =
+                        meanLapseRate > UNSTABLE_LAPSE_RATE_K_per_km;
+            }
+            if (criterionFulfilled)
+            {
+                double TCheck = interpolateColumnToHeight(
+                            T_K, z_m, n, z_m[k] + UNSTABLE_DEPTH_m);
+                double meanLapseRate = -1000. * (TCheck - T_K[k])
+                        / UNSTABLE_DEPTH_m;
+                criterionFulfilled =
+                        meanLapseRate > UNSTABLE_LAPSE_RATE_K_per_km;
+            }
+
+            if (criterionFulfilled) kUnstable = k;
+        }
+
+        if (kUnstable < 0) break;
+        kStart = kUnstable;
+    }
+
+    return numTropopauses;
+}
+
+
+int lapseRateIsosurfaceCrossings(const float *p_hPa, const float *T_K,
+                                 const float *z_m, int n,
+                                 float pBottom_hPa, float pTop_hPa,
+                                 double lapseRate_K_per_km)
+{
+    int numCrossings = 0;
+    int prevSign = 0;
+
+    for (int k = 0; k < n - 1; k++)
+    {
+        if (p_hPa[k] < pTop_hPa) break;
+        if (p_hPa[k+1] > pBottom_hPa) continue;
+
+        if (IS_MISSING(T_K[k]) || IS_MISSING(T_K[k+1])
+                || IS_MISSING(z_m[k]) || IS_MISSING(z_m[k+1]))
+        {
+            continue;
+        }
+
+        double dz_m = z_m[k+1] - z_m[k];
+        if (dz_m <= 0.) continue;
+
+        double lapseRate = -1000. * (T_K[k+1] - T_K[k]) / dz_m;
+        int sign = (lapseRate > lapseRate_K_per_km) ? 1 : -1;
+
+        if (prevSign != 0 && sign != prevSign) numCrossings++;
+        prevSign = sign;
+    }
+
+    return numCrossings;
+}
+
+
+bool isTropopauseFoldColumn(const float *p_hPa, const float *T_K,
+                            const float *z_m, int n, float pBottom_hPa,
+                            float zTrop_m)
+{
+    const double CRITICAL_LAPSE_RATE_K_per_km = 2.;
+    const double INTRUSION_LAPSE_RATE_K_per_km = 1.;
+    const double MIN_LAYER_DEPTH_m = 500.;
+
+    if (IS_MISSING(zTrop_m)) return false;
+
+    // Runs of consecutive stable (lapse rate <= 2 K/km) or unstable layers
+    // between the bottom of the search range and the primary tropopause.
+    struct LayerRun
+    {
+        bool stable;
+        double zBottom_m, TBottom_K, zTop_m, TTop_K;
+    };
+    QVarLengthArray<LayerRun, 64> runs;
+
+    for (int k = 0; k < n - 1; k++)
+    {
+        if (p_hPa[k+1] > pBottom_hPa) continue;
+        if (z_m[k] >= zTrop_m) break;
+
+        if (IS_MISSING(T_K[k]) || IS_MISSING(T_K[k+1])
+                || IS_MISSING(z_m[k]) || IS_MISSING(z_m[k+1]))
+        {
+            // Runs must not span missing layers.
+            runs.clear();
+            continue;
+        }
+
+        double dz_m = z_m[k+1] - z_m[k];
+        if (dz_m <= 0.) continue;
+
+        double lapseRate = -1000. * (T_K[k+1] - T_K[k]) / dz_m;
+        bool stable = lapseRate <= CRITICAL_LAPSE_RATE_K_per_km;
+
+        // The layer containing the tropopause is cut at the tropopause.
+        double zTop_m = std::min(double(z_m[k+1]), double(zTrop_m));
+        double TTop_K = T_K[k] - lapseRate / 1000. * (zTop_m - z_m[k]);
+
+        if (!runs.isEmpty() && runs.last().stable == stable)
+        {
+            runs.last().zTop_m = zTop_m;
+            runs.last().TTop_K = TTop_K;
+        }
+        else
+        {
+            LayerRun run = { stable, z_m[k], T_K[k], zTop_m, TTop_K };
+            runs.append(run);
+        }
+    }
+
+    // Runs shallower than the minimum depth are regarded as noise and merged
+    // into the run below (the run below and the run above then have the same
+    // class and are merged as well). The run directly below the tropopause
+    // is kept to be able to check its depth.
+    QVarLengthArray<LayerRun, 64> merged;
+    for (int r = 0; r < runs.size(); r++)
+    {
+        const LayerRun &run = runs[r];
+        const bool isNoise = (run.zTop_m - run.zBottom_m < MIN_LAYER_DEPTH_m)
+                && (r < runs.size() - 1);
+
+        if (!merged.isEmpty()
+                && (isNoise || merged.last().stable == run.stable))
+        {
+            merged.last().zTop_m = run.zTop_m;
+            merged.last().TTop_K = run.TTop_K;
+        }
+        else
+        {
+            merged.append(run);
+        }
+    }
+
+    // Search for the sequence unstable -> stratospheric intrusion ->
+    // unstable. The primary tropopause above the sequence completes the
+    // non-monotonic order of the crossings.
+    for (int r = 1; r < merged.size() - 1; r++)
+    {
+        const LayerRun &intrusion = merged[r];
+        const LayerRun &above = merged[r+1];
+        if (!intrusion.stable || above.stable) continue;
+
+        const double depth_m = intrusion.zTop_m - intrusion.zBottom_m;
+        const double meanLapseRate =
+                -1000. * (intrusion.TTop_K - intrusion.TBottom_K) / depth_m;
+
+        if (depth_m >= MIN_LAYER_DEPTH_m
+                && meanLapseRate <= INTRUSION_LAPSE_RATE_K_per_km
+                && above.zTop_m - above.zBottom_m >= MIN_LAYER_DEPTH_m)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
 
 /******************************************************************************
 ***            WRAPPER for LAGRANTO LIBCALVAR FORTRAN FUNCTIONS             ***
@@ -967,11 +1310,137 @@ void test_saturationVapourPressure()
 }
 
 
+/**
+  Logs an error if @p passed is false and asserts @p passed (most tests in
+  this namespace only log their results for manual inspection).
+ */
+void checkTestResult(bool passed, const QString& description)
+{
+    if (!passed)
+    {
+        LOG4CPLUS_ERROR(mlog, "Test failed: " << description.toStdString());
+    }
+    assert(passed);
+}
+
+
+void test_wmoLapseRateTropopause()
+{
+    LOG4CPLUS_INFO(mlog, "Running test for WMO lapse-rate tropopause "
+                         "detection.");
+
+    // Test column: ICAO standard atmosphere sampled at 60 levels between
+    // 1000 and 20 hPa. The standard atmosphere's tropopause is located at
+    // 11 km (226.32 hPa, 216.65 K).
+    const int n = 60;
+    float p_hPa[n], T_K[n], z_m[n];
+    for (int k = 0; k < n; k++)
+    {
+        p_hPa[k] = 1000. * pow(20. / 1000., double(k) / double(n - 1));
+        T_K[k] = isaTemperature(pressure2metre_standardICAO(p_hPa[k] * 100.));
+    }
+
+    hypsometricColumnHeights_m(p_hPa, T_K, n, z_m);
+
+    float pTrop_hPa = M_MISSING_VALUE;
+    float zTrop_m = M_MISSING_VALUE;
+    float TTrop_K = M_MISSING_VALUE;
+    int k = wmoLapseRateTropopause(p_hPa, T_K, z_m, n, 0, 500., 75.,
+                                   &pTrop_hPa, &zTrop_m, &TTrop_K);
+
+    QString s = QString("target p_hPa = 226.32  z_m = 11000  T_K = 216.65  "
+                        "computed (k = %1) p_hPa = %2  z_m = %3  T_K = %4")
+            .arg(k).arg(pTrop_hPa).arg(zTrop_m).arg(TTrop_K);
+
+    LOG4CPLUS_INFO(mlog, s.toStdString());
+
+    // The detected tropopause is interpolated between layer mid-points;
+    // the level spacing is about 6% in pressure.
+    checkTestResult(k >= 0, "no tropopause detected");
+    checkTestResult(fabs(pTrop_hPa - 226.32) < 0.05 * 226.32,
+                    "tropopause pressure");
+    checkTestResult(fabs(TTrop_K - 216.65) < 1., "tropopause temperature");
+
+    LOG4CPLUS_INFO(mlog, "Test finished.");
+}
+
+
+void test_wmoMultipleTropopauses()
+{
+    LOG4CPLUS_INFO(mlog, "Running test for WMO multiple tropopause "
+                         "detection.");
+
+    // Test column: a double tropopause as frequently observed near the
+    // subtropical jet. Temperature decreases by 6.5 K/km up to a first
+    // tropopause at 10 km, is isothermal up to 12 km, decreases by 6 K/km
+    // up to a second tropopause at 15 km and is isothermal above.
+    const int n = 100;
+    float p_hPa[n], T_K[n], z_m[n];
+    for (int k = 0; k < n; k++)
+    {
+        p_hPa[k] = 1000. * pow(20. / 1000., double(k) / double(n - 1));
+
+        double z_km = pressure2metre_standardICAO(p_hPa[k] * 100.) / 1000.;
+        double T = 288.15 - 6.5 * std::min(z_km, 10.);
+        if (z_km > 12.) T -= 6. * (std::min(z_km, 15.) - 12.);
+        T_K[k] = T;
+    }
+
+    hypsometricColumnHeights_m(p_hPa, T_K, n, z_m);
+
+    const int maxTropopauses = 3;
+    float pTrop_hPa[maxTropopauses], zTrop_m[maxTropopauses];
+    float TTrop_K[maxTropopauses];
+    int numTropopauses = wmoMultipleTropopauses(
+                p_hPa, T_K, z_m, n, 500., 50., maxTropopauses,
+                pTrop_hPa, zTrop_m, TTrop_K);
+    int numCrossings = lapseRateIsosurfaceCrossings(
+                p_hPa, T_K, z_m, n, 500., 50.);
+    // A double tropopause is not a fold.
+    bool fold = isTropopauseFoldColumn(
+                p_hPa, T_K, z_m, n, 500.,
+                numTropopauses > 0 ? zTrop_m[0] : M_MISSING_VALUE);
+
+    QString s = QString("target: 2 tropopauses (T_K = 223.15, 205.15), "
+                        "3 crossings, no fold; computed: %1 tropopauses, "
+                        "%2 crossings, fold = %3")
+            .arg(numTropopauses).arg(numCrossings).arg(fold);
+    LOG4CPLUS_INFO(mlog, s.toStdString());
+
+    for (int t = 0; t < numTropopauses; t++)
+    {
+        s = QString("  (%1) p_hPa = %2  z_m = %3  T_K = %4")
+                .arg(t).arg(pTrop_hPa[t]).arg(zTrop_m[t]).arg(TTrop_K[t]);
+        LOG4CPLUS_INFO(mlog, s.toStdString());
+    }
+
+    // Target pressures: ICAO standard atmosphere at 10 and 15 km.
+    checkTestResult(numTropopauses == 2, "number of tropopauses");
+    checkTestResult(numCrossings == 3, "number of lapse-rate crossings");
+    checkTestResult(!fold, "double tropopause detected as fold");
+    if (numTropopauses == 2)
+    {
+        checkTestResult(fabs(pTrop_hPa[0] - 264.36) < 0.05 * 264.36,
+                        "first tropopause pressure");
+        checkTestResult(fabs(TTrop_K[0] - 223.15) < 1.,
+                        "first tropopause temperature");
+        checkTestResult(fabs(pTrop_hPa[1] - 120.45) < 0.05 * 120.45,
+                        "second tropopause pressure");
+        checkTestResult(fabs(TTrop_K[1] - 205.15) < 1.,
+                        "second tropopause temperature");
+    }
+
+    LOG4CPLUS_INFO(mlog, "Test finished.");
+}
+
+
 void runMetRoutinesTests()
 {
     test_temperatureAlongSaturatedAdiabat_K_MoisseevaStull();
     test_wetBulbPotentialTemperatureOfSaturatedAdiabat_K_MoisseevaStull();
     test_saturationVapourPressure();
+    test_wmoLapseRateTropopause();
+    test_wmoMultipleTropopauses();
 }
 
 } // namespace MetRoutinesTests
@@ -416,6 +416,107 @@ double saturationVapourPressure_Pa_Huang2018(double T_K);
 double relativeHumdity_Huang2018(double p_Pa, double T_K, double q_kgkg);
 
 
+/**
+  Computes the geometric height (m) of all @p n levels of a single vertical
+  column by integrating the hypsometric equation (see @ref
+  geopotentialThicknessOfLayer_m()) upwards from the lowest level. The lowest
+  level is placed at its ICAO standard atmosphere height.
+
+  @p p_hPa and @p T_K must be ordered from the bottom of the column upwards
+  (i.e. with decreasing pressure); the result is written to @p z_m.
+ */
+void hypsometricColumnHeights_m(const float *p_hPa, const float *T_K, int n,
+                                float *z_m);
+
+
+/**
+  Determines the thermal (lapse-rate) tropopause in a single vertical column
+  following the WMO (1957) definition: "The lowest level at which the lapse
+  rate decreases to 2 K/km or less, provided also the average lapse rate
+  between this level and all higher levels within 2 km does not exceed
+  2 K/km."
+
+  @p p_hPa, @p T_K and @p z_m (cf. @ref hypsometricColumnHeights_m()) are
+  ordered from the bottom of the column upwards. The lapse rate is evaluated
+  at layer mid-points; the tropopause is located where the lapse rate
+  crosses 2 K/km by linear interpolation between two mid-points. The search
+  starts at level @p kStart and is restricted to the pressure range
+  [@p pTop_hPa, @p pBottom_hPa].
+
+  Returns the index k of the level directly below the tropopause (i.e. the
+  tropopause lies between levels k and k+1) and writes its pressure, height
+  and temperature to @p pTrop_hPa, @p zTrop_m and @p TTrop_K. Returns -1 if
+  no tropopause is found in the column.
+
+  Reference: WMO (1957), Meteorology -- A three-dimensional science: Second
+  session of the Commission for Aerology, WMO Bulletin IV(4), 134-138.
+ */
+int wmoLapseRateTropopause(const float *p_hPa, const float *T_K,
+                           const float *z_m, int n, int kStart,
+                           float pBottom_hPa, float pTop_hPa,
+                           float *pTrop_hPa, float *zTrop_m, float *TTrop_K);
+
+
+/**
+  Determines all thermal tropopauses in a single vertical column following
+  the WMO (1957) definition of multiple tropopauses: the first tropopause is
+  found by @ref wmoLapseRateTropopause(). "If above the first tropopause the
+  average lapse rate between any level and all higher levels within 1 km
+  exceeds 3 K/km, then a second tropopause is defined by the same criterion
+  as under (a)." The second tropopause may lie within or above the 1 km
+  layer. Further tropopauses are found analogously.
+
+  Parameters are as for @ref wmoLapseRateTropopause(). At most @p
+  maxTropopauses tropopauses are written, ordered from the bottom upwards, to
+  @p pTrop_hPa, @p zTrop_m and @p TTrop_K (arrays of size @p
+  maxTropopauses). Returns the number of tropopauses found.
+ */
+int wmoMultipleTropopauses(const float *p_hPa, const float *T_K,
+                           const float *z_m, int n,
+                           float pBottom_hPa, float pTop_hPa,
+                           int maxTropopauses, float *pTrop_hPa,
+                           float *zTrop_m, float *TTrop_K);
+
+
+/**
+  Counts how often the lapse rate of a single vertical column crosses @p
+  lapseRate_K_per_km (in either direction) within the pressure range
+  [@p pTop_hPa, @p pBottom_hPa]. This is the number of intersections of the
+  column with the lapse-rate isosurface; a column with a single tropopause
+  and no folding intersects it once. Column layout as for @ref
+  wmoLapseRateTropopause().
+ */
+int lapseRateIsosurfaceCrossings(const float *p_hPa, const float *T_K,
+                                 const float *z_m, int n,
+                                 float pBottom_hPa, float pTop_hPa,
+                                 double lapseRate_K_per_km = 2.);
+
+
+/**
+  Returns true if the thermal structure of a single vertical column below its
+  primary tropopause (at height @p zTrop_m, cf. @ref
+  wmoMultipleTropopauses()) indicates a tropopause fold, i.e. a stratospheric
+  intrusion that the column intersects below the tropopause.
+
+  Going upwards, the lapse rate of a folded column crosses the 2 K/km
+  threshold in non-monotonic order: tropospheric air (lapse rate > 2 K/km) is
+  followed by a stable layer, then by tropospheric air again and finally by
+  the stratosphere above the primary tropopause. The stable layer is only
+  accepted as stratospheric intrusion if its mean lapse rate does not exceed
+  1 K/km (stratospheric stability) and if both the stable layer and the
+  tropospheric layer above it are at least 500 m deep. Noisy columns that
+  toggle around the threshold from layer to layer hence are not flagged.
+  Contrary to @ref lapseRateIsosurfaceCrossings(), double tropopauses above
+  the primary tropopause are not regarded as folds.
+
+  Column layout and search range as for @ref wmoLapseRateTropopause().
+  Returns false if @p zTrop_m is missing.
+ */
+bool isTropopauseFoldColumn(const float *p_hPa, const float *T_K,
+                            const float *z_m, int n, float pBottom_hPa,
+                            float zTrop_m);
+
+
 /******************************************************************************
 ***            WRAPPER for LAGRANTO LIBCALVAR FORTRAN FUNCTIONS             ***
 *******************************************************************************/
@@ -518,6 +619,9 @@ void test_EQPT();
 void test_temperatureAlongSaturatedAdiabat_K_MoisseevaStull();
 void test_saturationVapourPressure();
 
+void test_wmoLapseRateTropopause();
+void test_wmoMultipleTropopauses();
+
 void runMetRoutinesTests();
 
 } // namespace MetRoutinesTests
@@ -35,6 +35,9 @@
 // related third party imports
 #include <log4cplus/loggingmacros.h>
 
+// local application imports
+#include "data/gridpressureaccess.h"
+
 #define MEASURE_CPU_TIME
 #define COMPUTE_PARALLEL
 
@@ -43,31 +46,63 @@ using namespace Met3D;
 #define qNaN (std::numeric_limits<float>::quiet_NaN())
 #define iNaN (std::numeric_limits<unsigned int>::max())
 
+
 MMarchingCubes::MMarchingCubes(MStructuredGrid* grid, MStructuredGrid* zGrid)
     : inputGrid(grid),
       heightGrid(zGrid),
+      scalarValues(grid->getData()),
       nx(grid->getNumLons() - 1),
       ny(grid->getNumLats() - 1),
       nz(grid->getNumLevels() - 1),
-      numEdges(3 * grid->getNumValues()
-               - grid->getNumLons() * grid->getNumLevels()
-               - grid->getNumLons() * grid->getNumLats()
-               - grid->getNumLats() * grid->getNumLevels()),
-      numVoxels(nx * ny * nz),
-      gridPoints(grid->getNumValues()),
-      normals(grid->getNumValues()),
-      normalsZ((zGrid) ? grid->getNumValues() : 0),
-      voxelIndices(numVoxels, 0),
-      voxelNumTriangles(numVoxels, 0),
-      voxelMinIndexTriangle(numVoxels, 0),
-      intersectionIndices(numEdges, iNaN),
-      flattenPoints(numEdges, QVector3D(qNaN, qNaN, qNaN)),
-      flattenNormals(numEdges, QVector3D(qNaN, qNaN, qNaN)),
-      flattenNormalsZ((zGrid) ? numEdges : 0, QVector3D(qNaN, qNaN, qNaN)),
+      dimX(grid->getNumLons()),
+      dimY(grid->getNumLats()),
+      dimZ(grid->getNumLevels()),
+      maxMemoryUsage_bytes(0),
+      lazyPointEvaluation(true),
+      brickIndex(nullptr),
+      algorithm(MARCHING_CUBES),
+      slabK0(0),
+      slabNz(0),
+      numSlabXEdges(0),
+      numSlabYEdges(0),
+      triangleBase(0),
+      numVertices(0),
       atomicEdgeCount(0),
       atomicTriangleCount(0)
 {
-    precompute();
+}
+
+
+void MMarchingCubes::setScalarValues(const float* values)
+{
+    scalarValues = values;
+}
+
+
+void MMarchingCubes::setMinMaxBrickIndex(const MMinMaxBrickIndex* index)
+{
+    if (index && !index->hasDimensions(dimX, dimY, dimZ))
+    {
+        LOG4CPLUS_ERROR(mlog, "Marching cubes: the dimensions of the min/max "
+                        "brick index do not match the input grid; the index "
+                        "is ignored.");
+        index = nullptr;
+    }
+    brickIndex = index;
+}
+
+
+void MMarchingCubes::setMaxMemoryUsage_MB(unsigned int maxMemory_MB)
+{
+    maxMemoryUsage_bytes = quint64(maxMemory_MB) * 1024 * 1024;
+}
+
+
+int MMarchingCubes::addAttributeGrid(MStructuredGrid* grid)
+{
+    attributeGrids.push_back(grid);
+    flattenAttributes.resize(attributeGrids.size());
+    return int(attributeGrids.size()) - 1;
 }
 
 
@@ -368,17 +403,220 @@ int triTable[256][16] = {
 
 void MMarchingCubes::computeMeshOnCPU(const float isovalue)
 {
-    // 1)
-    computeVoxelIndices(isovalue);
+    flattenPoints.clear();
+    flattenNormals.clear();
+    flattenNormalsZ.clear();
+    flattenTriangles.clear();
+    for (std::vector<float>& attributes : flattenAttributes)
+    {
+        attributes.clear();
+    }
+    carriedPlaneIndices.clear();
+    numVertices = 0;
+
+    if (nx == 0 || ny == 0 || nz == 0) { return; }
+
+    if (algorithm == FLYING_EDGES)
+    {
+        computeMeshFlyingEdges(isovalue);
+        return;
+    }
+
+    const uint32_t numLayersPerSlab = computeNumLayersPerSlab();
+
+    LOG4CPLUS_DEBUG(mlog, "Marching cubes: processing " << nz
+                    << " voxel layers in slabs of " << numLayersPerSlab
+                    << " layers.");
+
+    for (uint32_t k0 = 0; k0 < nz; k0 += numLayersPerSlab)
+    {
+        initializeSlab(k0, std::min(numLayersPerSlab, nz - k0));
+        collectSlabBlocks(isovalue);
+
+        // 1)
+        if (!lazyPointEvaluation) { precompute(); }
+
+        // 2)
+        const quint64 numSlabVertices = computeVoxelIndices(isovalue);
+        if (lazyPointEvaluation) { evaluateActivePoints(slabK0); }
+
+        // Vertex indices are stored as 32 bit unsigned integers (as required
+        // by the index buffer); iNaN marks missing intersections. The index
+        // buffer holds three 32 bit indices per triangle.
+        if (numVertices + numSlabVertices >= quint64(iNaN)
+                || quint64(flattenTriangles.size()) * 3 >= quint64(iNaN))
+        {
+            LOG4CPLUS_ERROR(mlog, "Marching cubes: the isosurface exceeds "
+                            "the maximum number of vertices or triangles "
+                            "that can be indexed with 32 bit indices; the "
+                            "mesh is truncated at voxel layer " << k0 << ".");
+            flattenTriangles.resize(triangleBase);
+            break;
+        }
+
+        flattenPoints.resize(numVertices + numSlabVertices);
+        flattenNormals.resize(numVertices + numSlabVertices);
+        if (heightGrid)
+        {
+            flattenNormalsZ.resize(numVertices + numSlabVertices);
+        }
+        for (std::vector<float>& attributes : flattenAttributes)
+        {
+            attributes.resize(numVertices + numSlabVertices);
+        }
+
+        // 3)
+        computeIntersectionPoints(isovalue);
+
+        // 4)
+        generateTriangles();
+
+        carryTopPlaneIndices();
+    }
+
+    releaseSlab();
+}
+
+
+uint32_t MMarchingCubes::computeNumLayersPerSlab() const
+{
+    if (maxMemoryUsage_bytes == 0) { return nz; }
+
+    // Working memory per grid point and layer: position and normal(s) (in
+    // lazy mode only the index into the arrays of the evaluated points; the
+    // number of evaluated points scales with the size of the surface),
+    // voxel case, number of triangles, first triangle index (64 bit) and
+    // the indices of the three edges starting at the grid point.
+    const quint64 bytesPerPointData = lazyPointEvaluation
+            ? sizeof(uint32_t) : sizeof(QVector3D) * (heightGrid ? 3 : 2);
+    const quint64 bytesPerPoint = bytesPerPointData
+            + 2 * sizeof(uint8_t) + sizeof(quint64) + 3 * sizeof(uint32_t);
+    const quint64 bytesPerLayer = bytesPerPoint * dimX * dimY;
+
+    const quint64 numLayers = maxMemoryUsage_bytes / bytesPerLayer;
+    return uint32_t(std::max(quint64(1), std::min(numLayers, quint64(nz))));
+}
+
+
+void MMarchingCubes::initializeSlab(const uint32_t k0,
+                                    const uint32_t numLayers)
+{
+    slabK0 = k0;
+    slabNz = numLayers;
+
+    const size_t numPlanes = slabNz + 1;
+    const size_t numSlabPoints = numPlanes * dimY * dimX;
+    const size_t numSlabVoxels = size_t(slabNz) * ny * nx;
+
+    numSlabXEdges = numPlanes * dimY * nx;
+    numSlabYEdges = numPlanes * ny * dimX;
+    const size_t numSlabZEdges = size_t(slabNz) * dimY * dimX;
+
+    if (lazyPointEvaluation)
+    {
+        activePointIndices.assign(numSlabPoints, iNaN);
+    }
+    else
+    {
+        gridPoints.resize(numSlabPoints);
+        normals.resize(numSlabPoints);
+        if (heightGrid) { normalsZ.resize(numSlabPoints); }
+    }
+
+    voxelIndices.assign(numSlabVoxels, 0);
+    voxelNumTriangles.assign(numSlabVoxels, 0);
+    voxelMinIndexTriangle.assign(numSlabVoxels, 0);
+
+    intersectionIndices.assign(
+                numSlabXEdges + numSlabYEdges + numSlabZEdges, iNaN);
+
+    // The bottom plane of all but the first slab has been computed as the
+    // top plane of the previous slab.
+    if (slabK0 > 0)
+    {
+        const size_t numPlaneXEdges = size_t(dimY) * nx;
+        const size_t numPlaneYEdges = size_t(ny) * dimX;
+
+        std::copy(carriedPlaneIndices.begin(),
+                  carriedPlaneIndices.begin() + numPlaneXEdges,
+                  intersectionIndices.begin());
+        std::copy(carriedPlaneIndices.begin() + numPlaneXEdges,
+                  carriedPlaneIndices.begin() + numPlaneXEdges + numPlaneYEdges,
+                  intersectionIndices.begin() + numSlabXEdges);
+    }
+}
+
+
+void MMarchingCubes::carryTopPlaneIndices()
+{
+    const size_t numPlaneXEdges = size_t(dimY) * nx;
+    const size_t numPlaneYEdges = size_t(ny) * dimX;
+
+    carriedPlaneIndices.resize(numPlaneXEdges + numPlaneYEdges);
+
+    const size_t topXEdges = getPointIndex(slabNz - 1, 0, 0, 4);
+    const size_t topYEdges = getPointIndex(slabNz - 1, 0, 0, 7);
+
+    std::copy(intersectionIndices.begin() + topXEdges,
+              intersectionIndices.begin() + topXEdges + numPlaneXEdges,
+              carriedPlaneIndices.begin());
+    std::copy(intersectionIndices.begin() + topYEdges,
+              intersectionIndices.begin() + topYEdges + numPlaneYEdges,
+              carriedPlaneIndices.begin() + numPlaneXEdges);
+}
+
+
+void MMarchingCubes::releaseSlab()
+{
+    std::vector<QVector3D>().swap(gridPoints);
+    std::vector<QVector3D>().swap(normals);
+    std::vector<QVector3D>().swap(normalsZ);
+    std::vector<uint32_t>().swap(activePointIndices);
+    std::vector<uint8_t>().swap(voxelIndices);
+    std::vector<uint8_t>().swap(voxelNumTriangles);
+    std::vector<quint64>().swap(voxelMinIndexTriangle);
+    std::vector<uint32_t>().swap(intersectionIndices);
+    std::vector<uint32_t>().swap(carriedPlaneIndices);
+    std::vector<VoxelBlock>().swap(slabBlocks);
+}
+
+
+void MMarchingCubes::collectSlabBlocks(const float isovalue)
+{
+    slabBlocks.clear();
+
+    if (brickIndex == nullptr)
+    {
+        slabBlocks.reserve(size_t(slabNz) * ny);
+        for (uint32_t kk = 0; kk < slabNz; ++kk)
+        {
+            for (uint32_t j = 0; j < ny; ++j)
+            {
+                slabBlocks.push_back({ kk, kk + 1, j, j + 1, 0, nx });
+            }
+        }
+        return;
+    }
 
-    // 2)
-    computeIntersectionPoints(isovalue);
+    std::vector<uint32_t> bricks;
+    brickIndex->getCandidateBricks(isovalue, slabK0, slabK0 + slabNz, bricks);
 
-    // 3)
-    generateTriangles();
+    slabBlocks.reserve(bricks.size());
+    for (uint32_t brick : bricks)
+    {
+        VoxelBlock block;
+        brickIndex->getBrickVoxelRange(brick, block.k0, block.k1, block.j0,
+                                       block.j1, block.i0, block.i1);
+
+        // Clip the brick to the current slab.
+        block.k0 = std::max(block.k0, slabK0) - slabK0;
+        block.k1 = std::min(block.k1, slabK0 + slabNz) - slabK0;
+        if (block.k0 < block.k1) { slabBlocks.push_back(block); }
+    }
 
-    // 4) not necessary
-    //flatten();
+    LOG4CPLUS_DEBUG(mlog, "Marching cubes: " << slabBlocks.size()
+                    << " candidate bricks in slab at voxel layer "
+                    << slabK0 << ".");
 }
 
 
@@ -389,12 +627,36 @@ void MMarchingCubes::precompute()
     auto start = std::chrono::system_clock::now();
 #endif
 
-    const float DELTA_LAT_M = 1.112E5; // ~111.2km
+    switch (getPressureAccessType(inputGrid))
+    {
+    case LEVEL_PRESSURE_ACCESS:
+        precomputeGridPoints(MLevelPressureAccess(inputGrid));
+        break;
+    case HYBRID_SIGMA_PRESSURE_ACCESS:
+        precomputeGridPoints(MHybridSigmaPressureAccess(
+                static_cast<MLonLatHybridSigmaPressureGrid*>(inputGrid)));
+        break;
+    case PRESSURE_FIELD_ACCESS:
+        precomputeGridPoints(MPressureFieldAccess(inputGrid));
+        break;
+    default:
+        precomputeGridPoints(MGenericPressureAccess(inputGrid));
+    }
+
+#ifdef MEASURE_CPU_TIME
+    auto end = std::chrono::system_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    LOG4CPLUS_DEBUG(mlog, " done in " << elapsed.count() << "ms.\n");
+#endif
+}
+
 
-    for (uint32_t k = 0; k <= nz; ++k)
+template<typename PressureAccess>
+void MMarchingCubes::precomputeGridPoints(const PressureAccess &pressure)
+{
+    for (uint32_t kk = 0; kk <= slabNz; ++kk)
     {
-        auto kN = std::min(int(k + 1), int(nz));
-        auto kP = std::max(int(k - 1), 0);
+        const uint32_t k = slabK0 + kk;
 
 #ifdef COMPUTE_PARALLEL
 #pragma omp parallel for collapse(2)
@@ -403,69 +665,175 @@ void MMarchingCubes::precompute()
         {
             for (uint32_t i = 0; i <= nx; ++i)
             {
-                const float lon = inputGrid->getLons()[i];
-                const float lat = inputGrid->getLats()[j];
-                const float DELTA_LON_M = std::cos(lat / 180.0f * M_PI) * DELTA_LAT_M;
+                const size_t pIndex = getGridPointIndex(kk, j, i);
+                QVector3D normalZ;
 
-                const float pressure = inputGrid->getPressure(k, j, i);
+                evaluateGridPoint(pressure, k, j, i, gridPoints[pIndex],
+                                  normals[pIndex], normalZ);
 
-                const uint32_t pIndex = INDEX3zyx(k, j, i, ny + 1, nx + 1);
+                if (heightGrid) { normalsZ[pIndex] = normalZ; }
+            }
+        }
+    }
+}
 
-                gridPoints[pIndex] = QVector3D(lon, lat, pressure);
 
-                auto jN = std::min(int(j + 1), int(ny));
-                auto jP = std::max(int(j - 1), 0);
+void MMarchingCubes::markActivePoints(const uint32_t k, const uint32_t j,
+                                      const uint32_t i,
+                                      const uint16_t intersectedEdges)
+{
+    for (uint8_t edge = 0; edge < 12; ++edge)
+    {
+        if (!(intersectedEdges & (1 << edge))) { continue; }
 
-                auto iN = std::min(int(i + 1), int(nx));
-                auto iP = std::max(int(i - 1), 0);
+        uint8_t vP = 0;
+        uint8_t vN = 0;
+        getEdgeVertices(edge, vP, vN);
 
-                const float dx = inputGrid->getLons()[1] - inputGrid->getLons()[0];
-                const float dy = inputGrid->getLats()[1] - inputGrid->getLats()[0];
+        int kv, jv, iv;
+        getVertexIndices(k, j, i, vP, kv, jv, iv);
+        markActivePoint(getGridPointIndex(kv - slabK0, jv, iv));
+        getVertexIndices(k, j, i, vN, kv, jv, iv);
+        markActivePoint(getGridPointIndex(kv - slabK0, jv, iv));
+    }
+}
 
-                const float deltaDegreeX = (iN - iP) * dx;
-                const float deltaDegreeY = (jN - jP) * dy;
 
-                const float deltahPa = inputGrid->getPressure(kN, j, i) - inputGrid->getPressure(kP, j, i);
-                const float deltaLon = DELTA_LON_M * deltaDegreeX;
-                const float deltaLat = DELTA_LAT_M * deltaDegreeY;
+void MMarchingCubes::markActivePoint(const size_t pointIndex)
+{
+    // Any value other than iNaN marks the point; the points are numbered by
+    // evaluateActivePoints().
+#ifdef COMPUTE_PARALLEL
+#pragma omp atomic write
+#endif
+    activePointIndices[pointIndex] = 0;
+}
 
-                float diffLon = inputGrid->getValue(k, j, iN) - inputGrid->getValue(k, j, iP);
-                float diffLat = inputGrid->getValue(k, jN, i) - inputGrid->getValue(k, jP, i);
-                float diffZ = inputGrid->getValue(kN, j, i) - inputGrid->getValue(kP, j, i);
 
-                QVector3D normal(diffLon / deltaDegreeX,
-                                 diffLat / deltaDegreeY,
-                                 diffZ / deltahPa);
+void MMarchingCubes::evaluateActivePoints(const uint32_t k0)
+{
+    // Number the marked points consecutively; the positions and normals
+    // are stored in this order.
+    std::vector<size_t> activePoints;
+    for (size_t p = 0; p < activePointIndices.size(); ++p)
+    {
+        if (activePointIndices[p] == iNaN) { continue; }
+        activePointIndices[p] = uint32_t(activePoints.size());
+        activePoints.push_back(p);
+    }
 
-                normals[pIndex] = -normal;
+    gridPoints.resize(activePoints.size());
+    normals.resize(activePoints.size());
+    if (heightGrid) { normalsZ.resize(activePoints.size()); }
 
-                if (heightGrid)
-                {
-                    const float deltaZ = heightGrid->getValue(kN, j, i) - heightGrid->getValue(kP, j, i);
+    switch (getPressureAccessType(inputGrid))
+    {
+    case LEVEL_PRESSURE_ACCESS:
+        evaluateActivePoints(MLevelPressureAccess(inputGrid), k0,
+                             activePoints);
+        break;
+    case HYBRID_SIGMA_PRESSURE_ACCESS:
+        evaluateActivePoints(MHybridSigmaPressureAccess(
+                static_cast<MLonLatHybridSigmaPressureGrid*>(inputGrid)),
+                             k0, activePoints);
+        break;
+    case PRESSURE_FIELD_ACCESS:
+        evaluateActivePoints(MPressureFieldAccess(inputGrid), k0,
+                             activePoints);
+        break;
+    default:
+        evaluateActivePoints(MGenericPressureAccess(inputGrid), k0,
+                             activePoints);
+    }
+}
 
-                    QVector3D normalZ(diffLon / deltaLon,
-                                      diffLat / deltaLat,
-                                      diffZ / deltaZ);
 
-                    normalsZ[pIndex] = normalZ;
+template<typename PressureAccess>
+void MMarchingCubes::evaluateActivePoints(
+        const PressureAccess &pressure, const uint32_t k0,
+        const std::vector<size_t> &activePoints)
+{
+    const size_t numPlanePoints = size_t(dimY) * dimX;
 
-                }
+#ifdef COMPUTE_PARALLEL
+#pragma omp parallel for
+#endif
+    for (size_t a = 0; a < activePoints.size(); ++a)
+    {
+        const size_t p = activePoints[a];
+        const uint32_t k = k0 + uint32_t(p / numPlanePoints);
+        const uint32_t j = uint32_t((p % numPlanePoints) / dimX);
+        const uint32_t i = uint32_t(p % dimX);
+        QVector3D normalZ;
 
+        evaluateGridPoint(pressure, k, j, i, gridPoints[a], normals[a],
+                          normalZ);
 
-            }
-        }
+        if (heightGrid) { normalsZ[a] = normalZ; }
     }
+}
 
-#ifdef MEASURE_CPU_TIME
-    auto end = std::chrono::system_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-    LOG4CPLUS_DEBUG(mlog, " done in " << elapsed.count() << "ms.\n");
-#endif
+
+template<typename PressureAccess>
+void MMarchingCubes::evaluateGridPoint(const PressureAccess &pressureAccess,
+                                       const uint32_t k, const uint32_t j,
+                                       const uint32_t i, QVector3D& position,
+                                       QVector3D& normal,
+                                       QVector3D& normalZ) const
+{
+    const float DELTA_LAT_M = 1.112E5; // ~111.2km
+
+    auto kN = std::min(int(k + 1), int(nz));
+    auto kP = std::max(int(k) - 1, 0);
+
+    const float lon = inputGrid->getLons()[i];
+    const float lat = inputGrid->getLats()[j];
+    const float DELTA_LON_M = std::cos(lat / 180.0f * M_PI) * DELTA_LAT_M;
+
+    const float pressure = pressureAccess.getPressure(k, j, i);
+
+    position = QVector3D(lon, lat, pressure);
+
+    auto jN = std::min(int(j + 1), int(ny));
+    auto jP = std::max(int(j) - 1, 0);
+
+    auto iN = std::min(int(i + 1), int(nx));
+    auto iP = std::max(int(i) - 1, 0);
+
+    const float dx = inputGrid->getLons()[1] - inputGrid->getLons()[0];
+    const float dy = inputGrid->getLats()[1] - inputGrid->getLats()[0];
+
+    const float deltaDegreeX = (iN - iP) * dx;
+    const float deltaDegreeY = (jN - jP) * dy;
+
+    const float deltahPa = pressureAccess.getPressure(kN, j, i)
+            - pressureAccess.getPressure(kP, j, i);
+    const float deltaLon = DELTA_LON_M * deltaDegreeX;
+    const float deltaLat = DELTA_LAT_M * deltaDegreeY;
+
+    float diffLon = getScalar(k, j, iN) - getScalar(k, j, iP);
+    float diffLat = getScalar(k, jN, i) - getScalar(k, jP, i);
+    float diffZ = getScalar(kN, j, i) - getScalar(kP, j, i);
+
+    QVector3D gradient(diffLon / deltaDegreeX,
+                       diffLat / deltaDegreeY,
+                       diffZ / deltahPa);
+
+    normal = -gradient;
+
+    if (heightGrid)
+    {
+        const float deltaZ = heightGrid->getValue(kN, j, i) - heightGrid->getValue(kP, j, i);
+
+        normalZ = QVector3D(diffLon / deltaLon,
+                            diffLat / deltaLat,
+                            diffZ / deltaZ);
+    }
 }
 
 
 
-void MMarchingCubes::computeVoxelIndices(const double isovalue)
+quint64 MMarchingCubes::computeVoxelIndices(const double isovalue)
 {
     printf("\t -> compute voxel edge indices...");
 #ifdef MEASURE_CPU_TIME
@@ -473,63 +841,83 @@ void MMarchingCubes::computeVoxelIndices(const double isovalue)
 #endif
 
     atomicTriangleCount = 0;
+    quint64 numSlabVertices = 0;
 
-    for (uint32_t k = 0; k < nz; ++k)
-    {
 #ifdef COMPUTE_PARALLEL
-#pragma omp parallel for collapse(2)
+#pragma omp parallel for schedule(dynamic) reduction(+:numSlabVertices)
 #endif
-        for (uint32_t j = 0; j < ny; ++j)
-        {
-            for (uint32_t i = 0; i < nx; ++i)
-            {
-                uint8_t voxelIndex = 0;
-
-                voxelIndex |= (inputGrid->getValue(k, j, i) < isovalue)              ? 0x1 : 0;
-                voxelIndex |= (inputGrid->getValue(k, j, i + 1) < isovalue)          ? 0x2 : 0;
-                voxelIndex |= (inputGrid->getValue(k, j + 1, i + 1) < isovalue)      ? 0x4 : 0;
-                voxelIndex |= (inputGrid->getValue(k, j + 1, i) < isovalue)          ? 0x8 : 0;
-                voxelIndex |= (inputGrid->getValue(k + 1, j, i) < isovalue)          ? 0x10 : 0;
-                voxelIndex |= (inputGrid->getValue(k + 1, j, i + 1) < isovalue)      ? 0x20 : 0;
-                voxelIndex |= (inputGrid->getValue(k + 1, j + 1, i + 1) < isovalue)  ? 0x40 : 0;
-                voxelIndex |= (inputGrid->getValue(k + 1, j + 1, i) < isovalue)      ? 0x80 : 0;
+    for (size_t b = 0; b < slabBlocks.size(); ++b)
+    {
+        const VoxelBlock& block = slabBlocks[b];
 
-                const uint32_t pIndex = INDEX3zyx(k, j, i, ny, nx);
-                voxelIndices[pIndex] = voxelIndex;
+        for (uint32_t kk = block.k0; kk < block.k1; ++kk)
+        {
+            const uint32_t k = slabK0 + kk;
 
-                if (voxelIndex == 0 || voxelIndex == 0xFF) { continue; }
+            for (uint32_t j = block.j0; j < block.j1; ++j)
+            {
+                for (uint32_t i = block.i0; i < block.i1; ++i)
+                {
+                    uint8_t voxelIndex = 0;
+
+                    voxelIndex |= (getScalar(k, j, i) < isovalue)              ? 0x1 : 0;
+                    voxelIndex |= (getScalar(k, j, i + 1) < isovalue)          ? 0x2 : 0;
+                    voxelIndex |= (getScalar(k, j + 1, i + 1) < isovalue)      ? 0x4 : 0;
+                    voxelIndex |= (getScalar(k, j + 1, i) < isovalue)          ? 0x8 : 0;
+                    voxelIndex |= (getScalar(k + 1, j, i) < isovalue)          ? 0x10 : 0;
+                    voxelIndex |= (getScalar(k + 1, j, i + 1) < isovalue)      ? 0x20 : 0;
+                    voxelIndex |= (getScalar(k + 1, j + 1, i + 1) < isovalue)  ? 0x40 : 0;
+                    voxelIndex |= (getScalar(k + 1, j + 1, i) < isovalue)      ? 0x80 : 0;
+
+                    const size_t pIndex = getVoxelIndex(kk, j, i);
+                    voxelIndices[pIndex] = voxelIndex;
+
+                    if (voxelIndex == 0 || voxelIndex == 0xFF) { continue; }
+
+                    // Count the intersection points computed by this voxel
+                    // to size the output buffers exactly.
+                    const uint16_t intersectedEdges = uint16_t(
+                            edgeTable[voxelIndex] & getOwnedEdges(kk, j, i));
+                    numSlabVertices += qPopulationCount(
+                                quint32(intersectedEdges));
+
+                    if (lazyPointEvaluation)
+                    {
+                        markActivePoints(kk, j, i, intersectedEdges);
+                    }
 
-                uint8_t numVoxelTris = 0;
+                    uint8_t numVoxelTris = 0;
 
-                for (uint32_t ii = 0; triTable[voxelIndex][ii] != -1; ii += 3)
-                {
-                    numVoxelTris++;
-                }
+                    for (uint32_t ii = 0; triTable[voxelIndex][ii] != -1; ii += 3)
+                    {
+                        numVoxelTris++;
+                    }
 
-                uint32_t triIndex = 0;
+                    quint64 triIndex = 0;
 #ifdef COMPUTE_PARALLEL
 #pragma omp atomic capture
 #endif
-                {
-                    triIndex = atomicTriangleCount;
-                    atomicTriangleCount += numVoxelTris;
+                    {
+                        triIndex = atomicTriangleCount;
+                        atomicTriangleCount += numVoxelTris;
+                    }
+                    voxelNumTriangles[pIndex] = numVoxelTris;
+                    voxelMinIndexTriangle[pIndex] = triIndex;
                 }
-                voxelNumTriangles[pIndex] = numVoxelTris;
-                voxelMinIndexTriangle[pIndex] = triIndex;
             }
         }
     }
 
-
-    flattenTriangles.resize(atomicTriangleCount);
-//    flattenPoints.resize(numEdges);
-//    flattenNormals.resize(numEdges);
+    triangleBase = flattenTriangles.size();
+    flattenTriangles.resize(triangleBase + atomicTriangleCount);
 
 #ifdef MEASURE_CPU_TIME
     auto end = std::chrono::system_clock::now();
     auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
     LOG4CPLUS_DEBUG(mlog, " done in " << elapsed.count() << "ms.\n");
 #endif
+
+    return numSlabVertices;
 }
 
 void MMarchingCubes::computeIntersectionPoints(const double isovalue)
@@ -541,98 +929,104 @@ void MMarchingCubes::computeIntersectionPoints(const double isovalue)
 
     atomicEdgeCount = 0;
 
-    for (uint32_t k = 0; k < nz; ++k)
-    {
 #ifdef COMPUTE_PARALLEL
-#pragma omp parallel for collapse(2)
+#pragma omp parallel for schedule(dynamic)
 #endif
-        for (uint32_t j = 0; j < ny; ++j)
+    for (size_t b = 0; b < slabBlocks.size(); ++b)
+    {
+        const VoxelBlock& block = slabBlocks[b];
+
+        for (uint32_t kk = block.k0; kk < block.k1; ++kk)
         {
-            for (uint32_t i = 0; i < nx; ++i)
+            for (uint32_t j = block.j0; j < block.j1; ++j)
             {
-                const uint32_t index = INDEX3zyx(k, j, i, ny, nx);
-                const uint8_t voxelIndex = voxelIndices[index];
-
-                if (voxelIndex == 0 || voxelIndex == 0xFF) { continue; }
+                for (uint32_t i = block.i0; i < block.i1; ++i)
+                {
+                    const size_t index = getVoxelIndex(kk, j, i);
+                    const uint8_t voxelIndex = voxelIndices[index];
 
-                const int edgeIndex = edgeTable[voxelIndex];
+                    if (voxelIndex == 0 || voxelIndex == 0xFF) { continue; }
 
-                // last slice boundary --> collect upper edges
-                if (k == nz - 1)
-                {
-                    // Loop over all edges in x-direction
-                    // ___ ___ ___ ___
-                    if (j == ny - 1 && edgeIndex & 0x40)
-                    {
-                        lerpAtVoxel(isovalue, k, j, i, 6);
-                    }
-                    if (edgeIndex & 0x10)
-                    {
-                        lerpAtVoxel(isovalue, k, j, i, 4);
-                    }
+                    const int edgeIndex = edgeTable[voxelIndex]
+                            & getOwnedEdges(kk, j, i);
 
-                    // Loop over all edges in y-direction
-                    // |   |   |   |
-                    if (i == nx - 1 && edgeIndex & 0x20)
+                    for (uint8_t edge = 0; edge < 12; ++edge)
                     {
-                        lerpAtVoxel(isovalue, k, j, i, 5);
-                    }
-                    if (edgeIndex & 0x80)
-                    {
-                        lerpAtVoxel(isovalue, k, j, i, 7);
+                        if (edgeIndex & (1 << edge))
+                        {
+                            lerpAtVoxel(isovalue, kk, j, i, edge);
+                        }
                     }
                 }
-                // collect lower edges of voxels
+            }
+        }
+    }
 
-                // Loop over all edges in x-direction
-                // ___ ___ ___ ___
-                if (j == ny - 1 && edgeIndex & 0x4)
-                {
-                    lerpAtVoxel(isovalue, k, j, i, 2);
-                }
-                if (edgeIndex & 0x1)
-                {
-                    lerpAtVoxel(isovalue, k, j, i, 0);
-                }
+    numVertices += atomicEdgeCount;
 
-                // Loop over all edges in y-direction
-                // |   |   |   |
-                if (i == nx - 1 && edgeIndex & 0x2)
-                {
-                    lerpAtVoxel(isovalue, k, j, i, 1);
-                }
-                if (edgeIndex & 0x8)
-                {
-                    lerpAtVoxel(isovalue, k, j, i, 3);
-                }
+#ifdef MEASURE_CPU_TIME
+    auto end = std::chrono::system_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    LOG4CPLUS_DEBUG(mlog, " done in " << elapsed.count() << "ms.\n");
+#endif
+}
 
-                // Loop over all edges in z-direction
-                // |/_   _|/_   _|/_   _|/
-                if (edgeIndex & 0x100 )
-                {
-                    lerpAtVoxel(isovalue, k, j, i, 8);
-                }
-                if (edgeIndex & 0x200 && i == nx - 1)
-                {
-                    lerpAtVoxel(isovalue, k, j, i, 9);
-                }
-                if (edgeIndex & 0x400 && j == ny - 1 && i == nx - 1)
-                {
-                    lerpAtVoxel(isovalue, k, j, i, 10);
-                }
-                if (edgeIndex & 0x800 && j == ny - 1)
+
+void MMarchingCubes::generateTriangles()
+{
+    printf("\t -> generate triangles...");
+    auto start = std::chrono::system_clock::now();
+
+#ifdef COMPUTE_PARALLEL
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (size_t b = 0; b < slabBlocks.size(); ++b)
+    {
+        const VoxelBlock& block = slabBlocks[b];
+
+        for (uint32_t k = block.k0; k < block.k1; ++k)
+        {
+            for (uint32_t j = block.j0; j < block.j1; ++j)
+            {
+                for (uint32_t i = block.i0; i < block.i1; ++i)
                 {
-                    lerpAtVoxel(isovalue, k, j, i, 11);
-                }
+                    const size_t index = getVoxelIndex(k, j, i);
+                    const uint8_t voxelIndex = voxelIndices[index];
+
+                    if (voxelIndex == 0 || voxelIndex == 0xFF) { continue; }
+
+                    const size_t minIndexTriangle = triangleBase
+                            + voxelMinIndexTriangle[index];
+                    uint32_t numTriangles = voxelNumTriangles[index];
+
+                    bool degeneratedTriangle = false;
+
+                    //for (uint32_t ii = 0; triTable[voxelIndex][ii] != -1; ii += 3)
+                    for (uint32_t kk = 0; kk < numTriangles; ++kk)
+                    {
+                        uint32_t ii = kk * 3;
+                        Geometry::MTriangle triangle = { 0, 0, 0 };
+
+                        for (uint32_t jj = 0; jj < 3; ++jj)
+                        {
+                            const auto edgeIndex = triTable[voxelIndex][ii + jj];
+                            const size_t pIndex = getPointIndex(k, j, i, edgeIndex);
+                            const uint32_t fIndex = intersectionIndices[pIndex];
+
+                            degeneratedTriangle = (fIndex == iNaN);
+                            if (degeneratedTriangle) { break; }
 
+                            triangle.indices[jj] = intersectionIndices[pIndex];
+                        }
+
+                        if (!degeneratedTriangle) { flattenTriangles[minIndexTriangle + kk] = triangle; }
+                        else { flattenTriangles[minIndexTriangle + kk] = { 0, 0, 0 }; }
+                    }
+                }
             }
         }
     }
 
-    flattenPoints.resize(atomicEdgeCount);
-    flattenNormals.resize(atomicEdgeCount);
-    if (heightGrid) { flattenNormalsZ.resize(atomicEdgeCount); }
-
 #ifdef MEASURE_CPU_TIME
     auto end = std::chrono::system_clock::now();
     auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
@@ -641,63 +1035,419 @@ void MMarchingCubes::computeIntersectionPoints(const double isovalue)
 }
 
 
-void MMarchingCubes::generateTriangles()
+void MMarchingCubes::computeMeshFlyingEdges(const float isovalue)
 {
-    printf("\t -> generate triangles...");
+#ifdef MEASURE_CPU_TIME
     auto start = std::chrono::system_clock::now();
+#endif
+
+    const size_t numGridRows = size_t(dimZ) * dimY;
+    const size_t numVoxelRows = size_t(nz) * ny;
+
+    flyingEdgesRows.resize(numGridRows);
+    flyingEdgesBelow.resize(numGridRows * dimX);
+    std::vector<quint64> firstTriangle(numVoxelRows + 1, 0);
 
-    for (uint32_t k = 0; k < nz; ++k)
+    // 1) Classify the grid points and find the intersected x-edges of each
+    //    grid row.
+#ifdef COMPUTE_PARALLEL
+#pragma omp parallel for
+#endif
+    for (size_t r = 0; r < numGridRows; ++r)
     {
+        const float *values = scalarValues + r * dimX;
+        uint8_t *below = &flyingEdgesBelow[r * dimX];
+
+        for (uint32_t i = 0; i < dimX; ++i)
+        {
+            below[i] = (values[i] < isovalue) ? 1 : 0;
+        }
+
+        FlyingEdgesRow& row = flyingEdgesRows[r];
+        row.numXEdges = 0;
+        row.xL = nx;
+        row.xR = 0;
+
+        for (uint32_t i = 0; i < nx; ++i)
+        {
+            if (below[i] == below[i + 1]) { continue; }
+            if (row.numXEdges == 0) { row.xL = i; }
+            row.xR = i + 1;
+            row.numXEdges++;
+        }
+    }
+
+    // 2) Count the intersected y- and z-edges of each grid row and the
+    //    triangles of each row of voxels.
 #ifdef COMPUTE_PARALLEL
-#pragma omp parallel for collapse(2)
+#pragma omp parallel for
 #endif
-        for (uint32_t j = 0; j < ny; ++j)
+    for (size_t r = 0; r < numGridRows; ++r)
+    {
+        const uint32_t k = uint32_t(r / dimY);
+        const uint32_t j = uint32_t(r % dimY);
+        FlyingEdgesRow& row = flyingEdgesRows[r];
+        row.numYEdges = 0;
+        row.numZEdges = 0;
+
+        uint32_t i0, i1;
+        if (j < ny)
+        {
+            const size_t rows[2] = { r, r + 1 };
+            if (getFlyingEdgesTrim(rows, 2, i0, i1))
+            {
+                for (uint32_t i = i0; i <= i1; ++i)
+                {
+                    if (isBelow(r, i) != isBelow(r + 1, i)) { row.numYEdges++; }
+                }
+            }
+        }
+        if (k < nz)
         {
-            for (uint32_t i = 0; i < nx; ++i)
+            const size_t rows[2] = { r, r + dimY };
+            if (getFlyingEdgesTrim(rows, 2, i0, i1))
             {
-                const uint32_t index = INDEX3zyx(k, j, i, ny, nx);
-                const uint8_t voxelIndex = voxelIndices[index];
+                for (uint32_t i = i0; i <= i1; ++i)
+                {
+                    if (isBelow(r, i) != isBelow(r + dimY, i)) { row.numZEdges++; }
+                }
+            }
+        }
+
+        if (k < nz && j < ny)
+        {
+            const size_t rows[4] = { r, r + 1, r + dimY, r + dimY + 1 };
+            quint64 numTriangles = 0;
+            if (getFlyingEdgesTrim(rows, 4, i0, i1))
+            {
+                for (uint32_t i = i0; i < i1; ++i)
+                {
+                    uint8_t voxelIndex = 0;
+                    voxelIndex |= isBelow(rows[0], i)     ? 0x1 : 0;
+                    voxelIndex |= isBelow(rows[0], i + 1) ? 0x2 : 0;
+                    voxelIndex |= isBelow(rows[1], i + 1) ? 0x4 : 0;
+                    voxelIndex |= isBelow(rows[1], i)     ? 0x8 : 0;
+                    voxelIndex |= isBelow(rows[2], i)     ? 0x10 : 0;
+                    voxelIndex |= isBelow(rows[2], i + 1) ? 0x20 : 0;
+                    voxelIndex |= isBelow(rows[3], i + 1) ? 0x40 : 0;
+                    voxelIndex |= isBelow(rows[3], i)     ? 0x80 : 0;
+
+                    for (uint32_t ii = 0; triTable[voxelIndex][ii] != -1; ii += 3)
+                    {
+                        numTriangles++;
+                    }
+                }
+            }
+            firstTriangle[size_t(k) * ny + j + 1] = numTriangles;
+        }
+    }
+
+    // 3) Prefix sums over the rows yield the first vertex of each grid row
+    //    and the first triangle of each row of voxels.
+    quint64 numMeshVertices = 0;
+    for (size_t r = 0; r < numGridRows; ++r)
+    {
+        FlyingEdgesRow& row = flyingEdgesRows[r];
+        row.firstVertex = numMeshVertices;
+        numMeshVertices += quint64(row.numXEdges) + row.numYEdges + row.numZEdges;
+    }
+    for (size_t v = 0; v < numVoxelRows; ++v)
+    {
+        firstTriangle[v + 1] += firstTriangle[v];
+    }
+
+    // Vertex indices are stored as 32 bit unsigned integers (as required by
+    // the index buffer, which holds three indices per triangle).
+    if (numMeshVertices >= quint64(iNaN)
+            || firstTriangle[numVoxelRows] * 3 >= quint64(iNaN))
+    {
+        LOG4CPLUS_ERROR(mlog, "Flying edges: the isosurface exceeds the "
+                        "maximum number of vertices or triangles that can be "
+                        "indexed with 32 bit indices; no mesh is created.");
+        std::vector<FlyingEdgesRow>().swap(flyingEdgesRows);
+        std::vector<uint8_t>().swap(flyingEdgesBelow);
+        return;
+    }
 
-                if (voxelIndex == 0 || voxelIndex == 0xFF) { continue; }
+    numVertices = numMeshVertices;
+    flattenPoints.resize(numVertices);
+    flattenNormals.resize(numVertices);
+    if (heightGrid) { flattenNormalsZ.resize(numVertices); }
+    for (std::vector<float>& attributes : flattenAttributes)
+    {
+        attributes.resize(numVertices);
+    }
+    flattenTriangles.resize(firstTriangle[numVoxelRows]);
 
-                uint32_t minIndexTriangle = voxelMinIndexTriangle[index];
-                uint32_t numTriangles = voxelNumTriangles[index];
+    // 4) Evaluate the grid points adjacent to intersected edges once, then
+    //    compute the intersection points of each grid row in the order of
+    //    the x-, y- and z-edges of the row.
+    activePointIndices.assign(numGridRows * dimX, iNaN);
+#ifdef COMPUTE_PARALLEL
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+    for (size_t r = 0; r < numGridRows; ++r)
+    {
+        visitFlyingEdgesRowEdges(
+                    r, [this](const uint32_t kP, const uint32_t jP,
+                              const uint32_t iP, const uint32_t kN,
+                              const uint32_t jN, const uint32_t iN)
+        {
+            markActivePoint(getGridPointIndex(kP, jP, iP));
+            markActivePoint(getGridPointIndex(kN, jN, iN));
+        });
+    }
+
+    evaluateActivePoints(0);
+
+#ifdef COMPUTE_PARALLEL
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+    for (size_t r = 0; r < numGridRows; ++r)
+    {
+        size_t vertex = flyingEdgesRows[r].firstVertex;
+        visitFlyingEdgesRowEdges(
+                    r, [this, isovalue, &vertex](
+                    const uint32_t kP, const uint32_t jP, const uint32_t iP,
+                    const uint32_t kN, const uint32_t jN, const uint32_t iN)
+        {
+            interpolateEdge(isovalue, kP, jP, iP, kN, jN, iN, vertex++);
+        });
+    }
 
-                bool degeneratedTriangle = false;
+    // 5) Generate the triangles of each row of voxels. The vertex indices of
+    //    the edges of a voxel are obtained by counting the intersected edges
+    //    of the four adjacent grid rows while walking along the row.
+#ifdef COMPUTE_PARALLEL
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+    for (size_t v = 0; v < numVoxelRows; ++v)
+    {
+        if (firstTriangle[v] == firstTriangle[v + 1]) { continue; }
+
+        const uint32_t k = uint32_t(v / ny);
+        const uint32_t j = uint32_t(v % ny);
+
+        // Grid rows (k, j), (k, j+1), (k+1, j) and (k+1, j+1).
+        const size_t rows[4] = { size_t(k) * dimY + j, size_t(k) * dimY + j + 1,
+                                 size_t(k + 1) * dimY + j,
+                                 size_t(k + 1) * dimY + j + 1 };
+        const FlyingEdgesRow& rowA = flyingEdgesRows[rows[0]];
+        const FlyingEdgesRow& rowB = flyingEdgesRows[rows[1]];
+        const FlyingEdgesRow& rowC = flyingEdgesRows[rows[2]];
+        const FlyingEdgesRow& rowD = flyingEdgesRows[rows[3]];
+
+        // Next vertex on the x-edges of the four rows, on the y-edges of rows
+        // (k, j) and (k+1, j) and on the z-edges of rows (k, j) and (k, j+1).
+        size_t xA = rowA.firstVertex;
+        size_t xB = rowB.firstVertex;
+        size_t xC = rowC.firstVertex;
+        size_t xD = rowD.firstVertex;
+        size_t yA = rowA.firstVertex + rowA.numXEdges;
+        size_t yC = rowC.firstVertex + rowC.numXEdges;
+        size_t zA = rowA.firstVertex + rowA.numXEdges + rowA.numYEdges;
+        size_t zB = rowB.firstVertex + rowB.numXEdges + rowB.numYEdges;
+
+        size_t triangle = firstTriangle[v];
+
+        uint32_t i0, i1;
+        getFlyingEdgesTrim(rows, 4, i0, i1);
+
+        for (uint32_t i = i0; i < i1; ++i)
+        {
+            uint8_t voxelIndex = 0;
+            voxelIndex |= isBelow(rows[0], i)     ? 0x1 : 0;
+            voxelIndex |= isBelow(rows[0], i + 1) ? 0x2 : 0;
+            voxelIndex |= isBelow(rows[1], i + 1) ? 0x4 : 0;
+            voxelIndex |= isBelow(rows[1], i)     ? 0x8 : 0;
+            voxelIndex |= isBelow(rows[2], i)     ? 0x10 : 0;
+            voxelIndex |= isBelow(rows[2], i + 1) ? 0x20 : 0;
+            voxelIndex |= isBelow(rows[3], i + 1) ? 0x40 : 0;
+            voxelIndex |= isBelow(rows[3], i)     ? 0x80 : 0;
+
+            const bool yAi = isBelow(rows[0], i) != isBelow(rows[1], i);
+            const bool yCi = isBelow(rows[2], i) != isBelow(rows[3], i);
+            const bool zAi = isBelow(rows[0], i) != isBelow(rows[2], i);
+            const bool zBi = isBelow(rows[1], i) != isBelow(rows[3], i);
+
+            if (voxelIndex != 0 && voxelIndex != 0xFF)
+            {
+                // Vertex indices of the 12 edges (edge numbering of
+                // getEdgeVertices()); only the intersected ones are valid.
+                const size_t edgeVertices[12] = {
+                    xA, yA + (yAi ? 1 : 0), xB, yA,
+                    xC, yC + (yCi ? 1 : 0), xD, yC,
+                    zA, zA + (zAi ? 1 : 0), zB + (zBi ? 1 : 0), zB };
 
-                //for (uint32_t ii = 0; triTable[voxelIndex][ii] != -1; ii += 3)
-                for (uint32_t kk = 0; kk < numTriangles; ++kk)
+                for (uint32_t ii = 0; triTable[voxelIndex][ii] != -1; ii += 3)
                 {
-                    uint32_t ii = kk * 3;
-                    Geometry::MTriangle triangle = { 0, 0, 0 };
+                    Geometry::MTriangle tri = { 0, 0, 0 };
+                    bool degeneratedTriangle = false;
 
                     for (uint32_t jj = 0; jj < 3; ++jj)
                     {
-                        const auto edgeIndex = triTable[voxelIndex][ii + jj];
-                        const uint32_t pIndex = getPointIndex(k, j, i, edgeIndex);
-                        const uint32_t fIndex = intersectionIndices[pIndex];
+                        const size_t vertex =
+                                edgeVertices[triTable[voxelIndex][ii + jj]];
 
-                        degeneratedTriangle = (fIndex == iNaN);
+                        // Edges with a missing value yield invalid vertices.
+                        degeneratedTriangle = std::isnan(flattenPoints[vertex].x());
                         if (degeneratedTriangle) { break; }
 
-                        triangle.indices[jj] = intersectionIndices[pIndex];
+                        tri.indices[jj] = uint32_t(vertex);
                     }
 
-                    if (!degeneratedTriangle) { flattenTriangles[minIndexTriangle + kk] = triangle; }
-                    else { flattenTriangles[minIndexTriangle + kk] = { 0, 0, 0 }; }
+                    flattenTriangles[triangle++] = degeneratedTriangle
+                            ? Geometry::MTriangle({ 0, 0, 0 }) : tri;
                 }
             }
+
+            if (isBelow(rows[0], i) != isBelow(rows[0], i + 1)) { xA++; }
+            if (isBelow(rows[1], i) != isBelow(rows[1], i + 1)) { xB++; }
+            if (isBelow(rows[2], i) != isBelow(rows[2], i + 1)) { xC++; }
+            if (isBelow(rows[3], i) != isBelow(rows[3], i + 1)) { xD++; }
+            if (yAi) { yA++; }
+            if (yCi) { yC++; }
+            if (zAi) { zA++; }
+            if (zBi) { zB++; }
         }
     }
 
+    std::vector<FlyingEdgesRow>().swap(flyingEdgesRows);
+    std::vector<uint8_t>().swap(flyingEdgesBelow);
+    releaseSlab();
+
 #ifdef MEASURE_CPU_TIME
     auto end = std::chrono::system_clock::now();
     auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
-    LOG4CPLUS_DEBUG(mlog, " done in " << elapsed.count() << "ms.\n");
+    LOG4CPLUS_DEBUG(mlog, "Flying edges: " << numVertices << " vertices and "
+                    << flattenTriangles.size() << " triangles extracted in "
+                    << elapsed.count() << "ms.");
 #endif
 }
 
 
+template<typename EdgeVisitor>
+void MMarchingCubes::visitFlyingEdgesRowEdges(const size_t r,
+                                              EdgeVisitor visit) const
+{
+    const uint32_t k = uint32_t(r / dimY);
+    const uint32_t j = uint32_t(r % dimY);
+    const FlyingEdgesRow& row = flyingEdgesRows[r];
+
+    for (uint32_t i = row.xL; i < row.xR; ++i)
+    {
+        if (isBelow(r, i) == isBelow(r, i + 1)) { continue; }
+        visit(k, j, i, k, j, i + 1);
+    }
+
+    uint32_t i0, i1;
+    if (row.numYEdges > 0)
+    {
+        const size_t rows[2] = { r, r + 1 };
+        getFlyingEdgesTrim(rows, 2, i0, i1);
+        for (uint32_t i = i0; i <= i1; ++i)
+        {
+            if (isBelow(r, i) == isBelow(r + 1, i)) { continue; }
+            visit(k, j, i, k, j + 1, i);
+        }
+    }
+    if (row.numZEdges > 0)
+    {
+        const size_t rows[2] = { r, r + dimY };
+        getFlyingEdgesTrim(rows, 2, i0, i1);
+        for (uint32_t i = i0; i <= i1; ++i)
+        {
+            if (isBelow(r, i) == isBelow(r + dimY, i)) { continue; }
+            visit(k, j, i, k + 1, j, i);
+        }
+    }
+}
+
+
+bool MMarchingCubes::getFlyingEdgesTrim(const size_t* gridRows,
+                                        const int numRows,
+                                        uint32_t& i0, uint32_t& i1) const
+{
+    i0 = nx;
+    i1 = 0;
+    bool leftDiffers = false;
+    bool rightDiffers = false;
+
+    for (int q = 0; q < numRows; ++q)
+    {
+        const FlyingEdgesRow& row = flyingEdgesRows[gridRows[q]];
+        if (row.numXEdges > 0)
+        {
+            i0 = std::min(i0, row.xL);
+            i1 = std::max(i1, row.xR);
+        }
+        leftDiffers |= isBelow(gridRows[q], 0) != isBelow(gridRows[0], 0);
+        rightDiffers |= isBelow(gridRows[q], nx) != isBelow(gridRows[0], nx);
+    }
+
+    if (i0 >= i1)
+    {
+        // No row is intersected along x; all rows are uniform.
+        if (!leftDiffers) { return false; }
+        i0 = 0;
+        i1 = nx;
+        return true;
+    }
+
+    if (leftDiffers) { i0 = 0; }
+    if (rightDiffers) { i1 = nx; }
+    return true;
+}
+
+
+void MMarchingCubes::interpolateEdge(const float isovalue,
+                                     const uint32_t kP, const uint32_t jP,
+                                     const uint32_t iP, const uint32_t kN,
+                                     const uint32_t jN, const uint32_t iN,
+                                     const size_t vertex)
+{
+    const float valP = getScalar(kP, jP, iP);
+    const float valN = getScalar(kN, jN, iN);
+
+    if (std::isnan(valN) || std::isnan(valP))
+    {
+        flattenPoints[vertex] = QVector3D(qNaN, qNaN, qNaN);
+        flattenNormals[vertex] = QVector3D(qNaN, qNaN, qNaN);
+        if (heightGrid)
+        {
+            flattenNormalsZ[vertex] = QVector3D(qNaN, qNaN, qNaN);
+        }
+        for (std::vector<float>& attributes : flattenAttributes)
+        {
+            attributes[vertex] = qNaN;
+        }
+        return;
+    }
+
+    // Both grid points have been evaluated by evaluateActivePoints().
+    const uint32_t aP = activePointIndices[getGridPointIndex(kP, jP, iP)];
+    const uint32_t aN = activePointIndices[getGridPointIndex(kN, jN, iN)];
+
+    flattenPoints[vertex] = vec3Lerp(isovalue, valP, valN,
+                                     gridPoints[aP], gridPoints[aN]);
+    flattenNormals[vertex] = vec3Lerp(isovalue, valP, valN,
+                                      normals[aP], normals[aN]);
+    if (heightGrid)
+    {
+        flattenNormalsZ[vertex] = vec3Lerp(isovalue, valP, valN,
+                                           normalsZ[aP], normalsZ[aN]);
+    }
+
+    for (size_t a = 0; a < attributeGrids.size(); ++a)
+    {
+        flattenAttributes[a][vertex] = floatLerp(
+                    isovalue, valP, valN,
+                    attributeGrids[a]->getValue(kP, jP, iP),
+                    attributeGrids[a]->getValue(kN, jN, iN));
+    }
+}
+
+
 void MMarchingCubes::initializeVoxel(const uint32_t k, const uint32_t j,
                                      const uint32_t i,
                                      Geometry::MVoxel& voxel) const
@@ -706,9 +1456,12 @@ void MMarchingCubes::initializeVoxel(const uint32_t k, const uint32_t j,
 
     for (uint8_t cc = 0; cc < 8; ++cc)
     {
+        QVector3D normalZ;
         voxel.values[cc] = getVoxelValue(k, j, i, cc);
-        voxel.positions[cc] = getPosition(k, j, i, cc);
-        voxel.normals[cc] = getNormal(k, j, i, cc);
+        int kv, jv, iv;
+        getVertexIndices(k, j, i, cc, kv, jv, iv);
+        evaluateGridPoint(MGenericPressureAccess(inputGrid), kv, jv, iv,
+                          voxel.positions[cc], voxel.normals[cc], normalZ);
     }
 }
 
@@ -724,25 +1477,22 @@ void MMarchingCubes::lerpAtVoxel(const double isovalue,
     getEdgeVertices(edge, vP, vN);
 
     const float valP = getVoxelValue(k, j, i, vP);
-    const QVector3D posP = getPosition(k, j, i, vP);
-    const QVector3D normalP = getNormal(k, j, i, vP);
-
     const float valN = getVoxelValue(k, j, i, vN);
-    const QVector3D posN = getPosition(k, j, i, vN);
-    const QVector3D normalN = getNormal(k, j, i, vN);
 
-    const uint32_t pIndex = getPointIndex(k, j, i, edge);
+    const size_t pIndex = getPointIndex(k, j, i, edge);
 
-    uint32_t fIndex = 0;
+    uint32_t localIndex = 0;
 
 #ifdef COMPUTE_PARALLEL
 #pragma omp atomic capture
 #endif
     {
-        fIndex = atomicEdgeCount;
+        localIndex = atomicEdgeCount;
         atomicEdgeCount++;
     }
 
+    const uint32_t fIndex = uint32_t(numVertices + localIndex);
+
     if (std::isnan(valN) || std::isnan(valP))
     {
         flattenPoints[fIndex] = QVector3D(qNaN, qNaN, qNaN);
@@ -753,20 +1503,46 @@ void MMarchingCubes::lerpAtVoxel(const double isovalue,
             flattenNormalsZ[fIndex] = QVector3D(qNaN, qNaN, qNaN);;
         }
 
+        for (std::vector<float>& attributes : flattenAttributes)
+        {
+            attributes[fIndex] = qNaN;
+        }
+
         return;
     }
 
+    // Positions and normals are only required for the edges that are
+    // actually intersected.
+    QVector3D posP, normalP, normalZP;
+    QVector3D posN, normalN, normalZN;
+    getVertexData(k, j, i, vP, posP, normalP, normalZP);
+    getVertexData(k, j, i, vN, posN, normalN, normalZN);
+
     intersectionIndices[pIndex] = fIndex;
     flattenPoints[fIndex] = vec3Lerp(isovalue, valP, valN, posP, posN);
     flattenNormals[fIndex] = vec3Lerp(isovalue, valP, valN, normalP, normalN);
 
     if (heightGrid)
     {
-        const QVector3D normalZP = getNormalZ(k, j, i, vP);
-        const QVector3D normalZN = getNormalZ(k, j, i, vN);
-
         flattenNormalsZ[fIndex] = vec3Lerp(isovalue, valP, valN, normalZP, normalZN);
     }
+
+    // Attribute values are read directly at the two edge vertices, which
+    // avoids searching for the position in the attribute grid.
+    if (!attributeGrids.empty())
+    {
+        int kP, jP, iP, kN, jN, iN;
+        getVertexIndices(k, j, i, vP, kP, jP, iP);
+        getVertexIndices(k, j, i, vN, kN, jN, iN);
+
+        for (size_t a = 0; a < attributeGrids.size(); ++a)
+        {
+            flattenAttributes[a][fIndex] = floatLerp(
+                        isovalue, valP, valN,
+                        attributeGrids[a]->getValue(kP, jP, iP),
+                        attributeGrids[a]->getValue(kN, jN, iN));
+        }
+    }
 }
 
 
@@ -788,6 +1564,34 @@ QVector3D MMarchingCubes::vec3Lerp(const float isovalue,
 }
 
 
+float MMarchingCubes::floatLerp(const float isovalue,
+                                const float valP, const float valN,
+                                const float aP, const float aN) const
+{
+    const double PRECISION = 1E-30;
+
+    if (std::abs(isovalue - valP) < PRECISION) { return aP; }
+    if (std::abs(isovalue - valN) < PRECISION) { return aN; }
+    if (std::abs(valP - valN) < PRECISION)     { return aP; }
+
+    const double mu = (isovalue - valP) / (valN - valP);
+
+    return aP + mu * (aN - aP);
+}
+
+
+void MMarchingCubes::getVertexIndices(const uint32_t k, const uint32_t j,
+                                      const uint32_t i, const uint8_t v,
+                                      int& kv, int& jv, int& iv) const
+{
+    // Vertices 0..3 are on the lower, 4..7 on the upper level of the voxel;
+    // k is relative to the current slab.
+    kv = slabK0 + k + ((v >= 4) ? 1 : 0);
+    jv = j + ((v % 4 == 2 || v % 4 == 3) ? 1 : 0);
+    iv = i + ((v % 4 == 1 || v % 4 == 2) ? 1 : 0);
+}
+
+
 void MMarchingCubes::getEdgeVertices(const uint8_t edge,
                                      uint8_t& vP, uint8_t& vN) const
 {
@@ -806,32 +1610,89 @@ void MMarchingCubes::getEdgeVertices(const uint8_t edge,
 }
 
 
+uint16_t MMarchingCubes::getOwnedEdges(const uint32_t k, const uint32_t j,
+                                       const uint32_t i) const
+{
+    // Each voxel computes the intersections on its lower x- and y-edges
+    // starting at vertex 0 and on its vertical edge 8. Voxels at the upper
+    // boundaries additionally compute the edges not shared with a neighbour.
+    uint16_t ownedEdges = 0x1 | 0x8 | 0x100;
+
+    if (j == ny - 1) { ownedEdges |= 0x4 | 0x800; }
+    if (i == nx - 1) { ownedEdges |= 0x2 | 0x200; }
+    if (j == ny - 1 && i == nx - 1) { ownedEdges |= 0x400; }
+
+    // The top layer of a slab computes the upper edges; they are carried over
+    // to the next slab whose bottom layer hence must not recompute them.
+    if (k == slabNz - 1)
+    {
+        ownedEdges |= 0x10 | 0x80;
+        if (j == ny - 1) { ownedEdges |= 0x40; }
+        if (i == nx - 1) { ownedEdges |= 0x20; }
+    }
+    if (k == 0 && slabK0 > 0)
+    {
+        ownedEdges &= ~uint16_t(0xF);
+    }
+
+    return ownedEdges;
+}
+
+
 float MMarchingCubes::getVoxelValue(const uint32_t k, const uint32_t j,
                                     const uint32_t i, const uint8_t v) const
 {
-    if (v == 0) { return inputGrid->getValue(k, j, i); }
-    if (v == 1) { return inputGrid->getValue(k, j, i + 1); }
-    if (v == 2) { return inputGrid->getValue(k, j + 1, i + 1); }
-    if (v == 3) { return inputGrid->getValue(k, j + 1, i); }
-    if (v == 4) { return inputGrid->getValue(k + 1, j, i); }
-    if (v == 5) { return inputGrid->getValue(k + 1, j, i + 1); }
-    if (v == 6) { return inputGrid->getValue(k + 1, j + 1, i + 1); }
-    if (v == 7) { return inputGrid->getValue(k + 1, j + 1, i); }
+    // k is relative to the current slab.
+    const uint32_t kg = slabK0 + k;
+
+    if (v == 0) { return getScalar(kg, j, i); }
+    if (v == 1) { return getScalar(kg, j, i + 1); }
+    if (v == 2) { return getScalar(kg, j + 1, i + 1); }
+    if (v == 3) { return getScalar(kg, j + 1, i); }
+    if (v == 4) { return getScalar(kg + 1, j, i); }
+    if (v == 5) { return getScalar(kg + 1, j, i + 1); }
+    if (v == 6) { return getScalar(kg + 1, j + 1, i + 1); }
+    if (v == 7) { return getScalar(kg + 1, j + 1, i); }
     return 0;
 }
 
 
+void MMarchingCubes::getVertexData(const uint32_t k, const uint32_t j,
+                                   const uint32_t i, const uint8_t v,
+                                   QVector3D& position, QVector3D& normal,
+                                   QVector3D& normalZ) const
+{
+    if (lazyPointEvaluation)
+    {
+        // The vertex is adjacent to an intersected edge and has been
+        // evaluated by evaluateActivePoints().
+        int kv, jv, iv;
+        getVertexIndices(k, j, i, v, kv, jv, iv);
+        const uint32_t a = activePointIndices[
+                getGridPointIndex(kv - slabK0, jv, iv)];
+        position = gridPoints[a];
+        normal = normals[a];
+        if (heightGrid) { normalZ = normalsZ[a]; }
+        return;
+    }
+
+    position = getPosition(k, j, i, v);
+    normal = getNormal(k, j, i, v);
+    if (heightGrid) { normalZ = getNormalZ(k, j, i, v); }
+}
+
+
 QVector3D MMarchingCubes::getPosition(const uint32_t k, const uint32_t j,
                                       const uint32_t i, const uint8_t v) const
 {
-    if (v == 0) { return gridPoints[INDEX3zyx(k, j, i, ny + 1, nx + 1)]; }
-    if (v == 1) { return gridPoints[INDEX3zyx(k, j, i + 1, ny + 1, nx + 1)]; }
-    if (v == 2) { return gridPoints[INDEX3zyx(k, j + 1, i + 1, ny + 1, nx + 1)]; }
-    if (v == 3) { return gridPoints[INDEX3zyx(k, j + 1, i, ny + 1, nx + 1)]; }
-    if (v == 4) { return gridPoints[INDEX3zyx(k + 1, j, i, ny + 1, nx + 1)]; }
-    if (v == 5) { return gridPoints[INDEX3zyx(k + 1, j, i + 1, ny + 1, nx + 1)]; }
-    if (v == 6) { return gridPoints[INDEX3zyx(k + 1, j + 1, i + 1, ny + 1, nx + 1)]; }
-    if (v == 7) { return gridPoints[INDEX3zyx(k + 1, j + 1, i, ny + 1, nx + 1)]; }
+    if (v == 0) { return gridPoints[getGridPointIndex(k, j, i)]; }
+    if (v == 1) { return gridPoints[getGridPointIndex(k, j, i + 1)]; }
+    if (v == 2) { return gridPoints[getGridPointIndex(k, j + 1, i + 1)]; }
+    if (v == 3) { return gridPoints[getGridPointIndex(k, j + 1, i)]; }
+    if (v == 4) { return gridPoints[getGridPointIndex(k + 1, j, i)]; }
+    if (v == 5) { return gridPoints[getGridPointIndex(k + 1, j, i + 1)]; }
+    if (v == 6) { return gridPoints[getGridPointIndex(k + 1, j + 1, i + 1)]; }
+    if (v == 7) { return gridPoints[getGridPointIndex(k + 1, j + 1, i)]; }
 
     return QVector3D(0, 0, 0);
 }
@@ -840,14 +1701,14 @@ QVector3D MMarchingCubes::getPosition(const uint32_t k, const uint32_t j,
 QVector3D MMarchingCubes::getNormal(const uint32_t k, const uint32_t j,
                                       const uint32_t i, const uint8_t v) const
 {
-    if (v == 0) { return normals[INDEX3zyx(k, j, i, ny + 1, nx + 1)]; }
-    if (v == 1) { return normals[INDEX3zyx(k, j, i + 1, ny + 1, nx + 1)]; }
-    if (v == 2) { return normals[INDEX3zyx(k, j + 1, i + 1, ny + 1, nx + 1)]; }
-    if (v == 3) { return normals[INDEX3zyx(k, j + 1, i, ny + 1, nx + 1)]; }
-    if (v == 4) { return normals[INDEX3zyx(k + 1, j, i, ny + 1, nx + 1)]; }
-    if (v == 5) { return normals[INDEX3zyx(k + 1, j, i + 1, ny + 1, nx + 1)]; }
-    if (v == 6) { return normals[INDEX3zyx(k + 1, j + 1, i + 1, ny + 1, nx + 1)]; }
-    if (v == 7) { return normals[INDEX3zyx(k + 1, j + 1, i, ny + 1, nx + 1)]; }
+    if (v == 0) { return normals[getGridPointIndex(k, j, i)]; }
+    if (v == 1) { return normals[getGridPointIndex(k, j, i + 1)]; }
+    if (v == 2) { return normals[getGridPointIndex(k, j + 1, i + 1)]; }
+    if (v == 3) { return normals[getGridPointIndex(k, j + 1, i)]; }
+    if (v == 4) { return normals[getGridPointIndex(k + 1, j, i)]; }
+    if (v == 5) { return normals[getGridPointIndex(k + 1, j, i + 1)]; }
+    if (v == 6) { return normals[getGridPointIndex(k + 1, j + 1, i + 1)]; }
+    if (v == 7) { return normals[getGridPointIndex(k + 1, j + 1, i)]; }
 
     return QVector3D(0, 0, 0);
 }
@@ -856,66 +1717,47 @@ QVector3D MMarchingCubes::getNormal(const uint32_t k, const uint32_t j,
 QVector3D MMarchingCubes::getNormalZ(const uint32_t k, const uint32_t j,
                                      const uint32_t i, const uint8_t v) const
 {
-    if (v == 0) { return normalsZ[INDEX3zyx(k, j, i, ny + 1, nx + 1)]; }
-    if (v == 1) { return normalsZ[INDEX3zyx(k, j, i + 1, ny + 1, nx + 1)]; }
-    if (v == 2) { return normalsZ[INDEX3zyx(k, j + 1, i + 1, ny + 1, nx + 1)]; }
-    if (v == 3) { return normalsZ[INDEX3zyx(k, j + 1, i, ny + 1, nx + 1)]; }
-    if (v == 4) { return normalsZ[INDEX3zyx(k + 1, j, i, ny + 1, nx + 1)]; }
-    if (v == 5) { return normalsZ[INDEX3zyx(k + 1, j, i + 1, ny + 1, nx + 1)]; }
-    if (v == 6) { return normalsZ[INDEX3zyx(k + 1, j + 1, i + 1, ny + 1, nx + 1)]; }
-    if (v == 7) { return normalsZ[INDEX3zyx(k + 1, j + 1, i, ny + 1, nx + 1)]; }
+    if (v == 0) { return normalsZ[getGridPointIndex(k, j, i)]; }
+    if (v == 1) { return normalsZ[getGridPointIndex(k, j, i + 1)]; }
+    if (v == 2) { return normalsZ[getGridPointIndex(k, j + 1, i + 1)]; }
+    if (v == 3) { return normalsZ[getGridPointIndex(k, j + 1, i)]; }
+    if (v == 4) { return normalsZ[getGridPointIndex(k + 1, j, i)]; }
+    if (v == 5) { return normalsZ[getGridPointIndex(k + 1, j, i + 1)]; }
+    if (v == 6) { return normalsZ[getGridPointIndex(k + 1, j + 1, i + 1)]; }
+    if (v == 7) { return normalsZ[getGridPointIndex(k + 1, j + 1, i)]; }
 
     return QVector3D(0, 0, 0);
 }
 
 
-uint32_t MMarchingCubes::getPointIndex( const uint32_t k, const uint32_t j,
-                                        const uint32_t i, const uint32_t edgeIndex)
+size_t MMarchingCubes::getPointIndex(const uint32_t k, const uint32_t j,
+                                     const uint32_t i,
+                                     const uint32_t edgeIndex) const
 {
-    const uint32_t dimX = inputGrid->getNumLons();
-    const uint32_t dimY = inputGrid->getNumLats();
-    const uint32_t dimZ = inputGrid->getNumLevels();
-
-    const uint32_t numXEdges = dimZ * nx * dimY;
-    const uint32_t numYEdges = dimZ * ny * dimX;
+    // Edge layout of the current slab: x-edges (slabNz + 1 planes of
+    // dimY * nx), y-edges (slabNz + 1 planes of ny * dimX), z-edges
+    // (slabNz layers of dimY * dimX). k is relative to the current slab.
+    const size_t numXYEdges = numSlabXEdges + numSlabYEdges;
 
+    switch (edgeIndex)
+    {
     // x-edges
-    if (edgeIndex == 0) { return INDEX3zyx(k, j, i, dimY, nx); }
-    if (j == ny - 1 && edgeIndex == 2) { return INDEX3zyx(k, j + 1, i, dimY, nx); }
-    if (edgeIndex == 2) { return getPointIndex(k, j + 1, i, 0); }
+    case 0:  return (size_t(k) * dimY + j) * nx + i;
+    case 2:  return (size_t(k) * dimY + j + 1) * nx + i;
+    case 4:  return (size_t(k + 1) * dimY + j) * nx + i;
+    case 6:  return (size_t(k + 1) * dimY + j + 1) * nx + i;
     // y-edges
-    if (edgeIndex == 3) { return INDEX3zyx(k, j, i, ny, dimX) + numXEdges; }
-    if (i == nx - 1 && edgeIndex == 1) { return INDEX3zyx(k, j, i + 1, ny, dimX) + numXEdges; }
-    if (edgeIndex == 1) { return getPointIndex(k, j, i + 1, 3); }
-
-    if (k == nz - 1)
-    {
-        // x-edges
-        if (edgeIndex == 4) { return INDEX3zyx(k + 1, j, i, dimY, nx); }
-        if (j == ny - 1 && edgeIndex == 6) { return INDEX3zyx(k + 1, j + 1, i, dimY, nx); }
-        if (edgeIndex == 6) { return getPointIndex(k, j + 1, i, 0); }
-        // y-edges
-        if (edgeIndex == 7) { return INDEX3zyx(k + 1, j, i, ny, dimX) + numXEdges; }
-        if (i == nx - 1 && edgeIndex == 5) { return INDEX3zyx(k + 1, j, i + 1, ny, dimX) + numXEdges; }
-        if (edgeIndex == 5) { return getPointIndex(k, j, i + 1, 7); }
-    }
-    else
-    {
-        // x-edges
-        if (edgeIndex == 4) { return getPointIndex(k + 1, j, i, 0); }
-        if (edgeIndex == 6) { return getPointIndex(k + 1, j, i, 2); }
-        // y-edges
-        if (edgeIndex == 5) { return getPointIndex(k + 1, j, i, 1); }
-        if (edgeIndex == 7) { return getPointIndex(k + 1, j, i, 3); }
-    }
-
-    const uint32_t numXYEdges = numXEdges + numYEdges;
-
+    case 3:  return numSlabXEdges + (size_t(k) * ny + j) * dimX + i;
+    case 1:  return numSlabXEdges + (size_t(k) * ny + j) * dimX + i + 1;
+    case 7:  return numSlabXEdges + (size_t(k + 1) * ny + j) * dimX + i;
+    case 5:  return numSlabXEdges + (size_t(k + 1) * ny + j) * dimX + i + 1;
     // z-edges
-    if (edgeIndex == 8) {  return INDEX3zyx(k, j, i, dimY, dimX) + numXYEdges; }
-    if (edgeIndex == 9) {  return INDEX3zyx(k, j, i + 1, dimY, dimX) + numXYEdges; }
-    if (edgeIndex == 10) { return INDEX3zyx(k, j + 1, i + 1, dimY, dimX) + numXYEdges; }
-    if (edgeIndex == 11) { return INDEX3zyx(k, j + 1, i, dimY, dimX) + numXYEdges; }
+    case 8:  return numXYEdges + getGridPointIndex(k, j, i);
+    case 9:  return numXYEdges + getGridPointIndex(k, j, i + 1);
+    case 10: return numXYEdges + getGridPointIndex(k, j + 1, i + 1);
+    case 11: return numXYEdges + getGridPointIndex(k, j + 1, i);
+    default: break;
+    }
 
     return 0;
 }
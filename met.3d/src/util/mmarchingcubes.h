@@ -31,66 +31,328 @@
 // standard library imports
 #include <QtCore>
 #include <array>
+#include <vector>
 
 // related third party imports
 
 // local imports
 #include "data/structuredgrid.h"
+#include "data/minmaxbrickindex.h"
 #include "geometry.h"
 
 namespace Met3D
 {
 
+/**
+  @brief MMarchingCubes extracts an isosurface from a structured grid on the
+  CPU.
+
+  The grid is processed in slabs of voxel layers along the vertical axis.
+  Only the working arrays of the current slab (grid point positions and
+  normals, voxel cases and edge-to-vertex indices) are held in memory; the
+  edge indices of the top plane of a slab are carried over to the next slab
+  so that the resulting mesh is seamless. The number of layers per slab is
+  derived from the limit set with @ref setMaxMemoryUsage_MB(). The output
+  vertices and triangles of all slabs are assembled into single buffers.
+
+  By default, grid point positions and normals are evaluated lazily: the
+  voxels are classified first, and positions and gradients are only computed
+  once for each end point of the edges crossed by the isosurface. Per grid
+  point only the index into the arrays of these points is stored, so that
+  the working memory is dominated by the voxel classification. See @ref
+  setLazyPointEvaluation().
+
+  If a @ref MMinMaxBrickIndex of the scalar field is set with @ref
+  setMinMaxBrickIndex(), only the voxels of the bricks whose value range
+  contains the isovalue are classified and processed, so that repeated
+  extractions from the same field with different isovalues scale with the
+  size of the surface rather than with the size of the grid.
+
+  Alternatively, the mesh can be extracted with the flying edges algorithm
+  (see @ref setAlgorithm()), which yields the same surface without shared
+  counters between threads and with a reproducible vertex and triangle
+  order.
+ */
 class MMarchingCubes
 {
 public:
+    /**
+      MARCHING_CUBES processes the grid voxel by voxel (in slabs, see @ref
+      setMaxMemoryUsage_MB()); output indices are assigned with atomic
+      counters, so that the order of vertices and triangles differs between
+      runs. FLYING_EDGES (Schroeder et al., 2015) classifies the grid row by
+      row and assigns output indices with prefix sums over the rows; every
+      intersected edge yields exactly one vertex and the output is identical
+      between runs. The memory limit and the brick index are ignored by
+      FLYING_EDGES, whose working memory is five bytes per grid point (the
+      classification and the index of the evaluated grid points, see @ref
+      evaluateActivePoints()).
+     */
+    enum Algorithm
+    {
+        MARCHING_CUBES = 0,
+        FLYING_EDGES   = 1
+    };
+
     explicit MMarchingCubes(MStructuredGrid* grid, MStructuredGrid* zGrid = nullptr);
-//    explicit MMarchingCubes();
+
+    /**
+      Selects the extraction algorithm used by @ref computeMeshOnCPU()
+      (default MARCHING_CUBES).
+     */
+    void setAlgorithm(Algorithm algorithm) { this->algorithm = algorithm; }
+
+    /**
+      Limits the working memory used during mesh extraction to approximately
+      @p maxMemory_MB (the output mesh is not included). A value of 0 (the
+      default) processes the entire grid as a single slab.
+     */
+    void setMaxMemoryUsage_MB(unsigned int maxMemory_MB);
+
+    /**
+      If @p lazy is true (the default), positions and normals are only
+      evaluated at the corners of voxels intersected by the isosurface. If
+      false, they are precomputed for all grid points of a slab, which is
+      faster only if the isosurface crosses a large fraction of the voxels.
+      Both modes yield identical meshes.
+     */
+    void setLazyPointEvaluation(bool lazy) { lazyPointEvaluation = lazy; }
+
+    /**
+      Adds @p grid (which needs to have the same dimensions as the input
+      grid) as vertex attribute. When an intersection point is created, the
+      attribute is interpolated along the edge with the same parameter as the
+      position. Returns the index of the attribute for @ref
+      getFlattenAttributes().
+     */
+    int addAttributeGrid(MStructuredGrid* grid);
+
+    /**
+      Replaces the scalar values of the input grid by @p values (same size
+      and memory layout as the data of the input grid) for classification,
+      interpolation and normals. Grid coordinates and pressure are still
+      taken from the input grid. Allows to extract isosurfaces of fields
+      derived on the fly without creating an additional grid. @p values must
+      remain valid until @ref computeMeshOnCPU() has returned.
+     */
+    void setScalarValues(const float* values);
+
+    /**
+      Restricts the extraction to the candidate bricks of @p index, which
+      needs to have been built from the scalar values used for the
+      extraction (the data of the input grid or the values set with @ref
+      setScalarValues()). The index is not owned by this object and must
+      remain valid until @ref computeMeshOnCPU() has returned. Pass a null
+      pointer to process all voxels.
+     */
+    void setMinMaxBrickIndex(const MMinMaxBrickIndex* index);
 
     void computeMeshOnCPU(const float isovalue);
 
-//    QVector<QVector3D>* getIntersectionPoints() { return &intersectionPoints; }
-//    QVector<QVector3D>* getIntersectionNormals() { return &intersectionNormals; }
-//    QVector<MTriangle>* getTriangles() { return &triangles; }
-    QVector<QVector3D>* getFlattenInterPoints() { return &flattenPoints; }
-    QVector<QVector3D>* getFlattenInterNormals() { return &flattenNormals; }
-    QVector<QVector3D>* getFlattenInterNormalsZ() { return &flattenNormalsZ; }
-    QVector<Geometry::MTriangle>* getFlattenTriangles() { return &flattenTriangles; }
+    std::vector<QVector3D>* getFlattenInterPoints() { return &flattenPoints; }
+    std::vector<QVector3D>* getFlattenInterNormals() { return &flattenNormals; }
+    std::vector<QVector3D>* getFlattenInterNormalsZ() { return &flattenNormalsZ; }
+    std::vector<Geometry::MTriangle>* getFlattenTriangles() { return &flattenTriangles; }
+    std::vector<float>* getFlattenAttributes(int index) { return &flattenAttributes[index]; }
 
 private:
+    /**
+      Number of voxel layers that can be processed at once without exceeding
+      the memory limit.
+     */
+    uint32_t computeNumLayersPerSlab() const;
+
+    /**
+      Allocates the working arrays for the slab of @p numLayers voxel layers
+      starting at voxel layer @p k0. The edge indices of the bottom plane are
+      initialised with the indices carried over from the previous slab.
+     */
+    void initializeSlab(const uint32_t k0, const uint32_t numLayers);
+
+    /** Stores the edge indices of the top plane of the current slab. */
+    void carryTopPlaneIndices();
+
+    void releaseSlab();
+
+    /**
+      Extracts the mesh of the entire grid with the flying edges algorithm.
+     */
+    void computeMeshFlyingEdges(const float isovalue);
+
+    /**
+      Computes the range [@p i0, @p i1) of voxels (or x-edges) between the
+      grid rows @p gridRows that may be intersected by the isosurface.
+      Outside the range of their intersected x-edges all rows are uniformly
+      below or above the isovalue; the range is hence extended to the
+      boundary if the rows differ there. Returns false if the range is
+      empty.
+     */
+    bool getFlyingEdgesTrim(const size_t* gridRows, const int numRows,
+                            uint32_t& i0, uint32_t& i1) const;
+
+    /**
+      Calls @p visit(kP, jP, iP, kN, jN, iN) for each intersected edge
+      starting in grid row @p r, in the order of the vertices of the row
+      (x-, y- and z-edges).
+     */
+    template<typename EdgeVisitor>
+    void visitFlyingEdgesRowEdges(const size_t r, EdgeVisitor visit) const;
+
+    /**
+      Interpolates position, normal(s) and attributes of the intersection of
+      the isosurface with the edge between the grid points (@p kP, @p jP,
+      @p iP) and (@p kN, @p jN, @p iN) and stores them as vertex @p vertex.
+      The grid points need to have been evaluated by @ref
+      evaluateActivePoints().
+     */
+    void interpolateEdge(const float isovalue,
+                         const uint32_t kP, const uint32_t jP,
+                         const uint32_t iP, const uint32_t kN,
+                         const uint32_t jN, const uint32_t iN,
+                         const size_t vertex);
+
+    /**
+      Collects the blocks of voxels of the current slab that are visited by
+      the classification, intersection and triangulation passes: the
+      intersection of the candidate bricks for @p isovalue with the slab if
+      a brick index has been set, otherwise one block per row of voxels.
+     */
+    void collectSlabBlocks(const float isovalue);
 
+    /**
+      Evaluates all grid points of the current slab with the pressure
+      accessor matching the vertical grid type of the input grid (see
+      gridpressureaccess.h).
+     */
     void precompute();
 
-    void computeVoxelIndices(const double isovalue);
+    template<typename PressureAccess>
+    void precomputeGridPoints(const PressureAccess &pressure);
+
+    /**
+      Lazy point evaluation: marks the end points of the edges @p
+      intersectedEdges (bit mask) of voxel (@p k, @p j, @p i) of the current
+      slab as active.
+     */
+    void markActivePoints(const uint32_t k, const uint32_t j,
+                          const uint32_t i, const uint16_t intersectedEdges);
+
+    inline void markActivePoint(const size_t pointIndex);
+
+    /**
+      Lazy point evaluation: numbers the points marked in @ref
+      activePointIndices consecutively and evaluates each of them once into
+      @ref gridPoints, @ref normals and @ref normalsZ. Point indices are
+      relative to level @p k0. The pressure accessor matching the vertical
+      grid type of the input grid is selected once for all points.
+     */
+    void evaluateActivePoints(const uint32_t k0);
+
+    template<typename PressureAccess>
+    void evaluateActivePoints(const PressureAccess &pressure,
+                              const uint32_t k0,
+                              const std::vector<size_t> &activePoints);
+
+    /**
+      Computes position and normal(s) of grid point (@p k, @p j, @p i) (@p k
+      is a global level index) with the pressure of the grid points obtained
+      from @p pressureAccess. @p normalZ is only set if a height grid has
+      been specified.
+     */
+    template<typename PressureAccess>
+    void evaluateGridPoint(const PressureAccess &pressureAccess,
+                           const uint32_t k, const uint32_t j,
+                           const uint32_t i, QVector3D& position,
+                           QVector3D& normal, QVector3D& normalZ) const;
+
+    /**
+      Returns position and normal(s) of vertex @p v of voxel (@p k, @p j,
+      @p i) of the current slab from the precomputed arrays or, in lazy
+      mode, from the evaluated active points.
+     */
+    inline void getVertexData(const uint32_t k, const uint32_t j,
+                              const uint32_t i, const uint8_t v,
+                              QVector3D& position, QVector3D& normal,
+                              QVector3D& normalZ) const;
+
+    quint64 computeVoxelIndices(const double isovalue);
     void computeIntersectionPoints(const double isovalue);
     void generateTriangles();
 
-    //void generateMesh();
-    //void flatten();
-
     void initializeVoxel(const uint32_t k, const uint32_t j, const uint32_t i,
                          Geometry::MVoxel& voxel) const;
 
     MStructuredGrid*    inputGrid;
     MStructuredGrid*    heightGrid;
+    const float*        scalarValues;
     uint32_t            nx;
     uint32_t            ny;
     uint32_t            nz;
-    uint32_t            numEdges;
-    uint32_t            numVoxels;
-    QVector<QVector3D>  gridPoints;
-    QVector<QVector3D>  normals;
-    QVector<QVector3D>  normalsZ;
-    QVector<uint8_t>    voxelIndices;
-    QVector<uint8_t>    voxelNumTriangles;
-    QVector<uint32_t>   voxelMinIndexTriangle;
-    QVector<uint32_t>   intersectionIndices;
-    QVector<QVector3D>  flattenPoints;
-    QVector<QVector3D>  flattenNormals;
-    QVector<QVector3D>  flattenNormalsZ;
-    QVector<Geometry::MTriangle>  flattenTriangles;
+    uint32_t            dimX;
+    uint32_t            dimY;
+    uint32_t            dimZ;
+    quint64             maxMemoryUsage_bytes;
+    bool                lazyPointEvaluation;
+    const MMinMaxBrickIndex* brickIndex;
+    Algorithm           algorithm;
+
+    // Voxel range [k0, k1) x [j0, j1) x [i0, i1); k is relative to the
+    // current slab.
+    struct VoxelBlock
+    {
+        uint32_t k0, k1, j0, j1, i0, i1;
+    };
+    std::vector<VoxelBlock> slabBlocks;
+
+    // Flying edges: intersection metadata of a grid row (fixed k and j).
+    // [xL, xR) is the range of intersected x-edges; the vertices of the
+    // x-, y- and z-edges starting in the row are numbered consecutively
+    // from firstVertex.
+    struct FlyingEdgesRow
+    {
+        uint32_t numXEdges;
+        uint32_t numYEdges;
+        uint32_t numZEdges;
+        uint32_t xL;
+        uint32_t xR;
+        quint64  firstVertex;
+    };
+    std::vector<FlyingEdgesRow> flyingEdgesRows;
+    // One byte per grid point: value below the isovalue.
+    std::vector<uint8_t>        flyingEdgesBelow;
+
+    inline bool isBelow(const size_t gridRow, const uint32_t i) const
+    { return flyingEdgesBelow[gridRow * dimX + i]; }
+
+    // Current slab: first (global) voxel layer, number of voxel layers and
+    // number of x-/y-edges (the z-edges follow the y-edges).
+    uint32_t            slabK0;
+    uint32_t            slabNz;
+    size_t              numSlabXEdges;
+    size_t              numSlabYEdges;
+    size_t              triangleBase;
+
+    // Positions and normal(s) of all grid points of the current slab or, in
+    // lazy mode, of the active points only (indexed by activePointIndices,
+    // which holds iNaN for all other grid points).
+    std::vector<QVector3D>  gridPoints;
+    std::vector<QVector3D>  normals;
+    std::vector<QVector3D>  normalsZ;
+    std::vector<uint32_t>   activePointIndices;
+    std::vector<uint8_t>    voxelIndices;
+    std::vector<uint8_t>    voxelNumTriangles;
+    std::vector<quint64>    voxelMinIndexTriangle;
+    std::vector<uint32_t>   intersectionIndices;
+    std::vector<uint32_t>   carriedPlaneIndices;
+    std::vector<QVector3D>  flattenPoints;
+    std::vector<QVector3D>  flattenNormals;
+    std::vector<QVector3D>  flattenNormalsZ;
+    std::vector<Geometry::MTriangle>  flattenTriangles;
+    std::vector<MStructuredGrid*>     attributeGrids;
+    std::vector<std::vector<float>>   flattenAttributes;
+    quint64             numVertices;
     uint32_t            atomicEdgeCount;
-    uint32_t            atomicTriangleCount;
+    quint64             atomicTriangleCount;
 
     void lerpAtVoxel(const double isovalue,
                      const uint32_t k,
@@ -102,8 +364,28 @@ private:
                               const float valP, const float valN,
                               const QVector3D& vP, const QVector3D& vN) const;
 
+    inline float floatLerp(const float isovalue,
+                           const float valP, const float valN,
+                           const float aP, const float aN) const;
+
+    /**
+      Global grid indices of vertex @p v of voxel (@p k, @p j, @p i) of the
+      current slab.
+     */
+    inline void getVertexIndices(const uint32_t k, const uint32_t j,
+                                 const uint32_t i, const uint8_t v,
+                                 int& kv, int& jv, int& iv) const;
+
     inline void getEdgeVertices(const uint8_t edge, uint8_t& vP, uint8_t& vN) const;
 
+    /**
+      Bit mask of the edges of voxel (@p k, @p j, @p i) of the current slab
+      whose intersection points are computed by this voxel. Each edge of the
+      grid is owned by exactly one voxel.
+     */
+    inline uint16_t getOwnedEdges(const uint32_t k, const uint32_t j,
+                                  const uint32_t i) const;
+
     inline float getVoxelValue(const uint32_t k, const uint32_t j,
                                const uint32_t i, const uint8_t v) const;
 
@@ -116,8 +398,20 @@ private:
     inline QVector3D getNormalZ(const uint32_t k, const uint32_t j,
                                 const uint32_t i, const uint8_t v) const;
 
-    inline uint32_t getPointIndex(const uint32_t k, const uint32_t j,
-                                  const uint32_t i, const uint32_t edgeIndex);
+    inline size_t getPointIndex(const uint32_t k, const uint32_t j,
+                                const uint32_t i, const uint32_t edgeIndex) const;
+
+    inline float getScalar(const uint32_t k, const uint32_t j,
+                           const uint32_t i) const
+    { return scalarValues[(size_t(k) * dimY + j) * dimX + i]; }
+
+    inline size_t getGridPointIndex(const uint32_t k, const uint32_t j,
+                                    const uint32_t i) const
+    { return (size_t(k) * dimY + j) * dimX + i; }
+
+    inline size_t getVoxelIndex(const uint32_t k, const uint32_t j,
+                                const uint32_t i) const
+    { return (size_t(k) * ny + j) * nx + i; }
 };
 
 }
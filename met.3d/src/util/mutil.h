@@ -30,6 +30,7 @@
 // standard library imports
 #include <typeinfo>
 #include <float.h>
+#include <cstring>
 
 // related third party imports
 #include <QtCore>
@@ -175,4 +176,83 @@ bool floatIsAlmostEqualRelativeAndAbs(
         float floatA, float floatB,
         float maxDiff, float maxRelDiff = FLT_EPSILON);
 
+/**
+  Converts @p value to an IEEE 754 half precision (binary16) number, rounding
+  to the nearest representable value (ties to even). Values with a magnitude
+  of 65520 or larger become +-infinity, NaN stays NaN.
+ */
+inline quint16 floatToHalf(float value)
+{
+    quint32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const quint32 sign = (bits >> 16) & 0x8000;
+    const quint32 absBits = bits & 0x7fffffff;
+
+    if (absBits >= 0x7f800000) // infinity or NaN
+    {
+        return quint16(sign | 0x7c00 | (absBits > 0x7f800000 ? 0x200 : 0));
+    }
+    if (absBits >= 0x477ff000) // >= 65520, rounds to infinity
+    {
+        return quint16(sign | 0x7c00);
+    }
+    if (absBits < 0x33000000) // <= 2^-25, rounds to zero
+    {
+        return quint16(sign);
+    }
+
+    quint32 exponent = absBits >> 23;
+    quint32 mantissa = absBits & 0x7fffff;
+    quint32 half, shift;
+    if (exponent < 113) // below 2^-14, subnormal half
+    {
+        mantissa |= 0x800000;
+        shift = 126 - exponent;
+        half = mantissa >> shift;
+    }
+    else
+    {
+        shift = 13;
+        half = ((exponent - 112) << 10) | (mantissa >> shift);
+    }
+
+    // Round to nearest even. A carry out of the mantissa correctly increments
+    // the exponent.
+    const quint32 remainder = mantissa & ((1u << shift) - 1);
+    const quint32 halfway = 1u << (shift - 1);
+    if (remainder > halfway || (remainder == halfway && (half & 1))) half++;
+
+    return quint16(sign | half);
+}
+
+/**
+  Converts the IEEE 754 half precision number @p half to float (exact).
+ */
+inline float halfToFloat(quint16 half)
+{
+    const quint32 sign = quint32(half & 0x8000) << 16;
+    const quint32 exponent = (half >> 10) & 0x1f;
+    const quint32 mantissa = half & 0x3ff;
+
+    quint32 bits;
+    if (exponent == 0) // zero or subnormal
+    {
+        const float value = float(mantissa) * 5.9604644775390625e-8f; // 2^-24
+        memcpy(&bits, &value, sizeof(bits));
+        bits |= sign;
+    }
+    else if (exponent == 31) // infinity or NaN
+    {
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    }
+    else
+    {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
 #endif // MUTIL_H